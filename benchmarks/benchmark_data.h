@@ -0,0 +1,269 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file benchmark_data.h
+/// \brief Deterministic generators of key-value-intervals for benchmarking
+///
+/// Each workload is generated from a fixed seed so that successive runs (and
+/// different backends) see exactly the same data.
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef BENCHMARKS_BENCHMARK_DATA_H
+#define BENCHMARKS_BENCHMARK_DATA_H
+
+#include <boost/icl/interval.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace benchmark
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using KeyValueIntervals = std::vector<std::tuple<int, int, Interval>>;
+
+  /// Seed shared by all generators so that runs are reproducible
+  constexpr std::mt19937::result_type default_seed = 20200110;
+
+  /*
+   * Planned workloads from the README
+   */
+
+  /// Each interval overlaps the next few intervals for the same key:
+  ///     0------0
+  ///        1------1
+  ///           2------2
+  inline KeyValueIntervals successively_overlapping (int scale)
+  {
+    const int count_keys = 16;
+    const int per_key = scale / count_keys;
+    const int step = 10;
+    const int length = 45;
+    KeyValueIntervals results;
+    results.reserve (count_keys * per_key);
+    for (int key = 0; key < count_keys; ++key)
+    {
+      for (int i = 0; i < per_key; ++i)
+      {
+        results.push_back ({key, i, Interval {i * step, i * step + length}});
+      }
+    }
+    return results;
+  }
+
+  /// Intervals nested inside each other like a pyramid:
+  ///     0-----------------0
+  ///        1-----------1
+  ///           2-----2
+  /// Every interval overlaps every other for the same key, so the number of
+  /// disjoint intervals (and their value sets) grows quadratically with depth.
+  /// Depth is capped so that ICL does not exhaust memory
+  inline KeyValueIntervals nested_pyramid (int scale)
+  {
+    const int per_key = std::min (scale, 256);
+    const int count_keys = std::max (1, scale / per_key);
+    KeyValueIntervals results;
+    results.reserve (count_keys * per_key);
+    for (int key = 0; key < count_keys; ++key)
+    {
+      for (int i = 0; i < per_key; ++i)
+      {
+        results.push_back ({key, i, Interval {i, 2 * per_key - i}});
+      }
+    }
+    return results;
+  }
+
+  /// Each key starts with its own value. At successive time steps, a random
+  /// proportion of values swap between pairs of keys.
+  inline KeyValueIntervals random_value_swaps (int scale,
+                                               double proportion_swapped = 0.05)
+  {
+    const int count_keys = 256;
+    const int swaps_per_step
+      = std::max (1, static_cast<int> (count_keys * proportion_swapped / 2));
+    // Each swap ends two key-value intervals
+    const int count_steps = std::max (1, scale / (2 * swaps_per_step));
+    std::mt19937 generator (default_seed);
+    std::uniform_int_distribution<int> random_key (0, count_keys - 1);
+
+    // current value of each key and when that association started
+    std::vector<int> values (count_keys);
+    std::iota (values.begin (), values.end (), 0);
+    std::vector<int> starts (count_keys, 0);
+
+    KeyValueIntervals results;
+    results.reserve (scale);
+    for (int step = 1; step < count_steps; ++step)
+    {
+      for (int i = 0; i < swaps_per_step; ++i)
+      {
+        const int key_1 = random_key (generator);
+        const int key_2 = random_key (generator);
+        if (key_1 == key_2)
+        {
+          continue;
+        }
+        for (const int key : {key_1, key_2})
+        {
+          if (starts[key] < step)
+          {
+            results.push_back (
+              {key, values[key], Interval {starts[key], step}});
+          }
+          starts[key] = step;
+        }
+        std::swap (values[key_1], values[key_2]);
+      }
+    }
+    for (int key = 0; key < count_keys; ++key)
+    {
+      results.push_back ({key, values[key], Interval {starts[key], count_steps}});
+    }
+    return results;
+  }
+
+  /*
+   * Production shapes
+   */
+
+  /// Very many keys with only one to three short intervals each
+  inline KeyValueIntervals many_tiny_keys (int scale)
+  {
+    std::mt19937 generator (default_seed + 1);
+    std::uniform_int_distribution<int> random_count (1, 3);
+    std::uniform_int_distribution<int> random_start (0, 10'000);
+    std::uniform_int_distribution<int> random_length (1, 50);
+    std::uniform_int_distribution<int> random_value (0, 1000);
+    KeyValueIntervals results;
+    results.reserve (scale);
+    for (int key = 0; std::ssize (results) < scale; ++key)
+    {
+      for (int i = random_count (generator); i > 0; --i)
+      {
+        const int start = random_start (generator);
+        results.push_back ({key,
+                            random_value (generator),
+                            Interval {start, start + random_length (generator)}});
+      }
+    }
+    return results;
+  }
+
+  /// A handful of keys each with a great many randomly placed intervals
+  inline KeyValueIntervals few_giant_keys (int scale)
+  {
+    const int count_keys = 3;
+    std::mt19937 generator (default_seed + 2);
+    std::uniform_int_distribution<int> random_start (0, 10 * scale);
+    std::uniform_int_distribution<int> random_length (1, 500);
+    std::uniform_int_distribution<int> random_value (0, scale / 4);
+    KeyValueIntervals results;
+    results.reserve (scale);
+    for (int i = 0; i < scale; ++i)
+    {
+      const int start = random_start (generator);
+      results.push_back ({i % count_keys,
+                          random_value (generator),
+                          Interval {start, start + random_length (generator)}});
+    }
+    return results;
+  }
+
+  /// Stream of intervals arriving in time order, as if appended from a log
+  inline KeyValueIntervals append_ordered (int scale)
+  {
+    const int count_keys = 64;
+    std::mt19937 generator (default_seed + 3);
+    std::uniform_int_distribution<int> random_key (0, count_keys - 1);
+    std::uniform_int_distribution<int> random_gap (0, 3);
+    std::uniform_int_distribution<int> random_length (1, 100);
+    std::uniform_int_distribution<int> random_value (0, 255);
+    KeyValueIntervals results;
+    results.reserve (scale);
+    int now = 0;
+    for (int i = 0; i < scale; ++i)
+    {
+      now += random_gap (generator);
+      results.push_back ({random_key (generator),
+                          random_value (generator),
+                          Interval {now, now + random_length (generator)}});
+    }
+    return results;
+  }
+
+  /// Named workload generator
+  struct Workload
+  {
+    std::string name;
+    std::function<KeyValueIntervals (int)> generate;
+  };
+
+  /// All workloads in the order they are benchmarked
+  inline std::vector<Workload> all_workloads ()
+  {
+    return {
+      {"successively_overlapping", successively_overlapping},
+      {"nested_pyramid", nested_pyramid},
+      {"random_value_swaps",
+       [] (int scale)
+       {
+         return random_value_swaps (scale);
+       }},
+      {"many_tiny_keys", many_tiny_keys},
+      {"few_giant_keys", few_giant_keys},
+      {"append_ordered", append_ordered},
+    };
+  }
+
+  /// Lookup table from each value to one of @p count_buckets buckets over all
+  /// time. Used as the "B -> C" side of benchmarking joins.
+  inline KeyValueIntervals value_buckets (const KeyValueIntervals &data,
+                                          int count_buckets = 8)
+  {
+    std::vector<int> values;
+    for (const auto &[_, value, __] : data)
+    {
+      values.push_back (value);
+    }
+    std::sort (values.begin (), values.end ());
+    values.erase (std::unique (values.begin (), values.end ()), values.end ());
+
+    KeyValueIntervals results;
+    for (const auto value : values)
+    {
+      results.push_back ({value,
+                          value % count_buckets,
+                          Interval {std::numeric_limits<int>::lowest (),
+                                    std::numeric_limits<int>::max ()}});
+    }
+    return results;
+  }
+
+  /// Deterministic sample of every n-th item
+  inline KeyValueIntervals every_nth (const KeyValueIntervals &data, int n)
+  {
+    KeyValueIntervals results;
+    for (std::size_t i = 0; i < data.size (); i += n)
+    {
+      results.push_back (data[i]);
+    }
+    return results;
+  }
+
+} // namespace benchmark
+
+#endif // BENCHMARKS_BENCHMARK_DATA_H
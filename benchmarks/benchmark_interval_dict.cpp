@@ -0,0 +1,219 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file benchmark_interval_dict.cpp
+/// \brief Times IntervalDict operations for each workload and implementation
+///
+/// Usage:
+///     benchmark_interval_dict [scale=20000] [repeats=5] [output.json]
+///                             [baseline.json] [threshold=0.25]
+///
+/// Results are written as JSON to the output file (or stdout) so that
+/// successive runs can be compared. If a baseline from a previous run is
+/// given, operations that are slower by more than the threshold are reported
+/// and the exit status is non-zero.
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "benchmark_data.h"
+#include "benchmark_utils.h"
+
+#include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicthybrid.h>
+#include <interval_dict/intervaldicticl.h>
+#include <interval_dict/intervaldictitree.h>
+#include <interval_dict/intervaldictpartitioned.h>
+#include <interval_dict/intervaldicttimeline.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace benchmark
+{
+  /// Time each operation for a single implementation on one workload
+  template<template<typename, typename, typename> class IntervalDictType>
+  void benchmark_backend (const std::string &backend_name,
+                          const Workload &workload,
+                          const KeyValueIntervals &data,
+                          int repeats,
+                          std::vector<Result> &results)
+  {
+    using Dict = IntervalDictType<int, int, Interval>;
+    const auto erasures = every_nth (data, 10);
+    const auto queries = every_nth (data, 10);
+
+    const auto record = [&] (const std::string &operation, Timings timings)
+    {
+      std::cerr << workload.name << "\t" << backend_name << "\t" << operation
+                << "\t" << timings.median () / 1000 << "us\n";
+      results.push_back (
+        {workload.name, backend_name, operation, data.size (), timings});
+    };
+
+    record ("insert",
+            time_operation (
+              repeats,
+              [] ()
+              {
+                return Dict ();
+              },
+              [&] (Dict &dict)
+              {
+                dict.insert (data);
+                return dict.size ();
+              }));
+
+    const Dict built (data);
+    const auto copy_built = [&] ()
+    {
+      return built;
+    };
+    const auto no_state = [] ()
+    {
+      return std::size_t {0};
+    };
+
+    record ("erase",
+            time_operation (repeats,
+                            copy_built,
+                            [&] (Dict &dict)
+                            {
+                              dict.erase (erasures);
+                              return dict.size ();
+                            }));
+
+    record ("find",
+            time_operation (repeats,
+                            no_state,
+                            [&] (std::size_t &count)
+                            {
+                              for (const auto &[key, _, interval] : queries)
+                              {
+                                count += built.find (key, interval).size ();
+                              }
+                              return count;
+                            }));
+
+    record ("intervals",
+            time_operation (repeats,
+                            no_state,
+                            [&] (std::size_t &count)
+                            {
+                              for (const auto &kvi : intervals (built))
+                              {
+                                do_not_optimise (kvi);
+                                ++count;
+                              }
+                              return count;
+                            }));
+
+    record ("disjoint_intervals",
+            time_operation (repeats,
+                            no_state,
+                            [&] (std::size_t &count)
+                            {
+                              for (const auto &kvi : disjoint_intervals (built))
+                              {
+                                do_not_optimise (kvi);
+                                ++count;
+                              }
+                              return count;
+                            }));
+
+    record ("invert",
+            time_operation (repeats,
+                            no_state,
+                            [&] (std::size_t &count)
+                            {
+                              count = built.invert ().size ();
+                              return count;
+                            }));
+
+    // A -> B -> C where each value B maps to a single bucket C
+    const Dict b_to_c (value_buckets (data));
+    record ("joined_to",
+            time_operation (repeats,
+                            no_state,
+                            [&] (std::size_t &count)
+                            {
+                              count = built.joined_to (b_to_c).size ();
+                              return count;
+                            }));
+
+    record ("fill_gaps",
+            time_operation (repeats,
+                            copy_built,
+                            [&] (Dict &dict)
+                            {
+                              dict.fill_gaps ();
+                              return dict.size ();
+                            }));
+
+    record ("flatten",
+            time_operation (repeats,
+                            copy_built,
+                            [&] (Dict &dict)
+                            {
+                              dict = flattened (std::move (dict));
+                              return dict.size ();
+                            }));
+  }
+
+} // namespace benchmark
+
+int main (int argc, char *argv[])
+{
+  using namespace benchmark;
+  using namespace interval_dict;
+
+  const int scale = argc > 1 ? std::stoi (argv[1]) : 20'000;
+  const int repeats = argc > 2 ? std::stoi (argv[2]) : 5;
+
+  std::vector<Result> results;
+  for (const auto &workload : all_workloads ())
+  {
+    const auto data = workload.generate (scale);
+    benchmark_backend<IntervalDictICLExp> (
+      "IntervalDictICL", workload, data, repeats, results);
+    benchmark_backend<IntervalDictITreeExp> (
+      "IntervalDictITree", workload, data, repeats, results);
+    benchmark_backend<IntervalDictAILExp> (
+      "IntervalDictAIL", workload, data, repeats, results);
+    benchmark_backend<IntervalDictHybridExp> (
+      "IntervalDictHybrid", workload, data, repeats, results);
+    benchmark_backend<IntervalDictTimelineExp> (
+      "IntervalDictTimeline", workload, data, repeats, results);
+    benchmark_backend<IntervalDictPartitionedAILExp> (
+      "IntervalDictPartitionedAIL", workload, data, repeats, results);
+  }
+
+  if (argc > 3)
+  {
+    std::ofstream output (argv[3]);
+    write_json (output, results);
+  }
+  else
+  {
+    write_json (std::cout, results);
+  }
+
+  if (argc > 4)
+  {
+    std::ifstream baseline_file (argv[4]);
+    const double threshold = argc > 5 ? std::stod (argv[5]) : 0.25;
+    if (flag_regressions (
+          std::cerr, results, read_baseline (baseline_file), threshold))
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
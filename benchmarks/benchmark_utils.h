@@ -0,0 +1,222 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file benchmark_utils.h
+/// \brief Timing and JSON output helpers for benchmarking
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef BENCHMARKS_BENCHMARK_UTILS_H
+#define BENCHMARKS_BENCHMARK_UTILS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace benchmark
+{
+  /// Prevent the optimiser from discarding results that are never used
+  template<typename T>
+  inline void do_not_optimise (const T &value)
+  {
+    asm volatile ("" : : "r,m"(value) : "memory");
+  }
+
+  /// Summary statistics over repeated timings in nanoseconds
+  struct Timings
+  {
+    std::vector<std::int64_t> nanoseconds;
+
+    /// Size of the output of the last repeat, for sanity checking
+    std::size_t checksum = 0;
+
+    [[nodiscard]] std::int64_t min () const
+    {
+      return nanoseconds.empty ()
+               ? 0
+               : *std::min_element (nanoseconds.begin (), nanoseconds.end ());
+    }
+
+    [[nodiscard]] std::int64_t median () const
+    {
+      if (nanoseconds.empty ())
+      {
+        return 0;
+      }
+      auto sorted = nanoseconds;
+      std::sort (sorted.begin (), sorted.end ());
+      return sorted[sorted.size () / 2];
+    }
+
+    [[nodiscard]] double mean () const
+    {
+      if (nanoseconds.empty ())
+      {
+        return 0;
+      }
+      return std::accumulate (
+               nanoseconds.begin (), nanoseconds.end (), double {0})
+             / nanoseconds.size ();
+    }
+  };
+
+  /// Run @p setup (untimed) then @p operation (timed) @p repeats times.
+  /// @p operation is passed the result of @p setup and returns a checksum.
+  template<typename Setup, typename Operation>
+  Timings time_operation (int repeats, Setup setup, Operation operation)
+  {
+    Timings timings;
+    for (int i = 0; i < repeats; ++i)
+    {
+      auto state = setup ();
+      const auto start = std::chrono::steady_clock::now ();
+      timings.checksum = operation (state);
+      const auto stop = std::chrono::steady_clock::now ();
+      do_not_optimise (state);
+      timings.nanoseconds.push_back (
+        std::chrono::duration_cast<std::chrono::nanoseconds> (stop - start)
+          .count ());
+    }
+    return timings;
+  }
+
+  /// One line of results: a single operation on a workload for one backend
+  struct Result
+  {
+    std::string workload;
+    std::string backend;
+    std::string operation;
+    std::size_t size;
+    Timings timings;
+  };
+
+  /// Minimal escaping for JSON strings: names are all plain identifiers
+  inline std::string json_string (const std::string &str)
+  {
+    std::string escaped = "\"";
+    for (const char c : str)
+    {
+      if (c == '"' || c == '\\')
+      {
+        escaped += '\\';
+      }
+      escaped += c;
+    }
+    return escaped + "\"";
+  }
+
+  /// Write results as a JSON array of flat objects, one per result
+  inline void write_json (std::ostream &ostream,
+                          const std::vector<Result> &results)
+  {
+    ostream << "[\n";
+    for (std::size_t i = 0; i < results.size (); ++i)
+    {
+      const auto &result = results[i];
+      ostream << "  {\"workload\": " << json_string (result.workload)
+              << ", \"backend\": " << json_string (result.backend)
+              << ", \"operation\": " << json_string (result.operation)
+              << ", \"size\": " << result.size
+              << ", \"checksum\": " << result.timings.checksum
+              << ", \"repeats\": " << result.timings.nanoseconds.size ()
+              << ", \"min_ns\": " << result.timings.min ()
+              << ", \"median_ns\": " << result.timings.median ()
+              << ", \"mean_ns\": " << static_cast<std::int64_t> (
+                   result.timings.mean ())
+              << "}" << (i + 1 < results.size () ? "," : "") << "\n";
+    }
+    ostream << "]\n";
+  }
+
+  /// Median timings from a previous run,
+  /// indexed by workload, backend and operation
+  using Baseline
+    = std::map<std::tuple<std::string, std::string, std::string>, std::int64_t>;
+
+  /// Value of a field in one line of output from write_json().
+  /// Quotes are stripped from strings.
+  inline std::string json_field (const std::string &line,
+                                 const std::string &name)
+  {
+    const auto key = json_string (name) + ": ";
+    auto begin = line.find (key);
+    if (begin == std::string::npos)
+    {
+      return {};
+    }
+    begin += key.size ();
+    if (line[begin] == '"')
+    {
+      ++begin;
+      return line.substr (begin, line.find ('"', begin) - begin);
+    }
+    return line.substr (begin, line.find_first_of (",}", begin) - begin);
+  }
+
+  /// Read results previously saved by write_json()
+  inline Baseline read_baseline (std::istream &istream)
+  {
+    Baseline baseline;
+    std::string line;
+    while (std::getline (istream, line))
+    {
+      const auto median = json_field (line, "median_ns");
+      if (median.empty ())
+      {
+        continue;
+      }
+      baseline[{json_field (line, "workload"),
+                json_field (line, "backend"),
+                json_field (line, "operation")}]
+        = std::stoll (median);
+    }
+    return baseline;
+  }
+
+  /// Report results whose median timing is slower than the baseline by more
+  /// than @p threshold (e.g. 0.25 = 25% slower).
+  /// \return The number of regressions
+  inline int flag_regressions (std::ostream &ostream,
+                               const std::vector<Result> &results,
+                               const Baseline &baseline,
+                               double threshold)
+  {
+    int count_regressions = 0;
+    for (const auto &result : results)
+    {
+      const auto ff = baseline.find (
+        {result.workload, result.backend, result.operation});
+      if (ff == baseline.end () || ff->second <= 0)
+      {
+        continue;
+      }
+      const auto ratio
+        = static_cast<double> (result.timings.median ()) / ff->second;
+      if (ratio > 1.0 + threshold)
+      {
+        ++count_regressions;
+        ostream << "REGRESSION\t" << result.workload << "\t" << result.backend
+                << "\t" << result.operation << "\t" << ff->second << "ns -> "
+                << result.timings.median () << "ns (x" << ratio << ")\n";
+      }
+    }
+    return count_regressions;
+  }
+
+} // namespace benchmark
+
+#endif // BENCHMARKS_BENCHMARK_UTILS_H
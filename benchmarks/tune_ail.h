@@ -0,0 +1,188 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file tune_ail.h
+/// \brief Sweep augmented_interval_list::Tuning against a query log
+///
+/// Each combination of parameters in a TuningGrid is applied to a copy of
+/// the dictionary, and the time taken to rebuild the runs and to replay a
+/// sample of the query log is measured with time_operation(). Candidates are
+/// ranked by the median query time.
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef BENCHMARKS_TUNE_AIL_H
+#define BENCHMARKS_TUNE_AIL_H
+
+#include "benchmark_utils.h"
+
+#include <interval_dict/intervaldictail.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <tuple>
+#include <vector>
+
+namespace benchmark
+{
+  using interval_dict::augmented_interval_list::Tuning;
+
+  /// Values to try for each parameter. Every combination is timed.
+  ///
+  /// max_fraction_pending only affects incremental inserts and erases, not
+  /// queries, and is kept from the dictionary's current tuning
+  struct TuningGrid
+  {
+    std::vector<int_fast32_t> max_overlapping_neighbours {10, 20, 40};
+    std::vector<int_fast32_t> min_run_length {64, 256, 1024};
+    std::vector<double> max_fraction_promoted_per_run {0.1, 0.2, 0.5};
+    std::vector<int_fast32_t> max_brute_force_run_length {32, 64, 128};
+  };
+
+  /// Timings for one candidate tuning
+  struct TuningCost
+  {
+    Tuning tuning;
+
+    /// Median time to rebuild all runs with this tuning
+    std::int64_t rebuild_ns = 0;
+
+    /// Median time to replay the sampled query log
+    std::int64_t query_ns = 0;
+
+    std::size_t bytes = 0;
+  };
+
+  /// @return every combination of parameters in @p grid, with other
+  /// parameters taken from @p base
+  inline std::vector<Tuning> tuning_candidates (const TuningGrid &grid,
+                                                const Tuning &base)
+  {
+    std::vector<Tuning> candidates;
+    for (const auto max_overlapping_neighbours :
+         grid.max_overlapping_neighbours)
+    {
+      for (const auto min_run_length : grid.min_run_length)
+      {
+        for (const auto max_fraction_promoted_per_run :
+             grid.max_fraction_promoted_per_run)
+        {
+          for (const auto max_brute_force_run_length :
+               grid.max_brute_force_run_length)
+          {
+            auto tuning = base;
+            tuning.max_overlapping_neighbours = max_overlapping_neighbours;
+            tuning.min_run_length = min_run_length;
+            tuning.max_fraction_promoted_per_run
+              = max_fraction_promoted_per_run;
+            tuning.max_brute_force_run_length = max_brute_force_run_length;
+            candidates.push_back (tuning);
+          }
+        }
+      }
+    }
+    return candidates;
+  }
+
+  /// Deterministic sample of at most @p max_count items spread evenly over
+  /// @p query_log
+  template<typename Query>
+  std::vector<Query> sample_queries (const std::vector<Query> &query_log,
+                                     std::size_t max_count)
+  {
+    if (query_log.size () <= max_count || max_count == 0)
+    {
+      return query_log;
+    }
+    std::vector<Query> results;
+    results.reserve (max_count);
+    for (std::size_t i = 0; i < max_count; ++i)
+    {
+      results.push_back (query_log[i * query_log.size () / max_count]);
+    }
+    return results;
+  }
+
+  /// Time each combination of parameters in @p grid on @p dict
+  /// \param query_log key and interval of each find() to replay
+  /// \return costs sorted from fastest to slowest queries
+  template<typename Key, typename Value, typename Interval>
+  std::vector<TuningCost>
+  sweep_tuning (const interval_dict::IntervalDictAILExp<Key, Value, Interval>
+                  &dict,
+                const std::vector<std::tuple<Key, Interval>> &query_log,
+                const TuningGrid &grid,
+                int repeats)
+  {
+    using Dict = interval_dict::IntervalDictAILExp<Key, Value, Interval>;
+    const auto copy_dict = [&] ()
+    {
+      return dict;
+    };
+    const auto no_state = [] ()
+    {
+      return std::size_t {0};
+    };
+
+    std::vector<TuningCost> costs;
+    for (const auto &tuning : tuning_candidates (grid, dict.tuning ()))
+    {
+      TuningCost cost {.tuning = tuning};
+      cost.rebuild_ns = time_operation (repeats,
+                                        copy_dict,
+                                        [&] (Dict &tuned)
+                                        {
+                                          tuned.tune (tuning);
+                                          return tuned.size ();
+                                        })
+                          .median ();
+
+      auto tuned = dict;
+      tuned.tune (tuning);
+      cost.bytes = tuned.memory_usage (0).total ();
+      cost.query_ns
+        = time_operation (repeats,
+                          no_state,
+                          [&] (std::size_t &count)
+                          {
+                            for (const auto &[key, interval] : query_log)
+                            {
+                              count += tuned.find (key, interval).size ();
+                            }
+                            return count;
+                          })
+            .median ();
+      costs.push_back (cost);
+    }
+    std::stable_sort (costs.begin (),
+                      costs.end (),
+                      [] (const auto &lhs, const auto &rhs)
+                      {
+                        return lhs.query_ns < rhs.query_ns;
+                      });
+    return costs;
+  }
+
+  /// Write one line per candidate as tab separated values
+  inline void write_tuning_costs (std::ostream &ostream,
+                                  const std::vector<TuningCost> &costs)
+  {
+    ostream << "query_ns\trebuild_ns\tbytes\ttuning\n";
+    for (const auto &cost : costs)
+    {
+      ostream << cost.query_ns << "\t" << cost.rebuild_ns << "\t"
+              << cost.bytes << "\t" << cost.tuning << "\n";
+    }
+  }
+
+} // namespace benchmark
+
+#endif // BENCHMARKS_TUNE_AIL_H
@@ -0,0 +1,139 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file tune_interval_dict_ail.cpp
+/// \brief Finds the best augmented_interval_list::Tuning for a data set
+///
+/// Usage:
+///     tune_interval_dict_ail [data.tsv] [query_log.tsv] [repeats=5]
+///
+/// data.tsv holds one "key value begin end" per line, and query_log.tsv one
+/// "key begin end" per line. Without a query log, every tenth interval in
+/// the data is queried. The timings for each candidate are written to
+/// stderr, and the best tuning is saved to data.tsv.tuning where it can be
+/// read back with operator>> and passed to IntervalDictExp::tune().
+///
+/// Without any arguments, each of the benchmark workloads is tuned in turn
+/// and the best tuning for each is written to stdout.
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "benchmark_data.h"
+#include "benchmark_utils.h"
+#include "tune_ail.h"
+
+#include <interval_dict/intervaldictail.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace benchmark
+{
+  using QueryLog = std::vector<std::tuple<int, Interval>>;
+
+  /// Read "key value begin end" lines
+  inline KeyValueIntervals read_data (std::istream &istream)
+  {
+    KeyValueIntervals results;
+    int key, value, begin, end;
+    while (istream >> key >> value >> begin >> end)
+    {
+      results.push_back ({key, value, Interval {begin, end}});
+    }
+    return results;
+  }
+
+  /// Read "key begin end" lines
+  inline QueryLog read_query_log (std::istream &istream)
+  {
+    QueryLog results;
+    int key, begin, end;
+    while (istream >> key >> begin >> end)
+    {
+      results.push_back ({key, Interval {begin, end}});
+    }
+    return results;
+  }
+
+  /// Query every tenth interval in @p data
+  inline QueryLog default_query_log (const KeyValueIntervals &data)
+  {
+    QueryLog results;
+    for (const auto &[key, _, interval] : every_nth (data, 10))
+    {
+      results.push_back ({key, interval});
+    }
+    return results;
+  }
+
+  /// @return the fastest tuning for @p data, logging all timings to stderr
+  inline Tuning best_tuning (const std::string &name,
+                             const KeyValueIntervals &data,
+                             const QueryLog &query_log,
+                             int repeats)
+  {
+    const interval_dict::IntervalDictAILExp<int, int, Interval> dict (data);
+    const auto costs = sweep_tuning (
+      dict, sample_queries (query_log, 10'000), TuningGrid {}, repeats);
+    std::cerr << name << "\n";
+    write_tuning_costs (std::cerr, costs);
+    return costs.empty () ? dict.tuning () : costs.front ().tuning;
+  }
+
+} // namespace benchmark
+
+int main (int argc, char *argv[])
+{
+  using namespace benchmark;
+
+  const int repeats = argc > 3 ? std::stoi (argv[3]) : 5;
+  if (argc > 1)
+  {
+    const std::string data_path = argv[1];
+    std::ifstream data_file (data_path);
+    if (!data_file)
+    {
+      std::cerr << "Unable to read " << data_path << "\n";
+      return 1;
+    }
+    const auto data = read_data (data_file);
+
+    QueryLog query_log;
+    if (argc > 2)
+    {
+      std::ifstream query_log_file (argv[2]);
+      if (!query_log_file)
+      {
+        std::cerr << "Unable to read " << argv[2] << "\n";
+        return 1;
+      }
+      query_log = read_query_log (query_log_file);
+    }
+    else
+    {
+      query_log = default_query_log (data);
+    }
+
+    std::ofstream output (data_path + ".tuning");
+    output << best_tuning (data_path, data, query_log, repeats) << "\n";
+    return output ? 0 : 1;
+  }
+
+  for (const auto &workload : all_workloads ())
+  {
+    const auto data = workload.generate (20'000);
+    std::cout << workload.name << "\t"
+              << best_tuning (
+                   workload.name, data, default_query_log (data), repeats)
+              << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,278 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file fuzz_interval_dict.cpp
+/// \brief Differential fuzzing of the IntervalDict implementations
+///
+/// Replays the same random streams of operations against each implementation
+/// and checks that disjoint_intervals() agrees after every operation.
+/// Failing cases are shrunk to a minimal sequence of operations and printed
+/// as C++ that can be pasted into a test.
+///
+/// The time taken by each operation is recorded per implementation. If a
+/// baseline from a previous run is given, operations that are slower by more
+/// than the threshold are reported.
+///
+/// Usage:
+///     fuzz_interval_dict [iterations=1000] [seed=1] [timings.json]
+///                        [baseline.json] [threshold=0.25]
+///
+/// The exit status is non-zero for any discrepancy or timing regression.
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "../benchmarks/benchmark_utils.h"
+#include "fuzz_operations.h"
+
+#include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicthybrid.h>
+#include <interval_dict/intervaldicticl.h>
+#include <interval_dict/intervaldictitree.h>
+#include <interval_dict/intervaldictpartitioned.h>
+#include <interval_dict/intervaldicttimeline.h>
+
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+
+namespace fuzz
+{
+  using OperationTimings = std::map<OperationType, benchmark::Timings>;
+
+  /// State after each operation, or the error that stopped the replay
+  struct Replay
+  {
+    std::vector<Snapshot> snapshots;
+    std::string error;
+  };
+
+  /// Apply @p operations in turn, taking a snapshot after each
+  /// Optionally records how long each operation took.
+  template<typename Dict>
+  Replay replay (const Operations &operations, OperationTimings *timings)
+  {
+    Replay results;
+    Dict dict;
+    try
+    {
+      for (const auto &op : operations)
+      {
+        const auto start = std::chrono::steady_clock::now ();
+        apply (dict, op);
+        const auto stop = std::chrono::steady_clock::now ();
+        if (timings)
+        {
+          (*timings)[op.type].nanoseconds.push_back (
+            std::chrono::duration_cast<std::chrono::nanoseconds> (stop - start)
+              .count ());
+        }
+        results.snapshots.push_back (snapshot (dict));
+      }
+    }
+    catch (const std::exception &e)
+    {
+      results.error = e.what ();
+    }
+    return results;
+  }
+
+  /// One implementation under test
+  struct Backend
+  {
+    std::string name;
+    Replay (*replay) (const Operations &, OperationTimings *);
+    OperationTimings timings;
+  };
+
+  /// Where implementations first disagree
+  struct Discrepancy
+  {
+    std::size_t index;
+    std::string backend;
+    std::string expected;
+    std::string actual;
+  };
+
+  /// Replay @p operations on all @p backends and compare each with the first
+  /// \return The first operation after which implementations disagree
+  inline std::optional<Discrepancy>
+  first_discrepancy (std::vector<Backend> &backends,
+                     const Operations &operations,
+                     bool record_timings = false)
+  {
+    std::vector<Replay> replays;
+    for (auto &backend : backends)
+    {
+      replays.push_back (backend.replay (
+        operations, record_timings ? &backend.timings : nullptr));
+    }
+
+    const auto describe = [] (const Replay &replay, std::size_t i)
+    {
+      if (i < replay.snapshots.size ())
+      {
+        std::ostringstream os;
+        os << replay.snapshots[i];
+        return os.str ();
+      }
+      return "    exception: " + replay.error + "\n";
+    };
+
+    for (std::size_t i = 0; i < operations.size (); ++i)
+    {
+      for (std::size_t b = 1; b < backends.size (); ++b)
+      {
+        const auto expected = describe (replays[0], i);
+        const auto actual = describe (replays[b], i);
+        if (expected != actual)
+        {
+          return Discrepancy {i, backends[b].name, expected, actual};
+        }
+      }
+    }
+    return {};
+  }
+
+  /// Reduce a failing sequence of operations to one that still fails but from
+  /// which no single chunk of operations can be removed (delta debugging)
+  inline Operations shrink (std::vector<Backend> &backends,
+                            Operations operations)
+  {
+    // Operations after the first discrepancy are irrelevant
+    operations.resize (first_discrepancy (backends, operations)->index + 1);
+
+    std::size_t count_chunks = 2;
+    while (operations.size () >= 2)
+    {
+      const auto chunk_size
+        = (operations.size () + count_chunks - 1) / count_chunks;
+      bool reduced = false;
+      for (std::size_t begin = 0; begin < operations.size ();
+           begin += chunk_size)
+      {
+        Operations candidate (operations.begin (),
+                              operations.begin () + begin);
+        candidate.insert (
+          candidate.end (),
+          operations.begin ()
+            + std::min (begin + chunk_size, operations.size ()),
+          operations.end ());
+        if (const auto discrepancy = first_discrepancy (backends, candidate))
+        {
+          candidate.resize (discrepancy->index + 1);
+          operations = candidate;
+          count_chunks = std::max<std::size_t> (count_chunks - 1, 2);
+          reduced = true;
+          break;
+        }
+      }
+      if (!reduced)
+      {
+        if (count_chunks >= operations.size ())
+        {
+          break;
+        }
+        count_chunks = std::min (operations.size (), count_chunks * 2);
+      }
+    }
+    return operations;
+  }
+
+} // namespace fuzz
+
+int main (int argc, char *argv[])
+{
+  using namespace fuzz;
+  using namespace interval_dict;
+
+  const int iterations = argc > 1 ? std::stoi (argv[1]) : 1000;
+  const auto seed
+    = argc > 2 ? static_cast<std::mt19937::result_type> (std::stoul (argv[2]))
+               : 1u;
+  const int operations_per_case = 50;
+
+  std::vector<Backend> backends {
+    {"IntervalDictICL", replay<IntervalDictICLExp<int, int, Interval>>, {}},
+    {"IntervalDictITree", replay<IntervalDictITreeExp<int, int, Interval>>, {}},
+    {"IntervalDictAIL", replay<IntervalDictAILExp<int, int, Interval>>, {}},
+    {"IntervalDictHybrid",
+     replay<IntervalDictHybridExp<int, int, Interval>>,
+     {}},
+    {"IntervalDictTimeline",
+     replay<IntervalDictTimelineExp<int, int, Interval>>,
+     {}},
+    {"IntervalDictPartitionedAIL",
+     replay<IntervalDictPartitionedAILExp<int, int, Interval>>,
+     {}},
+  };
+
+  OperationGenerator generate (seed);
+  for (int iteration = 0; iteration < iterations; ++iteration)
+  {
+    const auto operations = generate (operations_per_case);
+    if (!first_discrepancy (backends, operations, true))
+    {
+      continue;
+    }
+
+    const auto minimal = shrink (backends, operations);
+    const auto discrepancy = *first_discrepancy (backends, minimal);
+    std::cerr << "Discrepancy in iteration " << iteration << " (seed " << seed
+              << ") after " << minimal.size () << " operations:\n";
+    for (const auto &op : minimal)
+    {
+      std::cerr << "    " << op << "\n";
+    }
+    std::cerr << backends[0].name << ":\n"
+              << discrepancy.expected << discrepancy.backend << ":\n"
+              << discrepancy.actual;
+    return 1;
+  }
+  std::cerr << iterations << " x " << operations_per_case
+            << " operations: no discrepancies\n";
+
+  std::vector<benchmark::Result> results;
+  for (const auto &backend : backends)
+  {
+    for (const auto &[operation_type, timings] : backend.timings)
+    {
+      results.push_back ({"fuzz",
+                          backend.name,
+                          name (operation_type),
+                          timings.nanoseconds.size (),
+                          timings});
+    }
+  }
+
+  if (argc > 3)
+  {
+    std::ofstream output (argv[3]);
+    benchmark::write_json (output, results);
+  }
+
+  if (argc > 4)
+  {
+    std::ifstream baseline_file (argv[4]);
+    const double threshold = argc > 5 ? std::stod (argv[5]) : 0.25;
+    if (benchmark::flag_regressions (std::cerr,
+                                     results,
+                                     benchmark::read_baseline (baseline_file),
+                                     threshold))
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,311 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file fuzz_operations.h
+/// \brief Random streams of operations that can be replayed against any
+/// IntervalDict implementation
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef FUZZ_FUZZ_OPERATIONS_H
+#define FUZZ_FUZZ_OPERATIONS_H
+
+#include <interval_dict/adaptor.h>
+#include <interval_dict/intervaldict.h>
+
+#include <boost/icl/interval.hpp>
+
+#include <array>
+#include <ostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace fuzz
+{
+  using Interval = boost::icl::right_open_interval<int>;
+
+  /// Every mutating operation that should behave identically whatever the
+  /// implementation
+  enum class OperationType
+  {
+    Insert,
+    EraseValue,
+    EraseKey,
+    EraseInterval,
+    FillGaps,
+    ExtendIntoGaps,
+    FillToStart,
+    FillToEnd,
+    Flatten,
+    Merge,
+    Subtract,
+  };
+
+  constexpr std::array all_operation_types {OperationType::Insert,
+                                            OperationType::EraseValue,
+                                            OperationType::EraseKey,
+                                            OperationType::EraseInterval,
+                                            OperationType::FillGaps,
+                                            OperationType::ExtendIntoGaps,
+                                            OperationType::FillToStart,
+                                            OperationType::FillToEnd,
+                                            OperationType::Flatten,
+                                            OperationType::Merge,
+                                            OperationType::Subtract};
+
+  inline std::string name (OperationType operation_type)
+  {
+    switch (operation_type)
+    {
+    case OperationType::Insert:
+      return "insert";
+    case OperationType::EraseValue:
+      return "erase_value";
+    case OperationType::EraseKey:
+      return "erase_key";
+    case OperationType::EraseInterval:
+      return "erase_interval";
+    case OperationType::FillGaps:
+      return "fill_gaps";
+    case OperationType::ExtendIntoGaps:
+      return "extend_into_gaps";
+    case OperationType::FillToStart:
+      return "fill_to_start";
+    case OperationType::FillToEnd:
+      return "fill_to_end";
+    case OperationType::Flatten:
+      return "flatten";
+    case OperationType::Merge:
+      return "merge";
+    case OperationType::Subtract:
+      return "subtract";
+    }
+    return "unknown";
+  }
+
+  /// A single operation and its arguments.
+  /// Arguments not used by an operation type are ignored.
+  struct Operation
+  {
+    OperationType type;
+    int key;
+    int value;
+    Interval interval;
+    int extension;
+    /// Contents of the other dictionary for Merge and Subtract
+    std::vector<std::tuple<int, int, Interval>> others;
+  };
+
+  using Operations = std::vector<Operation>;
+
+  inline std::string to_string (const Interval &interval)
+  {
+    return "Interval {" + std::to_string (interval.lower ()) + ", "
+           + std::to_string (interval.upper ()) + "}";
+  }
+
+  inline std::string
+  to_string (const std::vector<std::tuple<int, int, Interval>> &others)
+  {
+    std::string result = "decltype (dict) ({";
+    for (std::size_t i = 0; i < others.size (); ++i)
+    {
+      const auto &[key, value, interval] = others[i];
+      result += (i ? ", {" : "{") + std::to_string (key) + ", "
+                + std::to_string (value) + ", " + to_string (interval) + "}";
+    }
+    return result + "})";
+  }
+
+  /// Print as C++ that can be pasted into a test case
+  inline std::ostream &operator<< (std::ostream &os, const Operation &op)
+  {
+    const auto interval = to_string (op.interval);
+    switch (op.type)
+    {
+    case OperationType::Insert:
+      return os << "dict.insert ({{" << op.key << ", " << op.value << ", "
+                << interval << "}});";
+    case OperationType::EraseValue:
+      return os << "dict.erase ({{" << op.key << ", " << op.value << ", "
+                << interval << "}});";
+    case OperationType::EraseKey:
+      return os << "dict.erase (" << op.key << ", " << interval << ");";
+    case OperationType::EraseInterval:
+      return os << "dict.erase (" << interval << ");";
+    case OperationType::FillGaps:
+      return os << "dict.fill_gaps (" << op.extension << ");";
+    case OperationType::ExtendIntoGaps:
+      return os << "dict.extend_into_gaps (GapExtensionDirection::Both, "
+                << op.extension << ");";
+    case OperationType::FillToStart:
+      return os << "dict.fill_to_start (" << op.interval.upper () << ", "
+                << op.extension << ");";
+    case OperationType::FillToEnd:
+      return os << "dict.fill_to_end (" << op.interval.lower () << ", "
+                << op.extension << ");";
+    case OperationType::Flatten:
+      return os << "dict = flattened (dict);";
+    case OperationType::Merge:
+      return os << "dict += " << to_string (op.others) << ";";
+    case OperationType::Subtract:
+      return os << "dict -= " << to_string (op.others) << ";";
+    }
+    return os;
+  }
+
+  /// Generates operations over a small domain of keys, values and interval
+  /// edges so that operations frequently collide
+  class OperationGenerator
+  {
+    public:
+    explicit OperationGenerator (std::mt19937::result_type seed)
+      : m_generator (seed)
+    {
+    }
+
+    Operation operator() ()
+    {
+      // Mostly inserts and erases: otherwise dictionaries stay too small
+      const auto roll
+        = std::uniform_int_distribution<int> (0, 99) (m_generator);
+      OperationType type;
+      if (roll < 50)
+      {
+        type = OperationType::Insert;
+      }
+      else if (roll < 70)
+      {
+        type = OperationType::EraseValue;
+      }
+      else
+      {
+        type = all_operation_types[std::uniform_int_distribution<int> (
+          2, all_operation_types.size () - 1) (m_generator)];
+      }
+      const int lower = m_edge (m_generator);
+      Operation operation {type,
+                           m_key (m_generator),
+                           m_value (m_generator),
+                           Interval {lower, lower + m_length (m_generator)},
+                           m_length (m_generator),
+                           {}};
+      if (type == OperationType::Merge || type == OperationType::Subtract)
+      {
+        // Large enough relative to the dictionary to rebuild it wholesale
+        const auto count_others = m_count_others (m_generator);
+        for (int i = 0; i < count_others; ++i)
+        {
+          const int other_lower = m_edge (m_generator);
+          operation.others.emplace_back (
+            m_key (m_generator),
+            m_value (m_generator),
+            Interval {other_lower, other_lower + m_length (m_generator)});
+        }
+      }
+      return operation;
+    }
+
+    Operations operator() (int count)
+    {
+      Operations operations;
+      for (int i = 0; i < count; ++i)
+      {
+        operations.push_back ((*this) ());
+      }
+      return operations;
+    }
+
+    private:
+    std::mt19937 m_generator;
+    std::uniform_int_distribution<int> m_key {0, 3};
+    std::uniform_int_distribution<int> m_value {0, 5};
+    std::uniform_int_distribution<int> m_edge {0, 60};
+    std::uniform_int_distribution<int> m_length {1, 15};
+    std::uniform_int_distribution<int> m_count_others {1, 40};
+  };
+
+  /// Apply a single operation to an interval dictionary
+  template<typename Dict>
+  void apply (Dict &dict, const Operation &op)
+  {
+    using interval_dict::GapExtensionDirection;
+    switch (op.type)
+    {
+    case OperationType::Insert:
+      dict.insert ({{op.key, op.value, op.interval}});
+      break;
+    case OperationType::EraseValue:
+      dict.erase ({{op.key, op.value, op.interval}});
+      break;
+    case OperationType::EraseKey:
+      dict.erase (op.key, op.interval);
+      break;
+    case OperationType::EraseInterval:
+      dict.erase (op.interval);
+      break;
+    case OperationType::FillGaps:
+      dict.fill_gaps (op.extension);
+      break;
+    case OperationType::ExtendIntoGaps:
+      dict.extend_into_gaps (GapExtensionDirection::Both, op.extension);
+      break;
+    case OperationType::FillToStart:
+      dict.fill_to_start (op.interval.upper (), op.extension);
+      break;
+    case OperationType::FillToEnd:
+      dict.fill_to_end (op.interval.lower (), op.extension);
+      break;
+    case OperationType::Flatten:
+      dict = flattened (dict);
+      break;
+    case OperationType::Merge:
+      dict += Dict (op.others);
+      break;
+    case OperationType::Subtract:
+      dict -= Dict (op.others);
+      break;
+    }
+  }
+
+  /// Observable state of a dictionary: what every implementation must agree on
+  using Snapshot = std::vector<
+    interval_dict::KeyValuesDisjointInterval<int, int, Interval>>;
+
+  template<typename Dict>
+  Snapshot snapshot (const Dict &dict)
+  {
+    Snapshot results;
+    for (const auto &key_values_interval : disjoint_intervals (dict))
+    {
+      results.push_back (key_values_interval);
+    }
+    return results;
+  }
+
+  inline std::ostream &operator<< (std::ostream &os, const Snapshot &snapshot)
+  {
+    for (const auto &[key, values, interval] : snapshot)
+    {
+      os << "    " << key << "\t[";
+      for (std::size_t i = 0; i < values.size (); ++i)
+      {
+        os << (i ? ", " : "") << values[i];
+      }
+      os << "]\t" << interval << "\n";
+    }
+    return os;
+  }
+
+} // namespace fuzz
+
+#endif // FUZZ_FUZZ_OPERATIONS_H
@@ -17,15 +17,27 @@
 #ifndef INCLUDE_INTERVAL_DICT_ADAPTOR_H
 #define INCLUDE_INTERVAL_DICT_ADAPTOR_H
 
+#include "instrumentation.h"
 #include "interval_traits.h"
+#include "memory_usage.h"
+#include "query_explain.h"
 #include "value_interval.h"
 
 #include <boost/icl/interval_map.hpp>
 #include <cppcoro/generator.hpp>
+
+#include <cstdint>
+#include <memory>
 #include <ranges>
 
 namespace interval_dict
 {
+  /// Tuning parameters for implementations that have none
+  struct NoTuning
+  {
+    auto operator<=> (const NoTuning &) const = default;
+  };
+
   ///  Abstract trait definition to implement IntervalDict
   template<typename Value, typename Interval, typename Impl>
   struct Implementation
@@ -46,6 +58,13 @@ namespace interval_dict
       using type = void;
     };
 
+    /// Allocator for the interval-values of each key. IntervalDictExp
+    /// rebinds it to hold its keys, so that an allocator-aware
+    /// implementation such as augmented_interval_list::AugmentedIntervalList
+    /// with a std::pmr::polymorphic_allocator places all its storage in the
+    /// same memory resource
+    using Allocator = std::allocator<ValueInterval<Value, Interval>>;
+
     /// @return coroutine enumerating gaps between intervals and the values on
     /// either side
     static SandwichedGaps<Value, Interval> sandwiched_gaps (const Impl &);
@@ -87,6 +106,40 @@ namespace interval_dict
     /// @return the asymmetrical difference with another set of
     /// interval-values
     static Impl &subtract_by (Impl &, const Impl &);
+
+    /// record the work done by a query over @p query_interval in @p explain
+    static void explain (const Impl &, const Interval &, QueryExplain &explain);
+
+    /// @return bytes used by the interval-values
+    static MemoryUsage memory_usage (const Impl &);
+
+    /// release unused capacity
+    static void shrink_to_fit (Impl &);
+
+    /// Parameters shared by all keys of a dictionary for tuning the
+    /// implementation
+    using Tuning = NoTuning;
+
+    /// apply @p tuning
+    static void tune (Impl &, const Tuning &tuning);
+
+    /// @return whether pending changes should be integrated by compact()
+    static bool needs_compaction (const Impl &);
+
+    /// integrate pending changes
+    static void compact (Impl &);
+
+    /// @return a value that changes whenever the interval-values are
+    /// modified. Used to detect writes during background compaction
+    static std::uint64_t generation (const Impl &);
+
+#ifdef INTERVAL_DICT_STATS
+    /// add internal statistics to @p stats
+    static void collect_stats (const Impl &, instrumentation::Stats &stats);
+
+    /// zero internal statistics
+    static void reset_stats (Impl &);
+#endif
   };
 
 } // namespace interval_dict
@@ -28,6 +28,8 @@
 
 #include <cppcoro/generator.hpp>
 
+#include <memory>
+#include <memory_resource>
 #include <ranges>
 
 namespace interval_dict
@@ -43,15 +45,28 @@ namespace interval_dict
   {
     /// boost icl interval_map associating each Interval with a std::set of
     /// values
-    template<typename Value, typename Interval>
+    template<typename Value,
+             typename Interval,
+             typename Allocator
+             = std::allocator<ValueInterval<Value, Interval>>>
     using AugmentedIntervalList
-      = augmented_interval_list::AugmentedIntervalList<Value, Interval>;
+      = augmented_interval_list::AugmentedIntervalList<Value,
+                                                       Interval,
+                                                       Allocator>;
+
+    /// Augmented Interval List allocating from a std::pmr::memory_resource
+    template<typename Value, typename Interval>
+    using PmrAugmentedIntervalList = AugmentedIntervalList<
+      Value,
+      Interval,
+      std::pmr::polymorphic_allocator<ValueInterval<Value, Interval>>>;
   } // namespace implementation
 
   template<typename Impl, typename Value, typename Interval>
   concept AugmentedIntervalListConcept
-    = std::is_same_v<Impl,
-                     implementation::AugmentedIntervalList<Value, Interval>>;
+    = augmented_interval_list::IsAugmentedIntervalList<Impl>::value
+      && std::is_same_v<typename Impl::ValueIntervalType,
+                        ValueInterval<Value, Interval>>;
 
   template<typename Value,
            typename Interval,
@@ -71,9 +86,16 @@ namespace interval_dict
     struct rebind
     {
       /// Holds type of the implementation in the inverse() direction
-      using type = implementation::AugmentedIntervalList<NewVal, Interval>;
+      using type = implementation::AugmentedIntervalList<
+        NewVal,
+        Interval,
+        typename std::allocator_traits<typename Impl::allocator_type>::
+          template rebind_alloc<ValueInterval<NewVal, Interval>>>;
     };
 
+    /// Allocator for the interval-values of each key
+    using Allocator = typename Impl::allocator_type;
+
     /*
      * _____________________________________________________________________________
      *
@@ -168,6 +190,68 @@ namespace interval_dict
       assert (!interval_values.empty ());
       return interval_values.final_values ();
     }
+
+    /// record the work done by a query over @p query_interval in @p explain
+    static void explain (const Impl &interval_values,
+                         const Interval &query_interval,
+                         QueryExplain &explain)
+    {
+      interval_values.explain (query_interval, explain);
+    }
+
+    /// @return bytes used by the interval-values
+    static MemoryUsage memory_usage (const Impl &interval_values)
+    {
+      return interval_values.memory_usage ();
+    }
+
+    /// release unused capacity
+    static void shrink_to_fit (Impl &interval_values)
+    {
+      interval_values.shrink_to_fit ();
+    }
+
+    /// Parameters for decomposing intervals into runs
+    using Tuning = augmented_interval_list::Tuning;
+
+    /// apply @p tuning, rebuilding runs if it has changed
+    static void tune (Impl &interval_values, const Tuning &tuning)
+    {
+      interval_values.tune (tuning);
+    }
+
+    /// @return whether the compaction policy calls for a rebuild
+    static bool needs_compaction (const Impl &interval_values)
+    {
+      return interval_values.needs_compaction ();
+    }
+
+    /// rebuild runs, removing tombstones and integrating pending inserts
+    static void compact (Impl &interval_values)
+    {
+      interval_values.compact ();
+    }
+
+    /// @return a value that changes whenever the interval-values are modified
+    static std::uint64_t generation (const Impl &interval_values)
+    {
+      return interval_values.generation ();
+    }
+
+#ifdef INTERVAL_DICT_STATS
+    /// add internal statistics to @p stats
+    static void collect_stats (const Impl &interval_values,
+                               instrumentation::Stats &stats)
+    {
+      interval_values.collect_stats (stats);
+    }
+
+    /// zero internal statistics
+    static void reset_stats (Impl &interval_values)
+    {
+      interval_values.reset_stats ();
+    }
+#endif
   };
 
 } // namespace interval_dict
@@ -0,0 +1,236 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file adaptor_hybrid.h
+/// \brief Definitions of functions to implement IntervalDict with
+/// HybridIntervalList
+//
+// Keys with few intervals are held in a small vector, and the rest in an
+// Augmented Interval List (or any other implementation)
+//
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_ADAPTOR_HYBRID_H
+#define INCLUDE_INTERVAL_DICT_ADAPTOR_HYBRID_H
+
+#include "adaptor.h"
+#include "adaptor_ail.h"
+#include "hybrid_interval_list.h"
+#include "interval_traits.h"
+#include "value_interval.h"
+
+#include <cppcoro/generator.hpp>
+
+namespace interval_dict
+{
+  /*
+   * _____________________________________________________________________________
+   *
+   * Functions to handle hybrid::HybridIntervalList
+   *
+   */
+
+  namespace implementation
+  {
+    /// Small vector of interval-values for each key, promoted to an
+    /// Augmented Interval List when it grows
+    template<typename Value, typename Interval>
+    using HybridIntervalList = hybrid::HybridIntervalList<
+      Value,
+      Interval,
+      augmented_interval_list::AugmentedIntervalList<Value, Interval>>;
+  } // namespace implementation
+
+  template<typename Impl, typename Value, typename Interval>
+  concept HybridIntervalListConcept
+    = hybrid::IsHybridIntervalList<Impl>::value
+      && std::is_same_v<typename Impl::ValueIntervalType,
+                        ValueInterval<Value, Interval>>;
+
+  template<typename Value,
+           typename Interval,
+           HybridIntervalListConcept<Value, Interval> Impl>
+  struct Implementation<Value, Interval, Impl>
+  {
+    /// Type manipulating function for obtaining the same implementation
+    /// underlying an IntervalDict that uses the same Interval but "rebased"
+    /// with a new Value type.
+    ///
+    /// The return type is `::type` as per C++ convention.
+    ///
+    /// The Large implementation is rebased as well, and the thresholds
+    /// kept the same.
+    template<typename NewVal>
+    struct rebind
+    {
+      /// Holds type of the implementation in the inverse() direction
+      using type = hybrid::HybridIntervalList<
+        NewVal,
+        Interval,
+        typename Impl::LargeImplementation::template rebind<NewVal>::type,
+        Impl::max_small>;
+    };
+
+    /// Allocator for the interval-values of each key. Always the global heap
+    using Allocator = std::allocator<ValueInterval<Value, Interval>>;
+
+    /// @return coroutine enumerating gaps between intervals
+    static cppcoro::generator<Interval> gaps (const Impl &interval_values)
+    {
+      return interval_values.gaps ();
+    }
+
+    /// @return coroutine enumerating gaps between intervals and the values on
+    /// either side
+    static SandwichedGaps<Value, Interval>
+    sandwiched_gaps (const Impl &interval_values)
+    {
+      return interval_values.sandwiched_gaps ();
+    }
+
+    /// erase @p value for @p query_interval
+    static void erase (Impl &interval_values,
+                       const Interval &query_interval,
+                       const Value &value)
+    {
+      interval_values.erase (query_interval, value);
+    }
+
+    /// erase all values for @p query_interval
+    static void erase (Impl &interval_values, const Interval &query_interval)
+    {
+      interval_values.erase (query_interval);
+    }
+
+    /// insert @p value for @p query_interval
+    static void insert (Impl &interval_values,
+                        const Interval &query_interval,
+                        const Value &value)
+    {
+      interval_values.insert (query_interval, value);
+    }
+
+    /// @return coroutine enumerating all interval/values over @p query_interval
+    static cppcoro::generator<ValueInterval<Value, Interval>>
+    intervals (const Impl &interval_values, const Interval &query_interval)
+    {
+      return interval_values.intervals (query_interval);
+    }
+
+    /// @return coroutine enumerating all disjoint interval/values over @p
+    /// query_interval
+    static cppcoro::generator<ValuesDisjointInterval<Value, Interval>>
+    disjoint_intervals (const Impl &interval_values,
+                        const Interval &query_interval)
+    {
+      return interval_values.disjoint_intervals (query_interval);
+    }
+
+    /// @return whether there are no values
+    static bool empty (const Impl &interval_values)
+    {
+      return interval_values.empty ();
+    }
+
+    /// @return the union with another set of interval-values
+    static Impl &merged_with (Impl &interval_values, const Impl &other)
+    {
+      return interval_values.merged_with (other);
+    }
+
+    /// @return the asymmetrical difference with another set of
+    /// interval-values
+    static Impl &subtract_by (Impl &interval_values, const Impl &other)
+    {
+      return interval_values.subtract_by (other);
+    }
+
+    /// @return first disjoint interval (with one or more values)
+    static ValuesDisjointInterval<Value, Interval>
+    initial_values (const Impl &interval_values)
+    {
+      assert (!interval_values.empty ());
+      return interval_values.initial_values ();
+    }
+
+    /// @return last disjoint interval (with one or more values)
+    static ValuesDisjointInterval<Value, Interval>
+    final_values (const Impl &interval_values)
+    {
+      assert (!interval_values.empty ());
+      return interval_values.final_values ();
+    }
+
+    /// record the work done by a query over @p query_interval in @p explain
+    static void explain (const Impl &interval_values,
+                         const Interval &query_interval,
+                         QueryExplain &explain)
+    {
+      interval_values.explain (query_interval, explain);
+    }
+
+    /// @return bytes used by the interval-values
+    static MemoryUsage memory_usage (const Impl &interval_values)
+    {
+      return interval_values.memory_usage ();
+    }
+
+    /// release unused capacity and demote keys with few intervals
+    static void shrink_to_fit (Impl &interval_values)
+    {
+      interval_values.shrink_to_fit ();
+    }
+
+    /// Thresholds are compile time parameters of HybridIntervalList
+    using Tuning = NoTuning;
+
+    /// apply @p tuning
+    static void tune (Impl &, const Tuning &)
+    {
+    }
+
+    /// @return whether the Large implementation has pending changes to
+    /// integrate
+    static bool needs_compaction (const Impl &interval_values)
+    {
+      return interval_values.needs_compaction ();
+    }
+
+    /// integrate pending changes in the Large implementation
+    static void compact (Impl &interval_values)
+    {
+      interval_values.compact ();
+    }
+
+    /// @return a value that changes whenever the interval-values are modified
+    static std::uint64_t generation (const Impl &interval_values)
+    {
+      return interval_values.generation ();
+    }
+
+#ifdef INTERVAL_DICT_STATS
+    /// add internal statistics to @p stats
+    static void collect_stats (const Impl &interval_values,
+                               instrumentation::Stats &stats)
+    {
+      interval_values.collect_stats (stats);
+    }
+
+    /// zero internal statistics
+    static void reset_stats (Impl &interval_values)
+    {
+      interval_values.reset_stats ();
+    }
+#endif
+  };
+
+} // namespace interval_dict
+#endif // INCLUDE_INTERVAL_DICT_ADAPTOR_HYBRID_H
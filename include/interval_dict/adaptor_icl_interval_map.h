@@ -79,6 +79,9 @@ namespace interval_dict
       using type = implementation::IntervalDictICLSubMap<NewVal, Interval>;
     };
 
+    /// Allocator for the interval-values of each key. Always the global heap
+    using Allocator = std::allocator<ValueInterval<Value, Interval>>;
+
     /*
      * _____________________________________________________________________________
      *
@@ -110,7 +113,7 @@ namespace interval_dict
     /// either side
     static SandwichedGaps<Value, Interval> sandwiched_gaps (const Impl &impl)
     {
-      using legacy_ranges_conversion::to_vector;
+      using interval_dict::details::to_segment_values;
       SandwichedGaps<Value, Interval> results;
       // Need two intervals for gaps between disjoint intervals
       if (impl.iterative_size () >= 2)
@@ -126,9 +129,9 @@ namespace interval_dict
           {
             /*Previously used coroutines here (co_yield) for efficiency*/
             results.push_back (
-              {first->second | to_vector (),
+              {to_segment_values (first->second),
                boost::icl::inner_complement (first->first, next->first),
-               next->second | to_vector ()});
+               to_segment_values (next->second)});
           }
         }
       }
@@ -205,8 +208,8 @@ namespace interval_dict
            std::ranges::subrange (itpair.first, itpair.second))
       {
         const auto intersection = query_interval & interval;
-        using namespace legacy_ranges_conversion;
-        co_yield ValuesDisjointInterval {values | to_vector (), intersection};
+        co_yield ValuesDisjointInterval {
+          interval_dict::details::to_segment_values (values), intersection};
       }
     }
 
@@ -238,7 +241,8 @@ namespace interval_dict
     {
       assert (impl.iterative_size () > 0);
       const auto it = impl.begin ();
-      return {it->second | legacy_ranges_conversion::to_vector (), it->first};
+      return {interval_dict::details::to_segment_values (it->second),
+              it->first};
     }
 
     /// @return last disjoint interval (with one or more values)
@@ -247,8 +251,84 @@ namespace interval_dict
     {
       assert (impl.iterative_size ());
       const auto it = impl.rbegin ();
-      return {it->second | legacy_ranges_conversion::to_vector (), it->first};
+      return {interval_dict::details::to_segment_values (it->second),
+              it->first};
+    }
+
+    /// record the work done by a query over @p query_interval in @p explain
+    static void explain (const Impl &impl,
+                         const Interval &query_interval,
+                         QueryExplain &explain)
+    {
+      explain.backend = "icl interval_map";
+      const auto itpair = impl.equal_range (query_interval);
+      for (const auto &[interval, values] :
+           std::ranges::subrange (itpair.first, itpair.second))
+      {
+        ++explain.segments_touched;
+        explain.count_matched += values.size ();
+      }
+    }
+
+    /// @return bytes used by the interval-values
+    static MemoryUsage memory_usage (const Impl &impl)
+    {
+      // Each disjoint interval is a std::map node holding a std::set of values
+      MemoryUsage usage;
+      for (const auto &[interval, values] : impl)
+      {
+        usage.bytes_intervals
+          += sizeof (Interval) + values.size () * sizeof (Value);
+        usage.bytes_nodes += details::rb_tree_node_links
+                             + sizeof (typename Impl::codomain_type)
+                             + values.size () * details::rb_tree_node_links;
+      }
+      return usage;
+    }
+
+    /// release unused capacity: boost::icl is node-based and has none
+    static void shrink_to_fit (Impl &)
+    {
+    }
+
+    /// boost::icl has no tuning parameters
+    using Tuning = NoTuning;
+
+    /// apply @p tuning
+    static void tune (Impl &, const Tuning &)
+    {
+    }
+
+    /// @return false: there are never pending changes
+    static bool needs_compaction (const Impl &)
+    {
+      return false;
+    }
+
+    /// integrate pending changes: none
+    static void compact (Impl &)
+    {
+    }
+
+    /// @return 0: never compacted so never needs to be checked
+    static std::uint64_t generation (const Impl &)
+    {
+      return 0;
+    }
+
+#ifdef INTERVAL_DICT_STATS
+    /// add internal statistics to @p stats
+    static void collect_stats (const Impl &impl, instrumentation::Stats &stats)
+    {
+      // Disjoint intervals each with a set of values
+      stats.count_intervals += impl.iterative_size ();
+    }
+
+    /// zero internal statistics: boost::icl keeps none
+    static void reset_stats (Impl &)
+    {
     }
+#endif
   };
 
 } // namespace interval_dict
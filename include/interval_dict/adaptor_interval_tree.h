@@ -69,6 +69,9 @@ namespace interval_dict
       using type = implementation::IntervalTree<NewVal, Interval>;
     };
 
+    /// Allocator for the interval-values of each key. Always the global heap
+    using Allocator = std::allocator<ValueInterval<Value, Interval>>;
+
     /*
      * _____________________________________________________________________________
      *
@@ -154,6 +157,65 @@ namespace interval_dict
     {
       return impl.subtract_by (other);
     }
+
+    /// record the work done by a query over @p query_interval in @p explain
+    static void explain (const Impl &impl,
+                         const Interval &query_interval,
+                         QueryExplain &explain)
+    {
+      impl.explain (query_interval, explain);
+    }
+
+    /// @return bytes used by the interval-values
+    static MemoryUsage memory_usage (const Impl &impl)
+    {
+      return impl.memory_usage ();
+    }
+
+    /// release unused capacity
+    static void shrink_to_fit (Impl &impl)
+    {
+      impl.shrink_to_fit ();
+    }
+
+    /// IntervalTree has no tuning parameters
+    using Tuning = NoTuning;
+
+    /// apply @p tuning
+    static void tune (Impl &, const Tuning &)
+    {
+    }
+
+    /// @return false: there are never pending changes
+    static bool needs_compaction (const Impl &)
+    {
+      return false;
+    }
+
+    /// integrate pending changes: none
+    static void compact (Impl &)
+    {
+    }
+
+    /// @return 0: never compacted so never needs to be checked
+    static std::uint64_t generation (const Impl &)
+    {
+      return 0;
+    }
+
+#ifdef INTERVAL_DICT_STATS
+    /// add internal statistics to @p stats
+    static void collect_stats (const Impl &impl, instrumentation::Stats &stats)
+    {
+      impl.collect_stats (stats);
+    }
+
+    /// zero internal statistics
+    static void reset_stats (Impl &impl)
+    {
+      impl.reset_stats ();
+    }
+#endif
   };
 
 } // namespace interval_dict
@@ -0,0 +1,222 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file adaptor_timeline.h
+/// \brief Definitions of functions to implement IntervalDict with
+/// CompressedTimeline
+//
+// The intervals for each key are held as run-length encoded points for each
+// value
+//
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_ADAPTOR_TIMELINE_H
+#define INCLUDE_INTERVAL_DICT_ADAPTOR_TIMELINE_H
+
+#include "adaptor.h"
+#include "compressed_timeline.h"
+#include "interval_traits.h"
+#include "value_interval.h"
+
+#include <cppcoro/generator.hpp>
+
+namespace interval_dict
+{
+  /*
+   * _____________________________________________________________________________
+   *
+   * Functions to handle timeline::CompressedTimeline
+   *
+   */
+
+  namespace implementation
+  {
+    /// Run-length encoded points for each value. Discrete intervals only
+    template<typename Value, typename Interval>
+    using CompressedTimeline = timeline::CompressedTimeline<Value, Interval>;
+  } // namespace implementation
+
+  template<typename Impl, typename Value, typename Interval>
+  concept CompressedTimelineConcept
+    = timeline::IsCompressedTimeline<Impl>::value
+      && std::is_same_v<typename Impl::ValueIntervalType,
+                        ValueInterval<Value, Interval>>;
+
+  template<typename Value,
+           typename Interval,
+           CompressedTimelineConcept<Value, Interval> Impl>
+  struct Implementation<Value, Interval, Impl>
+  {
+    /// Type manipulating function for obtaining the same implementation
+    /// underlying an IntervalDict that uses the same Interval but "rebased"
+    /// with a new Value type.
+    ///
+    /// The return type is `::type` as per C++ convention.
+    template<typename NewVal>
+    struct rebind
+    {
+      /// Holds type of the implementation in the inverse() direction
+      using type = timeline::CompressedTimeline<NewVal, Interval>;
+    };
+
+    /// Allocator for the interval-values of each key. Always the global heap
+    using Allocator = std::allocator<ValueInterval<Value, Interval>>;
+
+    /// @return coroutine enumerating gaps between intervals
+    static cppcoro::generator<Interval> gaps (const Impl &interval_values)
+    {
+      return interval_values.gaps ();
+    }
+
+    /// @return coroutine enumerating gaps between intervals and the values on
+    /// either side
+    static SandwichedGaps<Value, Interval>
+    sandwiched_gaps (const Impl &interval_values)
+    {
+      return interval_values.sandwiched_gaps ();
+    }
+
+    /// erase @p value for @p query_interval
+    static void erase (Impl &interval_values,
+                       const Interval &query_interval,
+                       const Value &value)
+    {
+      interval_values.erase (query_interval, value);
+    }
+
+    /// erase all values for @p query_interval
+    static void erase (Impl &interval_values, const Interval &query_interval)
+    {
+      interval_values.erase (query_interval);
+    }
+
+    /// insert @p value for @p query_interval
+    static void insert (Impl &interval_values,
+                        const Interval &query_interval,
+                        const Value &value)
+    {
+      interval_values.insert (query_interval, value);
+    }
+
+    /// @return coroutine enumerating all interval/values over @p query_interval
+    static cppcoro::generator<ValueInterval<Value, Interval>>
+    intervals (const Impl &interval_values, const Interval &query_interval)
+    {
+      return interval_values.intervals (query_interval);
+    }
+
+    /// @return coroutine enumerating all disjoint interval/values over @p
+    /// query_interval
+    static cppcoro::generator<ValuesDisjointInterval<Value, Interval>>
+    disjoint_intervals (const Impl &interval_values,
+                        const Interval &query_interval)
+    {
+      return interval_values.disjoint_intervals (query_interval);
+    }
+
+    /// @return whether there are no values
+    static bool empty (const Impl &interval_values)
+    {
+      return interval_values.empty ();
+    }
+
+    /// @return the union with another set of interval-values
+    static Impl &merged_with (Impl &interval_values, const Impl &other)
+    {
+      return interval_values.merged_with (other);
+    }
+
+    /// @return the asymmetrical difference with another set of
+    /// interval-values
+    static Impl &subtract_by (Impl &interval_values, const Impl &other)
+    {
+      return interval_values.subtract_by (other);
+    }
+
+    /// @return first disjoint interval (with one or more values)
+    static ValuesDisjointInterval<Value, Interval>
+    initial_values (const Impl &interval_values)
+    {
+      assert (!interval_values.empty ());
+      return interval_values.initial_values ();
+    }
+
+    /// @return last disjoint interval (with one or more values)
+    static ValuesDisjointInterval<Value, Interval>
+    final_values (const Impl &interval_values)
+    {
+      assert (!interval_values.empty ());
+      return interval_values.final_values ();
+    }
+
+    /// record the work done by a query over @p query_interval in @p explain
+    static void explain (const Impl &interval_values,
+                         const Interval &query_interval,
+                         QueryExplain &explain)
+    {
+      interval_values.explain (query_interval, explain);
+    }
+
+    /// @return bytes used by the interval-values
+    static MemoryUsage memory_usage (const Impl &interval_values)
+    {
+      return interval_values.memory_usage ();
+    }
+
+    /// release unused capacity
+    static void shrink_to_fit (Impl &interval_values)
+    {
+      interval_values.shrink_to_fit ();
+    }
+
+    /// No tuning parameters
+    using Tuning = NoTuning;
+
+    /// apply @p tuning
+    static void tune (Impl &, const Tuning &)
+    {
+    }
+
+    /// @return false: changes are applied immediately
+    static bool needs_compaction (const Impl &)
+    {
+      return false;
+    }
+
+    /// Nothing to compact
+    static void compact (Impl &)
+    {
+    }
+
+    /// @return 0: never compacted so no need to detect writes
+    static std::uint64_t generation (const Impl &)
+    {
+      return 0;
+    }
+
+#ifdef INTERVAL_DICT_STATS
+    /// add internal statistics to @p stats
+    static void collect_stats (const Impl &interval_values,
+                               instrumentation::Stats &stats)
+    {
+      stats.count_intervals += interval_values.count_runs ();
+      stats.count_runs += interval_values.count_runs ();
+    }
+
+    /// zero internal statistics
+    static void reset_stats (Impl &)
+    {
+    }
+#endif
+  };
+
+} // namespace interval_dict
+#endif // INCLUDE_INTERVAL_DICT_ADAPTOR_TIMELINE_H
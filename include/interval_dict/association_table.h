@@ -0,0 +1,622 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file association_table.h
+/// \brief Columnar table of key-value-interval associations, and interval
+/// indexes of its rows
+///
+/// Each association is stored once as a row of key id, value id and
+/// interval. A RowIndex holds the row ids for a single key or value, in runs
+/// sorted by lower edge like an augmented interval list, so that a
+/// dictionary can look rows up from either side without storing them twice.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_ASSOCIATION_TABLE_H
+#define INCLUDE_INTERVAL_DICT_ASSOCIATION_TABLE_H
+
+#include "interval_compare.h"
+#include "interval_traits.h"
+#include "memory_usage.h"
+
+#include <boost/icl/concept/interval.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace interval_dict::association_table
+{
+  /// Index of a row in an AssociationTable
+  using RowId = std::uint32_t;
+
+  /// Dense id standing in for a key or a value in an AssociationTable
+  using Id = std::uint32_t;
+
+  /// Number of rows covered by each maximum upper edge in a RowIndex
+  inline constexpr std::size_t rows_per_block = 32;
+
+  /**
+   * Key id, value id and interval of every association in columns.
+   *
+   * Erased rows keep their interval while any RowIndex still holds them, so
+   * that indexes can leave them in place as tombstones. Once released by
+   * every index, they are reused by later inserts, so that row ids held by
+   * indexes remain valid.
+   */
+  template<typename Interval> class AssociationTable
+  {
+    public:
+    /// Add a row, reusing an erased one if possible
+    /// \return id of the new row
+    RowId insert (Id key_id, Id value_id, const Interval &interval)
+    {
+      if (!m_free_rows.empty ())
+      {
+        const auto row = m_free_rows.back ();
+        m_free_rows.pop_back ();
+        m_key_ids[row] = key_id;
+        m_value_ids[row] = value_id;
+        m_intervals[row] = interval;
+        m_erased[row] = false;
+        return row;
+      }
+      m_key_ids.push_back (key_id);
+      m_value_ids.push_back (value_id);
+      m_intervals.push_back (interval);
+      m_count_indexes.push_back (0);
+      m_erased.push_back (false);
+      return static_cast<RowId> (m_intervals.size () - 1);
+    }
+
+    /// Mark @p row as erased. It is reused once no index holds it
+    void erase (RowId row)
+    {
+      m_erased[row] = true;
+      ++m_count_held_erased;
+      free_if_unused (row);
+    }
+
+    /// Record that one more index holds @p row
+    void hold (RowId row)
+    {
+      ++m_count_indexes[row];
+    }
+
+    /// Record that an index no longer holds @p row
+    void release (RowId row)
+    {
+      --m_count_indexes[row];
+      free_if_unused (row);
+    }
+
+    void clear ()
+    {
+      m_key_ids.clear ();
+      m_value_ids.clear ();
+      m_intervals.clear ();
+      m_count_indexes.clear ();
+      m_erased.clear ();
+      m_free_rows.clear ();
+      m_count_held_erased = 0;
+    }
+
+    [[nodiscard]] Id key_id (RowId row) const
+    {
+      return m_key_ids[row];
+    }
+
+    [[nodiscard]] Id value_id (RowId row) const
+    {
+      return m_value_ids[row];
+    }
+
+    [[nodiscard]] const Interval &interval (RowId row) const
+    {
+      return m_intervals[row];
+    }
+
+    /// @return whether @p row has been erased
+    [[nodiscard]] bool erased (RowId row) const
+    {
+      return m_erased[row];
+    }
+
+    /// @return number of rows that have not been erased
+    [[nodiscard]] std::size_t size () const
+    {
+      return m_intervals.size () - m_free_rows.size () - m_count_held_erased;
+    }
+
+    /// Add the bytes used by all columns to @p usage
+    void add_memory_usage (MemoryUsage &usage) const
+    {
+      details::add_vector_usage (m_key_ids, usage.bytes_intervals, usage);
+      details::add_vector_usage (m_value_ids, usage.bytes_intervals, usage);
+      details::add_vector_usage (m_intervals, usage.bytes_intervals, usage);
+      details::add_vector_usage (m_count_indexes, usage.bytes_index, usage);
+      details::add_vector_usage (m_erased, usage.bytes_index, usage);
+      details::add_vector_usage (m_free_rows, usage.bytes_tombstones, usage);
+      // Erased rows are counted as tombstones rather than live intervals
+      const auto bytes_erased
+        = (m_free_rows.size () + m_count_held_erased)
+          * (2 * sizeof (Id) + sizeof (Interval));
+      usage.bytes_intervals -= bytes_erased;
+      usage.bytes_tombstones += bytes_erased;
+    }
+
+    private:
+    void free_if_unused (RowId row)
+    {
+      if (m_erased[row] && m_count_indexes[row] == 0)
+      {
+        m_intervals[row] = Interval {};
+        m_free_rows.push_back (row);
+        --m_count_held_erased;
+      }
+    }
+
+    std::vector<Id> m_key_ids;
+    std::vector<Id> m_value_ids;
+    std::vector<Interval> m_intervals;
+    /// Number of RowIndexes holding each row
+    std::vector<std::uint8_t> m_count_indexes;
+    std::vector<std::uint8_t> m_erased;
+    std::vector<RowId> m_free_rows;
+    /// Rows erased but still held by an index
+    std::size_t m_count_held_erased = 0;
+  };
+
+  /**
+   * Rows of an AssociationTable for a single key or value, in runs sorted
+   * by the lower edge of their intervals.
+   *
+   * As in an AugmentedIntervalList, inserts are appended to a short list of
+   * pending rows, which is sorted into a new run once it holds
+   * rows_per_block rows. A run is merged into the one before whenever it
+   * grows as long, so that run lengths halve from one run to the next, and
+   * each row is moved O(log n) times. Erased rows are left in their runs as
+   * tombstones until they outnumber the live rows.
+   *
+   * Within each run, the maximum upper edge of all rows so far is kept so
+   * that a backwards scan from the last row that could overlap a query can
+   * stop early. Only one maximum is stored per block of rows_per_block rows
+   * to keep the index small.
+   */
+  template<typename Interval> class RowIndex
+  {
+    public:
+    /// Add @p row with @p interval
+    void insert (AssociationTable<Interval> &table, RowId row)
+    {
+      table.hold (row);
+      m_pending.push_back (row);
+      ++m_count_live;
+      if (m_pending.size () == rows_per_block)
+      {
+        add_pending_run (table);
+      }
+    }
+
+    /// Remove @p row, which must already be marked as erased in @p table
+    void erase (AssociationTable<Interval> &table, RowId row)
+    {
+      --m_count_live;
+      if (const auto ff = std::find (m_pending.begin (), m_pending.end (), row);
+          ff != m_pending.end ())
+      {
+        *ff = m_pending.back ();
+        m_pending.pop_back ();
+        table.release (row);
+        return;
+      }
+      if (++m_count_tombstones > m_count_live)
+      {
+        compact (table);
+      }
+    }
+
+    /// Call @p callback for each row whose interval overlaps @p query
+    template<typename Callback>
+    void for_each_overlapping (const AssociationTable<Interval> &table,
+                               const Interval &query,
+                               Callback &&callback) const
+    {
+      for_each_matching (
+        table,
+        [&] (const Interval &interval)
+        {
+          return comparisons::exclusive_less (query, interval);
+        },
+        [&] (const Interval &interval)
+        {
+          return comparisons::exclusive_less (interval, query);
+        },
+        callback);
+    }
+
+    /// Call @p callback for each row whose interval overlaps or touches
+    /// @p query
+    template<typename Callback>
+    void for_each_touching (const AssociationTable<Interval> &table,
+                            const Interval &query,
+                            Callback &&callback) const
+    {
+      for_each_matching (
+        table,
+        [&] (const Interval &interval)
+        {
+          return !comparisons::more_or_touches (query, interval);
+        },
+        [&] (const Interval &interval)
+        {
+          return !comparisons::more_or_touches (interval, query);
+        },
+        callback);
+    }
+
+    [[nodiscard]] bool empty () const
+    {
+      return m_count_live == 0;
+    }
+
+    /// Add the bytes used by the index to @p usage
+    void add_memory_usage (MemoryUsage &usage) const
+    {
+      details::add_vector_usage (m_runs, usage.bytes_runs, usage);
+      for (const auto &run : m_runs)
+      {
+        details::add_vector_usage (run.rows, usage.bytes_index, usage);
+        details::add_vector_usage (
+          run.block_maxima, usage.bytes_scratch, usage);
+      }
+      details::add_vector_usage (m_pending, usage.bytes_index, usage);
+      usage.bytes_index -= m_count_tombstones * sizeof (RowId);
+      usage.bytes_tombstones += m_count_tombstones * sizeof (RowId);
+    }
+
+    private:
+    /// Rows sorted by lower edge, and the interval with the maximum upper
+    /// edge of all rows up to the end of each block
+    struct Run
+    {
+      std::vector<RowId> rows;
+      std::vector<Interval> block_maxima;
+    };
+
+    /// Order by lower edge then by row id so that every row has a unique
+    /// position
+    static auto row_less (const AssociationTable<Interval> &table)
+    {
+      return [&table] (RowId left, RowId right)
+      {
+        const auto &left_interval = table.interval (left);
+        const auto &right_interval = table.interval (right);
+        if (boost::icl::lower_less (left_interval, right_interval))
+        {
+          return true;
+        }
+        if (boost::icl::lower_less (right_interval, left_interval))
+        {
+          return false;
+        }
+        return left < right;
+      };
+    }
+
+    /// Sort the pending rows into a new run, merging it with earlier runs
+    /// no longer than itself
+    void add_pending_run (const AssociationTable<Interval> &table)
+    {
+      std::sort (m_pending.begin (), m_pending.end (), row_less (table));
+      m_runs.push_back (Run {m_pending, {}});
+      m_pending.clear ();
+      while (m_runs.size () > 1
+             && m_runs[m_runs.size () - 2].rows.size ()
+                  <= m_runs.back ().rows.size ())
+      {
+        merge_last_runs (table);
+      }
+      update_block_maxima (table, m_runs.back ());
+    }
+
+    /// Drop tombstones, releasing their rows, and merge all rows into a
+    /// single run
+    void compact (AssociationTable<Interval> &table)
+    {
+      for (auto &run : m_runs)
+      {
+        std::erase_if (run.rows,
+                       [&] (RowId row)
+                       {
+                         if (!table.erased (row))
+                         {
+                           return false;
+                         }
+                         table.release (row);
+                         return true;
+                       });
+      }
+      m_count_tombstones = 0;
+      if (!m_pending.empty ())
+      {
+        std::sort (m_pending.begin (), m_pending.end (), row_less (table));
+        m_runs.push_back (Run {m_pending, {}});
+        m_pending.clear ();
+      }
+      while (m_runs.size () > 1)
+      {
+        merge_last_runs (table);
+      }
+      if (m_count_live == 0)
+      {
+        m_runs.clear ();
+        return;
+      }
+      update_block_maxima (table, m_runs.back ());
+    }
+
+    /// Merge the last run into the one before. Block maxima are left for the
+    /// caller to update
+    void merge_last_runs (const AssociationTable<Interval> &table)
+    {
+      const auto last = std::move (m_runs.back ().rows);
+      m_runs.pop_back ();
+      auto &rows = m_runs.back ().rows;
+      const auto middle = static_cast<std::ptrdiff_t> (rows.size ());
+      rows.insert (rows.end (), last.begin (), last.end ());
+      std::inplace_merge (
+        rows.begin (), rows.begin () + middle, rows.end (), row_less (table));
+    }
+
+    /// Recalculate the maximum upper edge of every block of @p run
+    static void update_block_maxima (const AssociationTable<Interval> &table,
+                                     Run &run)
+    {
+      run.block_maxima.clear ();
+      Interval max_upper {};
+      for (std::size_t ii = 0; ii < run.rows.size (); ++ii)
+      {
+        const auto &interval = table.interval (run.rows[ii]);
+        if (boost::icl::is_empty (max_upper)
+            || boost::icl::upper_less (max_upper, interval))
+        {
+          max_upper = interval;
+        }
+        if ((ii + 1) % rows_per_block == 0 || ii + 1 == run.rows.size ())
+        {
+          run.block_maxima.push_back (max_upper);
+        }
+      }
+    }
+
+    /// Call @p callback for each live row for which neither
+    /// @p starts_after nor @p ends_before is true
+    template<typename StartsAfter, typename EndsBefore, typename Callback>
+    void for_each_matching (const AssociationTable<Interval> &table,
+                            StartsAfter &&starts_after,
+                            EndsBefore &&ends_before,
+                            Callback &&callback) const
+    {
+      for (const auto &run : m_runs)
+      {
+        // Rows starting after the query cannot match it
+        const auto end = std::partition_point (
+          run.rows.begin (),
+          run.rows.end (),
+          [&] (RowId row)
+          {
+            return !starts_after (table.interval (row));
+          });
+        scan_backwards (table,
+                        run,
+                        static_cast<std::size_t> (end - run.rows.begin ()),
+                        ends_before,
+                        callback);
+      }
+      for (const auto row : m_pending)
+      {
+        const auto &interval = table.interval (row);
+        if (!starts_after (interval) && !ends_before (interval))
+        {
+          callback (row);
+        }
+      }
+    }
+
+    /// Visit live rows of @p run before @p end in reverse, stopping at the
+    /// first block where @p ends_before is true of the maximum upper edge of
+    /// all rows up to and including that block
+    template<typename EndsBefore, typename Callback>
+    static void scan_backwards (const AssociationTable<Interval> &table,
+                                const Run &run,
+                                std::size_t end,
+                                EndsBefore &&ends_before,
+                                Callback &&callback)
+    {
+      while (end > 0)
+      {
+        const auto block = (end - 1) / rows_per_block;
+        if (ends_before (run.block_maxima[block]))
+        {
+          return;
+        }
+        const auto begin = block * rows_per_block;
+        for (auto ii = end; ii > begin; --ii)
+        {
+          const auto row = run.rows[ii - 1];
+          if (!table.erased (row) && !ends_before (table.interval (row)))
+          {
+            callback (row);
+          }
+        }
+        end = begin;
+      }
+    }
+
+    std::vector<Run> m_runs;
+
+    /// Rows not yet sorted into a run
+    std::vector<RowId> m_pending;
+
+    std::size_t m_count_live = 0;
+
+    /// Erased rows still held in m_runs
+    std::size_t m_count_tombstones = 0;
+  };
+
+  /**
+   * Dense ids for the keys or values of an AssociationTable, and a RowIndex
+   * for each id.
+   *
+   * Each key or value is only stored in the std::map from items to ids. As
+   * in a SymbolTable, ids point back into its nodes, which do not move.
+   * Ids whose index becomes empty are released and reused.
+   */
+  template<typename T, typename Interval> class IdIndex
+  {
+    public:
+    IdIndex () = default;
+
+    /// Items of the copy point into its own map
+    IdIndex (const IdIndex &other)
+      : m_ids (other.m_ids)
+      , m_items (other.m_items.size (), nullptr)
+      , m_indexes (other.m_indexes)
+      , m_free_ids (other.m_free_ids)
+    {
+      for (const auto &[item, id] : m_ids)
+      {
+        m_items[id] = &item;
+      }
+    }
+
+    IdIndex &operator= (const IdIndex &other)
+    {
+      if (this != &other)
+      {
+        *this = IdIndex (other);
+      }
+      return *this;
+    }
+
+    IdIndex (IdIndex &&) noexcept = default;
+    IdIndex &operator= (IdIndex &&) noexcept = default;
+
+    /// @return id of @p item if present
+    [[nodiscard]] std::optional<Id> find (const T &item) const
+    {
+      const auto ff = m_ids.find (item);
+      if (ff == m_ids.end ())
+      {
+        return std::nullopt;
+      }
+      return ff->second;
+    }
+
+    /// @return id of @p item, adding it if necessary
+    Id insert (const T &item)
+    {
+      if (const auto ff = m_ids.find (item); ff != m_ids.end ())
+      {
+        return ff->second;
+      }
+      Id id;
+      if (!m_free_ids.empty ())
+      {
+        id = m_free_ids.back ();
+        m_free_ids.pop_back ();
+      }
+      else
+      {
+        id = static_cast<Id> (m_items.size ());
+        m_items.push_back (nullptr);
+        m_indexes.emplace_back ();
+      }
+      m_items[id] = &m_ids.emplace (item, id).first->first;
+      return id;
+    }
+
+    /// Release @p id if it no longer has any rows
+    void release_if_empty (Id id)
+    {
+      if (!m_indexes[id].empty ())
+      {
+        return;
+      }
+      m_ids.erase (*m_items[id]);
+      m_items[id] = nullptr;
+      m_free_ids.push_back (id);
+    }
+
+    void clear ()
+    {
+      m_ids.clear ();
+      m_items.clear ();
+      m_indexes.clear ();
+      m_free_ids.clear ();
+    }
+
+    [[nodiscard]] const T &item (Id id) const
+    {
+      return *m_items[id];
+    }
+
+    [[nodiscard]] RowIndex<Interval> &index (Id id)
+    {
+      return m_indexes[id];
+    }
+
+    [[nodiscard]] const RowIndex<Interval> &index (Id id) const
+    {
+      return m_indexes[id];
+    }
+
+    /// @return ids in sorted order of their items
+    [[nodiscard]] const std::map<T, Id> &ids () const
+    {
+      return m_ids;
+    }
+
+    /// @return number of items with at least one row
+    [[nodiscard]] std::size_t size () const
+    {
+      return m_ids.size ();
+    }
+
+    /// Add the bytes used by ids and indexes to @p usage
+    void add_memory_usage (MemoryUsage &usage) const
+    {
+      usage.bytes_nodes
+        += m_ids.size ()
+           * (details::rb_tree_node_links + sizeof (std::pair<const T, Id>));
+      details::add_vector_usage (m_items, usage.bytes_index, usage);
+      details::add_vector_usage (m_indexes, usage.bytes_index, usage);
+      details::add_vector_usage (m_free_ids, usage.bytes_index, usage);
+      for (const auto &index : m_indexes)
+      {
+        index.add_memory_usage (usage);
+      }
+    }
+
+    private:
+    std::map<T, Id> m_ids;
+    /// Item for each id, pointing into m_ids. Null for released ids
+    std::vector<const T *> m_items;
+    std::vector<RowIndex<Interval>> m_indexes;
+    std::vector<Id> m_free_ids;
+  };
+
+} // namespace interval_dict::association_table
+
+#endif // INCLUDE_INTERVAL_DICT_ASSOCIATION_TABLE_H
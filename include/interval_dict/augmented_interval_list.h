@@ -30,10 +30,13 @@
 
 #include "default_init_allocator.h"
 #include "disjoint_adaptor.h"
+#include "instrumentation.h"
 #include "interval_compare.h"
 #include "interval_operators.h"
 #include "interval_overlaps.h"
 #include "interval_traits.h"
+#include "memory_usage.h"
+#include "query_explain.h"
 #include "std_ranges_23_patch.h"
 #include "value_interval.h"
 
@@ -45,9 +48,18 @@
 
 #include <cppcoro/generator.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
 #include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 namespace interval_dict::augmented_interval_list
@@ -81,8 +93,9 @@ namespace interval_dict::augmented_interval_list
   /**
    * Streaming operator for a vector of Runs
    */
-  inline std::ostream &operator<< (std::ostream &os,
-                                   const std::vector<Run> &runs)
+  template<typename Allocator>
+  std::ostream &operator<< (std::ostream &os,
+                            const std::vector<Run, Allocator> &runs)
   {
     for (const auto &run : runs)
     {
@@ -91,6 +104,141 @@ namespace interval_dict::augmented_interval_list
     return os;
   }
 
+  /**
+   * Parameters for tuning how an AugmentedIntervalList is decomposed into
+   * runs, and how often it is rebuilt.
+   *
+   * See AugmentedIntervalList::decompose_into_runs(). tune_ail.h can sweep
+   * these against a sample of queries to find the best for a data set.
+   *
+   * Inserts and erases are held as pending extra runs and tombstones until
+   * the compaction policy calls for a full rebuild. This happens when any
+   * of max_fraction_pending, max_count_pending or max_age_pending is
+   * exceeded. Unless compact_in_foreground is set, the rebuild is left to
+   * AugmentedIntervalList::compact(), for example from a
+   * BackgroundCompactor.
+   */
+  struct Tuning
+  {
+    /// Intervals overlapping more subsequent intervals than this are
+    /// promoted to the next run
+    int_fast32_t max_overlapping_neighbours = 20;
+
+    /// Runs with fewer intervals will not be promoted
+    int_fast32_t min_run_length = 256;
+
+    /// Never promote more than this fraction of a run, so that run sizes
+    /// decrease exponentially
+    double max_fraction_promoted_per_run = 0.20;
+
+    /// Runs no longer than this are scanned in their entirety rather than
+    /// using binary search
+    int_fast32_t max_brute_force_run_length = 64;
+
+    /// Runs are rebuilt from scratch when pending inserts and erases exceed
+    /// this fraction of all intervals
+    double max_fraction_pending = 0.20;
+
+    /// Runs are rebuilt from scratch when there are more pending inserts
+    /// and erases than this. Zero for no limit
+    int_fast32_t max_count_pending = 0;
+
+    /// Runs are rebuilt from scratch when the oldest pending insert or
+    /// erase is older than this. Zero for no limit. Only checked on
+    /// mutation or by needs_compaction()
+    std::chrono::milliseconds max_age_pending {0};
+
+    /// Rebuild in insert(), erase(), merged_with() and subtract_by() as soon
+    /// as the policy requires it. Otherwise only compact() rebuilds
+    bool compact_in_foreground = true;
+
+    auto operator<=> (const Tuning &) const = default;
+  };
+
+  /**
+   * Streaming operator for Tuning, written on one line as space separated
+   * name=value so that it can be saved alongside a dictionary and read back
+   * by operator>>
+   */
+  inline std::ostream &operator<< (std::ostream &os, const Tuning &tuning)
+  {
+    os << "max_overlapping_neighbours=" << tuning.max_overlapping_neighbours
+       << " min_run_length=" << tuning.min_run_length
+       << " max_fraction_promoted_per_run="
+       << tuning.max_fraction_promoted_per_run
+       << " max_brute_force_run_length=" << tuning.max_brute_force_run_length
+       << " max_fraction_pending=" << tuning.max_fraction_pending
+       << " max_count_pending=" << tuning.max_count_pending
+       << " max_age_pending_ms=" << tuning.max_age_pending.count ()
+       << " compact_in_foreground=" << tuning.compact_in_foreground;
+    return os;
+  }
+
+  /**
+   * Read a line of Tuning written by operator<<. Missing names keep their
+   * default values. Unrecognised names set failbit and leave @p tuning
+   * unchanged
+   */
+  inline std::istream &operator>> (std::istream &is, Tuning &tuning)
+  {
+    std::string line;
+    if (!std::getline (is >> std::ws, line))
+    {
+      return is;
+    }
+    std::istringstream fields (line);
+    Tuning parsed;
+    std::string name;
+    while (std::getline (fields >> std::ws, name, '='))
+    {
+      if (name == "max_overlapping_neighbours")
+      {
+        fields >> parsed.max_overlapping_neighbours;
+      }
+      else if (name == "min_run_length")
+      {
+        fields >> parsed.min_run_length;
+      }
+      else if (name == "max_fraction_promoted_per_run")
+      {
+        fields >> parsed.max_fraction_promoted_per_run;
+      }
+      else if (name == "max_brute_force_run_length")
+      {
+        fields >> parsed.max_brute_force_run_length;
+      }
+      else if (name == "max_fraction_pending")
+      {
+        fields >> parsed.max_fraction_pending;
+      }
+      else if (name == "max_count_pending")
+      {
+        fields >> parsed.max_count_pending;
+      }
+      else if (name == "max_age_pending_ms")
+      {
+        std::chrono::milliseconds::rep milliseconds = 0;
+        fields >> milliseconds;
+        parsed.max_age_pending = std::chrono::milliseconds (milliseconds);
+      }
+      else if (name == "compact_in_foreground")
+      {
+        fields >> parsed.compact_in_foreground;
+      }
+      else
+      {
+        fields.setstate (std::ios::failbit);
+      }
+      if (fields.fail ())
+      {
+        is.setstate (std::ios::failbit);
+        return is;
+      }
+    }
+    tuning = parsed;
+    return is;
+  }
+
   /// @cond Suppress_Doxygen_Warning
   namespace details
   {
@@ -99,8 +247,13 @@ namespace interval_dict::augmented_interval_list
     using TouchingSet = std::set<ValueInterval<Value, Interval>,
                                  comparisons::CompareValIntervalTouches>;
 
-    template<typename Value, typename Interval>
-    void remove_empty (ValueIntervals<Value, Interval> &value_intervals)
+    // Source of AugmentedIntervalList::generation() values, unique across
+    // all lists so that a list replaced by another is always detected
+    inline std::atomic<std::uint64_t> last_generation {0};
+
+    template<typename Value, typename Interval, typename Allocator>
+    void remove_empty (
+      std::vector<ValueInterval<Value, Interval>, Allocator> &value_intervals)
     {
       // remove empty intervals
       std::erase_if (value_intervals,
@@ -111,11 +264,11 @@ namespace interval_dict::augmented_interval_list
     }
 
     /**
-     * Sort and merge overlapping intervals with the same value
+     * Sort and merge overlapping or touching intervals with the same value
      */
-    template<typename Value, typename Interval>
-    void
-    sort_combine_overlapping (ValueIntervals<Value, Interval> &value_intervals)
+    template<typename Value, typename Interval, typename Allocator>
+    void sort_combine_overlapping (
+      std::vector<ValueInterval<Value, Interval>, Allocator> &value_intervals)
     {
       std::ranges::sort (value_intervals, comparisons::CompareValInterval {});
       const auto [l, e] = std::ranges::unique (
@@ -125,7 +278,7 @@ namespace interval_dict::augmented_interval_list
           /*
            * Only discard rhs (return true) if
            * 1. values are the identical
-           * 2. intervals overlap
+           * 2. intervals overlap or touch, as for insert()
            * In which case, also extend lhs to
            * hull of both
            */
@@ -134,7 +287,7 @@ namespace interval_dict::augmented_interval_list
             return false;
           }
 
-          if (!comparisons::exclusive_less (lhs.interval, rhs.interval))
+          if (comparisons::more_or_touches (lhs.interval, rhs.interval))
           {
             lhs.interval = boost::icl::hull (lhs.interval, rhs.interval);
             return true;
@@ -151,6 +304,7 @@ namespace interval_dict::augmented_interval_list
    * \brief Implements an augmented interval list of intervals and values
    * \tparam Value value type
    * \tparam Interval interval type
+   * \tparam Allocator allocator for the interval-values, runs and right edges
    */
 
   /*
@@ -186,8 +340,14 @@ namespace interval_dict::augmented_interval_list
    * deletions (using tombstone values) and insertions (added to a separate
    * list of runs) until indels reach a specified proportion of stored
    * intervals.
+   *
+   * Pass a std::pmr::polymorphic_allocator as Allocator to place all the
+   * storage in a memory resource. A dictionary with these lists hands its
+   * allocator to each key. See IntervalDictExp::get_allocator()
    */
-  template<typename Value, typename Interval>
+  template<typename Value,
+           typename Interval,
+           typename Allocator = std::allocator<ValueInterval<Value, Interval>>>
   struct AugmentedIntervalList
   {
     // Dynamic bounds are converted into static bounds for the query algorithm
@@ -200,6 +360,18 @@ namespace interval_dict::augmented_interval_list
       "with dynamic bounds (that can be set to open/closed at run time)");
 
     using ValueIntervalType = ValueInterval<Value, Interval>;
+    using allocator_type = Allocator;
+
+    /// Storage for the interval-values, in runs
+    using Storage = std::vector<
+      ValueIntervalType,
+      typename std::allocator_traits<Allocator>::template rebind_alloc<
+        ValueIntervalType>>;
+
+    /// Storage for the begin and end of each run
+    using Runs = std::vector<
+      Run,
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Run>>;
 
     // Matching indices type driven by efficiency savings in query()
     // with a non-default initialising allocator
@@ -244,8 +416,7 @@ namespace interval_dict::augmented_interval_list
         using const_pointer = const value_type *;
         using iterator_category = std::input_iterator_tag;
 
-        ConstIterator (const ValueIntervals<Value, Interval> &intervals,
-                       std::vector<Run> runs)
+        ConstIterator (const Storage &intervals, std::vector<Run> runs)
           : m_value_intervals (intervals)
           , m_runs (std::move (runs))
         {
@@ -270,18 +441,17 @@ namespace interval_dict::augmented_interval_list
         const_pointer operator->() const;
 
         private:
-        const ValueIntervals<Value, Interval> &m_value_intervals;
+        const Storage &m_value_intervals;
         std::vector<Run> m_runs;
       };
 
-      AllIntervalsRange (const ValueIntervals<Value, Interval> &intervals,
-                         std::vector<Run> runs);
+      AllIntervalsRange (const Storage &intervals, std::vector<Run> runs);
 
       ConstIterator begin () const;
       ConstIterator end () const;
 
       private:
-      const ValueIntervals<Value, Interval> &m_value_intervals;
+      const Storage &m_value_intervals;
       std::vector<Run> m_runs;
     };
     /// @endcond
@@ -308,7 +478,7 @@ namespace interval_dict::augmented_interval_list
         using const_pointer = const value_type *;
         using iterator_category = std::input_iterator_tag;
 
-        ConstIterator (const ValueIntervals<Value, Interval> &intervals,
+        ConstIterator (const Storage &intervals,
                        const VecIndices &indices,
                        std::size_t pos = 0)
           : m_value_intervals (intervals)
@@ -337,13 +507,12 @@ namespace interval_dict::augmented_interval_list
 
         private:
         // Stores reference to
-        const ValueIntervals<Value, Interval> &m_value_intervals;
+        const Storage &m_value_intervals;
         const VecIndices &m_indices;
         std::size_t m_pos = 0;
       };
 
-      IntervalsRange (const ValueIntervals<Value, Interval> &intervals,
-                      VecIndices indices)
+      IntervalsRange (const Storage &intervals, VecIndices indices)
         : m_value_intervals (intervals)
         , m_indices (indices)
       {
@@ -353,7 +522,7 @@ namespace interval_dict::augmented_interval_list
       ConstIterator end () const;
 
       private:
-      const ValueIntervals<Value, Interval> &m_value_intervals;
+      const Storage &m_value_intervals;
       VecIndices m_indices;
     };
     /// @endcond
@@ -377,11 +546,27 @@ namespace interval_dict::augmented_interval_list
                                     int max_overlapping_neighbours = 30,
                                     int min_run_length = 64,
                                     double max_fraction_promoted_per_run = 0.50)
-      : m_max_overlapping_neighbours (
-        static_cast<int_fast32_t> (max_overlapping_neighbours))
-      , m_min_run_length (static_cast<int_fast32_t> (min_run_length))
-      , m_max_fraction_promoted_per_run (max_fraction_promoted_per_run)
+      : AugmentedIntervalList (
+        std::move (intervals),
+        Tuning {.max_overlapping_neighbours = max_overlapping_neighbours,
+                .min_run_length = min_run_length,
+                .max_fraction_promoted_per_run
+                = max_fraction_promoted_per_run})
+    {
+    }
+
+    /**
+     * \brief Construct augmented list from intervals
+     * \param intervals The vector of values and intervals for the container.
+     * \param tuning Parameters for decomposing intervals into runs
+     * \param allocator Allocator for all storage
+     */
+    AugmentedIntervalList (ValueIntervals<Value, Interval> intervals,
+                           const Tuning &tuning,
+                           const allocator_type &allocator = allocator_type ())
+      : AugmentedIntervalList (allocator)
     {
+      m_tuning = tuning;
       details::remove_empty (intervals);
       details::sort_combine_overlapping (intervals);
       insert (intervals);
@@ -392,11 +577,42 @@ namespace interval_dict::augmented_interval_list
      */
     AugmentedIntervalList () = default;
 
+    /**
+     * Construct empty list using @p allocator for all storage
+     */
+    explicit AugmentedIntervalList (const allocator_type &allocator)
+      : m_value_intervals (allocator)
+      , m_max_right_edges (allocator)
+      , m_runs (allocator)
+    {
+    }
+
     /**
      * Copy constructor
      */
     AugmentedIntervalList (const AugmentedIntervalList &) = default;
 
+    /**
+     * Allocator-extended copy constructor
+     */
+    AugmentedIntervalList (const AugmentedIntervalList &other,
+                           const allocator_type &allocator)
+      : AugmentedIntervalList (allocator)
+    {
+      *this = other;
+    }
+
+    /**
+     * Allocator-extended move constructor. Copies the intervals if
+     * @p allocator differs from the allocator of @p other
+     */
+    AugmentedIntervalList (AugmentedIntervalList &&other,
+                           const allocator_type &allocator)
+      : AugmentedIntervalList (allocator)
+    {
+      *this = std::move (other);
+    }
+
     /**
      * Copy assignment operator
      */
@@ -414,17 +630,34 @@ namespace interval_dict::augmented_interval_list
     AugmentedIntervalList &operator= (AugmentedIntervalList &&other) noexcept
       = default;
 
+    /**
+     * @return allocator used for all storage
+     */
+    [[nodiscard]] allocator_type get_allocator () const
+    {
+      return allocator_type (m_value_intervals.get_allocator ());
+    }
+
     /*
      * @return true if tree is empty
      */
     [[nodiscard]] bool empty () const;
 
+    /**
+     * @return number of interval-values stored, including erased intervals
+     * not yet removed. An upper bound on the number of interval-values
+     */
+    [[nodiscard]] std::size_t count_stored () const
+    {
+      return m_value_intervals.size ();
+    }
+
     /**
      * @return iterator for all interval/values
      */
     AllIntervalsRange all_intervals () const
     {
-      return {m_value_intervals, m_runs};
+      return {m_value_intervals, {m_runs.begin (), m_runs.end ()}};
     }
 
     /**
@@ -503,7 +736,9 @@ namespace interval_dict::augmented_interval_list
       /*
        * Safe to return iterator from temp object
        */
-      AllIntervalsRange (m_value_intervals, m_runs).begin ();
+      AllIntervalsRange (m_value_intervals,
+                         {m_runs.begin (), m_runs.end ()})
+        .begin ();
     }
 
     /**
@@ -514,7 +749,9 @@ namespace interval_dict::augmented_interval_list
       /*
        * Safe to return iterator from temp object
        */
-      AllIntervalsRange (m_value_intervals, m_runs).end ();
+      AllIntervalsRange (m_value_intervals,
+                         {m_runs.begin (), m_runs.end ()})
+        .end ();
     }
 
     /**
@@ -529,20 +766,85 @@ namespace interval_dict::augmented_interval_list
                                VecIndices &matching_indices) const;
     /**
      * @return indices of intervals intersecting the query
+     * Records the work done for each run in @p explain if not null
      */
     void unsorted_match_indices (const Interval &query,
-                                 VecIndices &matching_indices) const;
+                                 VecIndices &matching_indices,
+                                 QueryExplain *explain = nullptr) const;
+
+    /**
+     * Records the work done by a query in @p explain
+     */
+    void explain (const Interval &query_interval, QueryExplain &explain) const;
+
+    /**
+     * @return bytes used by intervals, tombstones, runs and scratch space
+     */
+    [[nodiscard]] MemoryUsage memory_usage () const;
+
+    /**
+     * Remove all tombstones, integrate pending inserts and release unused
+     * capacity
+     */
+    void shrink_to_fit ();
+
+    /**
+     * @return parameters for decomposing intervals into runs
+     */
+    [[nodiscard]] const Tuning &tuning () const
+    {
+      return m_tuning;
+    }
+
+    /**
+     * Change the parameters for decomposing intervals into runs, rebuilding
+     * all runs with the new parameters
+     */
+    void tune (const Tuning &tuning);
+
+    /**
+     * @return whether the compaction policy in tuning() calls for pending
+     * inserts and erases to be integrated by compact()
+     */
+    [[nodiscard]] bool needs_compaction () const;
+
+    /**
+     * Rebuild all runs from scratch, removing tombstones and integrating
+     * pending inserts
+     */
+    void compact ();
+
+    /**
+     * @return a value that changes whenever the list is modified, and is
+     * never shared with other lists unless copied
+     */
+    [[nodiscard]] std::uint64_t generation () const
+    {
+      return m_generation;
+    }
 
     /**
      * list of intervals and values
      */
-    ValueIntervals<Value, Interval> m_value_intervals;
+    Storage m_value_intervals;
 
-    [[nodiscard]] const std::vector<Run> &runs () const
+    [[nodiscard]] const Runs &runs () const
     {
       return m_runs;
     }
 
+#ifdef INTERVAL_DICT_STATS
+    /**
+     * add internal statistics to @p stats
+     */
+    void collect_stats (instrumentation::Stats &stats) const;
+
+    /**
+     * zero internal statistics
+     */
+    void reset_stats ();
+#endif
+
     private:
     /**
      * @return indices of intervals intersecting or touching the query and
@@ -559,17 +861,24 @@ namespace interval_dict::augmented_interval_list
                                        const Value &query_value,
                                        VecIndices &matching_indices) const;
 
+    /// Right edges are cached as EdgeEncoding integers for dates and times
+    using EdgeEncodingType
+      = EdgeEncoding<typename ValueInterval<Value, Interval>::BaseType>;
+    using EncodedEdge = typename EdgeEncodingType::EncodedType;
+
     /**
      * Cumulative maximum value of the right edge
      * Used to short circuit binary search
      */
-    std::vector<typename ValueInterval<Value, Interval>::BaseType>
+    std::vector<EncodedEdge,
+                typename std::allocator_traits<
+                  Allocator>::template rebind_alloc<EncodedEdge>>
       m_max_right_edges;
 
     /**
      * The begin and end indices of each "run" of sorted intervals
      */
-    std::vector<Run> m_runs;
+    Runs m_runs;
 
     /**
      * Split m_value_intervals into "run"s each of intervals sorted by left edge
@@ -592,12 +901,10 @@ namespace interval_dict::augmented_interval_list
      */
     void mark_as_erased (const VecIndices &indices);
 
-    // Parameters for tuning the decompose_into_runs algorithm
-    /// @cond Suppress_Doxygen_Warning
-    int_fast32_t m_max_overlapping_neighbours = 20;
-    int_fast32_t m_min_run_length = 256;
-    double m_max_fraction_promoted_per_run = 0.20;
-    /// @endcond
+    /**
+     * Parameters for tuning the decompose_into_runs algorithm
+     */
+    Tuning m_tuning;
 
     /**
      * Count number of erased intervals that have yet to be removed
@@ -614,29 +921,74 @@ namespace interval_dict::augmented_interval_list
      */
     int_fast32_t m_optimal_runs = 0;
 
+    /**
+     * When the oldest pending insert or erase was made. Only kept if
+     * Tuning::max_age_pending is set
+     */
+    std::chrono::steady_clock::time_point m_pending_since {};
+
+    /**
+     * Changed by every call to decompose_into_runs(). See generation()
+     */
+    std::uint64_t m_generation = 0;
+
+    /**
+     * @return whether the compaction policy is exceeded with @p
+     * count_pending inserts and erases
+     */
+    [[nodiscard]] bool exceeds_compaction_policy (
+      int_fast32_t count_pending) const;
+
     /**
      * Re-calculate running maximum right edges
      * Start from the Nth run where N = run_index
      */
     void calculate_running_max_end (int run_index = 0);
+
+#ifdef INTERVAL_DICT_STATS
+    /**
+     * Calls to decompose_into_runs() and their durations
+     */
+    instrumentation::OperationStats m_decompositions;
+
+    /**
+     * Intervals examined by queries. Updated by const member functions,
+     * possibly on several threads
+     */
+    mutable instrumentation::RelaxedCounter m_count_elements_scanned;
+#endif
+  };
+
+  /// Type trait to identify AugmentedIntervalList
+  template<typename T> struct IsAugmentedIntervalList : std::false_type
+  {
   };
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::calculate_running_max_end (
+  /// Type trait to identify AugmentedIntervalList
+  template<typename Value, typename Interval, typename Allocator>
+  struct IsAugmentedIntervalList<
+    AugmentedIntervalList<Value, Interval, Allocator>> : std::true_type
+  {
+  };
+
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::
+    calculate_running_max_end (
     int run_index)
   {
     m_max_right_edges.resize (m_value_intervals.size ());
     for (auto i = run_index; i < std::ssize (m_runs); ++i)
     {
       const auto [begin, end] = m_runs[i];
-      assert (end - begin > 1);
-      auto max_end
-        = comparisons::upper_edge (m_value_intervals[begin].interval);
+      assert (end - begin > 0);
+      auto max_end = EdgeEncodingType::encode (
+        comparisons::upper_edge (m_value_intervals[begin].interval));
       m_max_right_edges[begin] = max_end;
       for (auto j = begin + 1; j < end; ++j)
       {
-        max_end = std::max (
-          comparisons::upper_edge (m_value_intervals[j].interval), max_end);
+        max_end = std::max (EdgeEncodingType::encode (comparisons::upper_edge (
+                              m_value_intervals[j].interval)),
+                            max_end);
         m_max_right_edges[j] = max_end;
       }
     }
@@ -663,15 +1015,27 @@ namespace interval_dict::augmented_interval_list
 
   } // namespace details
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::decompose_into_runs ()
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::decompose_into_runs ()
   {
-    if ((m_count_inserted + m_count_removed) > 0.2 * m_value_intervals.size ()
-        || std::ssize (m_value_intervals) < m_min_run_length)
+#ifdef INTERVAL_DICT_STATS
+    const instrumentation::ScopedTimer timer (m_decompositions);
+#endif
+    m_generation = ++details::last_generation;
+    const auto count_pending = m_count_inserted + m_count_removed;
+    if (count_pending > 0 && m_tuning.max_age_pending.count () > 0
+        && m_pending_since == std::chrono::steady_clock::time_point {})
+    {
+      m_pending_since = std::chrono::steady_clock::now ();
+    }
+    if ((m_tuning.compact_in_foreground
+         && exceeds_compaction_policy (count_pending))
+        || std::ssize (m_value_intervals) < m_tuning.min_run_length)
     {
       m_count_inserted = 0;
       m_count_removed = 0;
       m_optimal_runs = 0;
+      m_pending_since = {};
     }
 
     if (m_optimal_runs < std::ssize (m_runs))
@@ -693,18 +1057,26 @@ namespace interval_dict::augmented_interval_list
     }
 
     // Remove intervals marked as erased that are not part of a Run
-    std::remove_if (m_value_intervals.begin () + intervals_offset,
-                    m_value_intervals.end (),
-                    [] (const auto &iv)
-                    {
-                      return boost::icl::is_empty (iv.interval);
-                    });
+    m_value_intervals.erase (
+      std::remove_if (m_value_intervals.begin () + intervals_offset,
+                      m_value_intervals.end (),
+                      [] (const auto &iv)
+                      {
+                        return boost::icl::is_empty (iv.interval);
+                      }),
+      m_value_intervals.end ());
+    if (intervals_offset == std::ssize (m_value_intervals))
+    {
+      calculate_running_max_end (m_optimal_runs);
+      return;
+    }
     std::sort (m_value_intervals.begin () + intervals_offset,
                m_value_intervals.end (),
                comparisons::CompareInterval ());
 
     // Index of first interval to decompose runs off the end.
-    if (std::ssize (m_value_intervals) - intervals_offset <= m_min_run_length)
+    if (std::ssize (m_value_intervals) - intervals_offset
+        <= m_tuning.min_run_length)
     {
       assert (std::ssize (m_value_intervals) > intervals_offset);
       m_runs.emplace_back (intervals_offset, std::ssize (m_value_intervals));
@@ -716,12 +1088,14 @@ namespace interval_dict::augmented_interval_list
       return;
     }
 
-    // scratch space
-    auto unresolved = m_value_intervals;
+    // scratch space: only the intervals not already in a Run
+    Storage unresolved (m_value_intervals.begin () + intervals_offset,
+                        m_value_intervals.end (),
+                        m_value_intervals.get_allocator ());
 
-    // intervals that cover more than 'm_max_overlapping_neighbours' subsequent
+    // intervals that cover more than 'max_overlapping_neighbours' subsequent
     // intervals
-    ValueIntervals<Value, Interval> overlapping;
+    Storage overlapping (m_value_intervals.get_allocator ());
 
     int_fast32_t runs_count = 0;
     int_fast32_t pos = intervals_offset;
@@ -738,10 +1112,11 @@ namespace interval_dict::augmented_interval_list
       // Make sure we use a level of overlapping_threshold that
       // doesn't promote too much of the list
       const int_fast32_t overlapping_threshold = std::max (
-        m_min_run_length,
-        std::max (m_max_overlapping_neighbours,
-                  details::quantile (overlap_counter.m_counts,
-                                     1.0 - m_max_fraction_promoted_per_run)));
+        m_tuning.min_run_length,
+        std::max (
+          m_tuning.max_overlapping_neighbours,
+          details::quantile (overlap_counter.m_counts,
+                             1.0 - m_tuning.max_fraction_promoted_per_run)));
 
       // short last run: save verbatim
       if (unresolved_size < overlapping_threshold)
@@ -790,16 +1165,20 @@ namespace interval_dict::augmented_interval_list
     }
   }
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::unsorted_match_indices (
-    const Interval &query_interval, VecIndices &matching_indices) const
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::
+    unsorted_match_indices (
+    const Interval &query_interval,
+    VecIndices &matching_indices,
+    QueryExplain *explain) const
   {
     if (m_runs.empty ())
     {
       return;
     }
     matching_indices.clear ();
-    const auto query_start = comparisons::lower_edge (query_interval);
+    const auto query_start
+      = EdgeEncodingType::encode (comparisons::lower_edge (query_interval));
     const auto query_end = comparisons::upper_edge (query_interval);
     int cnt_elements = 0;
     /*
@@ -815,8 +1194,12 @@ namespace interval_dict::augmented_interval_list
       matching_indices.resize (matching_indices.size () + end - begin);
 
       // brute force small runs
-      if (end - begin <= 64)
+      if (end - begin <= m_tuning.max_brute_force_run_length)
       {
+#ifdef INTERVAL_DICT_STATS
+        m_count_elements_scanned += end - begin;
+#endif
+        const auto cnt_before = cnt_elements;
         for (int_fast32_t i = begin; i < end; ++i)
         {
           // intersects
@@ -826,12 +1209,22 @@ namespace interval_dict::augmented_interval_list
             matching_indices[cnt_elements++] = i;
           }
         }
+        if (explain)
+        {
+          explain->runs.push_back (
+            {.begin = begin,
+             .end = end,
+             .brute_force = true,
+             .elements_scanned = std::size_t (end - begin),
+             .elements_matched = std::size_t (cnt_elements - cnt_before)});
+        }
         continue;
       }
 
       // Binary search for the last item that can intersect the query
       // N.B. Extra -1 because lower_bound returns the "open" end
       // of our search from begin->end, and we actually want the "last" index
+      std::size_t binary_search_steps = 0;
       int_fast32_t i
         = std::lower_bound (
             m_value_intervals.begin () + begin,
@@ -840,11 +1233,14 @@ namespace interval_dict::augmented_interval_list
             /*
              * lower bound where query.right >= m_value_intervals.left
              */
-            [] (const auto &iv, auto q)
+            [&binary_search_steps] (const auto &iv, auto q)
             {
+              ++binary_search_steps;
               return !comparisons::exclusive_less (q, iv.interval);
             })
           - m_value_intervals.begin () - 1;
+      const auto scan_start = i;
+      const auto cnt_before = cnt_elements;
 
       /*
        * While m_max_right_edges[i] >= query_start, some interval(s) will
@@ -870,12 +1266,35 @@ namespace interval_dict::augmented_interval_list
         }
         --i;
       }
+#ifdef INTERVAL_DICT_STATS
+      m_count_elements_scanned += scan_start - i;
+#endif
+      if (explain)
+      {
+        explain->runs.push_back (
+          {.begin = begin,
+           .end = end,
+           .binary_search_steps = binary_search_steps,
+           .elements_scanned = std::size_t (scan_start - i),
+           .elements_matched = std::size_t (cnt_elements - cnt_before)});
+      }
     }
     matching_indices.resize (cnt_elements);
   }
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::unsorted_touching_value_indices (
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::explain (
+    const Interval &query_interval, QueryExplain &explain) const
+  {
+    explain.backend = "augmented interval list";
+    VecIndices matching_indices;
+    unsorted_match_indices (query_interval, matching_indices, &explain);
+    explain.count_matched += matching_indices.size ();
+  }
+
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::
+    unsorted_touching_value_indices (
     const Interval &query_interval,
     const Value &query_value,
     VecIndices &matching_indices) const
@@ -886,8 +1305,8 @@ namespace interval_dict::augmented_interval_list
     }
     matching_indices.clear ();
     const auto query_start = comparisons::lower_edge (query_interval);
-    const auto query_start_touches
-      = boost::icl::domain_prior<Interval> (query_start);
+    const auto query_start_touches = EdgeEncodingType::encode (
+      boost::icl::domain_prior<Interval> (query_start));
     for (const auto &[begin, end] : m_runs)
     {
       // Binary search for the last item that may touch the query
@@ -900,7 +1319,7 @@ namespace interval_dict::augmented_interval_list
                             // query_interval.right >= m_value_intervals[i].left
                             [] (const auto &iv, const auto &q)
                             {
-                              return !comparisons::more_or_touches (
+                              return comparisons::more_or_touches (
                                 q, iv.interval);
                             })
           - m_value_intervals.begin () - 1;
@@ -908,8 +1327,8 @@ namespace interval_dict::augmented_interval_list
       while (i >= begin && m_max_right_edges[i] >= query_start_touches)
       {
         // m_value_intervals[i].interval.right >= query_interval.left
-        if (!comparisons::more_or_touches (m_value_intervals[i].interval,
-                                           query_interval)
+        if (comparisons::more_or_touches (m_value_intervals[i].interval,
+                                          query_interval)
             && m_value_intervals[i].value == query_value)
         {
           matching_indices.push_back (i);
@@ -919,8 +1338,9 @@ namespace interval_dict::augmented_interval_list
     }
   }
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::unsorted_match_value_indices (
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::
+    unsorted_match_value_indices (
     const Interval &query_interval,
     const Value &query_value,
     VecIndices &matching_indices) const
@@ -941,9 +1361,9 @@ namespace interval_dict::augmented_interval_list
   /**
    * @return coroutine enumerating all interval/values over @p query_interval
    */
-  template<typename Value, typename Interval>
-  typename AugmentedIntervalList<Value, Interval>::IntervalsRange
-  AugmentedIntervalList<Value, Interval>::intervals (
+  template<typename Value, typename Interval, typename Allocator>
+  typename AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange
+  AugmentedIntervalList<Value, Interval, Allocator>::intervals (
     const Interval &query_interval) const
   {
     VecIndices matching_indices;
@@ -951,8 +1371,8 @@ namespace interval_dict::augmented_interval_list
     return IntervalsRange {m_value_intervals, matching_indices};
   }
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::sorted_match_indices (
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::sorted_match_indices (
     const Interval &query_interval, VecIndices &matching_indices) const
   {
     /*
@@ -974,46 +1394,167 @@ namespace interval_dict::augmented_interval_list
       });
   }
 
-  template<typename Value, typename Interval>
-  bool AugmentedIntervalList<Value, Interval>::empty () const
+  template<typename Value, typename Interval, typename Allocator>
+  bool AugmentedIntervalList<Value, Interval, Allocator>::empty () const
   {
     return m_value_intervals.empty ();
   }
 
-  template<typename Value, typename Interval>
-  bool AugmentedIntervalList<Value, Interval>::operator== (
+#ifdef INTERVAL_DICT_STATS
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::collect_stats (
+    instrumentation::Stats &stats) const
+  {
+    // Count tombstones directly: m_count_removed also includes intervals
+    // replaced on insert and tombstones already removed from pending runs
+    const auto count_tombstones
+      = std::ranges::count_if (m_value_intervals,
+                               [] (const auto &iv)
+                               {
+                                 return boost::icl::is_empty (iv.interval);
+                               });
+    stats.count_intervals += m_value_intervals.size () - count_tombstones;
+    stats.count_runs += m_runs.size ();
+    // Runs after the first up to m_optimal_runs hold promoted intervals.
+    // Later runs hold pending inserts
+    for (auto i = 1; i < std::min<int_fast32_t> (m_optimal_runs,
+                                                 std::ssize (m_runs));
+         ++i)
+    {
+      stats.count_promoted += m_runs[i].end - m_runs[i].begin;
+    }
+    stats.count_pending_inserts += m_count_inserted;
+    stats.count_pending_removes += count_tombstones;
+    stats.count_elements_scanned += m_count_elements_scanned.load ();
+    stats.decompositions += m_decompositions;
+  }
+
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::reset_stats ()
+  {
+    m_decompositions = {};
+    m_count_elements_scanned = {};
+  }
+#endif
+
+  template<typename Value, typename Interval, typename Allocator>
+  MemoryUsage
+  AugmentedIntervalList<Value, Interval, Allocator>::memory_usage () const
+  {
+    MemoryUsage usage;
+    interval_dict::details::add_vector_usage (
+      m_value_intervals, usage.bytes_intervals, usage);
+    const auto count_tombstones
+      = std::ranges::count_if (m_value_intervals,
+                               [] (const auto &iv)
+                               {
+                                 return boost::icl::is_empty (iv.interval);
+                               });
+    usage.bytes_tombstones = count_tombstones * sizeof (ValueIntervalType);
+    usage.bytes_intervals -= usage.bytes_tombstones;
+    interval_dict::details::add_vector_usage (
+      m_max_right_edges, usage.bytes_scratch, usage);
+    interval_dict::details::add_vector_usage (m_runs, usage.bytes_runs, usage);
+    return usage;
+  }
+
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::shrink_to_fit ()
+  {
+    compact ();
+    m_value_intervals.shrink_to_fit ();
+    m_max_right_edges.shrink_to_fit ();
+    m_runs.shrink_to_fit ();
+  }
+
+  template<typename Value, typename Interval, typename Allocator>
+  void
+  AugmentedIntervalList<Value, Interval, Allocator>::tune (const Tuning &tuning)
+  {
+    if (tuning == m_tuning)
+    {
+      return;
+    }
+    m_tuning = tuning;
+    if (m_value_intervals.empty ())
+    {
+      return;
+    }
+    compact ();
+  }
+
+  template<typename Value, typename Interval, typename Allocator>
+  bool AugmentedIntervalList<Value, Interval, Allocator>::
+    exceeds_compaction_policy (
+    int_fast32_t count_pending) const
+  {
+    if (count_pending <= 0)
+    {
+      return false;
+    }
+    if (count_pending
+          > m_tuning.max_fraction_pending * m_value_intervals.size ()
+        || (m_tuning.max_count_pending > 0
+            && count_pending > m_tuning.max_count_pending))
+    {
+      return true;
+    }
+    return m_tuning.max_age_pending.count () > 0
+           && m_pending_since != std::chrono::steady_clock::time_point {}
+           && std::chrono::steady_clock::now () - m_pending_since
+                > m_tuning.max_age_pending;
+  }
+
+  template<typename Value, typename Interval, typename Allocator>
+  bool
+  AugmentedIntervalList<Value, Interval, Allocator>::needs_compaction () const
+  {
+    return exceeds_compaction_policy (m_count_inserted + m_count_removed);
+  }
+
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::compact ()
+  {
+    // Rebuild all runs from scratch
+    details::remove_empty (m_value_intervals);
+    m_runs.clear ();
+    m_optimal_runs = 0;
+    m_count_inserted = 0;
+    m_count_removed = 0;
+    m_pending_since = {};
+    decompose_into_runs ();
+  }
+
+  template<typename Value, typename Interval, typename Allocator>
+  bool AugmentedIntervalList<Value, Interval, Allocator>::operator== (
     const AugmentedIntervalList &rhs) const
   {
     return std::tie (m_value_intervals,
                      m_max_right_edges,
                      m_runs,
-                     m_max_overlapping_neighbours,
-                     m_min_run_length,
-                     m_max_fraction_promoted_per_run,
+                     m_tuning,
                      m_count_removed,
                      m_count_inserted,
                      m_optimal_runs)
            == std::tie (rhs.m_value_intervals,
                         rhs.m_max_right_edges,
                         rhs.m_runs,
-                        rhs.m_max_overlapping_neighbours,
-                        rhs.m_min_run_length,
-                        rhs.m_max_fraction_promoted_per_run,
+                        rhs.m_tuning,
                         rhs.m_count_removed,
                         rhs.m_count_inserted,
                         rhs.m_optimal_runs);
   }
 
-  template<typename Value, typename Interval>
+  template<typename Value, typename Interval, typename Allocator>
   ValuesDisjointInterval<Value, Interval>
-  AugmentedIntervalList<Value, Interval>::initial_values () const
+  AugmentedIntervalList<Value, Interval, Allocator>::initial_values () const
   {
     return disjoint_adaptor::initial_values<Value, Interval> (all_intervals ());
   }
 
-  template<typename Value, typename Interval>
+  template<typename Value, typename Interval, typename Allocator>
   cppcoro::generator<ValuesDisjointInterval<Value, Interval>>
-  AugmentedIntervalList<Value, Interval>::disjoint_intervals (
+  AugmentedIntervalList<Value, Interval, Allocator>::disjoint_intervals (
     const Interval &query_interval) const
   {
     // TODO: What is this?
@@ -1022,23 +1563,23 @@ namespace interval_dict::augmented_interval_list
         intervals (query_interval), query_interval);
   }
 
-  template<typename Value, typename Interval>
+  template<typename Value, typename Interval, typename Allocator>
   cppcoro::generator<Interval>
-  AugmentedIntervalList<Value, Interval>::gaps () const
+  AugmentedIntervalList<Value, Interval, Allocator>::gaps () const
   {
     return disjoint_adaptor::gaps<Interval> (all_intervals ());
   }
 
-  template<typename Value, typename Interval>
+  template<typename Value, typename Interval, typename Allocator>
   SandwichedGaps<Value, Interval>
-  AugmentedIntervalList<Value, Interval>::sandwiched_gaps () const
+  AugmentedIntervalList<Value, Interval, Allocator>::sandwiched_gaps () const
   {
     return disjoint_adaptor::
       sandwiched_gaps<Value, Interval, ValueIntervalType> (all_intervals ());
   }
 
-  template<typename Value, typename Interval>
-  std::vector<Value> AugmentedIntervalList<Value, Interval>::values (
+  template<typename Value, typename Interval, typename Allocator>
+  std::vector<Value> AugmentedIntervalList<Value, Interval, Allocator>::values (
     const Interval &interval) const
   {
     return disjoint_adaptor::values<Value> (intervals (interval));
@@ -1050,10 +1591,11 @@ namespace interval_dict::augmented_interval_list
     // Helper function for subtract_by()
     // Subtracts two vectors after sorting in value-interval order
     // returns a vector still in value_interval sorted order
-    template<typename Value, typename Interval>
-    ValueIntervals<Value, Interval>
-    sort_subtract_intervals (ValueIntervals<Value, Interval> &value_intervals,
-                             ValueIntervals<Value, Interval> other)
+    template<typename Value, typename Interval, typename Allocator>
+    std::vector<ValueInterval<Value, Interval>, Allocator>
+    sort_subtract_intervals (
+      std::vector<ValueInterval<Value, Interval>, Allocator> &value_intervals,
+      std::vector<ValueInterval<Value, Interval>, Allocator> other)
     {
       using comparisons::CompareValInterval;
 
@@ -1062,9 +1604,10 @@ namespace interval_dict::augmented_interval_list
 
       auto first1 = value_intervals.begin ();
       auto last1 = value_intervals.end ();
-      auto first2 = other.end ();
-      auto last2 = other.begin ();
-      ValueIntervals<Value, Interval> result;
+      auto first2 = other.begin ();
+      auto last2 = other.end ();
+      std::vector<ValueInterval<Value, Interval>, Allocator> result (
+        value_intervals.get_allocator ());
 
       while (first1 != last1)
       {
@@ -1110,11 +1653,16 @@ namespace interval_dict::augmented_interval_list
             {
               result.push_back ({first1->value, remainder1});
             }
-            if (!boost::icl::is_empty (remainder2))
+            // Whatever remains to the right may still overlap later
+            // intervals in other
+            if (boost::icl::is_empty (remainder2))
+            {
+              ++first1;
+            }
+            else
             {
-              result.push_back ({first1->value, remainder2});
+              first1->interval = remainder2;
             }
-            ++first1;
           }
         }
       }
@@ -1124,8 +1672,8 @@ namespace interval_dict::augmented_interval_list
   } // namespace details
   /// @endcond
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::insert_helper (
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::insert_helper (
     const ValueInterval<Value, Interval> &value_interval,
     details::TouchingSet<Value, Interval> &new_value_intervals)
   {
@@ -1177,22 +1725,16 @@ namespace interval_dict::augmented_interval_list
     new_value_intervals.insert ({value_interval.value, total_interval});
   }
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::insert (Interval interval,
-                                                       const Value &value)
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::insert (
+    Interval interval, const Value &value)
   {
-    // Prepare intervals for insertion
-    if (boost::icl::is_empty (interval))
-    {
-      return;
-    }
-    ++m_count_inserted;
-    m_value_intervals.emplace_back (value, interval);
-    decompose_into_runs ();
+    // Merge with overlapping or touching intervals with the same value
+    insert (ValueIntervals<Value, Interval> {{value, interval}});
   }
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::insert (
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::insert (
     ValueIntervals<Value, Interval> value_intervals)
   {
     // Prepare intervals for insertion
@@ -1215,8 +1757,9 @@ namespace interval_dict::augmented_interval_list
     decompose_into_runs ();
   }
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::erase (const Interval &interval)
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::erase (
+    const Interval &interval)
   {
     VecIndices matching_indices;
     unsorted_match_indices (interval, matching_indices);
@@ -1237,13 +1780,14 @@ namespace interval_dict::augmented_interval_list
         ++m_count_inserted;
       }
     }
+    m_count_removed += std::ssize (matching_indices);
     mark_as_erased (matching_indices);
     decompose_into_runs ();
   }
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::erase (const Interval &interval,
-                                                      const Value &value)
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::erase (
+    const Interval &interval, const Value &value)
   {
     VecIndices matching_indices;
     unsorted_match_value_indices (interval, value, matching_indices);
@@ -1264,12 +1808,13 @@ namespace interval_dict::augmented_interval_list
         ++m_count_inserted;
       }
     }
+    m_count_removed += std::ssize (matching_indices);
     mark_as_erased (matching_indices);
     decompose_into_runs ();
   }
 
-  template<typename Value, typename Interval>
-  void AugmentedIntervalList<Value, Interval>::mark_as_erased (
+  template<typename Value, typename Interval, typename Allocator>
+  void AugmentedIntervalList<Value, Interval, Allocator>::mark_as_erased (
     const VecIndices &indices)
   {
     using namespace boost::icl;
@@ -1287,17 +1832,20 @@ namespace interval_dict::augmented_interval_list
     }
   }
 
-  template<typename Value, typename Interval>
-  AugmentedIntervalList<Value, Interval> &
-  AugmentedIntervalList<Value, Interval>::merged_with (
+  template<typename Value, typename Interval, typename Allocator>
+  AugmentedIntervalList<Value, Interval, Allocator> &
+  AugmentedIntervalList<Value, Interval, Allocator>::merged_with (
     const AugmentedIntervalList &other)
   {
-    // If too few, just pretend it is a normal insert
-    if (other.m_value_intervals.size () + m_count_inserted + m_count_removed
-          < int (0.2 * m_value_intervals.size ())
-        && std::ssize (m_value_intervals) > m_min_run_length)
+    // If too few, or rebuilds are left to compact(), just pretend it is a
+    // normal insert
+    if ((!m_tuning.compact_in_foreground
+         || !exceeds_compaction_policy (std::ssize (other.m_value_intervals)
+                                        + m_count_inserted + m_count_removed))
+        && std::ssize (m_value_intervals) > m_tuning.min_run_length)
     {
-      insert (other.m_value_intervals);
+      insert ({other.m_value_intervals.begin (),
+               other.m_value_intervals.end ()});
       return *this;
     }
 
@@ -1306,22 +1854,30 @@ namespace interval_dict::augmented_interval_list
     m_value_intervals.insert (m_value_intervals.end (),
                               other.m_value_intervals.begin (),
                               other.m_value_intervals.end ());
+    // Tombstones from either list
+    details::remove_empty (m_value_intervals);
     details::sort_combine_overlapping (m_value_intervals);
+    // Rebuild all runs from scratch: nothing is pending any longer
     m_runs.clear ();
+    m_optimal_runs = 0;
+    m_count_inserted = 0;
+    m_count_removed = 0;
+    m_pending_since = {};
     decompose_into_runs ();
     return *this;
   }
 
-  template<typename Value, typename Interval>
-  AugmentedIntervalList<Value, Interval> &
-  AugmentedIntervalList<Value, Interval>::subtract_by (
+  template<typename Value, typename Interval, typename Allocator>
+  AugmentedIntervalList<Value, Interval, Allocator> &
+  AugmentedIntervalList<Value, Interval, Allocator>::subtract_by (
     const AugmentedIntervalList &other)
   {
-    // If too few, just pretend it is a normal erase
-    if (std::ssize (other.m_value_intervals) + m_count_inserted
-            + m_count_removed
-          < static_cast<int> (0.2 * m_value_intervals.size ())
-        && std::ssize (m_value_intervals) > m_min_run_length)
+    // If too few, or rebuilds are left to compact(), just pretend it is a
+    // normal erase
+    if ((!m_tuning.compact_in_foreground
+         || !exceeds_compaction_policy (std::ssize (other.m_value_intervals)
+                                        + m_count_inserted + m_count_removed))
+        && std::ssize (m_value_intervals) > m_tuning.min_run_length)
     {
       for (const auto &[value, interval] : other.m_value_intervals)
       {
@@ -1330,16 +1886,25 @@ namespace interval_dict::augmented_interval_list
       return *this;
     }
 
+    // Tombstones from either list do not sort consistently
+    details::remove_empty (m_value_intervals);
+    auto other_value_intervals = other.m_value_intervals;
+    details::remove_empty (other_value_intervals);
     m_value_intervals = details::sort_subtract_intervals (
-      m_value_intervals, other.m_value_intervals);
+      m_value_intervals, std::move (other_value_intervals));
+    // Rebuild all runs from scratch: nothing is pending any longer
     m_runs.clear ();
+    m_optimal_runs = 0;
+    m_count_inserted = 0;
+    m_count_removed = 0;
+    m_pending_since = {};
     decompose_into_runs ();
     return *this;
   }
 
-  template<typename Value, typename Interval>
+  template<typename Value, typename Interval, typename Allocator>
   ValuesDisjointInterval<Value, Interval>
-  AugmentedIntervalList<Value, Interval>::final_values () const
+  AugmentedIntervalList<Value, Interval, Allocator>::final_values () const
   {
     if (m_runs.empty ())
     {
@@ -1347,17 +1912,16 @@ namespace interval_dict::augmented_interval_list
     }
 
     // Get the maximum right edge over all runs
-    typename ValueInterval<Value, Interval>::BaseType max_right_edge
-      = m_max_right_edges[m_runs.front ().end - 1];
+    EncodedEdge max_right_edge = m_max_right_edges[m_runs.front ().end - 1];
     for (auto [begin, end] : m_runs)
     {
       assert (end > begin);
       max_right_edge = std::max (max_right_edge, m_max_right_edges[end - 1]);
     }
 
-    // The last values have intervals whose right edge match the global
-    // maximum right edge
-    std::set<Value> values;
+    // The last disjoint interval lies within all the intervals whose right
+    // edge matches the global maximum right edge
+    bool first = true;
     Interval interval;
     using comparisons::upper_edge;
     for (const auto &[begin, end] : m_runs)
@@ -1365,53 +1929,52 @@ namespace interval_dict::augmented_interval_list
       auto i = end - 1;
       while (i >= begin && m_max_right_edges[i] == max_right_edge)
       {
-        if (upper_edge (m_value_intervals[i].interval) == max_right_edge)
+        if (EdgeEncodingType::encode (
+              upper_edge (m_value_intervals[i].interval))
+            == max_right_edge)
         {
-          if (values.empty ())
-          {
-            interval = m_value_intervals[i].interval;
-          }
-          else
-          {
-            interval = interval & m_value_intervals[i].interval;
-          }
-          values.insert (m_value_intervals[i].value);
+          interval = first ? m_value_intervals[i].interval
+                           : interval & m_value_intervals[i].interval;
+          first = false;
         }
+        --i;
       }
     }
-    using namespace legacy_ranges_conversion;
-    return {values | to_vector (), interval};
+
+    // Other intervals may still end within that intersection
+    ValuesDisjointInterval<Value, Interval> final;
+    for (auto &values_interval : disjoint_intervals (interval))
+    {
+      final = std::move (values_interval);
+    }
+    return final;
   }
 
   /*
    * Implementation of AugmentedIntervalList::AllIntervalsRange
    */
-  template<typename Value, typename Interval>
-  typename AugmentedIntervalList<Value,
-                                 Interval>::AllIntervalsRange::ConstIterator &
-  AugmentedIntervalList<Value, Interval>::AllIntervalsRange::ConstIterator::
-  operator= (const typename AugmentedIntervalList<Value, Interval>::
-               AllIntervalsRange::ConstIterator &other)
+  template<typename Value, typename Interval, typename Allocator>
+  typename AugmentedIntervalList<Value, Interval, Allocator>::
+    AllIntervalsRange::ConstIterator &
+  AugmentedIntervalList<Value, Interval, Allocator>::AllIntervalsRange::
+    ConstIterator::operator= (const ConstIterator &other)
   {
     assert (&m_value_intervals == &other.m_value_intervals);
     m_runs = other.m_runs;
+    return *this;
   }
 
-  template<typename Value, typename Interval>
-  bool
-  AugmentedIntervalList<Value, Interval>::AllIntervalsRange::ConstIterator::
-  operator== (const typename AugmentedIntervalList<Value, Interval>::
-                AllIntervalsRange::ConstIterator &other) const
+  template<typename Value, typename Interval, typename Allocator>
+  bool AugmentedIntervalList<Value, Interval, Allocator>::AllIntervalsRange::
+    ConstIterator::operator== (const ConstIterator &other) const
   {
     assert (&m_value_intervals == &other.m_value_intervals);
     return (other.m_runs.size () == m_runs.size () && other.m_runs == m_runs);
   }
 
-  template<typename Value, typename Interval>
-  bool
-  AugmentedIntervalList<Value, Interval>::AllIntervalsRange::ConstIterator::
-  operator!= (const typename AugmentedIntervalList<Value, Interval>::
-                AllIntervalsRange::ConstIterator &other) const
+  template<typename Value, typename Interval, typename Allocator>
+  bool AugmentedIntervalList<Value, Interval, Allocator>::AllIntervalsRange::
+    ConstIterator::operator!= (const ConstIterator &other) const
   {
     assert (&m_value_intervals == &other.m_value_intervals);
     /*
@@ -1420,24 +1983,22 @@ namespace interval_dict::augmented_interval_list
     return (other.m_runs.size () != m_runs.size () || other.m_runs != m_runs);
   }
 
-  template<typename Value, typename Interval>
-  typename AugmentedIntervalList<Value,
-                                 Interval>::AllIntervalsRange::ConstIterator
-  AugmentedIntervalList<Value, Interval>::AllIntervalsRange::ConstIterator::
-  operator++ (int)
+  template<typename Value, typename Interval, typename Allocator>
+  typename AugmentedIntervalList<Value, Interval, Allocator>::
+    AllIntervalsRange::ConstIterator
+  AugmentedIntervalList<Value, Interval, Allocator>::AllIntervalsRange::
+    ConstIterator::operator++ (int)
   {
-    typename AugmentedIntervalList<Value,
-                                   Interval>::AllIntervalsRange::ConstIterator
-      cpy (*this);
+    ConstIterator cpy (*this);
     this->operator++ ();
     return cpy;
   }
 
-  template<typename Value, typename Interval>
-  typename AugmentedIntervalList<Value,
-                                 Interval>::AllIntervalsRange::ConstIterator &
-  AugmentedIntervalList<Value, Interval>::AllIntervalsRange::ConstIterator::
-  operator++ ()
+  template<typename Value, typename Interval, typename Allocator>
+  typename AugmentedIntervalList<Value, Interval, Allocator>::
+    AllIntervalsRange::ConstIterator &
+  AugmentedIntervalList<Value, Interval, Allocator>::AllIntervalsRange::
+    ConstIterator::operator++ ()
   {
     assert (!m_runs.empty ());
     /*
@@ -1473,27 +2034,29 @@ namespace interval_dict::augmented_interval_list
     return *this;
   }
 
-  template<typename Value, typename Interval>
-  const ValueInterval<Value, Interval> &AugmentedIntervalList<Value, Interval>::
-    AllIntervalsRange::ConstIterator::operator* () const
+  template<typename Value, typename Interval, typename Allocator>
+  const ValueInterval<Value, Interval> &
+  AugmentedIntervalList<Value, Interval, Allocator>::AllIntervalsRange::
+    ConstIterator::operator* () const
   {
     assert (!m_runs.empty ());
     assert (m_runs.back ().begin != m_runs.back ().end);
     return m_value_intervals[m_runs.back ().begin];
   }
 
-  template<typename Value, typename Interval>
-  const ValueInterval<Value, Interval> *AugmentedIntervalList<Value, Interval>::
-    AllIntervalsRange::ConstIterator::operator->() const
+  template<typename Value, typename Interval, typename Allocator>
+  const ValueInterval<Value, Interval> *
+  AugmentedIntervalList<Value, Interval, Allocator>::AllIntervalsRange::
+    ConstIterator::operator->() const
   {
     assert (!m_runs.empty ());
     assert (m_runs.back ().begin != m_runs.back ().end);
     return &m_value_intervals[m_runs.back ().begin];
   }
 
-  template<typename Value, typename Interval>
-  AugmentedIntervalList<Value, Interval>::AllIntervalsRange::AllIntervalsRange (
-    const ValueIntervals<Value, Interval> &intervals, std::vector<Run> runs)
+  template<typename Value, typename Interval, typename Allocator>
+  AugmentedIntervalList<Value, Interval, Allocator>::AllIntervalsRange::
+    AllIntervalsRange (const Storage &intervals, std::vector<Run> runs)
     : m_value_intervals (intervals)
     , m_runs (std::move (runs))
   {
@@ -1515,76 +2078,71 @@ namespace interval_dict::augmented_interval_list
                        });
   }
 
-  template<typename Value, typename Interval>
-  typename AugmentedIntervalList<Value,
-                                 Interval>::AllIntervalsRange::ConstIterator
-  AugmentedIntervalList<Value, Interval>::AllIntervalsRange::begin () const
+  template<typename Value, typename Interval, typename Allocator>
+  typename AugmentedIntervalList<Value, Interval, Allocator>::
+    AllIntervalsRange::ConstIterator
+  AugmentedIntervalList<Value, Interval, Allocator>::AllIntervalsRange::begin ()
+    const
   {
-    using ConstIterator = typename AugmentedIntervalList<Value, Interval>::
-      AllIntervalsRange::ConstIterator;
     return ConstIterator {m_value_intervals, m_runs};
   }
 
-  template<typename Value, typename Interval>
-  typename AugmentedIntervalList<Value,
-                                 Interval>::AllIntervalsRange::ConstIterator
-  AugmentedIntervalList<Value, Interval>::AllIntervalsRange::end () const
+  template<typename Value, typename Interval, typename Allocator>
+  typename AugmentedIntervalList<Value, Interval, Allocator>::
+    AllIntervalsRange::ConstIterator
+  AugmentedIntervalList<Value, Interval, Allocator>::AllIntervalsRange::end ()
+    const
   {
-    using ConstIterator = typename AugmentedIntervalList<Value, Interval>::
-      AllIntervalsRange::ConstIterator;
     return ConstIterator {m_value_intervals, {}};
   }
 
   /*
    * Implementation of AugmentedIntervalList::IntervalsRange
    */
-  template<typename Value, typename Interval>
-  typename AugmentedIntervalList<Value,
-                                 Interval>::IntervalsRange::ConstIterator &
-  AugmentedIntervalList<Value, Interval>::IntervalsRange::ConstIterator::
-  operator= (const typename AugmentedIntervalList<Value, Interval>::
-               IntervalsRange::ConstIterator &other)
+  template<typename Value, typename Interval, typename Allocator>
+  typename AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator &
+  AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator::operator= (const ConstIterator &other)
   {
     assert (&m_value_intervals == &other.m_value_intervals);
     assert (&m_indices == &other.m_indices);
     m_pos = other.m_pos;
+    return *this;
   }
 
-  template<typename Value, typename Interval>
-  bool AugmentedIntervalList<Value, Interval>::IntervalsRange::ConstIterator::
-  operator== (const typename AugmentedIntervalList<Value, Interval>::
-                IntervalsRange::ConstIterator &other) const
+  template<typename Value, typename Interval, typename Allocator>
+  bool AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator::operator== (const ConstIterator &other) const
   {
     assert (&m_value_intervals == &other.m_value_intervals);
     assert (&m_indices == &other.m_indices);
     return (other.m_pos == m_pos);
   }
 
-  template<typename Value, typename Interval>
-  bool AugmentedIntervalList<Value, Interval>::IntervalsRange::ConstIterator::
-  operator!= (const typename AugmentedIntervalList<Value, Interval>::
-                IntervalsRange::ConstIterator &other) const
+  template<typename Value, typename Interval, typename Allocator>
+  bool AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator::operator!= (const ConstIterator &other) const
   {
     return (other.m_pos != m_pos);
   }
 
-  template<typename Value, typename Interval>
-  typename AugmentedIntervalList<Value, Interval>::IntervalsRange::ConstIterator
-  AugmentedIntervalList<Value, Interval>::IntervalsRange::ConstIterator::
-  operator++ (int)
+  template<typename Value, typename Interval, typename Allocator>
+  typename AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator
+  AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator::operator++ (int)
   {
-    typename AugmentedIntervalList<Value,
-                                   Interval>::IntervalsRange::ConstIterator
-      cpy (*this);
+    ConstIterator cpy (*this);
     this->operator++ ();
     return cpy;
   }
 
-  template<typename Value, typename Interval>
-  typename AugmentedIntervalList<Value,
-                                 Interval>::IntervalsRange::ConstIterator &
-  AugmentedIntervalList<Value,
-                        Interval>::IntervalsRange::ConstIterator::operator++ ()
+  template<typename Value, typename Interval, typename Allocator>
+  typename AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator &
+  AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator::operator++ ()
   {
     /* Don't increment any more if already at end */
     if (m_pos < std::size (m_indices))
@@ -1594,9 +2152,10 @@ namespace interval_dict::augmented_interval_list
     return *this;
   }
 
-  template<typename Value, typename Interval>
-  const ValueInterval<Value, Interval> &AugmentedIntervalList<Value, Interval>::
-    IntervalsRange::ConstIterator::operator* () const
+  template<typename Value, typename Interval, typename Allocator>
+  const ValueInterval<Value, Interval> &
+  AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator::operator* () const
   {
     assert (!m_indices.empty ());
     assert (m_pos < std::size (m_indices));
@@ -1605,9 +2164,10 @@ namespace interval_dict::augmented_interval_list
     return m_value_intervals[index];
   }
 
-  template<typename Value, typename Interval>
-  const ValueInterval<Value, Interval> *AugmentedIntervalList<Value, Interval>::
-    IntervalsRange::ConstIterator::operator->() const
+  template<typename Value, typename Interval, typename Allocator>
+  const ValueInterval<Value, Interval> *
+  AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator::operator->() const
   {
     assert (!m_indices.empty ());
     assert (m_pos < std::ssize (m_indices));
@@ -1616,23 +2176,21 @@ namespace interval_dict::augmented_interval_list
     assert (index < std::ssize (m_value_intervals));
   }
 
-  template<typename Value, typename Interval>
-  typename AugmentedIntervalList<Value, Interval>::IntervalsRange::ConstIterator
-  AugmentedIntervalList<Value, Interval>::IntervalsRange::begin () const
+  template<typename Value, typename Interval, typename Allocator>
+  typename AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator
+  AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::begin ()
+    const
   {
-    using ConstIterator =
-      typename AugmentedIntervalList<Value,
-                                     Interval>::IntervalsRange::ConstIterator;
     return ConstIterator {m_value_intervals, m_indices, 0};
   }
 
-  template<typename Value, typename Interval>
-  typename AugmentedIntervalList<Value, Interval>::IntervalsRange::ConstIterator
-  AugmentedIntervalList<Value, Interval>::IntervalsRange::end () const
+  template<typename Value, typename Interval, typename Allocator>
+  typename AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::
+    ConstIterator
+  AugmentedIntervalList<Value, Interval, Allocator>::IntervalsRange::end ()
+    const
   {
-    using ConstIterator =
-      typename AugmentedIntervalList<Value,
-                                     Interval>::IntervalsRange::ConstIterator;
     return ConstIterator {m_value_intervals, m_indices, m_indices.size ()};
   }
 
@@ -1640,7 +2198,6 @@ namespace interval_dict::augmented_interval_list
 
 #endif // INCLUDE_INTERVAL_DICT_AUGMENTED_INTERVAL_LIST_H
 // TODO find other lower() and upper() dynamic intervals that break logic
-// TODO separate amortisation parameter and logic 0.2 * m_value_intervals.size()
 // TODO check calculate running_max_end still works
 // TODO tests for insertion deletions
 // TODO all intervals should step over tombstoned intervals
@@ -20,9 +20,130 @@
 #define INCLUDE_INTERVAL_DICT_BI_INTERVALDICT_H
 
 #include "intervaldict.h"
+#include "inverse_change_log.h"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 namespace interval_dict
 {
+  /// Default number of key-value changes from which BiIntervalDictExp
+  /// updates its forward and inverse dictionaries on separate threads
+  inline constexpr std::size_t default_min_count_concurrent_changes = 4096;
+
+  /// @cond Suppress_Doxygen_Warning
+  namespace details
+  {
+    /// Thread which runs one task at a time, handed over by its owner
+    class Worker
+    {
+      public:
+      Worker () = default;
+      Worker (const Worker &) = delete;
+      Worker &operator= (const Worker &) = delete;
+
+      /// Start running @p task. The previous task must have finished
+      void start (std::function<void ()> task)
+      {
+        {
+          const std::scoped_lock lock (m_mutex);
+          m_task = std::move (task);
+          m_done = false;
+        }
+        m_ready.notify_all ();
+      }
+
+      /// Wait for the task passed to start() to finish
+      void wait ()
+      {
+        std::unique_lock lock (m_mutex);
+        m_ready.wait (lock, [this] () { return m_done; });
+      }
+
+      private:
+      void run (const std::stop_token &stop)
+      {
+        std::unique_lock lock (m_mutex);
+        while (m_ready.wait (lock, stop, [this] () { return bool (m_task); }))
+        {
+          const auto task = std::exchange (m_task, nullptr);
+          lock.unlock ();
+          task ();
+          lock.lock ();
+          m_done = true;
+          m_ready.notify_all ();
+        }
+      }
+
+      std::mutex m_mutex;
+      std::condition_variable_any m_ready;
+      std::function<void ()> m_task;
+      bool m_done = true;
+      // Stopped and joined before the members it uses are destroyed
+      std::jthread m_thread {[this] (const std::stop_token &stop)
+                             {
+                               run (stop);
+                             }};
+    };
+
+    /// @return worker thread kept for the lifetime of the calling thread,
+    /// so that it is only started once
+    inline Worker &thread_worker ()
+    {
+      thread_local Worker worker;
+      return worker;
+    }
+
+    /// Run @p first on this thread while @p second runs on a worker thread
+    ///
+    /// Once both have finished, rethrows any exception from @p first, or
+    /// failing that from @p second
+    template<typename First, typename Second>
+    void run_concurrently (First &&first, Second &&second)
+    {
+      std::exception_ptr first_error;
+      std::exception_ptr second_error;
+      auto &worker = thread_worker ();
+      worker.start (
+        [&] ()
+        {
+          try
+          {
+            second ();
+          }
+          catch (...)
+          {
+            second_error = std::current_exception ();
+          }
+        });
+      try
+      {
+        first ();
+      }
+      catch (...)
+      {
+        first_error = std::current_exception ();
+      }
+      // second refers to this frame, so must finish even if first throws
+      worker.wait ();
+      if (first_error)
+      {
+        std::rethrow_exception (first_error);
+      }
+      if (second_error)
+      {
+        std::rethrow_exception (second_error);
+      }
+    }
+  } // namespace details
+  /// @endcond
+
   // forward declaration of BiIntervalDictExp
   template<typename Key,
            typename Value,
@@ -329,9 +450,12 @@ namespace interval_dict
     using OtherImplType =
       typename Implementation<Value, Interval, Impl>::template rebind<
         OtherVal>::type;
-    using DataType = std::map<Key, Impl>;
-    using InverseDataType = std::map<Key, InverseImpl>;
+    using DataType = typename ForwardDict::DataType;
+    using InverseDataType = typename InverseDict::DataType;
     using KeyValueIntervals = std::vector<std::tuple<Key, Value, Interval>>;
+    using ChangeBatchType = typename ForwardDict::ChangeBatchType;
+    using ChangeObserverType = typename ForwardDict::ChangeObserverType;
+    using ChangeBatchScope = typename ForwardDict::ChangeBatchScope;
     /// @endcond
 
     /// @name Constructors
@@ -344,10 +468,11 @@ namespace interval_dict
     BiIntervalDictExp (const BiIntervalDictExp &) = default;
     /// Default move constructor
     BiIntervalDictExp (BiIntervalDictExp &&other) noexcept = default;
-    /// Default copy assignment operator
-    BiIntervalDictExp &operator= (const BiIntervalDictExp &other) = default;
-    /// Default move assignment operator
-    BiIntervalDictExp &operator= (BiIntervalDictExp &&other) noexcept = default;
+    /// Copy assignment operator. Observers are notified as for
+    /// IntervalDictExp, after the inverse has been assigned
+    BiIntervalDictExp &operator= (const BiIntervalDictExp &other);
+    /// Move assignment operator. As for copy assignment
+    BiIntervalDictExp &operator= (BiIntervalDictExp &&other) noexcept;
 
     /// Construct from a vector of [key-value-interval]s
     explicit BiIntervalDictExp (
@@ -369,6 +494,8 @@ namespace interval_dict
     /// \param key_value_pairs is a vector of key-value
     /// \param interval defaults to `interval_extent`, i.e. The key values
     /// associations are always valid \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     insert (const std::vector<std::pair<Key, Value>> &key_value_pairs,
             Interval interval = interval_extent<Interval>);
@@ -378,6 +505,8 @@ namespace interval_dict
     /// For batch inserting key-values each for a different interval.
     /// \param key_value_intervals is a vector of Key-Value-Interval
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &insert (
       const std::vector<std::tuple<Key, Value, Interval>> &key_value_intervals);
 
@@ -393,6 +522,8 @@ namespace interval_dict
     /// underlying interval type is open/close etc.
     ///
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     insert (const std::vector<std::pair<Key, Value>> &key_value_pairs,
             BaseType first,
@@ -405,6 +536,8 @@ namespace interval_dict
     /// For batch inserting values-keys each for a different interval.
     /// \param value_key_intervals is a vector of Value-Key-Interval
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &inverse_insert (
       const std::vector<std::tuple<Value, Key, Interval>> &value_key_intervals);
 
@@ -416,6 +549,8 @@ namespace interval_dict
     /// \param value_key_pairs is a vector of value-key
     /// \param interval defaults to `interval_extent`, i.e. The key values
     /// associations are always valid \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     inverse_insert (const std::vector<std::pair<Value, Key>> &value_key_pairs,
                     Interval interval = interval_extent<Interval>);
@@ -434,6 +569,8 @@ namespace interval_dict
     /// underlying interval type is open/close etc.
     ///
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     inverse_insert (const std::vector<std::pair<Value, Key>> &value_key_pairs,
                     BaseType first,
@@ -444,6 +581,8 @@ namespace interval_dict
     /// For batch erasing key-values each for a different interval.
     /// \param key_value_intervals is a vector of Key-Value-Interval
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &erase (
       const std::vector<std::tuple<Key, Value, Interval>> &key_value_intervals);
 
@@ -453,6 +592,8 @@ namespace interval_dict
     /// \param key_value_pairs is a vector of key-value
     /// \param interval defaults to `interval_extent`, i.e. All the specified
     /// key values associations are removed over all intervals \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     erase (const std::vector<std::pair<Key, Value>> &key_value_pairs,
            Interval interval = interval_extent<Interval>);
@@ -468,6 +609,8 @@ namespace interval_dict
     ///
     /// The exact interpretation of first and last depends on whether the
     /// underlying interval type is open/close etc. \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     erase (const std::vector<std::pair<Key, Value>> &key_value_pairs,
            BaseType first,
@@ -479,6 +622,8 @@ namespace interval_dict
     /// \param interval defaults to `interval_extent`, i.e. All data for @p key
     /// are removed over all intervals
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     erase (const Key &key, Interval interval = interval_extent<Interval>);
 
@@ -492,6 +637,8 @@ namespace interval_dict
     ///
     /// The exact interpretation of first and last depends on whether the
     /// underlying interval type is open/close etc. \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     erase (const Key &key,
            BaseType first,
@@ -500,6 +647,8 @@ namespace interval_dict
     /// Erase all values over the given @p interval.
     ///
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     erase (Interval interval);
 
@@ -512,6 +661,8 @@ namespace interval_dict
     ///
     /// The exact interpretation of first and last depends on whether the
     /// underlying interval type is open/close etc. \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     erase (BaseType first,
            BaseType last = IntervalTraits<Interval>::maximum ());
@@ -523,6 +674,8 @@ namespace interval_dict
     /// For batch erasing key-values each for a different interval.
     /// \param value_key_intervals is a vector of Value-Key-Interval
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &inverse_erase (
       const std::vector<std::tuple<Value, Key, Interval>> &value_key_intervals);
 
@@ -534,6 +687,8 @@ namespace interval_dict
     /// \param interval defaults to `interval_extent`, i.e. All data for @p key
     /// are removed over all intervals
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     inverse_erase (const std::vector<std::pair<Value, Key>> &value_key_pairs,
                    Interval interval = interval_extent<Interval>);
@@ -543,6 +698,66 @@ namespace interval_dict
 
     /// @}
 
+    /// @name Inverse Maintenance
+    /// @{
+
+    /// Choose whether the inverse dictionary is updated by every insert or
+    /// erase, or only when it is next needed.
+    ///
+    /// With InverseMaintenance::lazy, changes are logged and applied as a
+    /// batch by the next inverse_find(), values() or other member function
+    /// that reads the inverse. Beyond @p max_count_pending key-value changes,
+    /// the log is dropped and the inverse is rebuilt from the forward
+    /// dictionary instead. As this happens inside const member functions,
+    /// concurrent readers must be serialised by the caller.
+    /// \param maintenance Pending changes are applied when switching to
+    /// InverseMaintenance::eager
+    /// \param max_count_pending Most key-value changes to replay
+    void set_inverse_maintenance (
+      InverseMaintenance maintenance,
+      std::size_t max_count_pending = default_max_count_inverse_changes);
+
+    /// Return when the inverse dictionary is updated
+    [[nodiscard]] InverseMaintenance inverse_maintenance () const;
+
+    /// Return the number of key-value changes not yet applied to the inverse
+    [[nodiscard]] std::size_t count_pending_inverse_changes () const;
+
+    /// Update the forward and inverse dictionaries on separate threads for
+    /// batches of at least @p min_count_changes key-value changes.
+    ///
+    /// Only applies to eager inverse maintenance. The second thread is kept
+    /// for the lifetime of the calling thread. If either update throws, the
+    /// inverse is rebuilt from the forward dictionary when next used.
+    /// \param min_count_changes `std::numeric_limits<std::size_t>::max ()`
+    /// always updates on the calling thread
+    void set_min_count_concurrent (std::size_t min_count_changes);
+
+    /// @}
+
+    /// @name Change Notification
+    /// @{
+    /// Changes to the key-value associations, whichever way they are made.
+    /// See change_feed.h
+
+    /// Calls @p observer with the changes made by each subsequent call that
+    /// modifies the dictionary. Copies of the dictionary are not observed.
+    ///
+    /// Changes are published on the calling thread once both the forward and
+    /// the inverse dictionaries have been updated, so observers may query
+    /// either, e.g. with inverse_find()
+    /// \return id for remove_observer()
+    ObserverId add_observer (ChangeObserverType observer);
+
+    /// Stops calling the observer registered as @p id
+    void remove_observer (ObserverId id);
+
+    /// Returns a scope within which all changes are published to observers as
+    /// a single batch when the scope ends
+    [[nodiscard]] ChangeBatchScope batch_changes ();
+
+    /// @}
+
     /// @name Find Member Functions
     /// @{
     /// find data for specified key(s)
@@ -639,6 +854,8 @@ namespace interval_dict
 
     /// Supplement with entries from @p other only for missing keys or gaps
     /// where a key does not map to any values. \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &fill_gaps_with (
       const BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &other);
 
@@ -657,6 +874,8 @@ namespace interval_dict
     /// all the way whatever its size)
     ///
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &fill_to_start (
       BaseType starting_point = IntervalTraits<Interval>::maximum (),
       typename IntervalTraits<Interval>::BaseDifferenceType max_extension
@@ -676,6 +895,8 @@ namespace interval_dict
     /// all the way whatever its size)
     ///
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &fill_to_end (
       BaseType starting_point = IntervalTraits<Interval>::minimum (),
       typename IntervalTraits<Interval>::BaseDifferenceType max_extension
@@ -698,6 +919,8 @@ namespace interval_dict
     /// whatever their size)
     ///
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
     extend_into_gaps (
       GapExtensionDirection gap_extension_direction
@@ -722,6 +945,8 @@ namespace interval_dict
     /// whatever their size)
     ///
     /// \return *this
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &fill_gaps (
       typename IntervalTraits<Interval>::BaseDifferenceType max_extension
       = IntervalTraits<Interval>::max_size ());
@@ -817,10 +1042,14 @@ namespace interval_dict
                                        OtherInverseImpl> &b_to_c) const;
 
     /// Returns the asymmetrical differences with another interval dictionary
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &operator-= (
       const BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &other);
 
     /// Returns the union with another interval dictionary
+    /// \note Not rolled back on exception: the inverse is rebuilt to match
+    /// whatever changes were made to the forward dictionary
     BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &operator+= (
       const BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &other);
 
@@ -844,7 +1073,7 @@ namespace interval_dict
     friend BiIntervalDictExp merge<> (BiIntervalDictExp dict_1,
                                       const BiIntervalDictExp &dict_2);
 
-    friend cppcoro::generator<std::tuple<const Key &, const Value &, Interval>>
+    friend cppcoro::generator<KeyValueInterval<Key, Value, Interval>>
     intervals<> (const BiIntervalDictExp &interval_dict,
                  std::vector<Key> keys,
                  Interval query_interval);
@@ -865,8 +1094,28 @@ namespace interval_dict
     /// @endcond
 
     private:
+    /// Apply @p update to the inverse dictionary, or to the log of pending
+    /// changes if inverse maintenance is lazy
+    template<typename Update> void update_inverse (Update update);
+
+    /// Apply @p forward_update to the forward dictionary and
+    /// @p inverse_update as for update_inverse(), concurrently for at least
+    /// m_min_count_concurrent changes
+    template<typename ForwardUpdate, typename InverseUpdate>
+    void update_both (std::size_t count_changes,
+                      ForwardUpdate forward_update,
+                      InverseUpdate inverse_update);
+
+    /// Return the inverse dictionary after applying any pending changes
+    const InverseDict &inverse () const;
+
     ForwardDict m_forward;
-    InverseDict m_inverse;
+
+    // The inverse is brought up to date by const member functions
+    mutable InverseDict m_inverse;
+    mutable details::InverseChangeLog<Key, Value, Interval> m_inverse_changes;
+    InverseMaintenance m_inverse_maintenance = InverseMaintenance::eager;
+    std::size_t m_min_count_concurrent = default_min_count_concurrent_changes;
   };
 
   /// \brief Bidirectional one-to-many dictionary where key-values vary over
@@ -916,6 +1165,48 @@ namespace interval_dict
     insert (key_value_intervals);
   }
 
+  // The forward dictionary is assigned last so that its observers are
+  // notified once the inverse is consistent with it
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
+  BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::operator= (
+    const BiIntervalDictExp &other)
+  {
+    if (this != &other)
+    {
+      m_inverse = other.m_inverse;
+      m_inverse_changes = other.m_inverse_changes;
+      m_inverse_maintenance = other.m_inverse_maintenance;
+      m_min_count_concurrent = other.m_min_count_concurrent;
+      m_forward = other.m_forward;
+    }
+    return *this;
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &
+  BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::operator= (
+    BiIntervalDictExp &&other) noexcept
+  {
+    if (this != &other)
+    {
+      m_inverse = std::move (other.m_inverse);
+      m_inverse_changes = std::move (other.m_inverse_changes);
+      m_inverse_maintenance = other.m_inverse_maintenance;
+      m_min_count_concurrent = other.m_min_count_concurrent;
+      m_forward = std::move (other.m_forward);
+    }
+    return *this;
+  }
+
   /* _____________________________________________________________________________
    *
    * Implementations of member functions
@@ -964,7 +1255,7 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::count_value (
     const Value &value) const
   {
-    return m_inverse.count (value);
+    return inverse ().count (value);
   }
 
   template<typename Key,
@@ -976,7 +1267,7 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::contains_value (
     const Value &value) const
   {
-    return m_inverse.contains (value);
+    return inverse ().contains (value);
   }
 
   template<typename Key,
@@ -986,8 +1277,182 @@ namespace interval_dict
            typename InverseImpl>
   void BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::clear ()
   {
-    m_forward.clear ();
+    // Clear the inverse first: observers are notified by the forward
+    // dictionary
     m_inverse.clear ();
+    m_inverse_changes.clear ();
+    m_forward.clear ();
+  }
+
+  /*
+   * Inverse maintenance
+   */
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  void BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::
+    set_inverse_maintenance (InverseMaintenance maintenance,
+                             std::size_t max_count_pending)
+  {
+    inverse ();
+    m_inverse_maintenance = maintenance;
+    m_inverse_changes
+      = details::InverseChangeLog<Key, Value, Interval> (max_count_pending);
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  InverseMaintenance
+  BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::
+    inverse_maintenance () const
+  {
+    return m_inverse_maintenance;
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  std::size_t BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::
+    count_pending_inverse_changes () const
+  {
+    return m_inverse_changes.count_changes ();
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  void BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::
+    set_min_count_concurrent (std::size_t min_count_changes)
+  {
+    m_min_count_concurrent = min_count_changes;
+  }
+
+  /*
+   * Change notification
+   */
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  ObserverId
+  BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::add_observer (
+    ChangeObserverType observer)
+  {
+    return m_forward.add_observer (std::move (observer));
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  void
+  BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::remove_observer (
+    ObserverId id)
+  {
+    m_forward.remove_observer (id);
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  typename BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::
+    ChangeBatchScope
+    BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::batch_changes ()
+  {
+    return m_forward.batch_changes ();
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  template<typename ForwardUpdate, typename InverseUpdate>
+  void BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::update_both (
+    std::size_t count_changes,
+    ForwardUpdate forward_update,
+    InverseUpdate inverse_update)
+  {
+    // Publish changes to observers only once both dictionaries are updated,
+    // including after an exception has been handled below
+    const auto batch = m_forward.batch_changes ();
+    try
+    {
+      if (m_inverse_maintenance == InverseMaintenance::eager
+          && count_changes >= m_min_count_concurrent)
+      {
+        details::run_concurrently (
+          [&] ()
+          {
+            forward_update (m_forward);
+          },
+          [&] ()
+          {
+            inverse_update (m_inverse);
+          });
+      }
+      else
+      {
+        forward_update (m_forward);
+        update_inverse (inverse_update);
+      }
+    }
+    catch (...)
+    {
+      // Whatever state the forward dictionary was left in, the inverse can
+      // be made consistent with it
+      m_inverse_changes.rebuild ();
+      throw;
+    }
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  template<typename Update>
+  void
+  BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::update_inverse (
+    Update update)
+  {
+    if (m_inverse_maintenance == InverseMaintenance::lazy)
+    {
+      update (m_inverse_changes);
+    }
+    else
+    {
+      update (m_inverse);
+    }
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename InverseImpl>
+  const typename BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::
+    InverseDict &
+    BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::inverse () const
+  {
+    if (!m_inverse_changes.empty ())
+    {
+      m_inverse_changes.apply (m_forward, m_inverse);
+    }
+    return m_inverse;
   }
 
   /*
@@ -1005,8 +1470,16 @@ namespace interval_dict
   {
     if (!boost::icl::is_empty (interval))
     {
-      m_forward.insert (key_value_pairs, interval);
-      m_inverse.inverse_insert (key_value_pairs, interval);
+      update_both (
+        key_value_pairs.size (),
+        [&] (ForwardDict &forward)
+        {
+          forward.insert (key_value_pairs, interval);
+        },
+        [&] (auto &inverse)
+        {
+          inverse.inverse_insert (key_value_pairs, interval);
+        });
     }
     return *this;
   }
@@ -1020,8 +1493,16 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::insert (
     const std::vector<std::tuple<Key, Value, Interval>> &key_value_intervals)
   {
-    m_forward.insert (key_value_intervals);
-    m_inverse.inverse_insert (key_value_intervals);
+    update_both (
+      key_value_intervals.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward.insert (key_value_intervals);
+      },
+      [&] (auto &inverse)
+      {
+        inverse.inverse_insert (key_value_intervals);
+      });
     return *this;
   }
 
@@ -1053,8 +1534,16 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::inverse_insert (
     const std::vector<std::tuple<Value, Key, Interval>> &value_key_intervals)
   {
-    m_forward.inverse_insert (value_key_intervals);
-    m_inverse.insert (value_key_intervals);
+    update_both (
+      value_key_intervals.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward.inverse_insert (value_key_intervals);
+      },
+      [&] (auto &inverse)
+      {
+        inverse.insert (value_key_intervals);
+      });
     return *this;
   }
 
@@ -1070,8 +1559,16 @@ namespace interval_dict
   {
     if (!boost::icl::is_empty (interval))
     {
-      m_forward.inverse_insert (value_key_pairs, interval);
-      m_inverse.insert (value_key_pairs, interval);
+      update_both (
+        value_key_pairs.size (),
+        [&] (ForwardDict &forward)
+        {
+          forward.inverse_insert (value_key_pairs, interval);
+        },
+        [&] (auto &inverse)
+        {
+          inverse.insert (value_key_pairs, interval);
+        });
     }
     return *this;
   }
@@ -1104,8 +1601,16 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::erase (
     const std::vector<std::tuple<Key, Value, Interval>> &key_value_intervals)
   {
-    m_forward.erase (key_value_intervals);
-    m_inverse.inverse_erase (key_value_intervals);
+    update_both (
+      key_value_intervals.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward.erase (key_value_intervals);
+      },
+      [&] (auto &inverse)
+      {
+        inverse.inverse_erase (key_value_intervals);
+      });
     return *this;
   }
 
@@ -1124,8 +1629,16 @@ namespace interval_dict
       return *this;
     }
 
-    m_forward.erase (key_value_pairs, interval);
-    m_inverse.inverse_erase (key_value_pairs, interval);
+    update_both (
+      key_value_pairs.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward.erase (key_value_pairs, interval);
+      },
+      [&] (auto &inverse)
+      {
+        inverse.inverse_erase (key_value_pairs, interval);
+      });
     return *this;
   }
 
@@ -1159,12 +1672,22 @@ namespace interval_dict
       return *this;
     }
 
-    const auto values = m_forward.find (key, interval);
-    m_forward.erase (key, interval);
-    for (const auto &value : values)
+    // Only erase the inverse associations back to this key
+    std::vector<std::pair<Key, Value>> key_value_pairs;
+    for (const auto &value : m_forward.find (key, interval))
     {
-      m_inverse.erase (value, interval);
+      key_value_pairs.emplace_back (key, value);
     }
+    update_both (
+      key_value_pairs.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward.erase (key, interval);
+      },
+      [&] (auto &inverse)
+      {
+        inverse.inverse_erase (key_value_pairs, interval);
+      });
     return *this;
   }
 
@@ -1195,8 +1718,16 @@ namespace interval_dict
   {
     if (!boost::icl::is_empty (interval))
     {
-      m_forward.erase (interval);
-      m_inverse.erase (interval);
+      update_both (
+        m_forward.size (),
+        [&] (ForwardDict &forward)
+        {
+          forward.erase (interval);
+        },
+        [&] (auto &inverse)
+        {
+          inverse.erase (interval);
+        });
     }
 
     return *this;
@@ -1229,8 +1760,16 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::inverse_erase (
     const std::vector<std::tuple<Value, Key, Interval>> &value_key_intervals)
   {
-    m_forward.inverse_erase (value_key_intervals);
-    m_inverse.erase (value_key_intervals);
+    update_both (
+      value_key_intervals.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward.inverse_erase (value_key_intervals);
+      },
+      [&] (auto &inverse)
+      {
+        inverse.erase (value_key_intervals);
+      });
     return *this;
   }
 
@@ -1246,8 +1785,16 @@ namespace interval_dict
   {
     if (!boost::icl::is_empty (interval))
     {
-      m_forward.inverse_erase (value_key_pairs, interval);
-      m_inverse.erase (value_key_pairs, interval);
+      update_both (
+        value_key_pairs.size (),
+        [&] (ForwardDict &forward)
+        {
+          forward.inverse_erase (value_key_pairs, interval);
+        },
+        [&] (auto &inverse)
+        {
+          inverse.erase (value_key_pairs, interval);
+        });
     }
 
     return *this;
@@ -1336,7 +1883,7 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::inverse_find (
     const Value &value, const Intervals &query_intervals) const
   {
-    return m_inverse.find (value, query_intervals);
+    return inverse ().find (value, query_intervals);
   }
 
   template<typename Key,
@@ -1348,7 +1895,7 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::inverse_find (
     const std::vector<Value> &values, Interval query_interval) const
   {
-    return m_inverse.find (values, query_interval);
+    return inverse ().find (values, query_interval);
   }
 
   /// @cond Suppress_Doxygen_Warning
@@ -1415,7 +1962,7 @@ namespace interval_dict
   std::vector<Value>
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::values () const
   {
-    return m_inverse.keys ();
+    return inverse ().keys ();
   }
 
   template<typename Key,
@@ -1438,7 +1985,7 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::inverse_size ()
     const
   {
-    return m_inverse.size ();
+    return inverse ().size ();
   }
 
   /*
@@ -1501,7 +2048,7 @@ namespace interval_dict
     }
     return BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> ()
       .inverse_insert (
-        details::subset_inserts (m_inverse, values_subset, query_interval));
+        details::subset_inserts (inverse (), values_subset, query_interval));
   }
 
   /*
@@ -1516,7 +2063,7 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::invert () const &
   {
     return BiIntervalDictExp<Value, Key, Interval, InverseImpl, Impl> (
-      m_inverse, m_forward);
+      inverse (), m_forward);
   }
 
   template<typename Key,
@@ -1527,6 +2074,7 @@ namespace interval_dict
   BiIntervalDictExp<Value, Key, Interval, InverseImpl, Impl>
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::invert () &&
   {
+    inverse ();
     return BiIntervalDictExp<Value, Key, Interval, InverseImpl, Impl> (
       std::move (m_inverse), std::move (m_forward));
   }
@@ -1543,8 +2091,24 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::operator-= (
     const BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &other)
   {
-    m_forward -= other.m_forward;
-    m_inverse -= other.m_inverse;
+    update_both (
+      other.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward -= other.m_forward;
+      },
+      [&] (auto &inverse)
+      {
+        if constexpr (std::is_same_v<std::decay_t<decltype (inverse)>,
+                                     InverseDict>)
+        {
+          inverse -= other.inverse ();
+        }
+        else
+        {
+          inverse.rebuild ();
+        }
+      });
     return *this;
   }
 
@@ -1558,8 +2122,24 @@ namespace interval_dict
   BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl>::operator+= (
     const BiIntervalDictExp<Key, Value, Interval, Impl, InverseImpl> &other)
   {
-    m_forward += other.m_forward;
-    m_inverse += other.m_inverse;
+    update_both (
+      other.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward += other.m_forward;
+      },
+      [&] (auto &inverse)
+      {
+        if constexpr (std::is_same_v<std::decay_t<decltype (inverse)>,
+                                     InverseDict>)
+        {
+          inverse += other.inverse ();
+        }
+        else
+        {
+          inverse.rebuild ();
+        }
+      });
     return *this;
   }
 
@@ -1581,13 +2161,49 @@ namespace interval_dict
     const BiIntervalDictExp<B, C, Interval, OtherImpl, OtherInverseImpl>
       &b_to_c) const
   {
+    using Results
+      = BiIntervalDictExp<A, C, Interval, OtherImplType<C>, InverseImpl>;
+    if (m_inverse_maintenance == InverseMaintenance::lazy)
+    {
+      // Leave the inverse to be built when it is first needed
+      Results results;
+      results.m_forward = m_forward.joined_to (b_to_c.m_forward);
+      results.m_inverse_maintenance = InverseMaintenance::lazy;
+      results.m_inverse_changes.rebuild ();
+      return results;
+    }
+
+    // C -> A is C -> B joined to B -> A, so the inverse can be joined at
+    // the same time as the forward dictionary instead of inverting it
+    // afterwards
+    const auto &c_to_b = b_to_c.inverse ();
+    const auto &b_to_a = inverse ();
+    using InverseResults = typename Results::InverseDict;
+    if constexpr (std::is_same_v<decltype (c_to_b.joined_to (b_to_a)),
+                                 InverseResults>)
+    {
+      if (m_forward.size () + b_to_c.m_forward.size ()
+          >= m_min_count_concurrent)
+      {
+        // The results are not yet observed, so there are no changes to
+        // publish while the inverse is being joined
+        typename Results::ForwardDict forward;
+        InverseResults inverse;
+        details::run_concurrently (
+          [&] ()
+          {
+            forward = m_forward.joined_to (b_to_c.m_forward);
+          },
+          [&] ()
+          {
+            inverse = c_to_b.joined_to (b_to_a);
+          });
+        return Results {std::move (forward), std::move (inverse)};
+      }
+    }
     auto forward = m_forward.joined_to (b_to_c.m_forward);
-    // Since we are creating forward from scratch, there is little advantage in
-    // doing the same operation with m_inverse rather than just inverting the
-    // results of the forward operation
     auto inverse = forward.invert ();
-    return BiIntervalDictExp<A, C, Interval, OtherImplType<C>, InverseImpl> {
-      std::move (forward), std::move (inverse)};
+    return Results {std::move (forward), std::move (inverse)};
   }
   /// @endcond
 
@@ -1602,8 +2218,16 @@ namespace interval_dict
   {
     const auto insertions
       = details::fill_gaps_with_inserts (m_forward, other.m_forward);
-    m_forward.insert (insertions);
-    m_inverse.inverse_insert (insertions);
+    update_both (
+      insertions.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward.insert (insertions);
+      },
+      [&] (auto &inverse)
+      {
+        inverse.inverse_insert (insertions);
+      });
     return *this;
   }
 
@@ -1623,8 +2247,16 @@ namespace interval_dict
   {
     const auto insertions = details::fill_to_start_inserts (
       m_forward, starting_point, max_extension);
-    m_forward.insert (insertions);
-    m_inverse.inverse_insert (insertions);
+    update_both (
+      insertions.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward.insert (insertions);
+      },
+      [&] (auto &inverse)
+      {
+        inverse.inverse_insert (insertions);
+      });
     return *this;
   }
   /// @endcond
@@ -1642,8 +2274,16 @@ namespace interval_dict
   {
     const auto insertions
       = details::fill_to_end_inserts (m_forward, starting_point, max_extension);
-    m_forward.insert (insertions);
-    m_inverse.inverse_insert (insertions);
+    update_both (
+      insertions.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward.insert (insertions);
+      },
+      [&] (auto &inverse)
+      {
+        inverse.inverse_insert (insertions);
+      });
     return *this;
   }
   /// @endcond
@@ -1660,8 +2300,16 @@ namespace interval_dict
   {
     const auto insertions = details::extend_into_gaps_inserts (
       m_forward, gap_extension_direction, max_extension);
-    m_forward.insert (insertions);
-    m_inverse.inverse_insert (insertions);
+    update_both (
+      insertions.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward.insert (insertions);
+      },
+      [&] (auto &inverse)
+      {
+        inverse.inverse_insert (insertions);
+      });
     return *this;
   }
 
@@ -1676,8 +2324,16 @@ namespace interval_dict
   {
     const auto insertions
       = details::fill_gaps_inserts (m_forward, max_extension);
-    m_forward.insert (insertions);
-    m_inverse.inverse_insert (insertions);
+    update_both (
+      insertions.size (),
+      [&] (ForwardDict &forward)
+      {
+        forward.insert (insertions);
+      },
+      [&] (auto &inverse)
+      {
+        inverse.inverse_insert (insertions);
+      });
     return *this;
   }
 
@@ -1885,8 +2541,11 @@ namespace interval_dict
   {
     const auto [insertions, erasures]
       = details::flatten_actions (interval_dict.m_forward, keep_one_value);
-    interval_dict.insert (insertions);
-    interval_dict.erase (erasures);
+    {
+      const auto batch = interval_dict.batch_changes ();
+      interval_dict.insert (insertions);
+      interval_dict.erase (erasures);
+    }
     return interval_dict;
   }
 
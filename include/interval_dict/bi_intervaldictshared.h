@@ -0,0 +1,830 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file bi_intervaldictshared.h
+/// \brief Bidirectional interval dictionary storing each association once
+///
+/// BiIntervalDictExp holds a complete IntervalDictExp in each direction, so
+/// every key-value-interval is stored and updated twice.
+/// BiIntervalDictSharedExp instead keeps a single AssociationTable of key id,
+/// value id and interval, with a RowIndex of row ids for each key and for
+/// each value. Only the row ids are duplicated, roughly halving memory for
+/// large dictionaries.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_BI_INTERVALDICTSHARED_H
+#define INCLUDE_INTERVAL_DICT_BI_INTERVALDICTSHARED_H
+
+#include "adaptor.h"
+#include "association_table.h"
+#include "intervaldict.h"
+#include "memory_usage.h"
+
+#include <boost/icl/concept/interval.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <set>
+#include <tuple>
+#include <vector>
+
+namespace interval_dict
+{
+  /**
+   * @brief Bidirectional interval dictionary with a single shared table of
+   * associations
+   *
+   * Supports the same insert, erase and find operations in both directions
+   * as BiIntervalDictExp. As in the other implementations, overlapping or
+   * touching intervals for the same key and value are merged on insert.
+   *
+   * @tparam Key Type of keys
+   * @tparam Value Type of Values
+   * @tparam Interval Interval Type. E.g. boost::icl::right_open_interval<Date>
+   */
+  template<typename Key, typename Value, typename Interval>
+  class BiIntervalDictSharedExp
+  {
+    public:
+    /// @cond Suppress_Doxygen_Warning
+    using IntervalType = Interval;
+    using BaseType = typename IntervalTraits<Interval>::BaseType;
+    using KeyType = Key;
+    using ValType = Value;
+    // boost icl interval_set of Intervals
+    using Intervals = interval_dict::Intervals<Interval>;
+    using KeyValueIntervals = std::vector<std::tuple<Key, Value, Interval>>;
+    /// @endcond
+
+    /// @name Constructors
+    /// @{
+
+    /// Default Constructor
+    BiIntervalDictSharedExp () = default;
+
+    /// Construct from a vector of [key-value-interval]s
+    explicit BiIntervalDictSharedExp (
+      const KeyValueIntervals &key_value_intervals);
+
+    /// @}
+    /// @name Insert and Erase Member Functions
+    /// @{
+
+    /// Insert a key-value association valid over @p interval
+    BiIntervalDictSharedExp &
+    insert (const Key &key, const Value &value, const Interval &interval);
+
+    /// Insert [key-value-interval]s
+    BiIntervalDictSharedExp &
+    insert (const KeyValueIntervals &key_value_intervals);
+
+    /// Insert a value-key association valid over @p interval
+    BiIntervalDictSharedExp &inverse_insert (const Value &value,
+                                             const Key &key,
+                                             const Interval &interval);
+
+    /// Erase a key-value association over @p interval
+    BiIntervalDictSharedExp &
+    erase (const Key &key, const Value &value, const Interval &interval);
+
+    /// Erase [key-value-interval]s
+    BiIntervalDictSharedExp &
+    erase (const KeyValueIntervals &key_value_intervals);
+
+    /// Erase all values for @p key over @p interval
+    BiIntervalDictSharedExp &
+    erase (const Key &key, Interval interval = interval_extent<Interval>);
+
+    /// Erase all keys and values over @p interval
+    BiIntervalDictSharedExp &erase (Interval interval);
+
+    /// Erase a value-key association over @p interval
+    BiIntervalDictSharedExp &inverse_erase (const Value &value,
+                                            const Key &key,
+                                            const Interval &interval);
+
+    /// Erase all keys for @p value over @p interval
+    BiIntervalDictSharedExp &
+    inverse_erase (const Value &value,
+                   Interval interval = interval_extent<Interval>);
+
+    /// erase all keys
+    void clear ();
+
+    /// @}
+    /// @name Find Member Functions
+    /// @{
+
+    /// Returns all mapped values in a sorted list for the specified @p key on
+    /// the given query start. Only really makes sense for closed intervals
+    [[nodiscard]] std::vector<Value> find (const Key &key,
+                                           BaseType query) const;
+
+    /// Returns all mapped values in a sorted list for the specified @p key on
+    /// the given query interval from @p first to @p last
+    [[nodiscard]] std::vector<Value>
+    find (const Key &key, BaseType first, BaseType last) const;
+
+    /// Returns all mapped values in a sorted list for the specified @p key on
+    /// the given query interval
+    [[nodiscard]] std::vector<Value>
+    find (const Key &key, Interval interval = interval_extent<Interval>) const;
+
+    /// Returns all mapped values in a sorted list for the specified @p keys on
+    /// the given query interval
+    [[nodiscard]] std::vector<Value> find (const std::vector<Key> &keys,
+                                           Interval interval
+                                           = interval_extent<Interval>) const;
+
+    /// Returns all mapped values in a sorted list for the specified @p key on
+    /// the given query intervals
+    [[nodiscard]] std::vector<Value>
+    find (const Key &key, const Intervals &query_intervals) const;
+
+    /// Returns all mapped keys in a sorted list for the specified @p value on
+    /// the given query start. Only really makes sense for closed intervals
+    [[nodiscard]] std::vector<Key> inverse_find (const Value &value,
+                                                 BaseType query) const;
+
+    /// Returns all mapped keys in a sorted list for the specified @p value on
+    /// the given query interval from @p first to @p last
+    [[nodiscard]] std::vector<Key>
+    inverse_find (const Value &value, BaseType first, BaseType last) const;
+
+    /// Returns all mapped keys in a sorted list for the specified @p value on
+    /// the given query interval
+    [[nodiscard]] std::vector<Key>
+    inverse_find (const Value &value,
+                  Interval interval = interval_extent<Interval>) const;
+
+    /// Returns all mapped keys in a sorted list for the specified @p values
+    /// on the given query interval
+    [[nodiscard]] std::vector<Key>
+    inverse_find (const std::vector<Value> &values,
+                  Interval interval = interval_extent<Interval>) const;
+
+    /// Returns all mapped keys in a sorted list for the specified @p value on
+    /// the given query intervals
+    [[nodiscard]] std::vector<Key>
+    inverse_find (const Value &value, const Intervals &query_intervals) const;
+
+    /// @}
+
+    /// Return all keys in sorted order
+    [[nodiscard]] std::vector<Key> keys () const;
+
+    /// Return all values in sorted order
+    [[nodiscard]] std::vector<Value> values () const;
+
+    /// Returns the number of unique keys
+    [[nodiscard]] std::size_t size () const;
+
+    /// Returns the number of unique values
+    [[nodiscard]] std::size_t inverse_size () const;
+
+    /// Return whether there are no keys
+    [[nodiscard]] bool empty () const;
+
+    /// Return whether the specified key is in the dictionary
+    [[nodiscard]] std::size_t count (const Key &key) const;
+
+    /// Return whether the specified value is in the dictionary
+    [[nodiscard]] std::size_t count_value (const Value &value) const;
+
+    /// Return whether the specified key is in the dictionary
+    [[nodiscard]] bool contains (const Key &key) const;
+
+    /// Return whether the specified value is in the dictionary
+    [[nodiscard]] bool contains_value (const Value &value) const;
+
+    /// Returns all [key-value-interval]s overlapping @p query_interval,
+    /// sorted by key, then interval, then value
+    [[nodiscard]] KeyValueIntervals
+    intervals (Interval query_interval = interval_extent<Interval>) const;
+
+    /// Returns a dictionary from values to keys
+    [[nodiscard]] BiIntervalDictSharedExp<Value, Key, Interval> invert () const;
+
+    /// Bytes used by the association table and indexes
+    [[nodiscard]] MemoryUsage memory_usage () const;
+
+    /// Equality operator
+    bool operator== (const BiIntervalDictSharedExp &rhs) const;
+
+    /// Inequality operator
+    bool operator!= (const BiIntervalDictSharedExp &rhs) const;
+
+    private:
+    using RowId = association_table::RowId;
+    using Id = association_table::Id;
+
+    /// Add a row to the table and to the indexes of its key and value
+    void add_row (Id key_id, Id value_id, const Interval &interval);
+
+    /// Remove a row from the indexes of its key and value, and the table
+    void remove_row (RowId row);
+
+    /// Insert, merging with touching or overlapping rows with the same value
+    void insert_ids (Id key_id, Id value_id, const Interval &interval);
+
+    /// Remove @p interval from each of @p rows, keeping any remainder
+    void erase_rows (const std::vector<RowId> &rows, const Interval &interval);
+
+    /// @return rows in @p index overlapping @p interval
+    [[nodiscard]] std::vector<RowId>
+    overlapping_rows (const association_table::RowIndex<Interval> &index,
+                      const Interval &interval) const;
+
+    association_table::AssociationTable<Interval> m_table;
+    association_table::IdIndex<Key, Interval> m_keys;
+    association_table::IdIndex<Value, Interval> m_values;
+  };
+
+  /*
+   * _____________________________________________________________________________
+   *
+   * Implementation
+   *
+   */
+
+  /*
+   * Constructors
+   */
+  template<typename Key, typename Value, typename Interval>
+  BiIntervalDictSharedExp<Key, Value, Interval>::BiIntervalDictSharedExp (
+    const KeyValueIntervals &key_value_intervals)
+  {
+    insert (key_value_intervals);
+  }
+
+  /*
+   * Private helpers
+   */
+  template<typename Key, typename Value, typename Interval>
+  void BiIntervalDictSharedExp<Key, Value, Interval>::add_row (
+    Id key_id, Id value_id, const Interval &interval)
+  {
+    const auto row = m_table.insert (key_id, value_id, interval);
+    m_keys.index (key_id).insert (m_table, row);
+    m_values.index (value_id).insert (m_table, row);
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  void BiIntervalDictSharedExp<Key, Value, Interval>::remove_row (RowId row)
+  {
+    // Marked as erased first, so that the indexes can keep it as a tombstone
+    m_table.erase (row);
+    m_keys.index (m_table.key_id (row)).erase (m_table, row);
+    m_values.index (m_table.value_id (row)).erase (m_table, row);
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  void BiIntervalDictSharedExp<Key, Value, Interval>::insert_ids (
+    Id key_id, Id value_id, const Interval &interval)
+  {
+    std::vector<RowId> merged_rows;
+    m_keys.index (key_id).for_each_touching (
+      m_table,
+      interval,
+      [&] (RowId row)
+      {
+        if (m_table.value_id (row) == value_id)
+        {
+          merged_rows.push_back (row);
+        }
+      });
+
+    auto merged = interval;
+    for (const auto row : merged_rows)
+    {
+      merged = boost::icl::hull (merged, m_table.interval (row));
+      remove_row (row);
+    }
+    add_row (key_id, value_id, merged);
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  void BiIntervalDictSharedExp<Key, Value, Interval>::erase_rows (
+    const std::vector<RowId> &rows, const Interval &interval)
+  {
+    for (const auto row : rows)
+    {
+      const auto key_id = m_table.key_id (row);
+      const auto value_id = m_table.value_id (row);
+      const auto original = m_table.interval (row);
+      remove_row (row);
+
+      // Keep the parts of the row before and after the erased interval
+      const auto before = boost::icl::right_subtract (original, interval);
+      if (!boost::icl::is_empty (before))
+      {
+        add_row (key_id, value_id, before);
+      }
+      const auto after = boost::icl::left_subtract (original, interval);
+      if (!boost::icl::is_empty (after))
+      {
+        add_row (key_id, value_id, after);
+      }
+      m_keys.release_if_empty (key_id);
+      m_values.release_if_empty (value_id);
+    }
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::vector<association_table::RowId>
+  BiIntervalDictSharedExp<Key, Value, Interval>::overlapping_rows (
+    const association_table::RowIndex<Interval> &index,
+    const Interval &interval) const
+  {
+    std::vector<RowId> rows;
+    index.for_each_overlapping (m_table,
+                                interval,
+                                [&] (RowId row)
+                                {
+                                  rows.push_back (row);
+                                });
+    return rows;
+  }
+
+  /*
+   * Insert
+   */
+  template<typename Key, typename Value, typename Interval>
+  BiIntervalDictSharedExp<Key, Value, Interval> &
+  BiIntervalDictSharedExp<Key, Value, Interval>::insert (
+    const Key &key, const Value &value, const Interval &interval)
+  {
+    if (!boost::icl::is_empty (interval))
+    {
+      insert_ids (m_keys.insert (key), m_values.insert (value), interval);
+    }
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  BiIntervalDictSharedExp<Key, Value, Interval> &
+  BiIntervalDictSharedExp<Key, Value, Interval>::insert (
+    const KeyValueIntervals &key_value_intervals)
+  {
+    for (const auto &[key, value, interval] : key_value_intervals)
+    {
+      insert (key, value, interval);
+    }
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  BiIntervalDictSharedExp<Key, Value, Interval> &
+  BiIntervalDictSharedExp<Key, Value, Interval>::inverse_insert (
+    const Value &value, const Key &key, const Interval &interval)
+  {
+    return insert (key, value, interval);
+  }
+
+  /*
+   * Erase
+   */
+  template<typename Key, typename Value, typename Interval>
+  BiIntervalDictSharedExp<Key, Value, Interval> &
+  BiIntervalDictSharedExp<Key, Value, Interval>::erase (
+    const Key &key, const Value &value, const Interval &interval)
+  {
+    if (boost::icl::is_empty (interval))
+    {
+      return *this;
+    }
+    const auto key_id = m_keys.find (key);
+    const auto value_id = m_values.find (value);
+    if (!key_id || !value_id)
+    {
+      return *this;
+    }
+    auto rows = overlapping_rows (m_keys.index (*key_id), interval);
+    std::erase_if (rows,
+                   [&] (RowId row)
+                   {
+                     return m_table.value_id (row) != *value_id;
+                   });
+    erase_rows (rows, interval);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  BiIntervalDictSharedExp<Key, Value, Interval> &
+  BiIntervalDictSharedExp<Key, Value, Interval>::erase (
+    const KeyValueIntervals &key_value_intervals)
+  {
+    for (const auto &[key, value, interval] : key_value_intervals)
+    {
+      erase (key, value, interval);
+    }
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  BiIntervalDictSharedExp<Key, Value, Interval> &
+  BiIntervalDictSharedExp<Key, Value, Interval>::erase (const Key &key,
+                                                        Interval interval)
+  {
+    if (boost::icl::is_empty (interval))
+    {
+      return *this;
+    }
+    if (const auto key_id = m_keys.find (key))
+    {
+      erase_rows (overlapping_rows (m_keys.index (*key_id), interval),
+                  interval);
+    }
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  BiIntervalDictSharedExp<Key, Value, Interval> &
+  BiIntervalDictSharedExp<Key, Value, Interval>::erase (Interval interval)
+  {
+    if (boost::icl::is_empty (interval))
+    {
+      return *this;
+    }
+    // erase_rows() may release key ids, so collect all rows first
+    std::vector<RowId> rows;
+    for (const auto &[_, key_id] : m_keys.ids ())
+    {
+      const auto key_rows = overlapping_rows (m_keys.index (key_id), interval);
+      rows.insert (rows.end (), key_rows.begin (), key_rows.end ());
+    }
+    erase_rows (rows, interval);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  BiIntervalDictSharedExp<Key, Value, Interval> &
+  BiIntervalDictSharedExp<Key, Value, Interval>::inverse_erase (
+    const Value &value, const Key &key, const Interval &interval)
+  {
+    return erase (key, value, interval);
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  BiIntervalDictSharedExp<Key, Value, Interval> &
+  BiIntervalDictSharedExp<Key, Value, Interval>::inverse_erase (
+    const Value &value, Interval interval)
+  {
+    if (boost::icl::is_empty (interval))
+    {
+      return *this;
+    }
+    if (const auto value_id = m_values.find (value))
+    {
+      erase_rows (overlapping_rows (m_values.index (*value_id), interval),
+                  interval);
+    }
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  void BiIntervalDictSharedExp<Key, Value, Interval>::clear ()
+  {
+    m_table.clear ();
+    m_keys.clear ();
+    m_values.clear ();
+  }
+
+  /*
+   * find
+   */
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Value> BiIntervalDictSharedExp<Key, Value, Interval>::find (
+    const Key &key, const Intervals &query_intervals) const
+  {
+    const auto key_id = m_keys.find (key);
+    if (!key_id)
+    {
+      return {};
+    }
+    std::set<Value> unique_results;
+    for (const auto &query_interval : query_intervals)
+    {
+      m_keys.index (*key_id).for_each_overlapping (
+        m_table,
+        query_interval,
+        [&] (RowId row)
+        {
+          unique_results.insert (m_values.item (m_table.value_id (row)));
+        });
+    }
+    return {unique_results.begin (), unique_results.end ()};
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Value> BiIntervalDictSharedExp<Key, Value, Interval>::find (
+    const std::vector<Key> &keys, Interval query_interval) const
+  {
+    if (boost::icl::is_empty (query_interval))
+    {
+      return {};
+    }
+    std::set<Value> unique_results;
+    for (const auto &key : keys)
+    {
+      const auto key_id = m_keys.find (key);
+      if (!key_id)
+      {
+        continue;
+      }
+      m_keys.index (*key_id).for_each_overlapping (
+        m_table,
+        query_interval,
+        [&] (RowId row)
+        {
+          unique_results.insert (m_values.item (m_table.value_id (row)));
+        });
+    }
+    return {unique_results.begin (), unique_results.end ()};
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Value> BiIntervalDictSharedExp<Key, Value, Interval>::find (
+    const Key &key, BaseType query) const
+  {
+    return find (key, Interval {query, query});
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Value> BiIntervalDictSharedExp<Key, Value, Interval>::find (
+    const Key &key, BaseType first, BaseType last) const
+  {
+    return find (std::vector {key}, Interval {first, last});
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Value>
+  BiIntervalDictSharedExp<Key, Value, Interval>::find (const Key &key,
+                                                       Interval interval) const
+  {
+    return find (std::vector {key}, interval);
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Key> BiIntervalDictSharedExp<Key, Value, Interval>::inverse_find (
+    const Value &value, const Intervals &query_intervals) const
+  {
+    const auto value_id = m_values.find (value);
+    if (!value_id)
+    {
+      return {};
+    }
+    std::set<Key> unique_results;
+    for (const auto &query_interval : query_intervals)
+    {
+      m_values.index (*value_id).for_each_overlapping (
+        m_table,
+        query_interval,
+        [&] (RowId row)
+        {
+          unique_results.insert (m_keys.item (m_table.key_id (row)));
+        });
+    }
+    return {unique_results.begin (), unique_results.end ()};
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Key> BiIntervalDictSharedExp<Key, Value, Interval>::inverse_find (
+    const std::vector<Value> &values, Interval query_interval) const
+  {
+    if (boost::icl::is_empty (query_interval))
+    {
+      return {};
+    }
+    std::set<Key> unique_results;
+    for (const auto &value : values)
+    {
+      const auto value_id = m_values.find (value);
+      if (!value_id)
+      {
+        continue;
+      }
+      m_values.index (*value_id).for_each_overlapping (
+        m_table,
+        query_interval,
+        [&] (RowId row)
+        {
+          unique_results.insert (m_keys.item (m_table.key_id (row)));
+        });
+    }
+    return {unique_results.begin (), unique_results.end ()};
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Key> BiIntervalDictSharedExp<Key, Value, Interval>::inverse_find (
+    const Value &value, BaseType query) const
+  {
+    return inverse_find (std::vector {value}, Interval {query, query});
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Key> BiIntervalDictSharedExp<Key, Value, Interval>::inverse_find (
+    const Value &value, BaseType first, BaseType last) const
+  {
+    return inverse_find (std::vector {value}, Interval {first, last});
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Key> BiIntervalDictSharedExp<Key, Value, Interval>::inverse_find (
+    const Value &value, Interval interval) const
+  {
+    return inverse_find (std::vector {value}, interval);
+  }
+
+  /*
+   * Keys and Values
+   */
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Key> BiIntervalDictSharedExp<Key, Value, Interval>::keys () const
+  {
+    std::vector<Key> results;
+    results.reserve (m_keys.size ());
+    for (const auto &[key, _] : m_keys.ids ())
+    {
+      results.push_back (key);
+    }
+    return results;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::vector<Value>
+  BiIntervalDictSharedExp<Key, Value, Interval>::values () const
+  {
+    std::vector<Value> results;
+    results.reserve (m_values.size ());
+    for (const auto &[value, _] : m_values.ids ())
+    {
+      results.push_back (value);
+    }
+    return results;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::size_t BiIntervalDictSharedExp<Key, Value, Interval>::size () const
+  {
+    return m_keys.size ();
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::size_t
+  BiIntervalDictSharedExp<Key, Value, Interval>::inverse_size () const
+  {
+    return m_values.size ();
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  bool BiIntervalDictSharedExp<Key, Value, Interval>::empty () const
+  {
+    return m_keys.size () == 0;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::size_t
+  BiIntervalDictSharedExp<Key, Value, Interval>::count (const Key &key) const
+  {
+    return m_keys.ids ().count (key);
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  std::size_t BiIntervalDictSharedExp<Key, Value, Interval>::count_value (
+    const Value &value) const
+  {
+    return m_values.ids ().count (value);
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  bool
+  BiIntervalDictSharedExp<Key, Value, Interval>::contains (const Key &key) const
+  {
+    return m_keys.ids ().contains (key);
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  bool BiIntervalDictSharedExp<Key, Value, Interval>::contains_value (
+    const Value &value) const
+  {
+    return m_values.ids ().contains (value);
+  }
+
+  /*
+   * intervals
+   */
+  template<typename Key, typename Value, typename Interval>
+  typename BiIntervalDictSharedExp<Key, Value, Interval>::KeyValueIntervals
+  BiIntervalDictSharedExp<Key, Value, Interval>::intervals (
+    Interval query_interval) const
+  {
+    KeyValueIntervals results;
+    if (boost::icl::is_empty (query_interval))
+    {
+      return results;
+    }
+    for (const auto &[key, key_id] : m_keys.ids ())
+    {
+      const auto begin = results.size ();
+      m_keys.index (key_id).for_each_overlapping (
+        m_table,
+        query_interval,
+        [&] (RowId row)
+        {
+          results.emplace_back (key,
+                                m_values.item (m_table.value_id (row)),
+                                m_table.interval (row));
+        });
+      std::sort (results.begin () + static_cast<std::ptrdiff_t> (begin),
+                 results.end (),
+                 [] (const auto &lhs, const auto &rhs)
+                 {
+                   const auto &[_l, value_l, interval_l] = lhs;
+                   const auto &[_r, value_r, interval_r] = rhs;
+                   if (boost::icl::lower_less (interval_l, interval_r))
+                   {
+                     return true;
+                   }
+                   if (boost::icl::lower_less (interval_r, interval_l))
+                   {
+                     return false;
+                   }
+                   if (boost::icl::upper_less (interval_l, interval_r))
+                   {
+                     return true;
+                   }
+                   if (boost::icl::upper_less (interval_r, interval_l))
+                   {
+                     return false;
+                   }
+                   return value_l < value_r;
+                 });
+    }
+    return results;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  BiIntervalDictSharedExp<Value, Key, Interval>
+  BiIntervalDictSharedExp<Key, Value, Interval>::invert () const
+  {
+    BiIntervalDictSharedExp<Value, Key, Interval> results;
+    for (const auto &[key, value, interval] : intervals ())
+    {
+      results.insert (value, key, interval);
+    }
+    return results;
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  MemoryUsage
+  BiIntervalDictSharedExp<Key, Value, Interval>::memory_usage () const
+  {
+    MemoryUsage usage;
+    m_table.add_memory_usage (usage);
+    m_keys.add_memory_usage (usage);
+    m_values.add_memory_usage (usage);
+    return usage;
+  }
+
+  /*
+   * Equality
+   */
+  template<typename Key, typename Value, typename Interval>
+  bool BiIntervalDictSharedExp<Key, Value, Interval>::operator== (
+    const BiIntervalDictSharedExp &rhs) const
+  {
+    return intervals () == rhs.intervals ();
+  }
+
+  template<typename Key, typename Value, typename Interval>
+  bool BiIntervalDictSharedExp<Key, Value, Interval>::operator!= (
+    const BiIntervalDictSharedExp &rhs) const
+  {
+    return !(*this == rhs);
+  }
+
+  /// \brief Bidirectional interval dictionary with a single shared table of
+  /// associations
+  ///
+  /// \tparam Key Type of keys
+  /// \tparam Value Type of Values
+  /// \tparam BaseType The base type of the interval: Date or Posix Time etc.
+  template<typename Key, typename Value, typename BaseType>
+  using BiIntervalDictShared
+    = BiIntervalDictSharedExp<Key,
+                              Value,
+                              typename boost::icl::interval<BaseType>::type>;
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_BI_INTERVALDICTSHARED_H
@@ -0,0 +1,803 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file bitemporal_intervaldict.h
+/// \brief Interval dictionary over valid time and transaction time
+///
+/// Each association is a BitemporalRecord: a key-value valid over an
+/// interval, and believed from the transaction time it was written until it
+/// was superseded. Superseding writes close the transaction time of the old
+/// record rather than erasing it, so that the dictionary can answer "what did
+/// we believe at transaction time T1 about the values valid at T2".
+///
+/// Records are indexed by valid time in IntervalDictExp of record ids, one
+/// for each epoch of consecutive transactions. As-of queries only visit
+/// epochs started by the query transaction time, and skip epochs whose
+/// records had all been superseded by then. Storage grows with the number of
+/// changes rather than the number of snapshots.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_BITEMPORAL_INTERVALDICT_H
+#define INCLUDE_INTERVAL_DICT_BITEMPORAL_INTERVALDICT_H
+
+#include "adaptor.h"
+#include "intervaldict.h"
+#include "memory_usage.h"
+
+#include <boost/icl/concept/interval.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace interval_dict
+{
+  /// A key-value valid over an interval, and believed over a half-open range
+  /// of transaction times
+  template<typename Key, typename Value, typename Interval, typename TxnTime>
+  struct BitemporalRecord
+  {
+    Key key;
+    Value value;
+
+    /// Valid time
+    Interval interval;
+
+    /// Transaction time when first believed
+    TxnTime transaction_begin;
+
+    /// Transaction time when superseded. Empty if still believed
+    std::optional<TxnTime> transaction_end;
+
+    /// @return whether believed at transaction time @p txn
+    [[nodiscard]] bool believed_at (const TxnTime &txn) const
+    {
+      return !(txn < transaction_begin)
+             && (!transaction_end || txn < *transaction_end);
+    }
+
+    bool operator== (const BitemporalRecord &) const = default;
+  };
+
+  /**
+   * @brief one-to-many interval dictionary over valid time, remembering what
+   * was believed at each transaction time
+   *
+   * Writes are made at a transaction time, which must not go backwards.
+   * Current values are found with find(), and past beliefs with find_as_of()
+   * and as_of().
+   *
+   * @tparam Key Type of keys
+   * @tparam Value Type of Values
+   * @tparam Interval Valid time Interval Type. E.g.
+   * boost::icl::right_open_interval<Date>
+   * @tparam Impl Implementation for Value as for IntervalDictExp. It is
+   * rebound to record ids for the indices
+   * @tparam TxnTime Type of transaction times. Must be less-than comparable
+   */
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime = typename IntervalTraits<Interval>::BaseType>
+  class BitemporalIntervalDictExp
+  {
+    public:
+    /// @cond Suppress_Doxygen_Warning
+    using IntervalType = Interval;
+    using BaseType = typename IntervalTraits<Interval>::BaseType;
+    using KeyType = Key;
+    using ValType = Value;
+    using TransactionTimeType = TxnTime;
+    // boost icl interval_set of Intervals
+    using Intervals = interval_dict::Intervals<Interval>;
+    using KeyValueIntervals = std::vector<std::tuple<Key, Value, Interval>>;
+    using Record = BitemporalRecord<Key, Value, Interval, TxnTime>;
+    using RecordId = std::size_t;
+    using IdImplType = typename Implementation<Value, Interval, Impl>::
+      template rebind<RecordId>::type;
+    using IdDict = IntervalDictExp<Key, RecordId, Interval, IdImplType>;
+    using Snapshot = IntervalDictExp<Key, Value, Interval, Impl>;
+    /// @endcond
+
+    /// @name Constructors
+    /// @{
+
+    /// Default Constructor
+    /// \param records_per_epoch Number of records indexed together before a
+    /// later transaction starts a new epoch
+    explicit BitemporalIntervalDictExp (std::size_t records_per_epoch = 1024);
+
+    /// @}
+    /// @name Insert and Erase Member Functions
+    /// @{
+
+    /// Believe [key-value-interval]s from transaction time @p txn.
+    ///
+    /// Only the parts of each interval not already believed for its
+    /// key-value are recorded.
+    /// \throws std::invalid_argument if @p txn precedes an earlier write
+    BitemporalIntervalDictExp &
+    insert (const KeyValueIntervals &key_value_intervals, const TxnTime &txn);
+
+    /// No longer believe [key-value-interval]s from transaction time @p txn.
+    ///
+    /// Records overlapping each interval are superseded. Their parts outside
+    /// the interval are believed afresh from @p txn.
+    /// \throws std::invalid_argument if @p txn precedes an earlier write
+    BitemporalIntervalDictExp &
+    erase (const KeyValueIntervals &key_value_intervals, const TxnTime &txn);
+
+    /// No longer believe any values for @p key over @p interval from
+    /// transaction time @p txn
+    /// \throws std::invalid_argument if @p txn precedes an earlier write
+    BitemporalIntervalDictExp &
+    erase (const Key &key, Interval interval, const TxnTime &txn);
+
+    /// Replace all values for @p key over @p interval with @p values from
+    /// transaction time @p txn. Values that are unchanged are not superseded
+    /// \throws std::invalid_argument if @p txn precedes an earlier write
+    BitemporalIntervalDictExp &assign (const Key &key,
+                                       const std::vector<Value> &values,
+                                       Interval interval,
+                                       const TxnTime &txn);
+
+    /// @}
+    /// @name Find Member Functions
+    /// @{
+
+    /// Returns the currently believed values in a sorted list for the
+    /// specified @p key at valid time @p query
+    [[nodiscard]] std::vector<Value> find (const Key &key,
+                                           BaseType query) const;
+
+    /// Returns the currently believed values in a sorted list for the
+    /// specified @p key over valid time @p interval
+    [[nodiscard]] std::vector<Value>
+    find (const Key &key, Interval interval = interval_extent<Interval>) const;
+
+    /// Returns the values believed at transaction time @p txn in a sorted
+    /// list for the specified @p key at valid time @p query
+    [[nodiscard]] std::vector<Value>
+    find_as_of (const Key &key, BaseType query, const TxnTime &txn) const;
+
+    /// Returns the values believed at transaction time @p txn in a sorted
+    /// list for the specified @p key over valid time @p interval
+    [[nodiscard]] std::vector<Value>
+    find_as_of (const Key &key, Interval interval, const TxnTime &txn) const;
+
+    /// Returns a dictionary of all values believed at transaction time @p txn
+    [[nodiscard]] Snapshot as_of (const TxnTime &txn) const;
+
+    /// Returns a dictionary of all values currently believed
+    [[nodiscard]] Snapshot current () const;
+
+    /// @}
+
+    /// Returns the history of @p key in the order written
+    [[nodiscard]] std::vector<Record> history (const Key &key) const;
+
+    /// Returns all records in the order written
+    [[nodiscard]] const std::vector<Record> &records () const;
+
+    /// Returns the latest transaction time written, if any
+    [[nodiscard]] std::optional<TxnTime> latest_transaction () const;
+
+    /// Returns the number of transaction epochs
+    [[nodiscard]] std::size_t count_epochs () const;
+
+    /// Return whether nothing has ever been written
+    [[nodiscard]] bool empty () const;
+
+    /// Returns bytes used by the records and all indices
+    [[nodiscard]] MemoryUsage memory_usage () const;
+
+    private:
+    /// Records first believed over consecutive transactions, indexed by
+    /// valid time
+    struct Epoch
+    {
+      /// Transaction time of the first record
+      TxnTime transaction_begin;
+
+      /// Latest transaction time that superseded a record in this epoch
+      TxnTime latest_superseded;
+
+      /// Records of an epoch have consecutive ids
+      RecordId first_record = 0;
+      std::size_t count_records = 0;
+      std::size_t count_believed = 0;
+      IdDict ids;
+    };
+
+    /// @throws std::invalid_argument if @p txn precedes the latest write
+    void start_transaction (const TxnTime &txn);
+
+    /// Believe @p key - @p value over @p interval from @p txn
+    void add_record (const Key &key,
+                     const Value &value,
+                     const Interval &interval,
+                     const TxnTime &txn);
+
+    /// Stop believing the record with @p id from @p txn
+    void supersede (RecordId id, const TxnTime &txn);
+
+    /// Supersede records for @p key over @p interval that @p matches, and
+    /// believe their parts outside @p interval afresh
+    template<typename Predicate>
+    void supersede_over (const Key &key,
+                         const Interval &interval,
+                         const TxnTime &txn,
+                         Predicate matches);
+
+    /// @return ids of records currently believed for @p key over @p interval
+    [[nodiscard]] std::vector<RecordId>
+    believed_ids (const Key &key, const Interval &interval) const;
+
+    /// @return sorted unique values of records with @p ids
+    [[nodiscard]] std::vector<Value>
+    sorted_values (const std::vector<RecordId> &ids) const;
+
+    /// @return values believed at @p txn in records matched by @p find_ids
+    template<typename FindIds>
+    [[nodiscard]] std::vector<Value> values_as_of (const TxnTime &txn,
+                                                   FindIds find_ids) const;
+
+    std::size_t m_records_per_epoch;
+    std::vector<Record> m_records;
+    std::vector<std::size_t> m_record_epochs;
+    std::vector<Epoch> m_epochs;
+
+    /// Index of records still believed
+    IdDict m_believed;
+    std::optional<TxnTime> m_latest_transaction;
+  };
+
+  /*
+   * _____________________________________________________________________________
+   *
+   * Implementation
+   *
+   */
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::
+    BitemporalIntervalDictExp (std::size_t records_per_epoch)
+    : m_records_per_epoch (std::max<std::size_t> (records_per_epoch, 1))
+  {
+  }
+
+  /*
+   * Private helpers
+   */
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  void
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::
+    start_transaction (const TxnTime &txn)
+  {
+    if (m_latest_transaction && txn < *m_latest_transaction)
+    {
+      throw std::invalid_argument (
+        "BitemporalIntervalDictExp: transaction time precedes earlier write");
+    }
+    m_latest_transaction = txn;
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  void BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::
+    add_record (const Key &key,
+                const Value &value,
+                const Interval &interval,
+                const TxnTime &txn)
+  {
+    if (boost::icl::is_empty (interval))
+    {
+      return;
+    }
+    // Full epochs are only closed between transactions so that each
+    // transaction time begins at most one epoch
+    if (m_epochs.empty ()
+        || (m_epochs.back ().count_records >= m_records_per_epoch
+            && m_epochs.back ().transaction_begin < txn))
+    {
+      m_epochs.push_back (Epoch {.transaction_begin = txn,
+                                 .latest_superseded = txn,
+                                 .first_record = m_records.size (),
+                                 .count_records = 0,
+                                 .count_believed = 0,
+                                 .ids = IdDict {}});
+    }
+    const RecordId id = m_records.size ();
+    m_records.push_back (Record {key, value, interval, txn, std::nullopt});
+    m_record_epochs.push_back (m_epochs.size () - 1);
+    auto &epoch = m_epochs.back ();
+    ++epoch.count_records;
+    ++epoch.count_believed;
+    const typename IdDict::KeyValueIntervals id_interval {{key, id, interval}};
+    epoch.ids.insert (id_interval);
+    m_believed.insert (id_interval);
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  void BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::
+    supersede (RecordId id, const TxnTime &txn)
+  {
+    auto &record = m_records[id];
+    auto &epoch = m_epochs[m_record_epochs[id]];
+    const typename IdDict::KeyValueIntervals id_interval {
+      {record.key, id, record.interval}};
+    record.transaction_end = txn;
+    m_believed.erase (id_interval);
+    --epoch.count_believed;
+    if (epoch.latest_superseded < txn)
+    {
+      epoch.latest_superseded = txn;
+    }
+    // Records superseded by the same transaction were never believed
+    if (!(record.transaction_begin < txn))
+    {
+      epoch.ids.erase (id_interval);
+    }
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  template<typename Predicate>
+  void BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::
+    supersede_over (const Key &key,
+                    const Interval &interval,
+                    const TxnTime &txn,
+                    Predicate matches)
+  {
+    for (const auto id : believed_ids (key, interval))
+    {
+      if (!matches (m_records[id].value))
+      {
+        continue;
+      }
+      supersede (id, txn);
+      // Copy: add_record() may reallocate m_records
+      const auto record = m_records[id];
+      Intervals remainder {record.interval};
+      remainder -= interval;
+      for (const auto &remaining : remainder)
+      {
+        add_record (record.key, record.value, remaining, txn);
+      }
+    }
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  std::vector<typename BitemporalIntervalDictExp<Key,
+                                                 Value,
+                                                 Interval,
+                                                 Impl,
+                                                 TxnTime>::RecordId>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::believed_ids (
+    const Key &key, const Interval &interval) const
+  {
+    return m_believed.find (key, interval);
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  std::vector<Value>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::
+    sorted_values (const std::vector<RecordId> &ids) const
+  {
+    std::vector<Value> values;
+    values.reserve (ids.size ());
+    for (const auto id : ids)
+    {
+      values.push_back (m_records[id].value);
+    }
+    // Abutting records may hold the same value
+    std::ranges::sort (values);
+    values.erase (std::unique (values.begin (), values.end ()), values.end ());
+    return values;
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  template<typename FindIds>
+  std::vector<Value>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::values_as_of (
+    const TxnTime &txn, FindIds find_ids) const
+  {
+    // Epochs begun after txn only hold later records
+    const auto end_epoch
+      = std::ranges::upper_bound (m_epochs,
+                                  txn,
+                                  std::less<> {},
+                                  [] (const Epoch &epoch) -> const TxnTime &
+                                  { return epoch.transaction_begin; });
+    std::vector<RecordId> ids;
+    for (auto epoch = m_epochs.begin (); epoch != end_epoch; ++epoch)
+    {
+      // All records had been superseded by txn
+      if (epoch->count_believed == 0 && !(txn < epoch->latest_superseded))
+      {
+        continue;
+      }
+      for (const auto id : find_ids (epoch->ids))
+      {
+        if (m_records[id].believed_at (txn))
+        {
+          ids.push_back (id);
+        }
+      }
+    }
+    return sorted_values (ids);
+  }
+
+  /*
+   * Insert and erase
+   */
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime> &
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::insert (
+    const KeyValueIntervals &key_value_intervals, const TxnTime &txn)
+  {
+    start_transaction (txn);
+    for (const auto &[key, value, interval] : key_value_intervals)
+    {
+      Intervals unbelieved {interval};
+      for (const auto id : believed_ids (key, interval))
+      {
+        if (m_records[id].value == value)
+        {
+          unbelieved -= m_records[id].interval;
+        }
+      }
+      for (const auto &new_interval : unbelieved)
+      {
+        add_record (key, value, new_interval, txn);
+      }
+    }
+    return *this;
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime> &
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::erase (
+    const KeyValueIntervals &key_value_intervals, const TxnTime &txn)
+  {
+    start_transaction (txn);
+    for (const auto &[key, value, interval] : key_value_intervals)
+    {
+      supersede_over (key,
+                      interval,
+                      txn,
+                      [&value] (const Value &record_value)
+                      { return record_value == value; });
+    }
+    return *this;
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime> &
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::erase (
+    const Key &key, Interval interval, const TxnTime &txn)
+  {
+    start_transaction (txn);
+    supersede_over (key, interval, txn, [] (const Value &) { return true; });
+    return *this;
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime> &
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::assign (
+    const Key &key,
+    const std::vector<Value> &values,
+    Interval interval,
+    const TxnTime &txn)
+  {
+    start_transaction (txn);
+    supersede_over (key,
+                    interval,
+                    txn,
+                    [&values] (const Value &record_value)
+                    { return std::ranges::find (values, record_value)
+                             == values.end (); });
+    KeyValueIntervals key_value_intervals;
+    for (const auto &value : values)
+    {
+      key_value_intervals.emplace_back (key, value, interval);
+    }
+    return insert (key_value_intervals, txn);
+  }
+
+  /*
+   * Find
+   */
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  std::vector<Value>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::find (
+    const Key &key, BaseType query) const
+  {
+    return sorted_values (m_believed.find (key, query));
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  std::vector<Value>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::find (
+    const Key &key, Interval interval) const
+  {
+    return sorted_values (m_believed.find (key, interval));
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  std::vector<Value>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::find_as_of (
+    const Key &key, BaseType query, const TxnTime &txn) const
+  {
+    return values_as_of (txn,
+                         [&key, &query] (const IdDict &ids)
+                         { return ids.find (key, query); });
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  std::vector<Value>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::find_as_of (
+    const Key &key, Interval interval, const TxnTime &txn) const
+  {
+    return values_as_of (txn,
+                         [&key, &interval] (const IdDict &ids)
+                         { return ids.find (key, interval); });
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  typename BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::
+    Snapshot
+    BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::as_of (
+      const TxnTime &txn) const
+  {
+    // Records are appended in transaction order: later records were not yet
+    // believed at txn
+    const auto end_record = static_cast<RecordId> (
+      std::ranges::upper_bound (m_records,
+                                txn,
+                                std::less<> {},
+                                [] (const Record &record) -> const TxnTime &
+                                { return record.transaction_begin; })
+      - m_records.begin ());
+    KeyValueIntervals key_value_intervals;
+    for (const auto &epoch : m_epochs)
+    {
+      if (end_record <= epoch.first_record)
+      {
+        break;
+      }
+      // All records had been superseded by txn
+      if (epoch.count_believed == 0 && !(txn < epoch.latest_superseded))
+      {
+        continue;
+      }
+      const auto end_id
+        = std::min (epoch.first_record + epoch.count_records, end_record);
+      for (auto id = epoch.first_record; id != end_id; ++id)
+      {
+        const auto &record = m_records[id];
+        if (record.believed_at (txn))
+        {
+          key_value_intervals.emplace_back (
+            record.key, record.value, record.interval);
+        }
+      }
+    }
+    return Snapshot (key_value_intervals);
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  typename BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::
+    Snapshot
+    BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::current ()
+      const
+  {
+    KeyValueIntervals key_value_intervals;
+    for (const auto &[key, id, interval] :
+         interval_dict::intervals (m_believed))
+    {
+      const auto &record = m_records[id];
+      key_value_intervals.emplace_back (key, record.value, interval);
+    }
+    return Snapshot (key_value_intervals);
+  }
+
+  /*
+   * Records
+   */
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  std::vector<typename BitemporalIntervalDictExp<Key,
+                                                 Value,
+                                                 Interval,
+                                                 Impl,
+                                                 TxnTime>::Record>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::history (
+    const Key &key) const
+  {
+    std::vector<RecordId> ids;
+    for (const auto &epoch : m_epochs)
+    {
+      for (const auto &id_interval :
+           interval_dict::intervals (epoch.ids, key))
+      {
+        ids.push_back (std::get<1> (id_interval));
+      }
+    }
+    std::ranges::sort (ids);
+    ids.erase (std::unique (ids.begin (), ids.end ()), ids.end ());
+    std::vector<Record> history;
+    history.reserve (ids.size ());
+    for (const auto id : ids)
+    {
+      history.push_back (m_records[id]);
+    }
+    return history;
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  const std::vector<typename BitemporalIntervalDictExp<Key,
+                                                       Value,
+                                                       Interval,
+                                                       Impl,
+                                                       TxnTime>::Record> &
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::records ()
+    const
+  {
+    return m_records;
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  std::optional<TxnTime>
+  BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::
+    latest_transaction () const
+  {
+    return m_latest_transaction;
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  std::size_t BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::
+    count_epochs () const
+  {
+    return m_epochs.size ();
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  bool BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::empty ()
+    const
+  {
+    return m_records.empty ();
+  }
+
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename Impl,
+           typename TxnTime>
+  MemoryUsage BitemporalIntervalDictExp<Key, Value, Interval, Impl, TxnTime>::
+    memory_usage () const
+  {
+    MemoryUsage usage;
+    details::add_vector_usage (m_records, usage.bytes_intervals, usage);
+    details::add_vector_usage (m_record_epochs, usage.bytes_index, usage);
+    details::add_vector_usage (m_epochs, usage.bytes_index, usage);
+    const auto add_index = [&usage] (const IdDict &ids)
+    {
+      const auto report = ids.memory_usage (0);
+      usage += report.usage;
+      usage.bytes_index += report.bytes_keys;
+    };
+    add_index (m_believed);
+    for (const auto &epoch : m_epochs)
+    {
+      add_index (epoch.ids);
+    }
+    return usage;
+  }
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_BITEMPORAL_INTERVALDICT_H
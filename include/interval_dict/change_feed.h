@@ -0,0 +1,401 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file change_feed.h
+/// \brief Notifying observers of the changes made to an IntervalDictExp
+///
+/// Observers registered with IntervalDictExp::add_observer() receive a batch
+/// of (key, value, interval, insert|erase) changes after each call that
+/// modifies the dictionary. Changes made internally, for example by
+/// fill_gaps(), flattened() or operator+=, are included in the batch of the
+/// outermost call. Each batch only holds the net changes of the call, as
+/// disjoint intervals of each key and value: inserting an association which
+/// is already present, or erasing and re-inserting it, publishes nothing.
+///
+/// Observers run on the writing thread. ChangeFeed instead queues each batch
+/// in a lock-free single-producer, single-consumer ring buffer for a reader on
+/// another thread.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_CHANGE_FEED_H
+#define INCLUDE_INTERVAL_DICT_CHANGE_FEED_H
+
+#include <boost/icl/interval_set.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace interval_dict
+{
+  /// \brief Whether an association was inserted or erased
+  enum class ChangeKind
+  {
+    insert,
+    erase
+  };
+
+  /// \brief An association inserted into or erased from a dictionary
+  template<typename Key, typename Value, typename Interval> struct Change
+  {
+    Key key;
+    Value value;
+    Interval interval;
+    ChangeKind kind;
+
+    bool operator== (const Change &) const = default;
+  };
+
+  /// \brief All changes made by one call to a dictionary
+  template<typename Key, typename Value, typename Interval>
+  using ChangeBatch = std::vector<Change<Key, Value, Interval>>;
+
+  /// \brief Called with each batch of changes. Must not throw
+  template<typename Key, typename Value, typename Interval>
+  using ChangeObserver
+    = std::function<void (const ChangeBatch<Key, Value, Interval> &)>;
+
+  /// \brief Identifies a registered ChangeObserver. See
+  /// IntervalDictExp::remove_observer()
+  using ObserverId = std::size_t;
+
+  /// @cond Suppress_Doxygen_Warning
+  namespace details
+  {
+    /// Observer ids are unique across dictionaries, so that the observers
+    /// of two dictionaries can be combined
+    inline std::atomic<ObserverId> last_observer_id {0};
+
+    /**
+     * Observers of an IntervalDictExp, and the changes pending for them
+     *
+     * Copies have no observers, so that copying a dictionary does not
+     * notify the observers of the original. Moves take the observers with
+     * them. Assignment keeps the observers of the target, adding those of
+     * the source if moved.
+     */
+    template<typename Key, typename Value, typename Interval>
+    class ChangeObservers
+    {
+      public:
+      using Batch = ChangeBatch<Key, Value, Interval>;
+      using Observer = ChangeObserver<Key, Value, Interval>;
+      using Intervals = boost::icl::interval_set<
+        typename boost::icl::interval_traits<Interval>::domain_type,
+        std::less,
+        Interval>;
+      /// Returns the intervals of a key and value within an interval
+      using CurrentIntervals = std::function<Intervals (
+        const Key &key, const Value &value, const Interval &interval)>;
+
+      ChangeObservers () = default;
+      ChangeObservers (const ChangeObservers &)
+      {
+      }
+      ChangeObservers (ChangeObservers &&) noexcept = default;
+      ChangeObservers &operator= (const ChangeObservers &)
+      {
+        return *this;
+      }
+      ChangeObservers &operator= (ChangeObservers &&other) noexcept
+      {
+        m_observers.merge (other.m_observers);
+        return *this;
+      }
+
+      /// Publishes pending changes when the outermost scope ends
+      class BatchScope
+      {
+        public:
+        BatchScope (ChangeObservers &observers, CurrentIntervals current)
+          : m_observers (observers)
+          , m_current (std::move (current))
+        {
+          ++m_observers.m_depth;
+        }
+        BatchScope (const BatchScope &) = delete;
+        BatchScope &operator= (const BatchScope &) = delete;
+        ~BatchScope ()
+        {
+          if (--m_observers.m_depth == 0)
+          {
+            m_observers.publish (m_current);
+          }
+        }
+
+        private:
+        ChangeObservers &m_observers;
+        CurrentIntervals m_current;
+      };
+
+      /// @return scope collecting changes into a single batch. @p current
+      /// gives the contents of the dictionary when the batch is published
+      [[nodiscard]] BatchScope batch (CurrentIntervals current)
+      {
+        return BatchScope (*this, std::move (current));
+      }
+
+      /// @return whether any observers are registered
+      [[nodiscard]] bool observed () const
+      {
+        return !m_observers.empty ();
+      }
+
+      ObserverId add (Observer observer)
+      {
+        const auto id
+          = last_observer_id.fetch_add (1, std::memory_order_relaxed) + 1;
+        m_observers.emplace (id, std::move (observer));
+        return id;
+      }
+
+      void remove (ObserverId id)
+      {
+        m_observers.erase (id);
+      }
+
+      /// If there are any observers, records that @p value of @p key is
+      /// about to be inserted or erased over @p interval. Must be called
+      /// before the change is made: @p current returns the intervals of the
+      /// key and value beforehand, and is only called for parts of
+      /// @p interval not already recorded in this batch
+      template<typename Current>
+      void record (const Key &key,
+                   const Value &value,
+                   const Interval &interval,
+                   Current current)
+      {
+        if (!observed () || boost::icl::is_empty (interval))
+        {
+          return;
+        }
+        auto &pending = m_pending[{key, value}];
+        Intervals untouched (interval);
+        untouched -= pending.touched;
+        for (const auto &piece : untouched)
+        {
+          pending.before += current (key, value, piece);
+        }
+        pending.touched += interval;
+      }
+
+      private:
+      /// The intervals of a key and value which may have changed in this
+      /// batch, and which of them were present beforehand
+      struct Pending
+      {
+        Intervals touched;
+        Intervals before;
+      };
+
+      void publish (const CurrentIntervals &current)
+      {
+        if (m_pending.empty ())
+        {
+          return;
+        }
+        Batch changes;
+        for (const auto &[key_value, pending] : m_pending)
+        {
+          const auto &[key, value] = key_value;
+          Intervals after;
+          for (const auto &interval : pending.touched)
+          {
+            after += current (key, value, interval);
+          }
+          for (const auto &interval : pending.before - after)
+          {
+            changes.push_back ({key, value, interval, ChangeKind::erase});
+          }
+          for (const auto &interval : after - pending.before)
+          {
+            changes.push_back ({key, value, interval, ChangeKind::insert});
+          }
+        }
+        m_pending.clear ();
+        if (changes.empty ())
+        {
+          return;
+        }
+        // Observers may add or remove observers, including themselves. Only
+        // those registered before publishing and not yet removed are called,
+        // each through a copy that outlives its removal
+        std::vector<ObserverId> ids;
+        ids.reserve (m_observers.size ());
+        for (const auto &[id, _] : m_observers)
+        {
+          ids.push_back (id);
+        }
+        for (const auto id : ids)
+        {
+          if (const auto found = m_observers.find (id);
+              found != m_observers.end ())
+          {
+            const auto observer = found->second;
+            observer (changes);
+          }
+        }
+      }
+
+      std::map<ObserverId, Observer> m_observers;
+      std::map<std::pair<Key, Value>, Pending> m_pending;
+      std::size_t m_depth = 0;
+    };
+  } // namespace details
+  /// @endcond
+
+  /**
+   * @brief Bounded lock-free queue for one producer and one consumer thread
+   *
+   * @tparam T Type of items, which must be default constructible
+   */
+  template<typename T> class SpscRingBuffer
+  {
+    public:
+    /// Queue holding up to @p capacity items
+    explicit SpscRingBuffer (std::size_t capacity)
+      : m_slots (capacity + 1)
+    {
+    }
+
+    SpscRingBuffer (const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator= (const SpscRingBuffer &) = delete;
+
+    /// Called by the producer. @return false if the queue is full
+    bool try_push (T item)
+    {
+      const auto tail = m_tail.load (std::memory_order_relaxed);
+      const auto next = advance (tail);
+      if (next == m_head.load (std::memory_order_acquire))
+      {
+        return false;
+      }
+      m_slots[tail] = std::move (item);
+      m_tail.store (next, std::memory_order_release);
+      return true;
+    }
+
+    /// Called by the consumer. @return the oldest item, or nothing if the
+    /// queue is empty
+    std::optional<T> try_pop ()
+    {
+      const auto head = m_head.load (std::memory_order_relaxed);
+      if (head == m_tail.load (std::memory_order_acquire))
+      {
+        return std::nullopt;
+      }
+      std::optional<T> item (std::move (m_slots[head]));
+      m_head.store (advance (head), std::memory_order_release);
+      return item;
+    }
+
+    /// @return whether the queue was empty. Only exact if neither thread is
+    /// using the queue
+    [[nodiscard]] bool empty () const
+    {
+      return m_head.load (std::memory_order_acquire)
+             == m_tail.load (std::memory_order_acquire);
+    }
+
+    /// @return maximum number of items
+    [[nodiscard]] std::size_t capacity () const
+    {
+      return m_slots.size () - 1;
+    }
+
+    private:
+    [[nodiscard]] std::size_t advance (std::size_t index) const
+    {
+      return index + 1 == m_slots.size () ? 0 : index + 1;
+    }
+
+    // Avoid false sharing between the producer and consumer indices
+    static constexpr std::size_t cache_line_size = 64;
+
+    std::vector<T> m_slots;
+    /// Next item to pop. Only written by the consumer
+    alignas (cache_line_size) std::atomic<std::size_t> m_head {0};
+    /// Next slot to push to. Only written by the producer
+    alignas (cache_line_size) std::atomic<std::size_t> m_tail {0};
+  };
+
+  /**
+   * @brief Queues the changes to a dictionary for a reader on another thread
+   *
+   * Registers itself as an observer of the dictionary on construction, and
+   * unregisters on destruction. The dictionary must outlive the feed, and
+   * may only be modified by one thread at a time.
+   *
+   * Batches are dropped rather than blocking the writer if the reader falls
+   * more than @p capacity batches behind. Readers should check
+   * count_dropped() and resynchronise if necessary.
+   *
+   * @tparam Dict IntervalDictExp type
+   */
+  template<typename Dict> class ChangeFeed
+  {
+    public:
+    using Batch = ChangeBatch<typename Dict::KeyType,
+                              typename Dict::ValType,
+                              typename Dict::IntervalType>;
+
+    /// Queue the changes to @p dict, up to @p capacity batches at a time
+    explicit ChangeFeed (Dict &dict, std::size_t capacity = 1024)
+      : m_dict (dict)
+      , m_batches (capacity)
+    {
+      m_observer_id = m_dict.add_observer (
+        [this] (const Batch &changes)
+        {
+          if (!m_batches.try_push (changes))
+          {
+            m_count_dropped.fetch_add (1, std::memory_order_relaxed);
+          }
+        });
+    }
+
+    ChangeFeed (const ChangeFeed &) = delete;
+    ChangeFeed &operator= (const ChangeFeed &) = delete;
+
+    /// Stop queueing changes
+    ~ChangeFeed ()
+    {
+      m_dict.remove_observer (m_observer_id);
+    }
+
+    /// Called by the reader. @return the oldest batch of changes, or nothing
+    /// if none are queued
+    std::optional<Batch> try_pop ()
+    {
+      return m_batches.try_pop ();
+    }
+
+    /// @return number of batches dropped because the queue was full
+    [[nodiscard]] std::size_t count_dropped () const
+    {
+      return m_count_dropped.load (std::memory_order_relaxed);
+    }
+
+    private:
+    Dict &m_dict;
+    SpscRingBuffer<Batch> m_batches;
+    std::atomic<std::size_t> m_count_dropped {0};
+    ObserverId m_observer_id = 0;
+  };
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_CHANGE_FEED_H
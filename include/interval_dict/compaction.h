@@ -0,0 +1,234 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file compaction.h
+/// \brief Compacting pending inserts and erases on a worker thread
+///
+/// Augmented interval lists hold erased intervals as tombstones, and new
+/// intervals in extra runs, until their compaction policy (see
+/// augmented_interval_list::Tuning) calls for all runs to be rebuilt. With
+/// Tuning::compact_in_foreground switched off, insert() and erase() never
+/// rebuild, and BackgroundCompactor does so instead.
+///
+/// Keys needing compaction are copied one at a time while holding the
+/// dictionary mutex, rebuilt without it, and swapped back in only if the key
+/// has not been modified in the meantime. The caller must hold the same mutex
+/// for every use of the dictionary.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_COMPACTION_H
+#define INCLUDE_INTERVAL_DICT_COMPACTION_H
+
+#include "adaptor.h"
+#include "intervaldict.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <tuple>
+
+namespace interval_dict
+{
+  /**
+   * Compacts the keys of an IntervalDictExp on a worker thread
+   *
+   * @tparam Dict IntervalDictExp type
+   */
+  template<typename Dict> class BackgroundCompactor
+  {
+    public:
+    using Key = typename Dict::KeyType;
+    using Value = typename Dict::ValType;
+    using Interval = typename Dict::IntervalType;
+    using Impl = typename Dict::ImplType;
+
+    /// Start compacting @p dict every @p period
+    /// \param dict Dictionary which must outlive the compactor
+    /// \param mutex Held by the caller whenever @p dict is used
+    /// \param period Time between checking keys for compaction
+    BackgroundCompactor (
+      Dict &dict,
+      std::mutex &mutex,
+      std::chrono::milliseconds period = std::chrono::milliseconds (100));
+
+    BackgroundCompactor (const BackgroundCompactor &) = delete;
+    BackgroundCompactor &operator= (const BackgroundCompactor &) = delete;
+
+    /// Stops the worker thread
+    ~BackgroundCompactor ();
+
+    /// Check for keys to compact now rather than at the end of the period
+    void wake ();
+
+    /// Stop the worker thread, waiting for any compaction in progress
+    void stop ();
+
+    /// Compact all keys that need it on the calling thread
+    /// \return number of keys compacted and swapped in
+    std::size_t compact_once ();
+
+    /// @return number of keys compacted and swapped in so far
+    [[nodiscard]] std::size_t count_compacted () const
+    {
+      return m_count_compacted;
+    }
+
+    /// @return number of keys compacted but discarded because the key was
+    /// modified during compaction
+    [[nodiscard]] std::size_t count_discarded () const
+    {
+      return m_count_discarded;
+    }
+
+    private:
+    void run (std::stop_token stop_token);
+
+    Dict &m_dict;
+    std::mutex &m_mutex;
+    std::chrono::milliseconds m_period;
+
+    std::atomic<std::size_t> m_count_compacted {0};
+    std::atomic<std::size_t> m_count_discarded {0};
+
+    /// Only used to wait between compactions
+    std::mutex m_wait_mutex;
+    std::condition_variable_any m_wake;
+    bool m_woken = false;
+
+    /// Last member so that it is started after everything else is
+    /// initialised
+    std::jthread m_thread;
+  };
+
+  /*
+   * _____________________________________________________________________________
+   *
+   * Implementation
+   *
+   */
+
+  template<typename Dict>
+  BackgroundCompactor<Dict>::BackgroundCompactor (
+    Dict &dict,
+    std::mutex &mutex,
+    std::chrono::milliseconds period)
+    : m_dict (dict)
+    , m_mutex (mutex)
+    , m_period (period)
+    , m_thread (
+        [this] (std::stop_token stop_token)
+        {
+          run (stop_token);
+        })
+  {
+  }
+
+  template<typename Dict> BackgroundCompactor<Dict>::~BackgroundCompactor ()
+  {
+    stop ();
+  }
+
+  template<typename Dict> void BackgroundCompactor<Dict>::wake ()
+  {
+    {
+      const std::lock_guard lock (m_wait_mutex);
+      m_woken = true;
+    }
+    m_wake.notify_all ();
+  }
+
+  template<typename Dict> void BackgroundCompactor<Dict>::stop ()
+  {
+    if (m_thread.joinable ())
+    {
+      m_thread.request_stop ();
+      m_thread.join ();
+    }
+  }
+
+  template<typename Dict>
+  std::size_t BackgroundCompactor<Dict>::compact_once ()
+  {
+    using Adaptor = Implementation<Value, Interval, Impl>;
+    std::size_t count_compacted = 0;
+    std::optional<Key> previous_key;
+    while (true)
+    {
+      // Copy the next key that needs compaction, holding the lock for one
+      // key at a time
+      std::optional<std::tuple<Key, Impl, std::uint64_t>> snapshot;
+      {
+        const std::lock_guard lock (m_mutex);
+        const auto ff = previous_key ? m_dict.data.upper_bound (*previous_key)
+                                     : m_dict.data.begin ();
+        if (ff == m_dict.data.end ())
+        {
+          break;
+        }
+        previous_key = ff->first;
+        if (Adaptor::needs_compaction (ff->second))
+        {
+          snapshot.emplace (
+            ff->first, ff->second, Adaptor::generation (ff->second));
+        }
+      }
+      if (!snapshot)
+      {
+        continue;
+      }
+
+      // Rebuild off the hot path
+      auto &[key, interval_values, generation] = *snapshot;
+      Adaptor::compact (interval_values);
+
+      // Swap in unless modified since the copy was made
+      const std::lock_guard lock (m_mutex);
+      const auto ff = m_dict.data.find (key);
+      if (ff == m_dict.data.end ()
+          || Adaptor::generation (ff->second) != generation)
+      {
+        ++m_count_discarded;
+        continue;
+      }
+      ff->second = std::move (interval_values);
+      ++count_compacted;
+      ++m_count_compacted;
+    }
+    return count_compacted;
+  }
+
+  template<typename Dict>
+  void BackgroundCompactor<Dict>::run (std::stop_token stop_token)
+  {
+    while (!stop_token.stop_requested ())
+    {
+      compact_once ();
+      std::unique_lock lock (m_wait_mutex);
+      m_wake.wait_for (lock,
+                       stop_token,
+                       m_period,
+                       [this]
+                       {
+                         return m_woken;
+                       });
+      m_woken = false;
+    }
+  }
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_COMPACTION_H
@@ -0,0 +1,881 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file compressed_timeline.h
+/// \brief Intervals for a single key held as run-length encoded timelines,
+/// one per value
+///
+/// Daily snapshots tend to hold the same values for long stretches, with
+/// short gaps in between. For discrete interval types (dates or integers),
+/// CompressedTimeline stores each distinct value once, together with the
+/// sorted runs of consecutive points for which it holds. Runs are closed
+/// [first, last] unsigned offsets from a per-key epoch, the earliest point
+/// ever inserted, so that all arithmetic is done on plain integers.
+///
+/// Point and range queries binary search the runs of each value. gaps(),
+/// and therefore fill_gaps() and extend_into_gaps(), merge the runs of all
+/// values without comparing any intervals.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_COMPRESSED_TIMELINE_H
+#define INCLUDE_INTERVAL_DICT_COMPRESSED_TIMELINE_H
+
+#include "instrumentation.h"
+#include "interval_traits.h"
+#include "memory_usage.h"
+#include "query_explain.h"
+#include "value_interval.h"
+
+#include <boost/icl/concept/interval.hpp>
+#include <boost/icl/type_traits/is_discrete.hpp>
+#include <boost/icl/type_traits/is_interval.hpp>
+
+#include <cppcoro/generator.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <set>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace interval_dict::timeline
+{
+  /// Intervals over points that can be numbered consecutively
+  template<typename Interval>
+  concept DiscreteTimeline
+    = boost::icl::is_discrete<
+        typename boost::icl::interval_traits<Interval>::domain_type>::value
+      && std::is_integral_v<typename EdgeEncoding<
+        typename boost::icl::interval_traits<Interval>::domain_type>::
+                              EncodedType>;
+
+  /**
+   * Interval-values for a single key stored as run-length encoded points
+   * for each value.
+   *
+   * Overlapping or touching intervals with the same value are merged on
+   * insert, exactly as in the other implementations.
+   *
+   * @tparam Interval Interval over dates or integers
+   */
+  template<typename Value, DiscreteTimeline Interval>
+  class CompressedTimeline
+  {
+    public:
+    using ValueIntervalType = ValueInterval<Value, Interval>;
+    using BaseType =
+      typename boost::icl::interval_traits<Interval>::domain_type;
+    using EncodingType = EdgeEncoding<BaseType>;
+    using EncodedType = typename EncodingType::EncodedType;
+
+    /// Points are numbered from the epoch, wrapping around as unsigned
+    using Offset = std::make_unsigned_t<EncodedType>;
+
+    /// Consecutive points [first, last]
+    struct Run
+    {
+      Offset first;
+      Offset last;
+
+      bool operator== (const Run &) const = default;
+    };
+
+    /// Sorted, neither overlapping nor touching
+    using Runs = std::vector<Run>;
+
+    CompressedTimeline () = default;
+
+    /// @return whether there are no values
+    [[nodiscard]] bool empty () const
+    {
+      return m_value_runs.empty ();
+    }
+
+    /// @return coroutine enumerating all interval-values overlapping
+    /// @p query_interval sorted by interval
+    cppcoro::generator<ValueIntervalType>
+    intervals (Interval query_interval) const;
+
+    /// @return coroutine enumerating all disjoint interval-values over
+    /// @p query_interval
+    cppcoro::generator<ValuesDisjointInterval<Value, Interval>>
+    disjoint_intervals (Interval query_interval) const;
+
+    /// @return coroutine enumerating gaps between intervals
+    cppcoro::generator<Interval> gaps () const;
+
+    /// @return gaps between intervals and the values on either side
+    SandwichedGaps<Value, Interval> sandwiched_gaps () const;
+
+    /// @return first disjoint interval (with one or more values)
+    ValuesDisjointInterval<Value, Interval> initial_values () const;
+
+    /// @return last disjoint interval (with one or more values)
+    ValuesDisjointInterval<Value, Interval> final_values () const;
+
+    /// insert @p value for @p interval
+    void insert (const Interval &interval, const Value &value);
+
+    /// erase @p value for @p query_interval
+    void erase (const Interval &query_interval, const Value &value);
+
+    /// erase all values for @p query_interval
+    void erase (const Interval &query_interval);
+
+    /// @return the union with another set of interval-values
+    CompressedTimeline &merged_with (const CompressedTimeline &other);
+
+    /// @return the asymmetrical difference with another set of
+    /// interval-values
+    CompressedTimeline &subtract_by (const CompressedTimeline &other);
+
+    /// record the work done by a query over @p query_interval in @p explain
+    void explain (const Interval &query_interval, QueryExplain &explain) const;
+
+    /// @return bytes used
+    [[nodiscard]] MemoryUsage memory_usage () const;
+
+    /// release unused capacity
+    void shrink_to_fit ();
+
+    /// @return number of runs over all values
+    [[nodiscard]] std::size_t count_runs () const;
+
+    /// Equal if the same interval-values, whatever the epoch
+    bool operator== (const CompressedTimeline &rhs) const;
+
+    private:
+    struct ValueRuns
+    {
+      Value value;
+      Runs runs;
+    };
+
+    /// Points of @p interval as encoded [first, last], or std::nullopt if
+    /// it is empty
+    static std::optional<std::pair<EncodedType, EncodedType>>
+    encoded_points (const Interval &interval);
+
+    /// @return offsets for the part of @p query_interval from the epoch
+    /// onwards, or std::nullopt if there is none
+    std::optional<Run> query_run (const Interval &query_interval) const;
+
+    /// @return @p run as an Interval
+    Interval to_interval (const Run &run) const;
+
+    /// Move the epoch back to @p epoch
+    void rebase (EncodedType epoch);
+
+    /// insert @p value for encoded points [first, last]
+    void insert (EncodedType first, EncodedType last, const Value &value);
+
+    /// erase @p value for @p run if present
+    void erase (const Run &run, const Value &value);
+
+    /// Runs of all values merged together
+    Runs coverage () const;
+
+    /// Offsets relative to the epoch of @p other
+    Run rebased_from (const CompressedTimeline &other, const Run &run) const;
+
+    /// @return the first run in @p runs that overlaps or follows @p first
+    static typename Runs::const_iterator
+    first_overlapping (const Runs &runs, Offset first);
+
+    /// Add @p run to @p runs, merging with overlapping or touching runs
+    static void add_run (Runs &runs, const Run &run);
+
+    /// Remove @p run from @p runs, keeping any remainders
+    static void subtract_run (Runs &runs, const Run &run);
+
+    /// Sorted by value
+    std::vector<ValueRuns> m_value_runs;
+
+    /// Encoded point with offset 0
+    EncodedType m_epoch {};
+  };
+
+  /// Type trait to identify CompressedTimeline
+  template<typename T> struct IsCompressedTimeline : std::false_type
+  {
+  };
+
+  /// Type trait to identify CompressedTimeline
+  template<typename Value, DiscreteTimeline Interval>
+  struct IsCompressedTimeline<CompressedTimeline<Value, Interval>>
+    : std::true_type
+  {
+  };
+
+  /*
+   * _____________________________________________________________________________
+   *
+   * Implementation
+   *
+   */
+
+  template<typename Value, DiscreteTimeline Interval>
+  std::optional<std::pair<typename CompressedTimeline<Value, Interval>::
+                            EncodedType,
+                          typename CompressedTimeline<Value, Interval>::
+                            EncodedType>>
+  CompressedTimeline<Value, Interval>::encoded_points (
+    const Interval &interval)
+  {
+    if (boost::icl::is_empty (interval))
+    {
+      return std::nullopt;
+    }
+    return std::pair {EncodingType::encode (boost::icl::first (interval)),
+                      EncodingType::encode (boost::icl::last (interval))};
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  std::optional<typename CompressedTimeline<Value, Interval>::Run>
+  CompressedTimeline<Value, Interval>::query_run (
+    const Interval &query_interval) const
+  {
+    const auto points = encoded_points (query_interval);
+    if (!points || empty () || points->second < m_epoch)
+    {
+      return std::nullopt;
+    }
+    const auto first = std::max (points->first, m_epoch);
+    return Run {static_cast<Offset> (Offset (first) - Offset (m_epoch)),
+                static_cast<Offset> (Offset (points->second)
+                                     - Offset (m_epoch))};
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  Interval
+  CompressedTimeline<Value, Interval>::to_interval (const Run &run) const
+  {
+    using namespace boost::icl;
+    const auto decode = [&] (Offset offset)
+    {
+      return EncodingType::decode (
+        static_cast<EncodedType> (Offset (m_epoch) + offset));
+    };
+    const auto first = Offset (run.first);
+    const auto last = Offset (run.last);
+    if constexpr (has_dynamic_bounds<Interval>::value)
+    {
+      // Right open like the default boost::icl::interval<T>::type, unless
+      // the last point is the largest representable
+      if (static_cast<EncodedType> (Offset (m_epoch) + last)
+          == std::numeric_limits<EncodedType>::max ())
+      {
+        return Interval::closed (decode (first), decode (last));
+      }
+      return Interval::right_open (decode (first),
+                                   decode (static_cast<Offset> (last + 1)));
+    }
+    else if constexpr (is_static_right_open<Interval>::value)
+    {
+      return Interval (decode (first), decode (static_cast<Offset> (last + 1)));
+    }
+    else if constexpr (is_static_left_open<Interval>::value)
+    {
+      return Interval (decode (static_cast<Offset> (first - 1)), decode (last));
+    }
+    else if constexpr (is_static_open<Interval>::value)
+    {
+      return Interval (decode (static_cast<Offset> (first - 1)),
+                       decode (static_cast<Offset> (last + 1)));
+    }
+    else
+    {
+      return Interval (decode (first), decode (last));
+    }
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  void CompressedTimeline<Value, Interval>::rebase (EncodedType epoch)
+  {
+    assert (epoch < m_epoch);
+    const auto delta = static_cast<Offset> (Offset (m_epoch) - Offset (epoch));
+    for (auto &value_runs : m_value_runs)
+    {
+      for (auto &run : value_runs.runs)
+      {
+        run.first += delta;
+        run.last += delta;
+      }
+    }
+    m_epoch = epoch;
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  typename CompressedTimeline<Value, Interval>::Runs::const_iterator
+  CompressedTimeline<Value, Interval>::first_overlapping (const Runs &runs,
+                                                          Offset first)
+  {
+    // Runs are sorted by last as well as by first
+    return std::partition_point (runs.begin (),
+                                 runs.end (),
+                                 [first] (const Run &run)
+                                 {
+                                   return run.last < first;
+                                 });
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  void CompressedTimeline<Value, Interval>::add_run (Runs &runs,
+                                                     const Run &run)
+  {
+    // Runs ending before the point preceding run.first neither overlap nor
+    // touch
+    const auto begin
+      = std::partition_point (runs.begin (),
+                              runs.end (),
+                              [&] (const Run &existing)
+                              {
+                                return run.first != 0
+                                       && existing.last < run.first - 1;
+                              });
+    const auto end = std::find_if (begin,
+                                   runs.end (),
+                                   [&] (const Run &existing)
+                                   {
+                                     return existing.first != 0
+                                            && existing.first - 1 > run.last;
+                                   });
+    if (begin == end)
+    {
+      runs.insert (begin, run);
+      return;
+    }
+    const Run merged {std::min (run.first, begin->first),
+                      std::max (run.last, std::prev (end)->last)};
+    *begin = merged;
+    runs.erase (std::next (begin), end);
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  void CompressedTimeline<Value, Interval>::subtract_run (Runs &runs,
+                                                          const Run &run)
+  {
+    const auto begin = std::partition_point (runs.begin (),
+                                             runs.end (),
+                                             [&] (const Run &existing)
+                                             {
+                                               return existing.last
+                                                      < run.first;
+                                             });
+    const auto end = std::find_if (begin,
+                                   runs.end (),
+                                   [&] (const Run &existing)
+                                   {
+                                     return existing.first > run.last;
+                                   });
+    if (begin == end)
+    {
+      return;
+    }
+    Runs remainders;
+    if (begin->first < run.first)
+    {
+      remainders.push_back ({begin->first, static_cast<Offset> (run.first - 1)});
+    }
+    if (std::prev (end)->last > run.last)
+    {
+      remainders.push_back (
+        {static_cast<Offset> (run.last + 1), std::prev (end)->last});
+    }
+    const auto position = runs.erase (begin, end);
+    runs.insert (position, remainders.begin (), remainders.end ());
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  void CompressedTimeline<Value, Interval>::insert (EncodedType first,
+                                                    EncodedType last,
+                                                    const Value &value)
+  {
+    if (empty ())
+    {
+      m_epoch = first;
+    }
+    else if (first < m_epoch)
+    {
+      rebase (first);
+    }
+    const Run run {static_cast<Offset> (Offset (first) - Offset (m_epoch)),
+                   static_cast<Offset> (Offset (last) - Offset (m_epoch))};
+
+    const auto ff = std::partition_point (m_value_runs.begin (),
+                                          m_value_runs.end (),
+                                          [&] (const ValueRuns &value_runs)
+                                          {
+                                            return value_runs.value < value;
+                                          });
+    if (ff == m_value_runs.end () || value < ff->value)
+    {
+      m_value_runs.insert (ff, ValueRuns {value, Runs {run}});
+      return;
+    }
+    add_run (ff->runs, run);
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  void CompressedTimeline<Value, Interval>::insert (const Interval &interval,
+                                                    const Value &value)
+  {
+    if (const auto points = encoded_points (interval))
+    {
+      insert (points->first, points->second, value);
+    }
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  void CompressedTimeline<Value, Interval>::erase (const Run &run,
+                                                   const Value &value)
+  {
+    const auto ff = std::partition_point (m_value_runs.begin (),
+                                          m_value_runs.end (),
+                                          [&] (const ValueRuns &value_runs)
+                                          {
+                                            return value_runs.value < value;
+                                          });
+    if (ff == m_value_runs.end () || value < ff->value)
+    {
+      return;
+    }
+    subtract_run (ff->runs, run);
+    if (ff->runs.empty ())
+    {
+      m_value_runs.erase (ff);
+    }
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  void CompressedTimeline<Value, Interval>::erase (
+    const Interval &query_interval,
+    const Value &value)
+  {
+    if (const auto run = query_run (query_interval))
+    {
+      erase (*run, value);
+    }
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  void CompressedTimeline<Value, Interval>::erase (
+    const Interval &query_interval)
+  {
+    const auto run = query_run (query_interval);
+    if (!run)
+    {
+      return;
+    }
+    for (auto &value_runs : m_value_runs)
+    {
+      subtract_run (value_runs.runs, *run);
+    }
+    std::erase_if (m_value_runs,
+                   [] (const ValueRuns &value_runs)
+                   {
+                     return value_runs.runs.empty ();
+                   });
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  cppcoro::generator<ValueInterval<Value, Interval>>
+  CompressedTimeline<Value, Interval>::intervals (
+    Interval query_interval) const
+  {
+    const auto query = query_run (query_interval);
+    if (!query)
+    {
+      co_return;
+    }
+    ValueIntervals<Value, Interval> matches;
+    for (const auto &[value, runs] : m_value_runs)
+    {
+      for (auto run = first_overlapping (runs, query->first);
+           run != runs.end () && run->first <= query->last;
+           ++run)
+      {
+        matches.push_back ({value, to_interval (*run)});
+      }
+    }
+    std::sort (matches.begin (), matches.end ());
+    for (auto &value_interval : matches)
+    {
+      co_yield value_interval;
+    }
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  cppcoro::generator<ValuesDisjointInterval<Value, Interval>>
+  CompressedTimeline<Value, Interval>::disjoint_intervals (
+    Interval query_interval) const
+  {
+    const auto query = query_run (query_interval);
+    if (!query)
+    {
+      co_return;
+    }
+
+    // Runs clipped to the query, by where they start and where they end.
+    // Each is tagged with the index of its value
+    std::vector<std::pair<Offset, std::size_t>> starts;
+    std::vector<std::pair<Offset, std::size_t>> ends;
+    for (std::size_t index = 0; index < m_value_runs.size (); ++index)
+    {
+      const auto &runs = m_value_runs[index].runs;
+      for (auto run = first_overlapping (runs, query->first);
+           run != runs.end () && run->first <= query->last;
+           ++run)
+      {
+        starts.emplace_back (std::max (run->first, query->first), index);
+        ends.emplace_back (std::min (run->last, query->last), index);
+      }
+    }
+    std::sort (starts.begin (), starts.end ());
+    std::sort (ends.begin (), ends.end ());
+
+    // Sweep from left to right. Indices are in value order
+    std::set<std::size_t> active;
+    const auto active_values = [&]
+    {
+      SegmentValues<Value> values;
+      for (const auto index : active)
+      {
+        values.push_back (m_value_runs[index].value);
+      }
+      return values;
+    };
+    Offset segment_first = 0;
+    auto start = starts.begin ();
+    auto end = ends.begin ();
+    while (end != ends.end ())
+    {
+      // Runs starting at a point are added before runs ending there
+      // are removed
+      if (start != starts.end () && start->first <= end->first)
+      {
+        const auto point = start->first;
+        if (!active.empty () && segment_first < point)
+        {
+          co_yield ValuesDisjointInterval<Value, Interval> {
+            active_values (),
+            to_interval ({segment_first, static_cast<Offset> (point - 1)})};
+        }
+        for (; start != starts.end () && start->first == point; ++start)
+        {
+          active.insert (start->second);
+        }
+        segment_first = point;
+        continue;
+      }
+
+      const auto point = end->first;
+      co_yield ValuesDisjointInterval<Value, Interval> {
+        active_values (), to_interval ({segment_first, point})};
+      for (; end != ends.end () && end->first == point; ++end)
+      {
+        active.erase (end->second);
+      }
+      segment_first = static_cast<Offset> (point + 1);
+    }
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  typename CompressedTimeline<Value, Interval>::Runs
+  CompressedTimeline<Value, Interval>::coverage () const
+  {
+    Runs all_runs;
+    for (const auto &value_runs : m_value_runs)
+    {
+      all_runs.insert (
+        all_runs.end (), value_runs.runs.begin (), value_runs.runs.end ());
+    }
+    std::sort (all_runs.begin (),
+               all_runs.end (),
+               [] (const Run &a, const Run &b)
+               {
+                 return a.first < b.first;
+               });
+
+    Runs merged;
+    for (const auto &run : all_runs)
+    {
+      if (!merged.empty ()
+          && (merged.back ().last == std::numeric_limits<Offset>::max ()
+              || merged.back ().last + 1 >= run.first))
+      {
+        merged.back ().last = std::max (merged.back ().last, run.last);
+        continue;
+      }
+      merged.push_back (run);
+    }
+    return merged;
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  cppcoro::generator<Interval>
+  CompressedTimeline<Value, Interval>::gaps () const
+  {
+    const auto merged = coverage ();
+    for (std::size_t i = 1; i < merged.size (); ++i)
+    {
+      co_yield to_interval ({static_cast<Offset> (merged[i - 1].last + 1),
+                             static_cast<Offset> (merged[i].first - 1)});
+    }
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  SandwichedGaps<Value, Interval>
+  CompressedTimeline<Value, Interval>::sandwiched_gaps () const
+  {
+    // Where each run starts and ends, tagged with the index of its value
+    std::vector<std::pair<Offset, std::size_t>> starts;
+    std::vector<std::pair<Offset, std::size_t>> ends;
+    for (std::size_t index = 0; index < m_value_runs.size (); ++index)
+    {
+      for (const auto &run : m_value_runs[index].runs)
+      {
+        starts.emplace_back (run.first, index);
+        ends.emplace_back (run.last, index);
+      }
+    }
+    std::sort (starts.begin (), starts.end ());
+    std::sort (ends.begin (), ends.end ());
+
+    const auto values_at
+      = [&] (const std::vector<std::pair<Offset, std::size_t>> &edges,
+             Offset point)
+    {
+      const auto begin = std::lower_bound (
+        edges.begin (), edges.end (), std::pair {point, std::size_t {0}});
+      const auto end = std::upper_bound (
+        begin,
+        edges.end (),
+        std::pair {point, std::numeric_limits<std::size_t>::max ()});
+      SegmentValues<Value> values;
+      for (auto edge = begin; edge != end; ++edge)
+      {
+        values.push_back (m_value_runs[edge->second].value);
+      }
+      return values;
+    };
+
+    SandwichedGaps<Value, Interval> results;
+    const auto merged = coverage ();
+    for (std::size_t i = 1; i < merged.size (); ++i)
+    {
+      results.push_back (
+        {values_at (ends, merged[i - 1].last),
+         to_interval ({static_cast<Offset> (merged[i - 1].last + 1),
+                       static_cast<Offset> (merged[i].first - 1)}),
+         values_at (starts, merged[i].first)});
+    }
+    return results;
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  ValuesDisjointInterval<Value, Interval>
+  CompressedTimeline<Value, Interval>::initial_values () const
+  {
+    for (auto &values_interval : disjoint_intervals (interval_extent<Interval>))
+    {
+      return std::move (values_interval);
+    }
+    return {};
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  ValuesDisjointInterval<Value, Interval>
+  CompressedTimeline<Value, Interval>::final_values () const
+  {
+    ValuesDisjointInterval<Value, Interval> final_values;
+    for (auto &values_interval : disjoint_intervals (interval_extent<Interval>))
+    {
+      final_values = std::move (values_interval);
+    }
+    return final_values;
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  typename CompressedTimeline<Value, Interval>::Run
+  CompressedTimeline<Value, Interval>::rebased_from (
+    const CompressedTimeline &other,
+    const Run &run) const
+  {
+    const auto delta
+      = static_cast<Offset> (Offset (other.m_epoch) - Offset (m_epoch));
+    return {static_cast<Offset> (run.first + delta),
+            static_cast<Offset> (run.last + delta)};
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  CompressedTimeline<Value, Interval> &
+  CompressedTimeline<Value, Interval>::merged_with (
+    const CompressedTimeline &other)
+  {
+    if (other.empty ())
+    {
+      return *this;
+    }
+    if (empty ())
+    {
+      return *this = other;
+    }
+    if (other.m_epoch < m_epoch)
+    {
+      rebase (other.m_epoch);
+    }
+    for (const auto &[value, runs] : other.m_value_runs)
+    {
+      for (const auto &run : runs)
+      {
+        const auto rebased = rebased_from (other, run);
+        insert (static_cast<EncodedType> (Offset (m_epoch) + rebased.first),
+                static_cast<EncodedType> (Offset (m_epoch) + rebased.last),
+                value);
+      }
+    }
+    return *this;
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  CompressedTimeline<Value, Interval> &
+  CompressedTimeline<Value, Interval>::subtract_by (
+    const CompressedTimeline &other)
+  {
+    for (const auto &[value, runs] : other.m_value_runs)
+    {
+      for (const auto &run : runs)
+      {
+        if (empty ())
+        {
+          return *this;
+        }
+        // Clip to the epoch, before which there is nothing to erase
+        const auto first = static_cast<EncodedType> (Offset (other.m_epoch)
+                                                     + run.first);
+        const auto last
+          = static_cast<EncodedType> (Offset (other.m_epoch) + run.last);
+        if (last < m_epoch)
+        {
+          continue;
+        }
+        erase (
+          Run {static_cast<Offset> (Offset (std::max (first, m_epoch))
+                                    - Offset (m_epoch)),
+               static_cast<Offset> (Offset (last) - Offset (m_epoch))},
+          value);
+      }
+    }
+    return *this;
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  void CompressedTimeline<Value, Interval>::explain (
+    const Interval &query_interval,
+    QueryExplain &explain) const
+  {
+    explain.backend = "compressed timeline";
+    const auto query = query_run (query_interval);
+    if (!query)
+    {
+      return;
+    }
+    for (const auto &value_runs : m_value_runs)
+    {
+      const auto &runs = value_runs.runs;
+      RunExplain run_explain {
+        .begin = 0,
+        .end = static_cast<int_fast32_t> (runs.size ()),
+        .binary_search_steps
+        = static_cast<std::size_t> (std::bit_width (runs.size ()))};
+      for (auto run = first_overlapping (runs, query->first);
+           run != runs.end () && run->first <= query->last;
+           ++run)
+      {
+        ++run_explain.elements_scanned;
+        ++run_explain.elements_matched;
+      }
+      explain.count_matched += run_explain.elements_matched;
+      explain.runs.push_back (run_explain);
+    }
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  MemoryUsage CompressedTimeline<Value, Interval>::memory_usage () const
+  {
+    MemoryUsage usage;
+    details::add_vector_usage (m_value_runs, usage.bytes_intervals, usage);
+    for (const auto &value_runs : m_value_runs)
+    {
+      details::add_vector_usage (value_runs.runs, usage.bytes_runs, usage);
+    }
+    return usage;
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  void CompressedTimeline<Value, Interval>::shrink_to_fit ()
+  {
+    for (auto &value_runs : m_value_runs)
+    {
+      value_runs.runs.shrink_to_fit ();
+    }
+    m_value_runs.shrink_to_fit ();
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  std::size_t CompressedTimeline<Value, Interval>::count_runs () const
+  {
+    std::size_t count = 0;
+    for (const auto &value_runs : m_value_runs)
+    {
+      count += value_runs.runs.size ();
+    }
+    return count;
+  }
+
+  template<typename Value, DiscreteTimeline Interval>
+  bool CompressedTimeline<Value, Interval>::operator== (
+    const CompressedTimeline &rhs) const
+  {
+    if (m_value_runs.size () != rhs.m_value_runs.size ())
+    {
+      return false;
+    }
+    for (std::size_t i = 0; i < m_value_runs.size (); ++i)
+    {
+      const auto &lhs_runs = m_value_runs[i];
+      const auto &rhs_runs = rhs.m_value_runs[i];
+      if (lhs_runs.value != rhs_runs.value
+          || lhs_runs.runs.size () != rhs_runs.runs.size ())
+      {
+        return false;
+      }
+      for (std::size_t j = 0; j < lhs_runs.runs.size (); ++j)
+      {
+        if (lhs_runs.runs[j] != rebased_from (rhs, rhs_runs.runs[j]))
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+} // namespace interval_dict::timeline
+
+#endif // INCLUDE_INTERVAL_DICT_COMPRESSED_TIMELINE_H
@@ -118,7 +118,7 @@ namespace interval_dict
     {
       std::set<Value> values;
       Interval interval;
-      typename boost::icl::interval_traits<Interval>::domain_type lower_edge;
+      typename boost::icl::interval_traits<Interval>::domain_type lower_edge {};
       for (const auto &value_interval : range)
       {
         if (boost::icl::is_empty (interval))
@@ -149,7 +149,7 @@ namespace interval_dict
         return {};
       }
 
-      return {values | legacy_ranges_conversion::to_vector (), interval};
+      return {interval_dict::details::to_segment_values (values), interval};
     }
 
     namespace details
@@ -213,7 +213,7 @@ namespace interval_dict
     {
       using interval_dict::comparisons::lower_edge;
       using interval_dict::comparisons::upper_edge;
-      using legacy_ranges_conversion::to_vector;
+      using interval_dict::details::to_segment_values;
       // right edges of intervals that are in play
       std::set<details::ValueIntervalEdge<ElementType>> right_edges;
       std::set<Value> values;
@@ -255,7 +255,7 @@ namespace interval_dict
           auto interval = total_interval & right_edge_node->interval;
           if (!boost::icl::is_empty (interval))
           {
-            co_yield ValuesDisjointInterval {values | to_vector (),
+            co_yield ValuesDisjointInterval {to_segment_values (values),
                                              interval & query_interval};
           }
           values.erase (right_edge_node->value);
@@ -274,7 +274,7 @@ namespace interval_dict
                                                       value_interval.interval);
           if (!boost::icl::is_empty (interval))
           {
-            co_yield {values | to_vector (), interval & query_interval};
+            co_yield {to_segment_values (values), interval & query_interval};
             // total_interval now starts off with new open
             total_interval
               = boost::icl::hull (value_interval.interval,
@@ -299,7 +299,7 @@ namespace interval_dict
         auto interval = total_interval & right_edge_node->interval;
         if (!boost::icl::is_empty (interval))
         {
-          co_yield std::tuple {values | to_vector (),
+          co_yield std::tuple {to_segment_values (values),
                                interval & query_interval};
         }
         assert (values.count (right_edge_node->value));
@@ -348,10 +348,10 @@ namespace interval_dict
         Interval gap_interval
           = boost::icl::inner_complement (interval_before, interval_after);
         assert (!boost::icl::is_empty (gap_interval));
-        using legacy_ranges_conversion::to_vector;
-        return {values_before_set | to_vector (),
+        using interval_dict::details::to_segment_values;
+        return {to_segment_values (values_before_set),
                 gap_interval,
-                values_after_set | to_vector ()};
+                to_segment_values (values_after_set)};
       }
 
     } // namespace details
@@ -384,27 +384,34 @@ namespace interval_dict
           if (left_edges.begin ()->edge == node_left_edge)
           {
             left_edges.insert ({&value_interval, node_left_edge});
+            continue;
           }
-          continue;
 
           // different left edge: process
-
           results.push_back (details::sandwiched_gap (left_edges, right_edges));
+
+          // intervals after the gap are now the rightmost so far
+          right_edges.clear ();
           for (const auto &edge_node : left_edges)
           {
             const auto right_edge
-              = lower_edge (edge_node.p_interval_value->interval);
-            if (right_edge > right_edges.begin ()->edge)
+              = upper_edge (edge_node.p_interval_value->interval);
+            if (!right_edges.empty ()
+                && right_edge > right_edges.begin ()->edge)
             {
               right_edges.clear ();
             }
-            right_edges.insert ({edge_node.p_interval_value, right_edge});
+            if (right_edges.empty ()
+                || right_edge == right_edges.begin ()->edge)
+            {
+              right_edges.insert ({edge_node.p_interval_value, right_edge});
+            }
           }
           left_edges.clear ();
         }
 
         // process current edge: it is either a left edge or a right edge
-        if (right_edges.size ()
+        if (!right_edges.empty ()
             && details::gap_between (
               right_edges.begin ()->p_interval_value->interval,
               value_interval.interval))
@@ -413,11 +420,18 @@ namespace interval_dict
           continue;
         }
 
-        if (node_right_edge > right_edges.begin ()->edge)
+        // Only keep the intervals with the rightmost edge: these border any
+        // gap that follows
+        if (!right_edges.empty ()
+            && node_right_edge > right_edges.begin ()->edge)
         {
           right_edges.clear ();
         }
-        right_edges.insert ({&value_interval, node_right_edge});
+        if (right_edges.empty ()
+            || node_right_edge == right_edges.begin ()->edge)
+        {
+          right_edges.insert ({&value_interval, node_right_edge});
+        }
       }
 
       if (!left_edges.empty ())
@@ -21,6 +21,9 @@
 #include <boost/icl/gregorian.hpp>
 
 #include <concepts>
+#include <cstdint>
+#include <limits>
+#include <optional>
 
 namespace interval_dict::date_literals
 {
@@ -72,6 +75,75 @@ namespace interval_dict
     }
   };
 
+  /// Encodes dates as their underlying day numbers
+  ///
+  /// Special values are already reserved day numbers, in the order
+  /// -infinity < all dates < not_a_date_time < +infinity
+  template<> struct EdgeEncoding<boost::gregorian::date>
+  {
+    using EncodedType = boost::gregorian::date::date_int_type;
+
+    static EncodedType encode (const boost::gregorian::date &edge) noexcept
+    {
+      return edge.day_number ();
+    }
+
+    static boost::gregorian::date decode (EncodedType edge) noexcept
+    {
+      return boost::gregorian::date {edge};
+    }
+  };
+
+  /// Partitions dates by calendar months or years
+  ///
+  /// -infinity is before the first partition, and not_a_date_time and
+  /// +infinity are after the last
+  template<> struct TimePartitioning<boost::gregorian::date>
+  {
+    static std::int64_t partition (const boost::gregorian::date &point,
+                                   const PartitionWidth &width)
+    {
+      using Limits = std::numeric_limits<std::int64_t>;
+      if (point.is_special ())
+      {
+        return point.is_neg_infinity () ? Limits::min () : Limits::max ();
+      }
+      const auto ymd = point.year_month_day ();
+      const std::int64_t periods
+        = width.period == PartitionPeriod::Year
+            ? std::int64_t {ymd.year}
+            : std::int64_t {ymd.year} * 12 + ymd.month - 1;
+      // Years and months are positive
+      return periods / width.count_periods;
+    }
+
+    static std::optional<boost::gregorian::date>
+    partition_end (std::int64_t partition, const PartitionWidth &width)
+    {
+      using Limits = std::numeric_limits<std::int64_t>;
+      if (partition == Limits::min ())
+      {
+        return boost::gregorian::date {boost::date_time::min_date_time};
+      }
+      const auto last_year
+        = boost::gregorian::date {boost::date_time::max_date_time}.year ();
+      const auto periods = (partition + 1) * width.count_periods;
+      const auto year = width.period == PartitionPeriod::Year
+                          ? periods
+                          : periods / 12;
+      if (partition == Limits::max () || year > last_year)
+      {
+        return std::nullopt;
+      }
+      const auto month
+        = width.period == PartitionPeriod::Year ? 1 : periods % 12 + 1;
+      return boost::gregorian::date (
+        static_cast<unsigned short> (year),
+        static_cast<unsigned short> (month),
+        1);
+    }
+  };
+
 } // namespace interval_dict
 
 namespace boost::gregorian
@@ -0,0 +1,822 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file hybrid_interval_list.h
+/// \brief Intervals for a single key held in a small inline vector until
+/// they outgrow it
+///
+/// Most keys in typical data sets only ever have a handful of intervals. For
+/// these, a short sorted vector searched linearly is both smaller and faster
+/// than an augmented interval list or interval tree. HybridIntervalList keeps
+/// up to MaxSmall interval-values in a boost::container::small_vector and
+/// promotes them to the Large implementation (an AugmentedIntervalList by
+/// default) when it grows past that. Erasing, or shrink_to_fit(), demotes
+/// back to the small vector once no more than MaxSmall / 2 interval-values
+/// remain: the gap between the two thresholds stops keys near the limit from
+/// flipping back and forth.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_HYBRID_INTERVAL_LIST_H
+#define INCLUDE_INTERVAL_DICT_HYBRID_INTERVAL_LIST_H
+
+#include "adaptor.h"
+#include "disjoint_adaptor.h"
+#include "instrumentation.h"
+#include "interval_compare.h"
+#include "interval_traits.h" // boost/container/small_vector.hpp
+#include "memory_usage.h"
+#include "query_explain.h"
+#include "value_interval.h"
+
+#include <boost/icl/concept/interval.hpp>
+
+#include <cppcoro/generator.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace interval_dict::hybrid
+{
+  /// Number of interval-values stored inside HybridIntervalList itself
+  /// before the small vector spills onto the heap
+  inline constexpr std::size_t count_inline_intervals = 4;
+
+  /**
+   * Interval-values for a single key stored as a sorted small vector, or
+   * as @p Large once there are more than @p MaxSmall of them.
+   *
+   * In the small representation, interval-values are sorted by interval then
+   * value, and overlapping or touching intervals with the same value are
+   * merged on insert, exactly as in the other implementations.
+   *
+   * @tparam Large Implementation used for keys with many intervals. Must
+   * have a specialisation of interval_dict::Implementation
+   * @tparam MaxSmall Largest number of interval-values kept in the small
+   * vector
+   */
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall = 64>
+  class HybridIntervalList
+  {
+    public:
+    using ValueIntervalType = ValueInterval<Value, Interval>;
+    using SmallVector
+      = boost::container::small_vector<ValueIntervalType,
+                                       count_inline_intervals>;
+    using LargeImplementation = Implementation<Value, Interval, Large>;
+    using LargeType = Large;
+
+    static_assert (MaxSmall >= count_inline_intervals);
+
+    /// Promote when there are more interval-values than this
+    static constexpr std::size_t max_small = MaxSmall;
+
+    /// erase() and shrink_to_fit() demote when there are no more
+    /// interval-values than this
+    static constexpr std::size_t max_demote = MaxSmall / 2;
+
+    HybridIntervalList () = default;
+    HybridIntervalList (const HybridIntervalList &other);
+    HybridIntervalList (HybridIntervalList &&other) noexcept = default;
+    HybridIntervalList &operator= (const HybridIntervalList &other);
+    HybridIntervalList &operator= (HybridIntervalList &&other) noexcept
+      = default;
+
+    /// @return whether the interval-values are held by Large
+    [[nodiscard]] bool is_large () const
+    {
+      return m_large != nullptr;
+    }
+
+    /// @return whether there are no values
+    [[nodiscard]] bool empty () const;
+
+    /// @return coroutine enumerating all interval-values overlapping
+    /// @p query_interval sorted by interval
+    cppcoro::generator<ValueIntervalType>
+    intervals (const Interval &query_interval) const;
+
+    /// @return coroutine enumerating all disjoint interval-values over
+    /// @p query_interval
+    cppcoro::generator<ValuesDisjointInterval<Value, Interval>>
+    disjoint_intervals (const Interval &query_interval) const;
+
+    /// @return coroutine enumerating gaps between intervals
+    cppcoro::generator<Interval> gaps () const;
+
+    /// @return gaps between intervals and the values on either side
+    SandwichedGaps<Value, Interval> sandwiched_gaps () const;
+
+    /// @return first disjoint interval (with one or more values)
+    ValuesDisjointInterval<Value, Interval> initial_values () const;
+
+    /// @return last disjoint interval (with one or more values)
+    ValuesDisjointInterval<Value, Interval> final_values () const;
+
+    /// insert @p value for @p interval, promoting to Large if necessary
+    void insert (const Interval &interval, const Value &value);
+
+    /// erase @p value for @p query_interval, demoting to the small vector if
+    /// few interval-values remain
+    void erase (const Interval &query_interval, const Value &value);
+
+    /// erase all values for @p query_interval, demoting to the small vector
+    /// if few interval-values remain
+    void erase (const Interval &query_interval);
+
+    /// @return the union with another set of interval-values
+    HybridIntervalList &merged_with (const HybridIntervalList &other);
+
+    /// @return the asymmetrical difference with another set of
+    /// interval-values
+    HybridIntervalList &subtract_by (const HybridIntervalList &other);
+
+    /// record the work done by a query over @p query_interval in @p explain
+    void explain (const Interval &query_interval, QueryExplain &explain) const;
+
+    /// @return bytes used. The inline small vector buffer is counted as part
+    /// of the owning container and is not included here
+    [[nodiscard]] MemoryUsage memory_usage () const;
+
+    /// release unused capacity, and demote to the small vector if few
+    /// interval-values remain
+    void shrink_to_fit ();
+
+    /// @return whether Large has pending changes to be integrated
+    [[nodiscard]] bool needs_compaction () const;
+
+    /// integrate pending changes in Large
+    void compact ();
+
+    /// @return a value that changes whenever Large is modified, or 0 for
+    /// the small vector, which is never compacted
+    [[nodiscard]] std::uint64_t generation () const;
+
+#ifdef INTERVAL_DICT_STATS
+    /// add internal statistics to @p stats
+    void collect_stats (instrumentation::Stats &stats) const;
+
+    /// zero internal statistics
+    void reset_stats ();
+#endif
+
+    /// Equal if the same interval-values, whichever the representation
+    bool operator== (const HybridIntervalList &rhs) const;
+
+    private:
+    /// @return all interval-values sorted by interval
+    ValueIntervals<Value, Interval> all_intervals () const;
+
+    /// Move the small vector into a newly created Large
+    void promote ();
+
+    /// Move the contents of Large back into the small vector
+    void demote ();
+
+    /// demote() if Large can cheaply show that few interval-values remain
+    void demote_after_erase ();
+
+    /// Sorted by interval then value, unless promoted
+    SmallVector m_small;
+
+    /// Only allocated after promotion
+    std::unique_ptr<Large> m_large;
+  };
+
+  /// Type trait to identify HybridIntervalList
+  template<typename T> struct IsHybridIntervalList : std::false_type
+  {
+  };
+
+  /// Type trait to identify HybridIntervalList
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  struct IsHybridIntervalList<
+    HybridIntervalList<Value, Interval, Large, MaxSmall>> : std::true_type
+  {
+  };
+
+  /*
+   * _____________________________________________________________________________
+   *
+   * Implementation
+   *
+   */
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::HybridIntervalList (
+    const HybridIntervalList &other)
+    : m_small (other.m_small)
+    , m_large (other.m_large ? std::make_unique<Large> (*other.m_large)
+                             : nullptr)
+  {
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  HybridIntervalList<Value, Interval, Large, MaxSmall> &
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::operator= (
+    const HybridIntervalList &other)
+  {
+    if (this != &other)
+    {
+      m_small = other.m_small;
+      m_large = other.m_large ? std::make_unique<Large> (*other.m_large)
+                              : nullptr;
+    }
+    return *this;
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  bool HybridIntervalList<Value, Interval, Large, MaxSmall>::empty () const
+  {
+    if (m_large)
+    {
+      return LargeImplementation::empty (*m_large);
+    }
+    return m_small.empty ();
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  cppcoro::generator<ValueInterval<Value, Interval>>
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::intervals (
+    const Interval &query_interval) const
+  {
+    if (m_large)
+    {
+      for (const auto &value_interval :
+           LargeImplementation::intervals (*m_large, query_interval))
+      {
+        co_yield ValueIntervalType {value_interval.value,
+                                    value_interval.interval};
+      }
+      co_return;
+    }
+
+    for (const auto &value_interval : m_small)
+    {
+      // Sorted by interval: nothing further along can overlap
+      if (comparisons::exclusive_less (query_interval,
+                                       value_interval.interval))
+      {
+        break;
+      }
+      if (boost::icl::intersects (value_interval.interval, query_interval))
+      {
+        co_yield ValueIntervalType {value_interval};
+      }
+    }
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  cppcoro::generator<ValuesDisjointInterval<Value, Interval>>
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::disjoint_intervals (
+    const Interval &query_interval) const
+  {
+    if (m_large)
+    {
+      return LargeImplementation::disjoint_intervals (*m_large,
+                                                      query_interval);
+    }
+    ValueIntervals<Value, Interval> matches;
+    for (const auto &value_interval : intervals (query_interval))
+    {
+      matches.push_back (value_interval);
+    }
+    return disjoint_adaptor::
+      disjoint_intervals<Value, Interval, ValueIntervalType> (
+        std::move (matches), query_interval);
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  cppcoro::generator<Interval>
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::gaps () const
+  {
+    if (m_large)
+    {
+      return LargeImplementation::gaps (*m_large);
+    }
+    return disjoint_adaptor::gaps<Interval> (m_small);
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  SandwichedGaps<Value, Interval>
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::sandwiched_gaps ()
+    const
+  {
+    if (m_large)
+    {
+      return LargeImplementation::sandwiched_gaps (*m_large);
+    }
+    return disjoint_adaptor::
+      sandwiched_gaps<Value, Interval, ValueIntervalType> (m_small);
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  ValuesDisjointInterval<Value, Interval>
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::initial_values ()
+    const
+  {
+    assert (!empty ());
+    if (m_large)
+    {
+      return LargeImplementation::initial_values (*m_large);
+    }
+    return disjoint_adaptor::initial_values<Value, Interval> (m_small);
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  ValuesDisjointInterval<Value, Interval>
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::final_values () const
+  {
+    assert (!empty ());
+    if (m_large)
+    {
+      return LargeImplementation::final_values (*m_large);
+    }
+    ValuesDisjointInterval<Value, Interval> final_values;
+    for (auto &&values_interval :
+         disjoint_intervals (interval_extent<Interval>))
+    {
+      final_values = std::move (values_interval);
+    }
+    return final_values;
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  void HybridIntervalList<Value, Interval, Large, MaxSmall>::insert (
+    const Interval &interval,
+    const Value &value)
+  {
+    if (boost::icl::is_empty (interval))
+    {
+      return;
+    }
+    if (m_large)
+    {
+      LargeImplementation::insert (*m_large, interval, value);
+      return;
+    }
+
+    // Merge with overlapping or touching intervals with the same value.
+    // These are already disjoint from each other, so anything touching the
+    // merged interval must touch the original
+    auto total_interval = interval;
+    m_small.erase (
+      std::remove_if (m_small.begin (),
+                      m_small.end (),
+                      [&] (const ValueIntervalType &value_interval)
+                      {
+                        if (value_interval.value != value
+                            || !comparisons::more_or_touches (
+                              value_interval.interval, interval)
+                            || !comparisons::more_or_touches (
+                              interval, value_interval.interval))
+                        {
+                          return false;
+                        }
+                        total_interval = boost::icl::hull (
+                          total_interval, value_interval.interval);
+                        return true;
+                      }),
+      m_small.end ());
+    ValueIntervalType new_value_interval {value, total_interval};
+    m_small.insert (std::upper_bound (m_small.begin (),
+                                      m_small.end (),
+                                      new_value_interval),
+                    std::move (new_value_interval));
+
+    if (m_small.size () > MaxSmall)
+    {
+      promote ();
+    }
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  void HybridIntervalList<Value, Interval, Large, MaxSmall>::erase (
+    const Interval &query_interval,
+    const Value &value)
+  {
+    if (m_large)
+    {
+      LargeImplementation::erase (*m_large, query_interval, value);
+      demote_after_erase ();
+      return;
+    }
+
+    // Remove matches and add back any parts outside the query
+    SmallVector remainders;
+    m_small.erase (std::remove_if (
+      m_small.begin (),
+      m_small.end (),
+      [&] (const ValueIntervalType &value_interval)
+      {
+        if (value_interval.value != value
+            || !boost::icl::intersects (value_interval.interval,
+                                        query_interval))
+        {
+          return false;
+        }
+        for (const auto &remainder :
+             {boost::icl::right_subtract (value_interval.interval,
+                                          query_interval),
+              boost::icl::left_subtract (value_interval.interval,
+                                         query_interval)})
+        {
+          if (!boost::icl::is_empty (remainder))
+          {
+            remainders.push_back ({value, remainder});
+          }
+        }
+        return true;
+      }),
+      m_small.end ());
+    if (remainders.empty ())
+    {
+      return;
+    }
+    m_small.insert (m_small.end (), remainders.begin (), remainders.end ());
+    std::sort (m_small.begin (), m_small.end ());
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  void HybridIntervalList<Value, Interval, Large, MaxSmall>::erase (
+    const Interval &query_interval)
+  {
+    if (m_large)
+    {
+      LargeImplementation::erase (*m_large, query_interval);
+      demote_after_erase ();
+      return;
+    }
+
+    SmallVector remainders;
+    m_small.erase (std::remove_if (
+      m_small.begin (),
+      m_small.end (),
+      [&] (const ValueIntervalType &value_interval)
+      {
+        if (!boost::icl::intersects (value_interval.interval, query_interval))
+        {
+          return false;
+        }
+        for (const auto &remainder :
+             {boost::icl::right_subtract (value_interval.interval,
+                                          query_interval),
+              boost::icl::left_subtract (value_interval.interval,
+                                         query_interval)})
+        {
+          if (!boost::icl::is_empty (remainder))
+          {
+            remainders.push_back ({value_interval.value, remainder});
+          }
+        }
+        return true;
+      }),
+      m_small.end ());
+    if (remainders.empty ())
+    {
+      return;
+    }
+    m_small.insert (m_small.end (), remainders.begin (), remainders.end ());
+    std::sort (m_small.begin (), m_small.end ());
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  HybridIntervalList<Value, Interval, Large, MaxSmall> &
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::merged_with (
+    const HybridIntervalList &other)
+  {
+    if (m_large && other.m_large)
+    {
+      LargeImplementation::merged_with (*m_large, *other.m_large);
+      return *this;
+    }
+
+    // Start from whichever already holds a Large
+    if (!m_large && other.m_large)
+    {
+      auto small = std::move (m_small);
+      m_small.clear ();
+      m_large = std::make_unique<Large> (*other.m_large);
+      for (const auto &value_interval : small)
+      {
+        LargeImplementation::insert (
+          *m_large, value_interval.interval, value_interval.value);
+      }
+      return *this;
+    }
+
+    for (const auto &value_interval : other.m_small)
+    {
+      insert (value_interval.interval, value_interval.value);
+    }
+    return *this;
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  HybridIntervalList<Value, Interval, Large, MaxSmall> &
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::subtract_by (
+    const HybridIntervalList &other)
+  {
+    if (m_large && other.m_large)
+    {
+      LargeImplementation::subtract_by (*m_large, *other.m_large);
+      return *this;
+    }
+    for (const auto &value_interval : other.all_intervals ())
+    {
+      erase (value_interval.interval, value_interval.value);
+    }
+    return *this;
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  void HybridIntervalList<Value, Interval, Large, MaxSmall>::explain (
+    const Interval &query_interval,
+    QueryExplain &explain) const
+  {
+    if (m_large)
+    {
+      LargeImplementation::explain (*m_large, query_interval, explain);
+      explain.backend = "hybrid: " + explain.backend;
+      return;
+    }
+
+    explain.backend = "hybrid: small vector";
+    RunExplain run {.begin = 0,
+                    .end = static_cast<int_fast32_t> (m_small.size ()),
+                    .brute_force = true};
+    for (const auto &value_interval : m_small)
+    {
+      ++run.elements_scanned;
+      if (comparisons::exclusive_less (query_interval,
+                                       value_interval.interval))
+      {
+        break;
+      }
+      if (boost::icl::intersects (value_interval.interval, query_interval))
+      {
+        ++run.elements_matched;
+      }
+    }
+    explain.count_matched += run.elements_matched;
+    explain.runs.push_back (run);
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  MemoryUsage
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::memory_usage () const
+  {
+    if (m_large)
+    {
+      auto usage = LargeImplementation::memory_usage (*m_large);
+      usage.bytes_nodes += sizeof (Large);
+      return usage;
+    }
+
+    MemoryUsage usage;
+    if (m_small.capacity () > count_inline_intervals)
+    {
+      usage.bytes_intervals = m_small.size () * sizeof (ValueIntervalType);
+      usage.bytes_wasted_capacity
+        = (m_small.capacity () - m_small.size ()) * sizeof (ValueIntervalType);
+    }
+    return usage;
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  void HybridIntervalList<Value, Interval, Large, MaxSmall>::shrink_to_fit ()
+  {
+    if (m_large)
+    {
+      LargeImplementation::shrink_to_fit (*m_large);
+      demote ();
+      return;
+    }
+    m_small.shrink_to_fit ();
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  bool
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::needs_compaction ()
+    const
+  {
+    return m_large && LargeImplementation::needs_compaction (*m_large);
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  void HybridIntervalList<Value, Interval, Large, MaxSmall>::compact ()
+  {
+    if (m_large)
+    {
+      LargeImplementation::compact (*m_large);
+    }
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  std::uint64_t
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::generation () const
+  {
+    return m_large ? LargeImplementation::generation (*m_large) : 0;
+  }
+
+#ifdef INTERVAL_DICT_STATS
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  void HybridIntervalList<Value, Interval, Large, MaxSmall>::collect_stats (
+    instrumentation::Stats &stats) const
+  {
+    if (m_large)
+    {
+      LargeImplementation::collect_stats (*m_large, stats);
+      return;
+    }
+    stats.count_intervals += m_small.size ();
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  void HybridIntervalList<Value, Interval, Large, MaxSmall>::reset_stats ()
+  {
+    if (m_large)
+    {
+      LargeImplementation::reset_stats (*m_large);
+    }
+  }
+#endif
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  bool HybridIntervalList<Value, Interval, Large, MaxSmall>::operator== (
+    const HybridIntervalList &rhs) const
+  {
+    if (!m_large && !rhs.m_large)
+    {
+      return m_small == rhs.m_small;
+    }
+    return all_intervals () == rhs.all_intervals ();
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  ValueIntervals<Value, Interval>
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::all_intervals () const
+  {
+    ValueIntervals<Value, Interval> value_intervals;
+    for (const auto &value_interval : intervals (interval_extent<Interval>))
+    {
+      value_intervals.push_back (value_interval);
+    }
+    std::sort (value_intervals.begin (), value_intervals.end ());
+    return value_intervals;
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  void HybridIntervalList<Value, Interval, Large, MaxSmall>::promote ()
+  {
+    assert (!m_large);
+    if constexpr (std::is_constructible_v<Large,
+                                          ValueIntervals<Value, Interval>>)
+    {
+      m_large = std::make_unique<Large> (
+        ValueIntervals<Value, Interval> (m_small.begin (), m_small.end ()));
+    }
+    else
+    {
+      m_large = std::make_unique<Large> ();
+      for (const auto &value_interval : m_small)
+      {
+        LargeImplementation::insert (
+          *m_large, value_interval.interval, value_interval.value);
+      }
+    }
+    m_small.clear ();
+    m_small.shrink_to_fit ();
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  void HybridIntervalList<Value, Interval, Large, MaxSmall>::demote ()
+  {
+    assert (m_large);
+    auto value_intervals = all_intervals ();
+    if (value_intervals.size () > max_demote)
+    {
+      return;
+    }
+    m_small.assign (value_intervals.begin (), value_intervals.end ());
+    m_large.reset ();
+  }
+
+  template<typename Value,
+           typename Interval,
+           typename Large,
+           std::size_t MaxSmall>
+  void
+  HybridIntervalList<Value, Interval, Large, MaxSmall>::demote_after_erase ()
+  {
+    // Counting the interval-values of Large on every erase would be linear,
+    // so only try when the number stored (including erased intervals not
+    // yet removed) is already small. Other Large types are only demoted by
+    // shrink_to_fit()
+    if constexpr (requires (const Large &large) { large.count_stored (); })
+    {
+      if (m_large->count_stored () <= max_demote)
+      {
+        demote ();
+      }
+    }
+  }
+
+} // namespace interval_dict::hybrid
+
+#endif // INCLUDE_INTERVAL_DICT_HYBRID_INTERVAL_LIST_H
@@ -0,0 +1,301 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file instrumentation.h
+/// \brief Opt-in counters and timers for IntervalDict operations
+///
+/// Compiled in only if INTERVAL_DICT_STATS is defined, e.g. with
+/// `cmake -DINTERVAL_DICT_STATS=ON`. Otherwise all hooks expand to nothing
+/// and dictionaries carry no extra state.
+///
+/// Counters updated by const queries, which may run on several threads at
+/// once (e.g. in temporal_join()), are relaxed atomics. Other statistics are
+/// not synchronised: timed operations, even const ones such as find(), must
+/// not be called concurrently on the same dictionary.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_INSTRUMENTATION_H
+#define INCLUDE_INTERVAL_DICT_INSTRUMENTATION_H
+
+#ifdef INTERVAL_DICT_STATS
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+
+namespace interval_dict::instrumentation
+{
+  /// Latencies in nanoseconds binned by powers of 2
+  struct Histogram
+  {
+    /// buckets[i] counts latencies in [2^(i-1), 2^i) nanoseconds. The last
+    /// bucket also counts all longer latencies
+    std::array<std::uint64_t, 64> buckets {};
+    std::uint64_t total_ns = 0;
+    std::uint64_t max_ns = 0;
+
+    void add (std::uint64_t nanoseconds)
+    {
+      ++buckets[std::min<std::size_t> (std::bit_width (nanoseconds),
+                                       buckets.size () - 1)];
+      total_ns += nanoseconds;
+      max_ns = std::max (max_ns, nanoseconds);
+    }
+
+    Histogram &operator+= (const Histogram &other)
+    {
+      for (std::size_t i = 0; i < buckets.size (); ++i)
+      {
+        buckets[i] += other.buckets[i];
+      }
+      total_ns += other.total_ns;
+      max_ns = std::max (max_ns, other.max_ns);
+      return *this;
+    }
+  };
+
+  /// Number of calls and their latencies
+  struct OperationStats
+  {
+    std::uint64_t calls = 0;
+    Histogram latencies;
+
+    OperationStats &operator+= (const OperationStats &other)
+    {
+      calls += other.calls;
+      latencies += other.latencies;
+      return *this;
+    }
+  };
+
+  /// Statistics for a dictionary, aggregated over all keys.
+  /// Counters that do not apply to an implementation remain zero.
+  struct Stats
+  {
+    /// Public IntervalDict member functions by name
+    std::map<std::string, OperationStats> operations;
+
+    /// Current state
+    std::uint64_t count_keys = 0;
+    std::uint64_t count_intervals = 0;
+
+    /// Augmented interval lists: calls to decompose_into_runs()
+    OperationStats decompositions;
+    /// Augmented interval lists: current sorted runs
+    std::uint64_t count_runs = 0;
+    /// Augmented interval lists: intervals promoted out of the first run
+    std::uint64_t count_promoted = 0;
+    /// Augmented interval lists: inserts not yet integrated into runs
+    std::uint64_t count_pending_inserts = 0;
+    /// Augmented interval lists: erased intervals (tombstones) not yet removed
+    std::uint64_t count_pending_removes = 0;
+    /// Augmented interval lists: intervals examined by queries
+    std::uint64_t count_elements_scanned = 0;
+
+    /// Interval trees: red-black tree rotations
+    std::uint64_t count_rotations = 0;
+
+    Stats &operator+= (const Stats &other)
+    {
+      for (const auto &[name, operation] : other.operations)
+      {
+        operations[name] += operation;
+      }
+      count_keys += other.count_keys;
+      count_intervals += other.count_intervals;
+      decompositions += other.decompositions;
+      count_runs += other.count_runs;
+      count_promoted += other.count_promoted;
+      count_pending_inserts += other.count_pending_inserts;
+      count_pending_removes += other.count_pending_removes;
+      count_elements_scanned += other.count_elements_scanned;
+      count_rotations += other.count_rotations;
+      return *this;
+    }
+  };
+
+  /// Count updated by const member functions on any thread. Copies take a
+  /// snapshot of the count
+  class RelaxedCounter
+  {
+    public:
+    RelaxedCounter () = default;
+
+    RelaxedCounter (const RelaxedCounter &other)
+      : m_count (other.load ())
+    {
+    }
+
+    RelaxedCounter &operator= (const RelaxedCounter &other)
+    {
+      m_count.store (other.load (), std::memory_order_relaxed);
+      return *this;
+    }
+
+    RelaxedCounter &operator+= (std::uint64_t count)
+    {
+      m_count.fetch_add (count, std::memory_order_relaxed);
+      return *this;
+    }
+
+    [[nodiscard]] std::uint64_t load () const
+    {
+      return m_count.load (std::memory_order_relaxed);
+    }
+
+    private:
+    std::atomic<std::uint64_t> m_count {0};
+  };
+
+  /// Records the duration of its own lifetime as a call
+  class ScopedTimer
+  {
+    public:
+    explicit ScopedTimer (OperationStats &operation_stats)
+      : m_operation_stats (operation_stats)
+      , m_start (std::chrono::steady_clock::now ())
+    {
+    }
+
+    ~ScopedTimer ()
+    {
+      ++m_operation_stats.calls;
+      m_operation_stats.latencies.add (
+        std::chrono::duration_cast<std::chrono::nanoseconds> (
+          std::chrono::steady_clock::now () - m_start)
+          .count ());
+    }
+
+    ScopedTimer (const ScopedTimer &) = delete;
+    ScopedTimer &operator= (const ScopedTimer &) = delete;
+
+    private:
+    OperationStats &m_operation_stats;
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+  /// Tree rotations on this thread. Rotation callbacks have no access to
+  /// their enclosing IntervalTree so count here and attribute the difference
+  /// with ScopedDelta
+  inline thread_local std::uint64_t thread_tree_rotations = 0;
+
+  /// Adds changes in a running counter over its own lifetime to @p total
+  class ScopedDelta
+  {
+    public:
+    ScopedDelta (const std::uint64_t &counter, std::uint64_t &total)
+      : m_counter (counter)
+      , m_total (total)
+      , m_start (counter)
+    {
+    }
+
+    ~ScopedDelta ()
+    {
+      m_total += m_counter - m_start;
+    }
+
+    ScopedDelta (const ScopedDelta &) = delete;
+    ScopedDelta &operator= (const ScopedDelta &) = delete;
+
+    private:
+    const std::uint64_t &m_counter;
+    std::uint64_t &m_total;
+    std::uint64_t m_start;
+  };
+
+  /// @cond Suppress_Doxygen_Warning
+  namespace details
+  {
+    inline void write_json (std::ostream &ostream, const Histogram &histogram)
+    {
+      // Trailing empty buckets are omitted
+      auto last = histogram.buckets.size ();
+      while (last > 0 && histogram.buckets[last - 1] == 0)
+      {
+        --last;
+      }
+      ostream << "{\"total_ns\": " << histogram.total_ns
+              << ", \"max_ns\": " << histogram.max_ns
+              << ", \"log2_ns_buckets\": [";
+      for (std::size_t i = 0; i < last; ++i)
+      {
+        ostream << (i ? ", " : "") << histogram.buckets[i];
+      }
+      ostream << "]}";
+    }
+
+    inline void write_json (std::ostream &ostream,
+                            const OperationStats &operation_stats)
+    {
+      ostream << "{\"calls\": " << operation_stats.calls
+              << ", \"latencies\": ";
+      write_json (ostream, operation_stats.latencies);
+      ostream << "}";
+    }
+  } // namespace details
+  /// @endcond
+
+  /// Dump statistics as a single JSON object
+  inline void write_json (std::ostream &ostream, const Stats &stats)
+  {
+    ostream << "{\n  \"operations\": {";
+    bool first = true;
+    for (const auto &[name, operation_stats] : stats.operations)
+    {
+      ostream << (first ? "\n" : ",\n") << "    \"" << name << "\": ";
+      details::write_json (ostream, operation_stats);
+      first = false;
+    }
+    ostream << "\n  },\n"
+            << "  \"count_keys\": " << stats.count_keys << ",\n"
+            << "  \"count_intervals\": " << stats.count_intervals << ",\n"
+            << "  \"decompositions\": ";
+    details::write_json (ostream, stats.decompositions);
+    ostream << ",\n"
+            << "  \"count_runs\": " << stats.count_runs << ",\n"
+            << "  \"fraction_promoted\": "
+            << (stats.count_intervals
+                  ? static_cast<double> (stats.count_promoted)
+                      / stats.count_intervals
+                  : 0.0)
+            << ",\n"
+            << "  \"count_pending_inserts\": " << stats.count_pending_inserts
+            << ",\n"
+            << "  \"count_pending_removes\": " << stats.count_pending_removes
+            << ",\n"
+            << "  \"count_elements_scanned\": "
+            << stats.count_elements_scanned << ",\n"
+            << "  \"count_rotations\": " << stats.count_rotations << "\n"
+            << "}\n";
+  }
+
+} // namespace interval_dict::instrumentation
+
+/// Time the enclosing scope as a call to IntervalDict operation @p name
+#define INTERVAL_DICT_TIME_OPERATION(name)                                     \
+  const interval_dict::instrumentation::ScopedTimer                            \
+    interval_dict_operation_timer_ (operation_stats.operations[name])
+
+#else
+
+#define INTERVAL_DICT_TIME_OPERATION(name)
+
+#endif // INTERVAL_DICT_STATS
+
+#endif // INCLUDE_INTERVAL_DICT_INSTRUMENTATION_H
@@ -0,0 +1,1013 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file interned_intervaldict.h
+/// \brief Interval dictionary storing keys and values as dense ids
+///
+/// Keys and values such as std::string identifiers are otherwise copied into
+/// every node and interval of the implementation. InternedIntervalDictExp
+/// instead interns them in a SymbolTable and stores only SymbolIds in an
+/// IntervalDictExp<SymbolId, SymbolId>, so that the implementation compares
+/// and copies integers. Keys and values are translated back at the API
+/// boundary, and results are sorted by Key and Value as for IntervalDictExp.
+///
+/// Dictionaries that share their symbol tables (for example the results of
+/// invert() and joined_to()) are combined directly on ids.
+///
+/// There is no interned BiIntervalDictExp: invert() shares the symbol tables,
+/// so it is cheap to invert when needed.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_INTERNED_INTERVALDICT_H
+#define INCLUDE_INTERVAL_DICT_INTERNED_INTERVALDICT_H
+
+#include "adaptor.h"
+#include "intervaldict.h"
+#include "memory_usage.h"
+#include "symbol_table.h"
+
+#include <boost/icl/concept/interval.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace interval_dict
+{
+  /// @cond Suppress_Doxygen_Warning
+  namespace details
+  {
+    /// @return id in @p to of the symbol with @p id in @p from
+    /// \param add_missing intern the symbol in @p to if it is not present
+    template<typename T>
+    std::optional<SymbolId> translate_id (SymbolId id,
+                                          const SymbolTable<T> &from,
+                                          SymbolTable<T> &to,
+                                          bool add_missing)
+    {
+      if (&from == &to)
+      {
+        return id;
+      }
+      if (add_missing)
+      {
+        return to.intern (from.symbol (id));
+      }
+      return to.find (from.symbol (id));
+    }
+  } // namespace details
+  /// @endcond
+
+  // forward declaration of InternedIntervalDictExp
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  class InternedIntervalDictExp;
+
+  /// \brief Flattens dictionary to one value per key per interval
+  ///
+  /// As for flattened() of IntervalDictExp. The values returned by
+  /// @p keep_one_value are interned if necessary
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  [[nodiscard]] InternedIntervalDictExp<Key, Value, Interval, Impl> flattened (
+    InternedIntervalDictExp<Key, Value, Interval, Impl> interval_dict,
+    FlattenPolicy<typename details::identity<Key>::type,
+                  typename details::identity<Value>::type,
+                  typename details::identity<Interval>::type> keep_one_value
+    = flatten_policy_prefer_status_quo ());
+
+  /**
+   * @brief one-to-many interval dictionary storing interned keys and values
+   *
+   * Has the same insert, erase, find, gap-filling and subset member functions
+   * as IntervalDictExp. disjoint_intervals() and intervals() are member
+   * functions returning vectors rather than coroutines. Symbol tables are
+   * held by std::shared_ptr and may be shared between dictionaries. Symbols
+   * are never removed from a table.
+   *
+   * @tparam Key Type of keys
+   * @tparam Value Type of Values
+   * @tparam Interval Interval Type. E.g. boost::icl::right_open_interval<Date>
+   * @tparam Impl Implementation for Value as for IntervalDictExp. It is
+   * rebound to SymbolId for storage
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  class InternedIntervalDictExp
+  {
+    public:
+    /// @cond Suppress_Doxygen_Warning
+    using IntervalType = Interval;
+    using BaseType = typename IntervalTraits<Interval>::BaseType;
+    using KeyType = Key;
+    using ValType = Value;
+    using BaseDifferenceType =
+      typename IntervalTraits<Interval>::BaseDifferenceType;
+    // boost icl interval_set of Intervals
+    using Intervals = interval_dict::Intervals<Interval>;
+    using KeyValueIntervals = std::vector<std::tuple<Key, Value, Interval>>;
+    using KeyValuesDisjointIntervals
+      = std::vector<KeyValuesDisjointInterval<Key, Value, Interval>>;
+    using KeySymbols = SymbolTable<Key>;
+    using ValueSymbols = SymbolTable<Value>;
+    using IdImplType = typename Implementation<Value, Interval, Impl>::
+      template rebind<SymbolId>::type;
+    using IdDict = IntervalDictExp<SymbolId, SymbolId, Interval, IdImplType>;
+    using InverseImplType =
+      typename Implementation<Value, Interval, Impl>::template rebind<
+        Key>::type;
+    template<typename OtherVal>
+    using OtherImplType =
+      typename Implementation<Value, Interval, Impl>::template rebind<
+        OtherVal>::type;
+    /// @endcond
+
+    /// @name Constructors
+    /// @{
+
+    /// Default Constructor with new symbol tables
+    InternedIntervalDictExp ();
+
+    /// Construct with shared symbol tables
+    InternedIntervalDictExp (std::shared_ptr<KeySymbols> key_symbols,
+                             std::shared_ptr<ValueSymbols> value_symbols);
+
+    /// Construct from a vector of [key-value-interval]s
+    explicit InternedIntervalDictExp (
+      const KeyValueIntervals &key_value_intervals);
+
+    /// @}
+    /// @name Insert and Erase Member Functions
+    /// @{
+
+    /// Insert key-value pairs valid over the specified interval
+    InternedIntervalDictExp &
+    insert (const std::vector<std::pair<Key, Value>> &key_value_pairs,
+            Interval interval = interval_extent<Interval>);
+
+    /// Insert [key-value-interval]s
+    InternedIntervalDictExp &
+    insert (const KeyValueIntervals &key_value_intervals);
+
+    /// Erase [key-value-interval]s
+    InternedIntervalDictExp &
+    erase (const KeyValueIntervals &key_value_intervals);
+
+    /// Erase key-value pairs over the specified interval
+    InternedIntervalDictExp &
+    erase (const std::vector<std::pair<Key, Value>> &key_value_pairs,
+           Interval interval = interval_extent<Interval>);
+
+    /// Erase all values for @p key over @p interval
+    InternedIntervalDictExp &
+    erase (const Key &key, Interval interval = interval_extent<Interval>);
+
+    /// Erase all keys and values over @p interval
+    InternedIntervalDictExp &erase (Interval interval);
+
+    /// erase all keys. Symbols are kept in the shared tables
+    void clear ();
+
+    /// @}
+    /// @name Find Member Functions
+    /// @{
+
+    /// Returns all mapped values in a sorted list for the specified @p key on
+    /// the given query start. Only really makes sense for closed intervals
+    [[nodiscard]] std::vector<Value> find (const Key &key,
+                                           BaseType query) const;
+
+    /// Returns all mapped values in a sorted list for the specified @p key on
+    /// the given query interval
+    [[nodiscard]] std::vector<Value>
+    find (const Key &key, Interval interval = interval_extent<Interval>) const;
+
+    /// Returns all mapped values in a sorted list for the specified @p keys on
+    /// the given query interval
+    [[nodiscard]] std::vector<Value> find (const std::vector<Key> &keys,
+                                           Interval interval
+                                           = interval_extent<Interval>) const;
+
+    /// @}
+    /// @name Gap-filling Member Functions
+    /// @{
+    /// As for IntervalDictExp. Values are compared by id, which is the same
+    /// as comparing their symbols
+
+    /// Supplement with entries from @p other only for missing keys or gaps
+    /// where a key does not map to any values. \return *this
+    InternedIntervalDictExp &
+    fill_gaps_with (const InternedIntervalDictExp &other);
+
+    /// Back fill initial gaps from @p starting_point by @p max_extension at
+    /// most. \return *this
+    InternedIntervalDictExp &
+    fill_to_start (BaseType starting_point
+                   = IntervalTraits<Interval>::maximum (),
+                   BaseDifferenceType max_extension
+                   = IntervalTraits<Interval>::max_size ());
+
+    /// Forward fill final gaps from @p starting_point by @p max_extension at
+    /// most. \return *this
+    InternedIntervalDictExp &
+    fill_to_end (BaseType starting_point = IntervalTraits<Interval>::minimum (),
+                 BaseDifferenceType max_extension
+                 = IntervalTraits<Interval>::max_size ());
+
+    /// Fill gaps by extending values from either side of each gap by
+    /// @p max_extension at most. \return *this
+    InternedIntervalDictExp &
+    extend_into_gaps (GapExtensionDirection gap_extension_direction
+                      = GapExtensionDirection::Both,
+                      BaseDifferenceType max_extension
+                      = IntervalTraits<Interval>::max_size ());
+
+    /// Fill gaps with values common to both sides of each gap by
+    /// @p max_extension at most from each side. \return *this
+    InternedIntervalDictExp &
+    fill_gaps (BaseDifferenceType max_extension
+               = IntervalTraits<Interval>::max_size ());
+
+    /// @}
+
+    /// Return all keys in sorted order
+    [[nodiscard]] std::vector<Key> keys () const;
+
+    /// Returns the number of unique keys
+    [[nodiscard]] std::size_t size () const;
+
+    /// Return whether there are no keys
+    [[nodiscard]] bool empty () const;
+
+    /// Return whether the specified key is in the dictionary
+    [[nodiscard]] std::size_t count (const Key &key) const;
+
+    /// Return whether the specified key is in the dictionary
+    [[nodiscard]] bool contains (const Key &key) const;
+
+    /// Returns all [key-value-interval]s overlapping @p query_interval,
+    /// sorted by key, then interval, then value
+    [[nodiscard]] KeyValueIntervals
+    intervals (Interval query_interval = interval_extent<Interval>) const;
+
+    /// Returns all mapped values for each disjoint interval overlapping
+    /// @p query_interval, sorted by key, then interval. Values are sorted
+    [[nodiscard]] KeyValuesDisjointIntervals disjoint_intervals (
+      Interval query_interval = interval_extent<Interval>) const;
+
+    /// Returns a dictionary sharing the same symbol tables that contains only
+    /// the specified \p keys for the specified \p interval
+    /// \param keys Any sequence of Key (suitable for range-based for loop)
+    template<typename KeyRange>
+    [[nodiscard]] InternedIntervalDictExp
+    subset (const KeyRange &keys,
+            Interval interval = interval_extent<Interval>) const;
+
+    /// Returns a dictionary sharing the same symbol tables that contains only
+    /// the specified \p keys and \p values for the specified \p interval
+    /// \param keys Any sequence of Key (suitable for range-based for loop)
+    /// \param values Any sequence of Value (suitable for range-based for loop)
+    template<typename KeyRange, typename ValRange>
+    [[nodiscard]] InternedIntervalDictExp
+    subset (const KeyRange &keys,
+            const ValRange &values,
+            Interval interval = interval_extent<Interval>) const;
+
+    /// Returns a dictionary from values to keys sharing the same symbol
+    /// tables
+    [[nodiscard]] InternedIntervalDictExp<Value, Key, Interval, InverseImplType>
+    invert () const;
+
+    /// Joins to a second dictionary with matching values so that if
+    /// *this and the parameter have key-value types of
+    /// A -> B and B -> C respectively, returns a dictionary A -> C that
+    /// spans A -> B -> C over common intervals
+    ///
+    /// Ids are joined directly if the keys of @p b_to_c are interned in the
+    /// value symbol table of *this
+    template<typename OtherVal, typename OtherImpl>
+    [[nodiscard]] InternedIntervalDictExp<Key,
+                                          OtherVal,
+                                          Interval,
+                                          OtherImplType<OtherVal>>
+    joined_to (
+      const InternedIntervalDictExp<Value, OtherVal, Interval, OtherImpl>
+        &b_to_c) const;
+
+    /// Returns the asymmetrical differences with another interval dictionary
+    InternedIntervalDictExp &operator-= (const InternedIntervalDictExp &other);
+
+    /// Returns the union with another interval dictionary
+    InternedIntervalDictExp &operator+= (const InternedIntervalDictExp &other);
+
+    /// Equality operator
+    bool operator== (const InternedIntervalDictExp &rhs) const;
+
+    /// Inequality operator
+    bool operator!= (const InternedIntervalDictExp &rhs) const;
+
+    /// @name Interned Storage
+    /// @{
+
+    /// The dictionary of ids
+    [[nodiscard]] const IdDict &ids () const;
+
+    /// Symbol table for keys
+    [[nodiscard]] const std::shared_ptr<KeySymbols> &key_symbols () const;
+
+    /// Symbol table for values
+    [[nodiscard]] const std::shared_ptr<ValueSymbols> &value_symbols () const;
+
+    /// Returns bytes used over all keys with a histogram of bytes per key.
+    /// Excludes the shared symbol tables: see SymbolTable::memory_usage()
+    /// \param count_heaviest_keys Number of keys using the most memory to
+    /// report
+    [[nodiscard]] MemoryReport<Key>
+    memory_usage (std::size_t count_heaviest_keys = 10) const;
+
+    /// @}
+
+    private:
+    template<typename, typename, typename, typename>
+    friend class InternedIntervalDictExp;
+
+    /// @cond Suppress_Doxygen_Warning
+    friend InternedIntervalDictExp flattened<> (
+      InternedIntervalDictExp interval_dict,
+      FlattenPolicy<typename details::identity<Key>::type,
+                    typename details::identity<Value>::type,
+                    typename details::identity<Interval>::type> keep_one_value);
+    /// @endcond
+
+    /// Construct from ids already interned in the specified tables
+    InternedIntervalDictExp (IdDict ids,
+                             std::shared_ptr<KeySymbols> key_symbols,
+                             std::shared_ptr<ValueSymbols> value_symbols);
+
+    /// @return values for @p value_ids in sorted order
+    template<typename ValueIds>
+    [[nodiscard]] std::vector<Value>
+    sorted_values (const ValueIds &value_ids) const;
+
+    /// @return ids of those of @p symbols in @p symbol_table. Symbols never
+    /// interned cannot be in the dictionary
+    template<typename T, typename Range>
+    [[nodiscard]] static std::vector<SymbolId>
+    found_ids (const SymbolTable<T> &symbol_table, const Range &symbols);
+
+    /// @return ids of @p other re-interned in the symbol tables of *this
+    /// \param add_missing intern symbols not already in these tables.
+    /// Otherwise skip associations with them
+    [[nodiscard]] IdDict reinterned (const InternedIntervalDictExp &other,
+                                     bool add_missing) const;
+
+    IdDict m_ids;
+    std::shared_ptr<KeySymbols> m_key_symbols;
+    std::shared_ptr<ValueSymbols> m_value_symbols;
+  };
+
+  /*
+   * _____________________________________________________________________________
+   *
+   * Implementation
+   *
+   */
+
+  /*
+   * Constructors
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::
+    InternedIntervalDictExp ()
+    : m_key_symbols (std::make_shared<KeySymbols> ())
+    , m_value_symbols (std::make_shared<ValueSymbols> ())
+  {
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::
+    InternedIntervalDictExp (
+    std::shared_ptr<KeySymbols> key_symbols,
+    std::shared_ptr<ValueSymbols> value_symbols)
+    : m_key_symbols (std::move (key_symbols))
+    , m_value_symbols (std::move (value_symbols))
+  {
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::
+    InternedIntervalDictExp (
+    const KeyValueIntervals &key_value_intervals)
+    : InternedIntervalDictExp ()
+  {
+    insert (key_value_intervals);
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::
+    InternedIntervalDictExp (
+    IdDict ids,
+    std::shared_ptr<KeySymbols> key_symbols,
+    std::shared_ptr<ValueSymbols> value_symbols)
+    : m_ids (std::move (ids))
+    , m_key_symbols (std::move (key_symbols))
+    , m_value_symbols (std::move (value_symbols))
+  {
+  }
+
+  /*
+   * Private helpers
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  template<typename ValueIds>
+  std::vector<Value>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::sorted_values (
+    const ValueIds &value_ids) const
+  {
+    std::vector<Value> values;
+    values.reserve (value_ids.size ());
+    for (const auto value_id : value_ids)
+    {
+      values.push_back (m_value_symbols->symbol (value_id));
+    }
+    // Ids are unique, and so are their symbols
+    std::ranges::sort (values);
+    return values;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  template<typename T, typename Range>
+  std::vector<SymbolId>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::found_ids (
+    const SymbolTable<T> &symbol_table, const Range &symbols)
+  {
+    std::vector<SymbolId> ids;
+    for (const auto &symbol : symbols)
+    {
+      if (const auto id = symbol_table.find (symbol))
+      {
+        ids.push_back (*id);
+      }
+    }
+    return ids;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  typename InternedIntervalDictExp<Key, Value, Interval, Impl>::IdDict
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::reinterned (
+    const InternedIntervalDictExp &other, bool add_missing) const
+  {
+    if (m_key_symbols == other.m_key_symbols
+        && m_value_symbols == other.m_value_symbols)
+    {
+      return other.m_ids;
+    }
+    std::vector<std::tuple<SymbolId, SymbolId, Interval>> id_intervals;
+    for (const auto &[key_id, value_id, interval] :
+         interval_dict::intervals (other.m_ids))
+    {
+      const auto new_key_id = details::translate_id (
+        key_id, *other.m_key_symbols, *m_key_symbols, add_missing);
+      const auto new_value_id = details::translate_id (
+        value_id, *other.m_value_symbols, *m_value_symbols, add_missing);
+      if (new_key_id && new_value_id)
+      {
+        id_intervals.emplace_back (*new_key_id, *new_value_id, interval);
+      }
+    }
+    return IdDict (id_intervals);
+  }
+
+  /*
+   * Insert and erase
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::insert (
+    const std::vector<std::pair<Key, Value>> &key_value_pairs,
+    Interval interval)
+  {
+    std::vector<std::pair<SymbolId, SymbolId>> id_pairs;
+    id_pairs.reserve (key_value_pairs.size ());
+    for (const auto &[key, value] : key_value_pairs)
+    {
+      id_pairs.emplace_back (m_key_symbols->intern (key),
+                             m_value_symbols->intern (value));
+    }
+    m_ids.insert (id_pairs, interval);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::insert (
+    const KeyValueIntervals &key_value_intervals)
+  {
+    std::vector<std::tuple<SymbolId, SymbolId, Interval>> id_intervals;
+    id_intervals.reserve (key_value_intervals.size ());
+    for (const auto &[key, value, interval] : key_value_intervals)
+    {
+      id_intervals.emplace_back (m_key_symbols->intern (key),
+                                 m_value_symbols->intern (value),
+                                 interval);
+    }
+    m_ids.insert (id_intervals);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::erase (
+    const KeyValueIntervals &key_value_intervals)
+  {
+    // Symbols never interned cannot be in the dictionary
+    std::vector<std::tuple<SymbolId, SymbolId, Interval>> id_intervals;
+    for (const auto &[key, value, interval] : key_value_intervals)
+    {
+      const auto key_id = m_key_symbols->find (key);
+      const auto value_id = m_value_symbols->find (value);
+      if (key_id && value_id)
+      {
+        id_intervals.emplace_back (*key_id, *value_id, interval);
+      }
+    }
+    m_ids.erase (id_intervals);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::erase (
+    const std::vector<std::pair<Key, Value>> &key_value_pairs,
+    Interval interval)
+  {
+    std::vector<std::pair<SymbolId, SymbolId>> id_pairs;
+    for (const auto &[key, value] : key_value_pairs)
+    {
+      const auto key_id = m_key_symbols->find (key);
+      const auto value_id = m_value_symbols->find (value);
+      if (key_id && value_id)
+      {
+        id_pairs.emplace_back (*key_id, *value_id);
+      }
+    }
+    m_ids.erase (id_pairs, interval);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::erase (
+    const Key &key, Interval interval)
+  {
+    if (const auto key_id = m_key_symbols->find (key))
+    {
+      m_ids.erase (*key_id, interval);
+    }
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::erase (
+    Interval interval)
+  {
+    m_ids.erase (interval);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  void InternedIntervalDictExp<Key, Value, Interval, Impl>::clear ()
+  {
+    m_ids.clear ();
+  }
+
+  /*
+   * Gap filling
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::fill_gaps_with (
+    const InternedIntervalDictExp &other)
+  {
+    m_ids.fill_gaps_with (reinterned (other, true));
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::fill_to_start (
+    BaseType starting_point, BaseDifferenceType max_extension)
+  {
+    m_ids.fill_to_start (starting_point, max_extension);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::fill_to_end (
+    BaseType starting_point, BaseDifferenceType max_extension)
+  {
+    m_ids.fill_to_end (starting_point, max_extension);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::extend_into_gaps (
+    GapExtensionDirection gap_extension_direction,
+    BaseDifferenceType max_extension)
+  {
+    m_ids.extend_into_gaps (gap_extension_direction, max_extension);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::fill_gaps (
+    BaseDifferenceType max_extension)
+  {
+    m_ids.fill_gaps (max_extension);
+    return *this;
+  }
+
+  /*
+   * Find
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  std::vector<Value> InternedIntervalDictExp<Key, Value, Interval, Impl>::find (
+    const Key &key, BaseType query) const
+  {
+    const auto key_id = m_key_symbols->find (key);
+    if (!key_id)
+    {
+      return {};
+    }
+    return sorted_values (m_ids.find (*key_id, query));
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  std::vector<Value> InternedIntervalDictExp<Key, Value, Interval, Impl>::find (
+    const Key &key, Interval interval) const
+  {
+    const auto key_id = m_key_symbols->find (key);
+    if (!key_id)
+    {
+      return {};
+    }
+    return sorted_values (m_ids.find (*key_id, interval));
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  std::vector<Value> InternedIntervalDictExp<Key, Value, Interval, Impl>::find (
+    const std::vector<Key> &keys, Interval interval) const
+  {
+    std::vector<SymbolId> key_ids;
+    for (const auto &key : keys)
+    {
+      if (const auto key_id = m_key_symbols->find (key))
+      {
+        key_ids.push_back (*key_id);
+      }
+    }
+    return sorted_values (m_ids.find (key_ids, interval));
+  }
+
+  /*
+   * Keys
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  std::vector<Key>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::keys () const
+  {
+    std::vector<Key> keys;
+    for (const auto key_id : m_ids.keys ())
+    {
+      keys.push_back (m_key_symbols->symbol (key_id));
+    }
+    std::ranges::sort (keys);
+    return keys;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  std::size_t InternedIntervalDictExp<Key, Value, Interval, Impl>::size () const
+  {
+    return m_ids.size ();
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  bool InternedIntervalDictExp<Key, Value, Interval, Impl>::empty () const
+  {
+    return m_ids.empty ();
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  std::size_t InternedIntervalDictExp<Key, Value, Interval, Impl>::count (
+    const Key &key) const
+  {
+    const auto key_id = m_key_symbols->find (key);
+    return key_id ? m_ids.count (*key_id) : 0;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  bool InternedIntervalDictExp<Key, Value, Interval, Impl>::contains (
+    const Key &key) const
+  {
+    return count (key) != 0;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  typename InternedIntervalDictExp<Key, Value, Interval, Impl>::
+    KeyValueIntervals
+    InternedIntervalDictExp<Key, Value, Interval, Impl>::intervals (
+      Interval query_interval) const
+  {
+    KeyValueIntervals results;
+    for (const auto &[key_id, value_id, interval] :
+         interval_dict::intervals (m_ids, query_interval))
+    {
+      results.emplace_back (m_key_symbols->symbol (key_id),
+                            m_value_symbols->symbol (value_id),
+                            interval);
+    }
+    std::ranges::sort (results,
+                       [] (const auto &lhs, const auto &rhs)
+                       {
+                         const auto &[key_l, value_l, interval_l] = lhs;
+                         const auto &[key_r, value_r, interval_r] = rhs;
+                         if (key_l < key_r)
+                         {
+                           return true;
+                         }
+                         if (key_r < key_l)
+                         {
+                           return false;
+                         }
+                         if (boost::icl::lower_less (interval_l, interval_r))
+                         {
+                           return true;
+                         }
+                         if (boost::icl::lower_less (interval_r, interval_l))
+                         {
+                           return false;
+                         }
+                         if (boost::icl::upper_less (interval_l, interval_r))
+                         {
+                           return true;
+                         }
+                         if (boost::icl::upper_less (interval_r, interval_l))
+                         {
+                           return false;
+                         }
+                         return value_l < value_r;
+                       });
+    return results;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  typename InternedIntervalDictExp<Key, Value, Interval, Impl>::
+    KeyValuesDisjointIntervals
+    InternedIntervalDictExp<Key, Value, Interval, Impl>::disjoint_intervals (
+      Interval query_interval) const
+  {
+    KeyValuesDisjointIntervals results;
+    for (const auto &[key_id, value_ids, interval] :
+         interval_dict::disjoint_intervals (m_ids, query_interval))
+    {
+      const auto values = sorted_values (value_ids);
+      results.emplace_back (m_key_symbols->symbol (key_id),
+                            SegmentValues<Value> (values.begin (),
+                                                  values.end ()),
+                            interval);
+    }
+    // Intervals are already in order for each key
+    std::ranges::stable_sort (results,
+                              [] (const auto &lhs, const auto &rhs)
+                              {
+                                return std::get<0> (lhs) < std::get<0> (rhs);
+                              });
+    return results;
+  }
+
+  /*
+   * Subsets
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  template<typename KeyRange>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::subset (
+    const KeyRange &keys, Interval interval) const
+  {
+    return InternedIntervalDictExp (
+      m_ids.subset (found_ids (*m_key_symbols, keys), interval),
+      m_key_symbols,
+      m_value_symbols);
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  template<typename KeyRange, typename ValRange>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::subset (
+    const KeyRange &keys, const ValRange &values, Interval interval) const
+  {
+    return InternedIntervalDictExp (
+      m_ids.subset (found_ids (*m_key_symbols, keys),
+                    found_ids (*m_value_symbols, values),
+                    interval),
+      m_key_symbols,
+      m_value_symbols);
+  }
+
+  /*
+   * Invert and join
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<
+    Value,
+    Key,
+    Interval,
+    typename InternedIntervalDictExp<Key, Value, Interval, Impl>::
+      InverseImplType>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::invert () const
+  {
+    return InternedIntervalDictExp<Value, Key, Interval, InverseImplType> (
+      m_ids.invert (), m_value_symbols, m_key_symbols);
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  template<typename OtherVal, typename OtherImpl>
+  InternedIntervalDictExp<
+    Key,
+    OtherVal,
+    Interval,
+    typename InternedIntervalDictExp<Key, Value, Interval, Impl>::
+      template OtherImplType<OtherVal>>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::joined_to (
+    const InternedIntervalDictExp<Value, OtherVal, Interval, OtherImpl>
+      &b_to_c) const
+  {
+    using Results = InternedIntervalDictExp<Key,
+                                            OtherVal,
+                                            Interval,
+                                            OtherImplType<OtherVal>>;
+    if (m_value_symbols == b_to_c.m_key_symbols)
+    {
+      return Results (m_ids.joined_to (b_to_c.m_ids),
+                      m_key_symbols,
+                      b_to_c.m_value_symbols);
+    }
+
+    // Translate the keys of b_to_c into our values. Keys we have never seen
+    // cannot join
+    std::vector<std::tuple<SymbolId, SymbolId, Interval>> id_intervals;
+    for (const auto &[key_id, value_id, interval] :
+         interval_dict::intervals (b_to_c.m_ids))
+    {
+      if (const auto new_key_id = details::translate_id (
+            key_id, *b_to_c.m_key_symbols, *m_value_symbols, false))
+      {
+        id_intervals.emplace_back (*new_key_id, value_id, interval);
+      }
+    }
+    using OtherIdDict =
+      typename InternedIntervalDictExp<Value, OtherVal, Interval, OtherImpl>::
+        IdDict;
+    return Results (m_ids.joined_to (OtherIdDict (id_intervals)),
+                    m_key_symbols,
+                    b_to_c.m_value_symbols);
+  }
+
+  /*
+   * Operators
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::operator-= (
+    const InternedIntervalDictExp &other)
+  {
+    m_ids -= reinterned (other, false);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::operator+= (
+    const InternedIntervalDictExp &other)
+  {
+    m_ids += reinterned (other, true);
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  bool InternedIntervalDictExp<Key, Value, Interval, Impl>::operator== (
+    const InternedIntervalDictExp &rhs) const
+  {
+    return intervals () == rhs.intervals ();
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  bool InternedIntervalDictExp<Key, Value, Interval, Impl>::operator!= (
+    const InternedIntervalDictExp &rhs) const
+  {
+    return !(*this == rhs);
+  }
+
+  /*
+   * Interned storage
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  const typename InternedIntervalDictExp<Key, Value, Interval, Impl>::IdDict &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::ids () const
+  {
+    return m_ids;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  const std::shared_ptr<
+    typename InternedIntervalDictExp<Key, Value, Interval, Impl>::KeySymbols> &
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::key_symbols () const
+  {
+    return m_key_symbols;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  const std::shared_ptr<
+    typename InternedIntervalDictExp<Key, Value, Interval, Impl>::ValueSymbols>
+    &InternedIntervalDictExp<Key, Value, Interval, Impl>::value_symbols () const
+  {
+    return m_value_symbols;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  MemoryReport<Key>
+  InternedIntervalDictExp<Key, Value, Interval, Impl>::memory_usage (
+    std::size_t count_heaviest_keys) const
+  {
+    const auto id_report = m_ids.memory_usage (count_heaviest_keys);
+    MemoryReport<Key> report;
+    report.usage = id_report.usage;
+    report.bytes_keys = id_report.bytes_keys;
+    report.log2_bytes_per_key = id_report.log2_bytes_per_key;
+    for (const auto &[key_id, bytes] : id_report.heaviest_keys)
+    {
+      report.heaviest_keys.emplace_back (m_key_symbols->symbol (key_id),
+                                         bytes);
+    }
+    return report;
+  }
+
+  /*
+   * Flatten
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  InternedIntervalDictExp<Key, Value, Interval, Impl> flattened (
+    InternedIntervalDictExp<Key, Value, Interval, Impl> interval_dict,
+    FlattenPolicy<typename details::identity<Key>::type,
+                  typename details::identity<Value>::type,
+                  typename details::identity<Interval>::type> keep_one_value)
+  {
+    auto &key_symbols = *interval_dict.m_key_symbols;
+    auto &value_symbols = *interval_dict.m_value_symbols;
+    // Call keep_one_value with symbols rather than ids
+    const auto keep_one_id
+      = [&] (const std::optional<SymbolId> &status_quo_id,
+             Interval interval,
+             const SymbolId &key_id,
+             const std::vector<SymbolId> &value_ids) -> std::optional<SymbolId>
+    {
+      std::optional<Value> status_quo;
+      if (status_quo_id)
+      {
+        status_quo = value_symbols.symbol (*status_quo_id);
+      }
+      const auto value
+        = keep_one_value (status_quo,
+                          interval,
+                          key_symbols.symbol (key_id),
+                          interval_dict.sorted_values (value_ids));
+      if (!value)
+      {
+        return std::nullopt;
+      }
+      return value_symbols.intern (*value);
+    };
+    interval_dict.m_ids
+      = flattened (std::move (interval_dict.m_ids),
+                   FlattenPolicy<SymbolId, SymbolId, Interval> (keep_one_id));
+    return interval_dict;
+  }
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_INTERNED_INTERVALDICT_H
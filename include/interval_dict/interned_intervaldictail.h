@@ -0,0 +1,48 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file interned_intervaldictail.h
+/// \brief Declaration of the InternedIntervalDictAILExp class
+//
+// Provides interval associative dictionaries of interned keys and values
+// implemented using Augmented Interval Lists
+//
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_INTERNED_INTERVALDICTAIL_H
+#define INCLUDE_INTERVAL_DICT_INTERNED_INTERVALDICTAIL_H
+
+#include "adaptor_ail.h"
+
+#include "interned_intervaldict.h"
+
+namespace interval_dict
+{
+  /**
+   * @brief IntervalDictAILExp storing keys and values as interned SymbolIds
+   *
+   * Suited to std::string keys and values: each is stored once in a shared
+   * SymbolTable, and the Augmented Interval Lists only hold integers.
+   *
+   * @tparam Key Type of keys
+   * @tparam Value Type of Values
+   * @tparam Interval Interval Type. E.g. boost::icl::right_open_interval<Date>
+   */
+  template<typename Key, typename Value, typename Interval>
+  using InternedIntervalDictAILExp = InternedIntervalDictExp<
+    Key,
+    Value,
+    Interval,
+    implementation::AugmentedIntervalList<Value, Interval>>;
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_INTERNED_INTERVALDICTAIL_H
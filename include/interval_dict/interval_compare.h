@@ -49,22 +49,13 @@
 #include <boost/icl/type_traits/is_continuous_interval.hpp>
 #include <boost/icl/type_traits/is_discrete_interval.hpp>
 
+#include <functional>
 #include <type_traits>
 
 namespace interval_dict::comparisons
 {
   namespace icl = boost::icl;
 
-  template<typename Interval>
-  concept AsymmetricOrContinuous
-    = boost::icl::is_asymmetric_interval<Interval>::value != 0
-      || boost::icl::is_continuous_interval<Interval>::value;
-
-  template<typename Interval>
-  concept SymmetricOrDiscrete
-    = boost::icl::has_symmetric_bounds<Interval>::value
-      || boost::icl::is_discrete_interval<Interval>::value;
-
   template<typename Interval>
   concept Asymmetric = boost::icl::is_asymmetric_interval<Interval>::value;
 
@@ -77,6 +68,34 @@ namespace interval_dict::comparisons
   template<typename Interval>
   concept Continuous = boost::icl::is_continuous_interval<Interval>::value;
 
+  // Written in terms of the concepts above so that StaticRightOpen
+  // overloads are more specialised than AsymmetricOrContinuous ones
+  template<typename Interval>
+  concept AsymmetricOrContinuous
+    = Asymmetric<Interval> || Continuous<Interval>;
+
+  template<typename Interval>
+  concept SymmetricOrDiscrete = Symmetric<Interval> || Discrete<Interval>;
+
+  // [lower, upper) with bounds fixed at compile time and ordered by
+  // operator<, e.g. boost::icl::right_open_interval<int>. Edges are compared
+  // directly without going through boost::icl.
+  // Define INTERVAL_DICT_GENERIC_COMPARISONS to compare using the generic
+  // code instead, for example to benchmark the difference.
+#ifdef INTERVAL_DICT_GENERIC_COMPARISONS
+  template<typename Interval>
+  concept StaticRightOpen = Asymmetric<Interval> && false;
+#else
+  template<typename Interval>
+  concept StaticRightOpen
+    = Asymmetric<Interval>
+      && (icl::interval_bound_type<Interval>::value
+          == icl::interval_bounds::static_right_open)
+      && std::is_same_v<
+        typename icl::interval_traits<Interval>::domain_compare,
+        std::less<typename icl::interval_traits<Interval>::domain_type>>;
+#endif
+
   //------------------------------------------------------------------------------
   // exclusive_less()
   // Like boost::icl::exclusive_less but does not check for interval emptiness
@@ -94,6 +113,13 @@ namespace interval_dict::comparisons
     return icl::last (left) < icl::first (right);
   }
 
+  template<StaticRightOpen IntervalType>
+  constexpr bool exclusive_less (const IntervalType &left,
+                                 const IntervalType &right)
+  {
+    return !(right.lower () < left.upper ());
+  }
+
   //------------------------------------------------------------------------------
   // exclusive_less() combined with touches
   template<Asymmetric IntervalType>
@@ -123,6 +149,13 @@ namespace interval_dict::comparisons
                 && icl::upper (left) == icl::lower (right)));
   }
 
+  template<StaticRightOpen IntervalType>
+  constexpr bool more_or_touches (const IntervalType &left,
+                                  const IntervalType &right)
+  {
+    return !(left.upper () < right.lower ());
+  }
+
   //
   // exclusive_less()
   // Comparison operators between a single point and an interval on the right
@@ -140,6 +173,14 @@ namespace interval_dict::comparisons
     return icl::domain_less<IntervalType> (left_upper, first (right));
   }
 
+  // Parameters match the AsymmetricOrContinuous overload so that the more
+  // constrained overload is chosen
+  template<typename BaseType, StaticRightOpen IntervalType>
+  constexpr bool exclusive_less (BaseType left_upper, IntervalType right)
+  {
+    return !(right.lower () < left_upper);
+  }
+
   //
   // exclusive_less()
   // Comparison operators between a single point and an interval on the right
@@ -161,6 +202,14 @@ namespace interval_dict::comparisons
     return icl::domain_less<IntervalType> (left_upper, first_right);
   }
 
+  template<StaticRightOpen IntervalType>
+  constexpr bool exclusive_less (
+    const typename icl::interval_traits<IntervalType>::domain_type &left_upper,
+    const typename icl::interval_traits<IntervalType>::domain_type &lower_right)
+  {
+    return !(lower_right < left_upper);
+  }
+
   /// intersects()
   /// Like icl::intersects but without empty() tests
   template<typename T>
@@ -170,6 +219,12 @@ namespace interval_dict::comparisons
              || comparisons::exclusive_less (b, a));
   }
 
+  template<StaticRightOpen T>
+  constexpr bool intersects (const T &a, const T &b)
+  {
+    return a.lower () < b.upper () && b.lower () < a.upper ();
+  }
+
   //
   // upper_edge()
   // Get the edges of an interval, consistent across dynamic and static
@@ -190,6 +245,13 @@ namespace interval_dict::comparisons
     return icl::last (interval);
   }
 
+  template<StaticRightOpen IntervalType>
+  constexpr IntervalTraits<IntervalType>::BaseType
+  upper_edge (const IntervalType &interval)
+  {
+    return interval.upper ();
+  }
+
   /**
    * lower_edge()
    *
@@ -212,6 +274,13 @@ namespace interval_dict::comparisons
     return icl::first (interval);
   }
 
+  template<StaticRightOpen IntervalType>
+  constexpr IntervalTraits<IntervalType>::BaseType
+  lower_edge (const IntervalType &interval)
+  {
+    return interval.lower ();
+  }
+
   /**
    * \brief Compare by value then by interval
    */
@@ -127,8 +127,9 @@ namespace interval_dict
     /// may be off by one, depending on how open/closed intervals are mixed
     /// together. There is no way to mix the two edges of continuous intervals
     /// so this is an acceptable compromise
-    template<typename Value>
-    void update (const ValueIntervals<Value, Interval> &intervals);
+    template<typename Value, typename Allocator>
+    void update (
+      const std::vector<ValueInterval<Value, Interval>, Allocator> &intervals);
     std::vector<int_fast32_t> m_counts;
 
     // private:
@@ -162,9 +163,9 @@ namespace interval_dict
   };
 
   template<typename Interval>
-  template<typename Value>
+  template<typename Value, typename Allocator>
   void CountOverlap<Interval>::update (
-    const ValueIntervals<Value, Interval> &intervals)
+    const std::vector<ValueInterval<Value, Interval>, Allocator> &intervals)
   {
     m_counts.resize (intervals.size ());
     m_overlap_counters.clear ();
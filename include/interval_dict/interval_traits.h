@@ -22,9 +22,36 @@
 
 #ifndef INCLUDE_INTERVAL_DICT_INTERVAL_TRAITS_H
 #define INCLUDE_INTERVAL_DICT_INTERVAL_TRAITS_H
+// With -O2 -D_FORTIFY_SOURCE=2, GCC warns that moving a small_vector whose
+// values are stored inline may read past the inline buffer
+// (-Wstringop-overread). This is a false positive: memmove only copies
+// size() elements, which fit inline, but GCC does not know that. The warning
+// is issued wherever SegmentValues are moved, and GCC honours this pragma
+// when small_vector's move constructor is in the inlining stack.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wstringop-overread"
+#endif
+#include <boost/container/small_vector.hpp>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
 #include <boost/icl/interval_traits.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <optional>
+#include <ranges>
+#include <tuple>
 #include <type_traits>
+#include <vector>
+
+/// Number of values held inline by each disjoint segment before its values
+/// spill onto the heap
+#ifndef INTERVAL_DICT_SEGMENT_VALUES_CAPACITY
+#define INTERVAL_DICT_SEGMENT_VALUES_CAPACITY 2
+#endif
 namespace interval_dict
 {
   template<typename Interval>
@@ -86,16 +113,147 @@ namespace interval_dict
     }
   };
 
+  /// \brief Maps interval edges to a type that is cheaper to store and
+  /// compare
+  ///
+  /// Must preserve order: `encode (a) < encode (b)` whenever `a < b`.
+  /// Specialised in gregorian.h and ptime.h to map dates and times, whose
+  /// comparisons check for special values, to plain integers. Other types
+  /// are used as they are.
+  template<typename BaseType> struct EdgeEncoding
+  {
+    using EncodedType = BaseType;
+
+    static constexpr const EncodedType &encode (const BaseType &edge) noexcept
+    {
+      return edge;
+    }
+
+    static constexpr const BaseType &decode (const EncodedType &edge) noexcept
+    {
+      return edge;
+    }
+  };
+
+  /// Calendar period of each partition of dates and times. See
+  /// PartitionWidth
+  enum class PartitionPeriod
+  {
+    Month,
+    Year
+  };
+
+  /// Width of each partition of time. See TimePartitioning
+  struct PartitionWidth
+  {
+    /// Calendar period for dates and times
+    PartitionPeriod period = PartitionPeriod::Year;
+
+    /// Number of calendar periods in each partition of dates and times
+    std::int64_t count_periods = 1;
+
+    /// Width of each partition for arithmetic types
+    std::int64_t units = 4096;
+
+    auto operator<=> (const PartitionWidth &) const = default;
+  };
+
+  /// \brief Maps points to numbered partitions of time
+  ///
+  /// Partitions are numbered in order, with every point in partition `p` less
+  /// than every point in partition `p + 1`. Partitions of arithmetic types
+  /// are PartitionWidth::units wide. Specialised in gregorian.h and ptime.h
+  /// to use calendar months or years.
+  template<typename BaseType> struct TimePartitioning;
+
+  template<typename BaseType>
+    requires std::is_arithmetic_v<BaseType>
+  struct TimePartitioning<BaseType>
+  {
+    /// @return the partition containing @p point
+    static std::int64_t partition (BaseType point, const PartitionWidth &width)
+    {
+      using Limits = std::numeric_limits<std::int64_t>;
+      if constexpr (std::is_integral_v<BaseType>)
+      {
+        if constexpr (std::is_unsigned_v<BaseType>
+                      && sizeof (BaseType) >= sizeof (std::int64_t))
+        {
+          if (point > static_cast<BaseType> (Limits::max ()))
+          {
+            return Limits::max ();
+          }
+        }
+        // Round towards -infinity
+        const auto point_64 = static_cast<std::int64_t> (point);
+        const auto partition = point_64 / width.units;
+        return point_64 % width.units < 0 ? partition - 1 : partition;
+      }
+      else
+      {
+        const auto partition
+          = std::floor (point / static_cast<BaseType> (width.units));
+        if (!(partition < static_cast<BaseType> (Limits::max ())))
+        {
+          return Limits::max ();
+        }
+        if (!(partition > static_cast<BaseType> (Limits::min ())))
+        {
+          return Limits::min ();
+        }
+        return static_cast<std::int64_t> (partition);
+      }
+    }
+
+    /// @return the first point after @p partition, or nothing if it is the
+    /// last
+    static std::optional<BaseType> partition_end (std::int64_t partition,
+                                                  const PartitionWidth &width)
+    {
+      // Avoid overflowing BaseType
+      if (partition
+          >= TimePartitioning::partition (std::numeric_limits<BaseType>::max (),
+                                          width))
+      {
+        return std::nullopt;
+      }
+      return static_cast<BaseType> (partition + 1)
+             * static_cast<BaseType> (width.units);
+    }
+  };
+
   /// \brief The largest possible interval for a given underlying type
   template<typename IntervalType>
   IntervalType interval_extent
     = IntervalType {IntervalTraits<IntervalType>::minimum (),
                     IntervalTraits<IntervalType>::maximum ()};
 
+  /// \brief Values over a single disjoint interval
+  ///
+  /// Almost all disjoint intervals have one or two values, which are stored
+  /// inline so that enumerating them does not allocate per interval.
+  template<typename Value>
+  using SegmentValues
+    = boost::container::small_vector<Value,
+                                     INTERVAL_DICT_SEGMENT_VALUES_CAPACITY>;
+
+  /// @cond Suppress_Doxygen_Warning
+  namespace details
+  {
+    /// @return the (sorted) values of @p range as SegmentValues
+    template<std::ranges::input_range Range>
+    auto to_segment_values (const Range &range)
+    {
+      return SegmentValues<std::ranges::range_value_t<Range>> (
+        std::ranges::begin (range), std::ranges::end (range));
+    }
+  } // namespace details
+  /// @endcond
+
   /// \brief Gap between two intervals and their values
   template<typename Value, typename Interval>
   using SandwichedGap
-    = std::tuple<std::vector<Value>, Interval, std::vector<Value>>;
+    = std::tuple<SegmentValues<Value>, Interval, SegmentValues<Value>>;
 
   /// \brief All gaps between intervals and their values for any key
   template<typename Value, typename Interval>
@@ -103,12 +261,12 @@ namespace interval_dict
 
   /// \brief A disjoint interval and all values therein
   template<typename Value, typename Interval>
-  using ValuesDisjointInterval = std::tuple<std::vector<Value>, Interval>;
+  using ValuesDisjointInterval = std::tuple<SegmentValues<Value>, Interval>;
 
   /// \brief A disjoint interval pertaining to a key, and all values therein
   template<typename Key, typename Value, typename Interval>
   using KeyValuesDisjointInterval
-    = std::tuple<Key, std::vector<Value>, Interval>;
+    = std::tuple<Key, SegmentValues<Value>, Interval>;
 
   /// \brief Corresponding Key-value-interval
   template<typename Key, typename Value, typename Interval>
@@ -57,8 +57,11 @@
 #define INCLUDE_INTERVAL_DICT_INTERVAL_TREE_H
 
 #include "disjoint_adaptor.h"
+#include "instrumentation.h"
 #include "interval_compare.h"
 #include "interval_traits.h"
+#include "memory_usage.h"
+#include "query_explain.h"
 #include "std_ranges_23_patch.h"
 #include "value_interval.h"
 
@@ -176,7 +179,8 @@ namespace interval_dict::tree
     template<typename Value, typename Interval>
     IntervalNode<Value, Interval> *
     find_next_overlapping (IntervalNode<Value, Interval> *cur,
-                           const Interval &q);
+                           const Interval &q,
+                           QueryExplain *explain = nullptr);
 
     // Compare Interval then value
     class CompareIntervalValue
@@ -358,6 +362,23 @@ namespace interval_dict::tree
     /// equality operator
     bool operator== (const IntervalTree &other) const;
 
+    /// Records the work done by a query in @p explain
+    void explain (const Interval &query_interval, QueryExplain &explain) const;
+
+    /// @return bytes used by nodes, hash buckets and tree hooks
+    [[nodiscard]] MemoryUsage memory_usage () const;
+
+    /// Release unused hash buckets
+    void shrink_to_fit ();
+
+#ifdef INTERVAL_DICT_STATS
+    /// add internal statistics to @p stats
+    void collect_stats (instrumentation::Stats &stats) const;
+
+    /// zero internal statistics
+    void reset_stats ();
+#endif
+
     /// Find matching nodes within an interval
     class AllIntervals
     {
@@ -453,6 +474,11 @@ namespace interval_dict::tree
      */
     QueryResult query (const Interval &q) const;
 
+    /// @return the first node overlapping @p q or nullptr.
+    /// Records nodes visited in @p explain if not null
+    Node *first_overlapping (const Interval &q,
+                             QueryExplain *explain = nullptr) const;
+
     /// Returns the first disjoint interval (possibly containing multiple
     /// values)
     void get_max_right_edge_nodes (Node &node,
@@ -472,6 +498,11 @@ namespace interval_dict::tree
 
     /// boost::intrusive::set: lookup by value then interval
     std::unique_ptr<IntrusiveSetNodeValInterval> p_nodes_by_val_interval;
+
+#ifdef INTERVAL_DICT_STATS
+    /// red-black tree rotations by insert() and erase()
+    std::uint64_t count_rotations = 0;
+#endif
   };
 
   /// @cond Suppress_Doxygen_Warning
@@ -536,6 +567,9 @@ namespace interval_dict::tree
       ExtendedNodeTraits::Node &node, BaseTree &t)
     {
       (void)t;
+#ifdef INTERVAL_DICT_STATS
+      ++instrumentation::thread_tree_rotations;
+#endif
 
       // 'node' is the node that was the old parent.
       fix_node (node);
@@ -548,6 +582,9 @@ namespace interval_dict::tree
       ExtendedNodeTraits::Node &node, BaseTree &t)
     {
       (void)t;
+#ifdef INTERVAL_DICT_STATS
+      ++instrumentation::thread_tree_rotations;
+#endif
       // 'node' is the node that was the old parent.
       fix_node (node);
       fix_node (*(node.get_parent ()));
@@ -591,6 +628,46 @@ namespace interval_dict::tree
     return *p_nodes_by_val_interval == *other.p_nodes_by_val_interval;
   }
 
+#ifdef INTERVAL_DICT_STATS
+  template<typename Value, typename Interval>
+  void IntervalTree<Value, Interval>::collect_stats (
+    instrumentation::Stats &stats) const
+  {
+    stats.count_intervals += p_nodes_by_val_interval->size ();
+    stats.count_rotations += count_rotations;
+  }
+
+  template<typename Value, typename Interval>
+  void IntervalTree<Value, Interval>::reset_stats ()
+  {
+    count_rotations = 0;
+  }
+#endif
+
+  template<typename Value, typename Interval>
+  MemoryUsage IntervalTree<Value, Interval>::memory_usage () const
+  {
+    MemoryUsage usage;
+    const auto count_nodes = nodes_exact_match.size ();
+    // Remainder of each node is red-black / intrusive hooks and padding
+    constexpr auto payload = sizeof (Interval) + sizeof (Value) + sizeof (Key);
+    usage.bytes_intervals = count_nodes * payload;
+    usage.bytes_index = count_nodes * (sizeof (Node) - payload)
+                        + sizeof (YggRBTree)
+                        + sizeof (IntrusiveSetNodeValInterval);
+    usage.bytes_nodes = count_nodes * interval_dict::details::hash_node_links;
+    usage.bytes_hash_buckets
+      = nodes_exact_match.bucket_count () * sizeof (void *);
+    return usage;
+  }
+
+  template<typename Value, typename Interval>
+  void IntervalTree<Value, Interval>::shrink_to_fit ()
+  {
+    // Nodes do not move so the trees remain valid
+    nodes_exact_match.rehash (0);
+  }
+
   template<typename Value, typename Interval>
   IntervalTree<Value, Interval>::IntervalTree ()
     : p_nodes_by_interval (std::make_unique<YggRBTree> ())
@@ -709,8 +786,7 @@ namespace interval_dict::tree
                               interval,
                               values,
                               p_nodes_by_interval->get_root ()->max_right_edge);
-    using namespace legacy_ranges_conversion;
-    return {values | to_vector (), interval};
+    return {interval_dict::details::to_segment_values (values), interval};
   }
 
   template<typename Value, typename Interval>
@@ -770,6 +846,10 @@ namespace interval_dict::tree
   typename IntervalTree<Value, Interval>::YggRBTree::template iterator<false>
   IntervalTree<Value, Interval>::insert (Interval interval, const Value &value)
   {
+#ifdef INTERVAL_DICT_STATS
+    const instrumentation::ScopedDelta rotations (
+      instrumentation::thread_tree_rotations, count_rotations);
+#endif
     // ignore empty intervals
     if (boost::icl::is_empty (interval))
     {
@@ -818,6 +898,10 @@ namespace interval_dict::tree
   void IntervalTree<Value, Interval>::erase (const Interval &interval,
                                              const Value &value)
   {
+#ifdef INTERVAL_DICT_STATS
+    const instrumentation::ScopedDelta rotations (
+      instrumentation::thread_tree_rotations, count_rotations);
+#endif
     ValueIntervalRef query {value, interval};
 
     // Efficiently check unordered_set for exact match in c++20
@@ -870,6 +954,10 @@ namespace interval_dict::tree
   template<typename Value, typename Interval>
   void IntervalTree<Value, Interval>::erase (const Interval &interval)
   {
+#ifdef INTERVAL_DICT_STATS
+    const instrumentation::ScopedDelta rotations (
+      instrumentation::thread_tree_rotations, count_rotations);
+#endif
     auto overlapping_nodes = query (interval);
     auto pnode = overlapping_nodes.begin ();
     auto end = overlapping_nodes.end ();
@@ -936,32 +1024,54 @@ namespace interval_dict::tree
   template<typename Value, typename Interval>
   typename IntervalTree<Value, Interval>::QueryResult
   IntervalTree<Value, Interval>::query (const Interval &q) const
+  {
+    return QueryResult (first_overlapping (q), q);
+  }
+
+  template<typename Value, typename Interval>
+  typename IntervalTree<Value, Interval>::Node *
+  IntervalTree<Value, Interval>::first_overlapping (const Interval &q,
+                                                    QueryExplain *explain) const
   {
     IntervalNode<Value, Interval> *cur = p_nodes_by_interval->get_root ();
     if (p_nodes_by_interval->get_root () == nullptr)
     {
-      return QueryResult (nullptr, q);
+      return nullptr;
     }
 
+    std::size_t nodes_visited = 1;
     while (
       (cur->get_left () != nullptr)
       && !comparisons::exclusive_less (cur->get_left ()->max_right_edge, q))
     {
       cur = cur->get_left ();
+      ++nodes_visited;
+    }
+    if (explain)
+    {
+      explain->nodes_visited += nodes_visited;
     }
 
-    IntervalNode<Value, Interval> *hit;
     // If this overlaps, this is our first hit. otherwise, find the next one
     if (boost::icl::intersects (q, cur->interval))
     {
-      hit = cur;
+      return cur;
     }
-    else
+    return details::find_next_overlapping<Value, Interval> (cur, q, explain);
+  }
+
+  template<typename Value, typename Interval>
+  void IntervalTree<Value, Interval>::explain (const Interval &query_interval,
+                                               QueryExplain &explain) const
+  {
+    explain.backend = "interval tree";
+    for (auto *node = first_overlapping (query_interval, &explain);
+         node != nullptr;
+         node = details::find_next_overlapping<Value, Interval> (
+           node, query_interval, &explain))
     {
-      hit = details::find_next_overlapping<Value, Interval> (cur, q);
+      ++explain.count_matched;
     }
-
-    return QueryResult (hit, q);
   }
 
   namespace details
@@ -969,8 +1079,26 @@ namespace interval_dict::tree
     template<typename Value, typename Interval>
     IntervalNode<Value, Interval> *
     find_next_overlapping (IntervalNode<Value, Interval> *cur,
-                           const Interval &q)
+                           const Interval &q,
+                           QueryExplain *explain)
     {
+      // Count nodes visited and pruned if explain is not null
+      const auto visit = [explain] (auto *node)
+      {
+        if (explain)
+        {
+          ++explain->nodes_visited;
+        }
+        return node;
+      };
+      const auto prune = [explain] ()
+      {
+        if (explain)
+        {
+          ++explain->nodes_pruned;
+        }
+      };
+
       // We search for the next bigger node, pruning the search as necessary.
       // When Pruning occurs, we need to restart the search for the next
       // larger node.
@@ -982,12 +1110,13 @@ namespace interval_dict::tree
         if (cur->get_right () != nullptr)
         {
           // go to smallest larger-or-equal child
-          cur = cur->get_right ();
+          cur = visit (cur->get_right ());
           if (comparisons::exclusive_less (cur->max_right_edge, q))
           {
             // Prune!
             // Nothing starting from this node can overlap b/c of upper
             // limit. Backtrack.
+            prune ();
             while ((cur->get_parent () != nullptr)
                    && (cur->get_parent ()->get_right () == cur))
             { // these are the nodes which are smaller and were
@@ -1004,19 +1133,20 @@ namespace interval_dict::tree
             else
             {
               // go up
-              cur = cur->get_parent ();
+              cur = visit (cur->get_parent ());
             }
           }
           else
           {
             while (cur->get_left () != nullptr)
             {
-              cur = cur->get_left ();
+              cur = visit (cur->get_left ());
               if (comparisons::exclusive_less (cur->max_right_edge, q))
               {
                 // Prune!
                 // Nothing starting from this node can overlap.
                 // Backtrack.
+                prune ();
                 cur = cur->get_parent ();
                 break;
               }
@@ -1043,7 +1173,7 @@ namespace interval_dict::tree
           else
           {
             // go up
-            cur = cur->get_parent ();
+            cur = visit (cur->get_parent ());
           }
         }
 
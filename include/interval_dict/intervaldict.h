@@ -18,9 +18,13 @@
 #ifndef INCLUDE_INTERVAL_DICT_INTERVALDICT_H
 #define INCLUDE_INTERVAL_DICT_INTERVALDICT_H
 
+#include "change_feed.h"
+#include "instrumentation.h"
 #include "interval_compare.h"
 #include "interval_operators.h"
 #include "interval_traits.h"
+#include "memory_usage.h"
+#include "query_explain.h"
 #include "std_ranges_23_patch.h"
 
 #include <cppcoro/generator.hpp>
@@ -30,8 +34,10 @@
 
 #include <boost/icl/interval_set.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <ranges>
 #include <tuple>
 #include <unordered_set>
@@ -79,6 +85,9 @@ namespace interval_dict
   template<typename Key, typename Value, typename Interval, typename Impl>
   class IntervalDictExp;
 
+  // forward declaration of BackgroundCompactor. See compaction.h
+  template<typename Dict> class BackgroundCompactor;
+
   /* _____________________________________________________________________________
    *
    * Forward declarations of associated functions whose definitions are in
@@ -465,8 +474,16 @@ namespace interval_dict
     using OtherImplType =
       typename Implementation<Value, Interval, Impl>::template rebind<
         OtherVal>::type;
-    using DataType = std::map<Key, Impl>;
+    using AllocatorType = typename std::allocator_traits<
+      typename Implementation<Value, Interval, Impl>::Allocator>::
+      template rebind_alloc<std::pair<const Key, Impl>>;
+    using DataType = std::map<Key, Impl, std::less<Key>, AllocatorType>;
     using KeyValueIntervals = std::vector<std::tuple<Key, Value, Interval>>;
+    using TuningType = typename Implementation<Value, Interval, Impl>::Tuning;
+    using ChangeBatchType = ChangeBatch<Key, Value, Interval>;
+    using ChangeObserverType = ChangeObserver<Key, Value, Interval>;
+    using ChangeBatchScope =
+      typename details::ChangeObservers<Key, Value, Interval>::BatchScope;
     /// @endcond
 
     /// @name Constructors
@@ -479,10 +496,12 @@ namespace interval_dict
     IntervalDictExp (const IntervalDictExp &) = default;
     /// Default move constructor
     IntervalDictExp (IntervalDictExp &&other) noexcept = default;
-    /// Default copy assignment operator
-    IntervalDictExp &operator= (const IntervalDictExp &other) = default;
-    /// Default move assignment operator
-    IntervalDictExp &operator= (IntervalDictExp &&other) noexcept = default;
+    /// Copy assignment operator. Observers of this dictionary are notified
+    /// of the erasure of its contents and the insertion of those of @p other
+    IntervalDictExp &operator= (const IntervalDictExp &other);
+    /// Move assignment operator. Observers of this dictionary are notified as
+    /// for copy assignment, then those of @p other are added
+    IntervalDictExp &operator= (IntervalDictExp &&other) noexcept;
 
     /// Construct from a vector of [key-value-interval]s
     explicit IntervalDictExp (
@@ -491,6 +510,22 @@ namespace interval_dict
     /// Construct from underlying data type
     explicit IntervalDictExp (IntervalDictExp::DataType internal);
 
+    /// Construct an empty dictionary whose keys and interval-values are
+    /// allocated with @p allocator. Only allocator-aware implementations
+    /// (such as implementation::PmrAugmentedIntervalList) use it for their
+    /// interval-values. Dictionaries returned by invert(), joined_to() and
+    /// subset() share the allocator of this dictionary.
+    ///
+    /// As for other std::pmr containers, copies use the default memory
+    /// resource
+    explicit IntervalDictExp (const AllocatorType &allocator);
+
+    /// @return the allocator for keys and interval-values
+    [[nodiscard]] AllocatorType get_allocator () const
+    {
+      return data.get_allocator ();
+    }
+
     /// @}
     /// @name Insert and Erase Member Functions
     /// Inserting into and removing from the dictionary
@@ -749,6 +784,15 @@ namespace interval_dict
     [[nodiscard]] std::vector<Value>
     find (const Key &key, const Intervals &query_intervals) const;
 
+    /// Reports the work done by the implementation to find values for @p key
+    /// over @p query_interval. Use to diagnose slow queries.
+    /// \param key
+    /// \param query_interval defaults to `interval_extent`
+    /// \return QueryExplain with `key_found == false` if @p key is absent
+    [[nodiscard]] QueryExplain
+    explain (const Key &key,
+             Interval query_interval = interval_extent<Interval>) const;
+
     /// @}
 
     /// @name Gap-filling Member Functions
@@ -917,8 +961,79 @@ namespace interval_dict
     /// Inequality operator
     bool operator!= (const IntervalDictExp &rhs) const;
 
+    /// @name Memory Usage
+    /// @{
+
+    /// Returns bytes used over all keys with a histogram of bytes per key
+    /// \param count_heaviest_keys Number of keys using the most memory to
+    /// report
+    [[nodiscard]] MemoryReport<Key>
+    memory_usage (std::size_t count_heaviest_keys = 10) const;
+
+    /// Reclaim unused capacity and pending erases, for example after large
+    /// erases
+    void shrink_to_fit ();
+
+    /// @}
+    /// @name Tuning
+    /// @{
+
+    /// Returns the parameters used by the implementation for all keys
+    [[nodiscard]] const TuningType &tuning () const;
+
+    /// Sets the parameters used by the implementation for all current and
+    /// future keys. See, for example, augmented_interval_list::Tuning
+    void tune (const TuningType &tuning);
+
+    /// Integrates pending inserts and erases for keys where the compaction
+    /// policy of the tuning requires it. To do this on another thread, see
+    /// BackgroundCompactor
+    /// \return number of keys compacted
+    std::size_t compact ();
+
+    /// @}
+
+#ifdef INTERVAL_DICT_STATS
+    /// @name Instrumentation
+    /// @{
+    /// Only available if INTERVAL_DICT_STATS is defined. See instrumentation.h
+
+    /// Returns counts and latencies of member function calls together with
+    /// the internal statistics of the implementation aggregated over all keys
+    ///
+    /// Operations implemented in terms of others (e.g. fill_gaps() calls
+    /// insert()) are counted under both names.
+    [[nodiscard]] instrumentation::Stats stats () const;
+
+    /// Zero all counts and latencies
+    void reset_stats ();
+
+    /// @}
+#endif
+
+    /// @name Change Notification
+    /// @{
+    /// See change_feed.h
+
+    /// Calls @p observer with the changes made by each subsequent call that
+    /// modifies the dictionary, including assignment to it. Copies of the
+    /// dictionary are not observed.
+    /// \return id for remove_observer()
+    ObserverId add_observer (ChangeObserverType observer);
+
+    /// Stops calling the observer registered as @p id
+    void remove_observer (ObserverId id);
+
+    /// Returns a scope within which all changes are published to observers as
+    /// a single batch when the scope ends
+    [[nodiscard]] ChangeBatchScope batch_changes ();
+
+    /// @}
+
     // friends
     /// @cond Suppress_Doxygen_Warning
+    template<typename Dict> friend class BackgroundCompactor;
+
     friend IntervalDictExp operator-<> (IntervalDictExp dict_1,
                                         const IntervalDictExp &dict_2);
 
@@ -1001,7 +1116,41 @@ namespace interval_dict
     /// @endcond
 
     private:
+    /// Returns the interval-values for @p key, adding @p key with the
+    /// current tuning if necessary
+    Impl &key_data (const Key &key);
+
+    /// Replaces all keys with @p other_data, recording the erasure of the
+    /// current contents and the insertion of the new if observed
+    template<typename Data> void replace_data (Data &&other_data);
+
+    using ChangeIntervals =
+      typename details::ChangeObservers<Key, Value, Interval>::Intervals;
+
+    /// Returns the intervals of @p value for @p key within @p query_interval
+    ChangeIntervals current_intervals (const Key &key,
+                                       const Value &value,
+                                       const Interval &query_interval) const;
+
+    /// Records that @p value of @p key is about to change over @p interval
+    /// if observed
+    void record_change (const Key &key,
+                        const Value &value,
+                        const Interval &interval);
+
+    /// Records the erasure of all values of @p key over @p query_interval if
+    /// observed
+    void record_erases (const Key &key,
+                        const Impl &interval_values,
+                        const Interval &query_interval);
+
     DataType data;
+    TuningType tuning_params;
+    details::ChangeObservers<Key, Value, Interval> observers;
+#ifdef INTERVAL_DICT_STATS
+    // Updated by const member functions such as find()
+    mutable instrumentation::Stats operation_stats;
+#endif
   };
 
   /// \brief One-to-many dictionary where key-values vary over intervals.
@@ -1038,6 +1187,48 @@ namespace interval_dict
   {
   }
 
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  IntervalDictExp<Key, Value, Interval, Impl>::IntervalDictExp (
+    const AllocatorType &allocator)
+    : data (allocator)
+  {
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  IntervalDictExp<Key, Value, Interval, Impl> &
+  IntervalDictExp<Key, Value, Interval, Impl>::operator= (
+    const IntervalDictExp &other)
+  {
+    if (this != &other)
+    {
+      replace_data (other.data);
+      tuning_params = other.tuning_params;
+#ifdef INTERVAL_DICT_STATS
+      operation_stats = other.operation_stats;
+#endif
+    }
+    return *this;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  IntervalDictExp<Key, Value, Interval, Impl> &
+  IntervalDictExp<Key, Value, Interval, Impl>::operator= (
+    IntervalDictExp &&other) noexcept
+  {
+    if (this != &other)
+    {
+      replace_data (std::move (other.data));
+      tuning_params = std::move (other.tuning_params);
+      // The observers of other have already seen its contents, e.g. in
+      // `dict = flattened (std::move (dict))`
+      observers = std::move (other.observers);
+#ifdef INTERVAL_DICT_STATS
+      operation_stats = std::move (other.operation_stats);
+#endif
+    }
+    return *this;
+  }
+
   template<typename Key, typename Value, typename Interval, typename Impl>
   bool IntervalDictExp<Key, Value, Interval, Impl>::empty () const
   {
@@ -1068,6 +1259,11 @@ namespace interval_dict
   template<typename Key, typename Value, typename Interval, typename Impl>
   void IntervalDictExp<Key, Value, Interval, Impl>::clear ()
   {
+    const auto batch = batch_changes ();
+    for (const auto &[key, interval_values] : data)
+    {
+      record_erases (key, interval_values, interval_extent<Interval>);
+    }
     return data.clear ();
   }
 
@@ -1080,12 +1276,15 @@ namespace interval_dict
     const std::vector<std::pair<Key, Value>> &key_value_pairs,
     Interval interval)
   {
+    INTERVAL_DICT_TIME_OPERATION ("insert");
+    const auto batch = batch_changes ();
     if (!boost::icl::is_empty (interval))
     {
       for (const auto &[key, value] : key_value_pairs)
       {
+        record_change (key, value, interval);
         Implementation<Value, Interval, Impl>::insert (
-          data[key], interval, value);
+          key_data (key), interval, value);
       }
     }
     return *this;
@@ -1096,12 +1295,15 @@ namespace interval_dict
   IntervalDictExp<Key, Value, Interval, Impl>::insert (
     const std::vector<std::tuple<Key, Value, Interval>> &key_value_intervals)
   {
+    INTERVAL_DICT_TIME_OPERATION ("insert");
+    const auto batch = batch_changes ();
     for (const auto &[key, value, interval] : key_value_intervals)
     {
       if (!boost::icl::is_empty (interval))
       {
+        record_change (key, value, interval);
         Implementation<Value, Interval, Impl>::insert (
-          data[key], interval, value);
+          key_data (key), interval, value);
       }
     }
     return *this;
@@ -1125,12 +1327,15 @@ namespace interval_dict
   IntervalDictExp<Key, Value, Interval, Impl>::inverse_insert (
     const std::vector<std::tuple<Value, Key, Interval>> &value_key_intervals)
   {
+    INTERVAL_DICT_TIME_OPERATION ("inverse_insert");
+    const auto batch = batch_changes ();
     for (const auto &[value, key, interval] : value_key_intervals)
     {
       if (!boost::icl::is_empty (interval))
       {
+        record_change (key, value, interval);
         Implementation<Value, Interval, Impl>::insert (
-          data[key], interval, value);
+          key_data (key), interval, value);
       }
     }
     return *this;
@@ -1142,12 +1347,15 @@ namespace interval_dict
     const std::vector<std::pair<Value, Key>> &value_key_pairs,
     Interval interval)
   {
+    INTERVAL_DICT_TIME_OPERATION ("inverse_insert");
+    const auto batch = batch_changes ();
     if (!boost::icl::is_empty (interval))
     {
       for (const auto &[value, key] : value_key_pairs)
       {
+        record_change (key, value, interval);
         Implementation<Value, Interval, Impl>::insert (
-          data[key], interval, value);
+          key_data (key), interval, value);
       }
     }
     return *this;
@@ -1169,8 +1377,13 @@ namespace interval_dict
   /// @cond Suppress_Doxygen_Warning
   namespace details
   {
-    template<typename Value, typename Interval, typename Key, typename Impl>
-    void cleanup_empty_keys (std::map<Key, Impl> &data,
+    template<typename Value,
+             typename Interval,
+             typename Key,
+             typename Impl,
+             typename Compare,
+             typename Allocator>
+    void cleanup_empty_keys (std::map<Key, Impl, Compare, Allocator> &data,
                              const std::set<Key> &keys_with_erases)
     {
       for (const auto &key : keys_with_erases)
@@ -1189,6 +1402,8 @@ namespace interval_dict
   IntervalDictExp<Key, Value, Interval, Impl>::erase (
     const std::vector<std::tuple<Key, Value, Interval>> &key_value_intervals)
   {
+    INTERVAL_DICT_TIME_OPERATION ("erase");
+    const auto batch = batch_changes ();
     // cleanup keys without intervals afterwards
     std::set<Key> keys_with_erases;
     for (const auto &[key, value, interval] : key_value_intervals)
@@ -1196,6 +1411,7 @@ namespace interval_dict
       if (!boost::icl::is_empty (interval))
       {
         keys_with_erases.insert (key);
+        record_change (key, value, interval);
         Implementation<Value, Interval, Impl>::erase (
           data[key], interval, value);
       }
@@ -1210,16 +1426,19 @@ namespace interval_dict
     const std::vector<std::pair<Key, Value>> &key_value_pairs,
     Interval interval)
   {
+    INTERVAL_DICT_TIME_OPERATION ("erase");
     if (boost::icl::is_empty (interval))
     {
       return *this;
     }
 
+    const auto batch = batch_changes ();
     // cleanup keys without intervals afterwards
     std::set<Key> keys_with_erases;
     for (const auto &[key, value] : key_value_pairs)
     {
       keys_with_erases.insert (key);
+      record_change (key, value, interval);
       Implementation<Value, Interval, Impl>::erase (data[key], interval, value);
     }
     details::cleanup_empty_keys<Value, Interval> (data, keys_with_erases);
@@ -1241,6 +1460,7 @@ namespace interval_dict
   IntervalDictExp<Key, Value, Interval, Impl>::erase (const Key &key,
                                                       Interval query_interval)
   {
+    INTERVAL_DICT_TIME_OPERATION ("erase");
     if (boost::icl::is_empty (query_interval))
     {
       return *this;
@@ -1253,6 +1473,8 @@ namespace interval_dict
       return *this;
     }
 
+    const auto batch = batch_changes ();
+    record_erases (key, ff->second, query_interval);
     Implementation<Value, Interval, Impl>::erase (data[key], query_interval);
     if (Implementation<Value, Interval, Impl>::empty (data[key]))
     {
@@ -1276,15 +1498,18 @@ namespace interval_dict
   IntervalDictExp<Key, Value, Interval, Impl> &
   IntervalDictExp<Key, Value, Interval, Impl>::erase (Interval query_interval)
   {
+    INTERVAL_DICT_TIME_OPERATION ("erase");
     if (boost::icl::is_empty (query_interval))
     {
       return *this;
     }
 
+    const auto batch = batch_changes ();
     // cleanup keys without intervals afterwards
     std::set<Key> keys_with_erases;
     for (const auto &[key, interval_values] : data)
     {
+      record_erases (key, interval_values, query_interval);
       Implementation<Value, Interval, Impl>::erase (data[key], query_interval);
       keys_with_erases.insert (key);
     }
@@ -1309,12 +1534,15 @@ namespace interval_dict
   IntervalDictExp<Key, Value, Interval, Impl>::inverse_erase (
     const std::vector<std::tuple<Value, Key, Interval>> &value_key_intervals)
   {
+    INTERVAL_DICT_TIME_OPERATION ("inverse_erase");
+    const auto batch = batch_changes ();
     // cleanup keys without intervals afterwards
     std::set<Key> keys_with_erases;
     for (const auto &[value, key, interval] : value_key_intervals)
     {
       if (!boost::icl::is_empty (interval))
       {
+        record_change (key, value, interval);
         Implementation<Value, Interval, Impl>::erase (
           data[key], interval, value);
         keys_with_erases.insert (key);
@@ -1330,15 +1558,18 @@ namespace interval_dict
     const std::vector<std::pair<Value, Key>> &value_key_pairs,
     Interval interval)
   {
+    INTERVAL_DICT_TIME_OPERATION ("inverse_erase");
     if (boost::icl::is_empty (interval))
     {
       return *this;
     }
 
+    const auto batch = batch_changes ();
     // cleanup keys without intervals afterwards
     std::set<Key> keys_with_erases;
     for (const auto &[value, key] : value_key_pairs)
     {
+      record_change (key, value, interval);
       Implementation<Value, Interval, Impl>::erase (data[key], interval, value);
       keys_with_erases.insert (key);
     }
@@ -1355,6 +1586,7 @@ namespace interval_dict
   std::vector<Value> IntervalDictExp<Key, Value, Interval, Impl>::find (
     const Key &key, const Intervals &query_intervals) const
   {
+    INTERVAL_DICT_TIME_OPERATION ("find");
     // Do not assume key is valid
     const auto ff = data.find (key);
     if (ff == data.end ())
@@ -1378,10 +1610,42 @@ namespace interval_dict
     return {unique_results.begin (), unique_results.end ()};
   }
 
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  QueryExplain IntervalDictExp<Key, Value, Interval, Impl>::explain (
+    const Key &key, Interval query_interval) const
+  {
+    QueryExplain results;
+    // Do not assume key is valid
+    const auto ff = data.find (key);
+    if (ff == data.end ())
+    {
+      return results;
+    }
+    results.key_found = true;
+    if (boost::icl::is_empty (query_interval))
+    {
+      return results;
+    }
+
+    Implementation<Value, Interval, Impl>::explain (
+      ff->second, query_interval, results);
+
+    std::set<Value> unique_results;
+    for (const auto &[value, _] :
+         Implementation<Value, Interval, Impl>::intervals (ff->second,
+                                                           query_interval))
+    {
+      unique_results.insert (value);
+    }
+    results.count_values = unique_results.size ();
+    return results;
+  }
+
   template<typename Key, typename Value, typename Interval, typename Impl>
   std::vector<Value> IntervalDictExp<Key, Value, Interval, Impl>::find (
     const std::vector<Key> &keys, Interval query_interval) const
   {
+    INTERVAL_DICT_TIME_OPERATION ("find");
     if (boost::icl::is_empty (query_interval))
     {
       return {};
@@ -1455,14 +1719,16 @@ namespace interval_dict
     const ValRange &values_subset,
     Interval query_interval) const
   {
+    INTERVAL_DICT_TIME_OPERATION ("subset");
     if (boost::icl::is_empty (query_interval))
     {
-      return {};
+      return IntervalDictExp (get_allocator ());
     }
 
-    return IntervalDictExp<Key, Value, Interval, Impl> ().insert (
-      details::subset_inserts (
-        *this, keys_subset, values_subset, query_interval));
+    IntervalDictExp result (get_allocator ());
+    result.insert (details::subset_inserts (
+      *this, keys_subset, values_subset, query_interval));
+    return result;
   }
 
   template<typename Key, typename Value, typename Interval, typename Impl>
@@ -1471,12 +1737,15 @@ namespace interval_dict
   IntervalDictExp<Key, Value, Interval, Impl>::subset (
     const KeyRange &keys_subset, Interval query_interval) const
   {
+    INTERVAL_DICT_TIME_OPERATION ("subset");
     if (boost::icl::is_empty (query_interval))
     {
-      return {};
+      return IntervalDictExp (get_allocator ());
     }
-    return IntervalDictExp<Key, Value, Interval, Impl> ().insert (
+    IntervalDictExp result (get_allocator ());
+    result.insert (
       details::subset_inserts (*this, keys_subset, query_interval));
+    return result;
   }
 
   /*
@@ -1490,9 +1759,11 @@ namespace interval_dict
     typename Implementation<Value, Interval, Impl>::template rebind<Key>::type>
   IntervalDictExp<Key, Value, Interval, Impl>::invert () const
   {
+    INTERVAL_DICT_TIME_OPERATION ("invert");
     using InverseDataType =
       typename IntervalDictExp<Value, Key, Interval, InverseImplType>::DataType;
-    InverseDataType inverted_data;
+    InverseDataType inverted_data (
+      typename InverseDataType::allocator_type (data.get_allocator ()));
     for (const auto &[key, interval_values] : data)
     {
       for (const auto &[value, interval] :
@@ -1504,7 +1775,7 @@ namespace interval_dict
       }
     }
     return IntervalDictExp<Value, Key, Interval, InverseImplType> (
-      inverted_data);
+      std::move (inverted_data));
   }
 
   /*
@@ -1515,15 +1786,26 @@ namespace interval_dict
   IntervalDictExp<Key, Value, Interval, Impl>::operator-= (
     const IntervalDictExp<Key, Value, Interval, Impl> &other)
   {
+    INTERVAL_DICT_TIME_OPERATION ("operator-=");
     // Iterate using the vector of keys() is a much more conservative choice at
     // the cost of making a copy of the keys:
     // makes sure we never change the std::map in the
     // middle of key iteration for example in the course of `myself -= myself;`
+    const auto batch = batch_changes ();
     for (auto &key : keys ())
     {
       if (const auto f = other.data.find (key); f != other.data.end ())
       {
         auto &interval_values = data.find (key)->second;
+        if (observers.observed ())
+        {
+          for (const auto &[value, interval] :
+               Implementation<Value, Interval, Impl>::intervals (
+                 f->second, interval_extent<Interval>))
+          {
+            record_change (key, value, interval);
+          }
+        }
         Implementation<Value, Interval, Impl>::subtract_by (interval_values,
                                                             f->second);
         // remove empty keys
@@ -1541,12 +1823,24 @@ namespace interval_dict
   IntervalDictExp<Key, Value, Interval, Impl>::operator+= (
     const IntervalDictExp<Key, Value, Interval, Impl> &other)
   {
+    INTERVAL_DICT_TIME_OPERATION ("operator+=");
+    const auto batch = batch_changes ();
     for (const auto &[key_other, interval_values_other] : other.data)
     {
+      if (observers.observed ())
+      {
+        for (const auto &[value, interval] :
+             Implementation<Value, Interval, Impl>::intervals (
+               interval_values_other, interval_extent<Interval>))
+        {
+          record_change (key_other, value, interval);
+        }
+      }
       auto f = data.find (key_other);
       if (f == data.end ())
       {
-        data[key_other] = interval_values_other;
+        Implementation<Value, Interval, Impl>::tune (
+          data[key_other] = interval_values_other, tuning_params);
       }
       else
       {
@@ -1569,10 +1863,12 @@ namespace interval_dict
   IntervalDictExp<A, B, Interval, Impl>::joined_to (
     const IntervalDictExp<B, C, Interval, OtherImpl> &b_to_c) const
   {
+    INTERVAL_DICT_TIME_OPERATION ("joined_to");
     using ReturnImplType = OtherImplType<C>;
     using ReturnType = IntervalDictExp<A, C, Interval, ReturnImplType>;
     using ReturnDataType = typename ReturnType::DataType;
-    ReturnDataType return_data;
+    ReturnDataType return_data (
+      typename ReturnDataType::allocator_type (data.get_allocator ()));
     for (const auto &[key_a, interval_values_ab] : data)
     {
       for (const auto &[value_b, interval_ab] :
@@ -1597,7 +1893,7 @@ namespace interval_dict
         }
       }
     }
-    return ReturnType (return_data);
+    return ReturnType (std::move (return_data));
   }
   /// @endcond
 
@@ -1606,6 +1902,7 @@ namespace interval_dict
   IntervalDictExp<Key, Value, Interval, Impl>::fill_gaps_with (
     const IntervalDictExp<Key, Value, Interval, Impl> &other)
   {
+    INTERVAL_DICT_TIME_OPERATION ("fill_gaps_with");
     return insert (details::fill_gaps_with_inserts (*this, other));
   }
 
@@ -1618,6 +1915,7 @@ namespace interval_dict
     typename IntervalDictExp::BaseType starting_point,
     typename IntervalDictExp::BaseDifferenceType max_extension)
   {
+    INTERVAL_DICT_TIME_OPERATION ("fill_to_start");
     return insert (
       details::fill_to_start_inserts (*this, starting_point, max_extension));
   }
@@ -1628,6 +1926,7 @@ namespace interval_dict
     typename IntervalDictExp::BaseType starting_point,
     typename IntervalDictExp::BaseDifferenceType max_extension)
   {
+    INTERVAL_DICT_TIME_OPERATION ("fill_to_end");
     return insert (
       details::fill_to_end_inserts (*this, starting_point, max_extension));
   }
@@ -1638,6 +1937,7 @@ namespace interval_dict
     GapExtensionDirection gap_extension_direction,
     typename IntervalDictExp::BaseDifferenceType max_extension)
   {
+    INTERVAL_DICT_TIME_OPERATION ("extend_into_gaps");
     return insert (details::extend_into_gaps_inserts (
       *this, gap_extension_direction, max_extension));
   }
@@ -1647,6 +1947,7 @@ namespace interval_dict
   IntervalDictExp<Key, Value, Interval, Impl>::fill_gaps (
     typename IntervalDictExp::BaseDifferenceType max_extension)
   {
+    INTERVAL_DICT_TIME_OPERATION ("fill_gaps");
     return insert (details::fill_gaps_inserts (*this, max_extension));
   }
 
@@ -1664,6 +1965,229 @@ namespace interval_dict
     return !(rhs == *this);
   }
 
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  MemoryReport<Key> IntervalDictExp<Key, Value, Interval, Impl>::memory_usage (
+    std::size_t count_heaviest_keys) const
+  {
+    MemoryReport<Key> report;
+    using KeyNode = typename DataType::value_type;
+    report.bytes_keys
+      = data.size () * (details::rb_tree_node_links + sizeof (KeyNode));
+    std::vector<std::pair<Key, std::size_t>> bytes_per_key;
+    bytes_per_key.reserve (data.size ());
+    for (const auto &[key, interval_values] : data)
+    {
+      const auto usage
+        = Implementation<Value, Interval, Impl>::memory_usage (interval_values);
+      report.usage += usage;
+      ++report.log2_bytes_per_key[details::log2_bin (
+        usage.total (), report.log2_bytes_per_key.size ())];
+      bytes_per_key.emplace_back (key, usage.total ());
+    }
+
+    // Heaviest first
+    const auto count_heaviest = std::min (count_heaviest_keys, data.size ());
+    std::ranges::partial_sort (bytes_per_key,
+                               bytes_per_key.begin () + count_heaviest,
+                               std::ranges::greater {},
+                               &std::pair<Key, std::size_t>::second);
+    bytes_per_key.resize (count_heaviest);
+    report.heaviest_keys = std::move (bytes_per_key);
+    return report;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  void IntervalDictExp<Key, Value, Interval, Impl>::shrink_to_fit ()
+  {
+    for (auto &[key, interval_values] : data)
+    {
+      Implementation<Value, Interval, Impl>::shrink_to_fit (interval_values);
+    }
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  const typename IntervalDictExp<Key, Value, Interval, Impl>::TuningType &
+  IntervalDictExp<Key, Value, Interval, Impl>::tuning () const
+  {
+    return tuning_params;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  void IntervalDictExp<Key, Value, Interval, Impl>::tune (
+    const TuningType &tuning)
+  {
+    tuning_params = tuning;
+    for (auto &[key, interval_values] : data)
+    {
+      Implementation<Value, Interval, Impl>::tune (interval_values, tuning);
+    }
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  std::size_t IntervalDictExp<Key, Value, Interval, Impl>::compact ()
+  {
+    INTERVAL_DICT_TIME_OPERATION ("compact");
+    std::size_t count_compacted = 0;
+    for (auto &[key, interval_values] : data)
+    {
+      if (Implementation<Value, Interval, Impl>::needs_compaction (
+            interval_values))
+      {
+        Implementation<Value, Interval, Impl>::compact (interval_values);
+        ++count_compacted;
+      }
+    }
+    return count_compacted;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  Impl &IntervalDictExp<Key, Value, Interval, Impl>::key_data (const Key &key)
+  {
+    auto [iter, inserted] = data.try_emplace (key);
+    if (inserted)
+    {
+      Implementation<Value, Interval, Impl>::tune (iter->second,
+                                                   tuning_params);
+    }
+    return iter->second;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  template<typename Data>
+  void
+  IntervalDictExp<Key, Value, Interval, Impl>::replace_data (Data &&other_data)
+  {
+    const auto batch = batch_changes ();
+    if (observers.observed ())
+    {
+      for (const auto &[key, interval_values] : data)
+      {
+        record_erases (key, interval_values, interval_extent<Interval>);
+      }
+      for (const auto &[key, interval_values] : other_data)
+      {
+        for (const auto &[value, interval] :
+             Implementation<Value, Interval, Impl>::intervals (
+               interval_values, interval_extent<Interval>))
+        {
+          record_change (key, value, interval);
+        }
+      }
+    }
+    data = std::forward<Data> (other_data);
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  void IntervalDictExp<Key, Value, Interval, Impl>::record_erases (
+    const Key &key,
+    const Impl &interval_values,
+    const Interval &query_interval)
+  {
+    if (!observers.observed ())
+    {
+      return;
+    }
+    for (const auto &[value, interval] :
+         Implementation<Value, Interval, Impl>::intervals (interval_values,
+                                                           query_interval))
+    {
+      // The value is present throughout its interval
+      observers.record (key,
+                        value,
+                        interval & query_interval,
+                        [] (const Key &, const Value &, const Interval &piece)
+                        { return ChangeIntervals (piece); });
+    }
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  typename IntervalDictExp<Key, Value, Interval, Impl>::ChangeIntervals
+  IntervalDictExp<Key, Value, Interval, Impl>::current_intervals (
+    const Key &key,
+    const Value &value,
+    const Interval &query_interval) const
+  {
+    ChangeIntervals current;
+    if (const auto found = data.find (key); found != data.end ())
+    {
+      for (const auto &[other_value, interval] :
+           Implementation<Value, Interval, Impl>::intervals (found->second,
+                                                             query_interval))
+      {
+        if (other_value == value)
+        {
+          current += interval & query_interval;
+        }
+      }
+    }
+    return current;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  void IntervalDictExp<Key, Value, Interval, Impl>::record_change (
+    const Key &key,
+    const Value &value,
+    const Interval &interval)
+  {
+    observers.record (key,
+                      value,
+                      interval,
+                      [this] (const auto &...args)
+                      { return current_intervals (args...); });
+  }
+
+  /*
+   * Change notification
+   */
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  ObserverId IntervalDictExp<Key, Value, Interval, Impl>::add_observer (
+    ChangeObserverType observer)
+  {
+    return observers.add (std::move (observer));
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  void
+  IntervalDictExp<Key, Value, Interval, Impl>::remove_observer (ObserverId id)
+  {
+    observers.remove (id);
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  typename IntervalDictExp<Key, Value, Interval, Impl>::ChangeBatchScope
+  IntervalDictExp<Key, Value, Interval, Impl>::batch_changes ()
+  {
+    return observers.batch (
+      [this] (const Key &key, const Value &value, const Interval &interval)
+      { return current_intervals (key, value, interval); });
+  }
+
+#ifdef INTERVAL_DICT_STATS
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  instrumentation::Stats
+  IntervalDictExp<Key, Value, Interval, Impl>::stats () const
+  {
+    auto results = operation_stats;
+    results.count_keys = data.size ();
+    for (const auto &[key, interval_values] : data)
+    {
+      Implementation<Value, Interval, Impl>::collect_stats (interval_values,
+                                                            results);
+    }
+    return results;
+  }
+
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  void IntervalDictExp<Key, Value, Interval, Impl>::reset_stats ()
+  {
+    operation_stats = {};
+    for (auto &[key, interval_values] : data)
+    {
+      Implementation<Value, Interval, Impl>::reset_stats (interval_values);
+    }
+  }
+#endif
+
   /// @cond Suppress_Doxygen_Warning
   namespace details
   {
@@ -1846,10 +2370,11 @@ namespace interval_dict
     }
 
     // Helper function for fill_gaps_inserts() and extend_into_gaps_inserts()
-    template<typename Key, typename Value, typename Interval>
+    // @p values can be a std::vector or SegmentValues
+    template<typename Key, typename Value, typename Interval, typename Values>
     void add_values_to_gap (Insertions<Key, Value, Interval> &results,
                             const Key &key,
-                            const std::vector<Value> &values,
+                            const Values &values,
                             const Interval gap_interval)
     {
       for (const auto &val : values)
@@ -2261,8 +2786,11 @@ namespace interval_dict
   {
     const auto [insertions, erasures]
       = details::flatten_actions (interval_dict, keep_one_value);
-    interval_dict.insert (insertions);
-    interval_dict.erase (erasures);
+    {
+      const auto batch = interval_dict.batch_changes ();
+      interval_dict.insert (insertions);
+      interval_dict.erase (erasures);
+    }
     return interval_dict;
   }
 
@@ -21,6 +21,7 @@
 #define INCLUDE_INTERVAL_DICT_INTERVALDICTAIL_H
 
 #include "adaptor_ail.h"
+#include "bitemporal_intervaldict.h"
 #include "intervaldict.h"
 
 namespace interval_dict
@@ -56,6 +57,52 @@ namespace interval_dict
                       Interval,
                       implementation::AugmentedIntervalList<Value, Interval>>;
 
+  /**
+   * @brief IntervalDictAILExp allocating all of its storage from a
+   * std::pmr::memory_resource
+   *
+   * Construct with, for example, a std::pmr::monotonic_buffer_resource to
+   * keep a dictionary and the results of invert() and joined_to() in one
+   * arena that is freed at once:
+   *
+   *     std::pmr::monotonic_buffer_resource arena;
+   *     IntervalDictAILPmrExp<K, V, I> dict (&arena);
+   *
+   * @tparam Key Type of keys
+   * @tparam Value Type of Values
+   * @tparam Interval Interval Type. E.g. boost::icl::right_open_interval<Date>
+   */
+  template<typename Key, typename Value, typename Interval>
+  using IntervalDictAILPmrExp = IntervalDictExp<
+    Key,
+    Value,
+    Interval,
+    implementation::PmrAugmentedIntervalList<Value, Interval>>;
+
+  /**
+   * @brief IntervalDictAILExp over valid time which remembers what was
+   * believed at each transaction time
+   *
+   * Records are indexed by valid time in Augmented Interval Lists, one for
+   * each epoch of transactions.
+   *
+   * @tparam Key Type of keys
+   * @tparam Value Type of Values
+   * @tparam Interval Interval Type. E.g. boost::icl::right_open_interval<Date>
+   * @tparam TxnTime Type of transaction times. Defaults to the base type of
+   * Interval
+   */
+  template<typename Key,
+           typename Value,
+           typename Interval,
+           typename TxnTime = typename IntervalTraits<Interval>::BaseType>
+  using BitemporalIntervalDictAILExp = BitemporalIntervalDictExp<
+    Key,
+    Value,
+    Interval,
+    implementation::AugmentedIntervalList<Value, Interval>,
+    TxnTime>;
+
   /// \brief one-to-many interval dictionary powered by boost::icl::interval_map
   ///
   /// \tparam Key Type of keys
@@ -0,0 +1,75 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file intervaldicthybrid.h
+/// \brief Declaration of the IntervalDictHybridExp / IntervalDictHybrid classes
+//
+// Provides interval associative dictionaries storing the intervals for each
+// key in a small vector, promoted to an Augmented Interval List when large
+//
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_INTERVALDICTHYBRID_H
+#define INCLUDE_INTERVAL_DICT_INTERVALDICTHYBRID_H
+
+#include "adaptor_hybrid.h"
+#include "intervaldict.h"
+
+namespace interval_dict
+{
+  /**
+   * @brief one-to-many interval dictionary powered by
+   * a small vector for each key, switching to an Augmented Interval List for
+   * keys with many intervals
+   *
+   *  Typically used for time-varying dictionaries where most keys have few
+   *  intervals.
+   *
+   *  `IntervalDictHybridExp` is useful for specifying the exact inclusive or
+   * exclusive interval type.
+   *
+   * Choices are [boost::icl intervals
+   * ](https://www.boost.org/doc/libs/release/libs/icl/doc/html/index.html#boost_icl.introduction.icl_s_class_templates)
+   * :
+   *
+   *  - `left_open_interval<BaseType>`
+   *  - `right_open_interval<BaseType>`
+   *  - `open_interval<BaseType>`
+   *  - `closed_interval<BaseType>`
+   *
+   *  `BaseType` can be a Date or Time type, for example.
+   *
+   * @tparam Key Type of keys
+   * @tparam Value Type of Values
+   * @tparam Interval Interval Type. E.g. boost::icl::right_open_interval<Date>
+   */
+  template<typename Key, typename Value, typename Interval>
+  using IntervalDictHybridExp
+    = IntervalDictExp<Key,
+                      Value,
+                      Interval,
+                      implementation::HybridIntervalList<Value, Interval>>;
+
+  /// \brief one-to-many interval dictionary powered by small vectors and
+  /// Augmented Interval Lists
+  ///
+  /// \tparam Key Type of keys
+  /// \tparam Value Type of Values
+  /// \tparam BaseType The base type of the interval: Date or Posix Time etc.
+  template<typename Key, typename Value, typename BaseType>
+  using IntervalDictHybrid
+    = IntervalDictHybridExp<Key,
+                            Value,
+                            typename boost::icl::interval<BaseType>::type>;
+
+} // namespace interval_dict
+
+#endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file intervaldictpartitioned.h
+/// \brief Declaration of the IntervalDictPartitionedExp /
+/// IntervalDictPartitionedAILExp classes
+//
+// Provides interval associative dictionaries splitting the intervals for each
+// key into partitions of time
+//
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_INTERVALDICTPARTITIONED_H
+#define INCLUDE_INTERVAL_DICT_INTERVALDICTPARTITIONED_H
+
+#include "adaptor_ail.h"
+#include "adaptor_partitioned.h"
+#include "intervaldict.h"
+
+namespace interval_dict
+{
+  /**
+   * @brief one-to-many interval dictionary splitting the intervals for each
+   * key into partitions of time
+   *
+   *  Typically used for long histories that are mostly corrected or queried
+   *  over recent months. Set the width of the partitions with
+   *  `dict.tune ({.width = {.period = PartitionPeriod::Month}})`, and drop
+   *  old partitions whole with `dict.erase (Interval {minimum, cutoff})`.
+   *
+   * @tparam Key Type of keys
+   * @tparam Value Type of Values
+   * @tparam Interval Interval Type. E.g. boost::icl::right_open_interval<Date>
+   * @tparam Inner Implementation for each partition
+   */
+  template<typename Key, typename Value, typename Interval, typename Inner>
+  using IntervalDictPartitionedExp = IntervalDictExp<
+    Key,
+    Value,
+    Interval,
+    implementation::PartitionedIntervals<Value, Interval, Inner>>;
+
+  /// \brief IntervalDictPartitionedExp holding each partition in an
+  /// Augmented Interval List
+  ///
+  /// \tparam Key Type of keys
+  /// \tparam Value Type of Values
+  /// \tparam Interval Interval Type. E.g.
+  /// boost::icl::right_open_interval<Date>
+  template<typename Key, typename Value, typename Interval>
+  using IntervalDictPartitionedAILExp = IntervalDictPartitionedExp<
+    Key,
+    Value,
+    Interval,
+    implementation::AugmentedIntervalList<Value, Interval>>;
+
+  /// \brief one-to-many interval dictionary partitioned by time, with
+  /// Augmented Interval Lists
+  ///
+  /// \tparam Key Type of keys
+  /// \tparam Value Type of Values
+  /// \tparam BaseType The base type of the interval: Date or Posix Time etc.
+  template<typename Key, typename Value, typename BaseType>
+  using IntervalDictPartitionedAIL = IntervalDictPartitionedAILExp<
+    Key,
+    Value,
+    typename boost::icl::interval<BaseType>::type>;
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_INTERVALDICTPARTITIONED_H
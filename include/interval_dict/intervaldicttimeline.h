@@ -0,0 +1,69 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file intervaldicttimeline.h
+/// \brief Declaration of the IntervalDictTimelineExp / IntervalDictTimeline
+/// classes
+//
+// Provides interval associative dictionaries storing the intervals for each
+// key as run-length encoded timelines, one per value
+//
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_INTERVALDICTTIMELINE_H
+#define INCLUDE_INTERVAL_DICT_INTERVALDICTTIMELINE_H
+
+#include "adaptor_timeline.h"
+#include "intervaldict.h"
+
+namespace interval_dict
+{
+  /**
+   * @brief one-to-many interval dictionary powered by
+   * run-length encoded timelines for each key
+   *
+   *  Typically used for daily snapshots, where values persist for long
+   *  stretches punctuated by short gaps.
+   *
+   *  Only discrete intervals, over dates or integers, are supported:
+   *
+   *  - `left_open_interval<BaseType>`
+   *  - `right_open_interval<BaseType>`
+   *  - `open_interval<BaseType>`
+   *  - `closed_interval<BaseType>`
+   *  - `discrete_interval<BaseType>`
+   *
+   * @tparam Key Type of keys
+   * @tparam Value Type of Values
+   * @tparam Interval Interval Type. E.g. boost::icl::right_open_interval<Date>
+   */
+  template<typename Key, typename Value, typename Interval>
+  using IntervalDictTimelineExp
+    = IntervalDictExp<Key,
+                      Value,
+                      Interval,
+                      implementation::CompressedTimeline<Value, Interval>>;
+
+  /// \brief one-to-many interval dictionary powered by run-length encoded
+  /// timelines
+  ///
+  /// \tparam Key Type of keys
+  /// \tparam Value Type of Values
+  /// \tparam BaseType The base type of the interval: Date or integer
+  template<typename Key, typename Value, typename BaseType>
+  using IntervalDictTimeline
+    = IntervalDictTimelineExp<Key,
+                              Value,
+                              typename boost::icl::interval<BaseType>::type>;
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_INTERVALDICTTIMELINE_H
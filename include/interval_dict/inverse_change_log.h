@@ -0,0 +1,319 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file inverse_change_log.h
+/// \brief Changes to the inverse of a BiIntervalDictExp that have not yet
+/// been applied
+///
+/// With InverseMaintenance::lazy, mutations of a BiIntervalDictExp only
+/// update the forward dictionary and append to an InverseChangeLog. The log
+/// has the same insert and erase member functions as the inverse
+/// IntervalDictExp, so that both can be updated by the same code.
+/// Consecutive inserts or erases are concatenated so that they are applied
+/// as a single batch. Once there are more changes than are worth replaying,
+/// the log is discarded and the inverse is rebuilt from the forward
+/// dictionary instead.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_INVERSE_CHANGE_LOG_H
+#define INCLUDE_INTERVAL_DICT_INVERSE_CHANGE_LOG_H
+
+#include "interval_traits.h"
+
+#include <boost/icl/concept/interval.hpp>
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace interval_dict
+{
+  /// \brief When a BiIntervalDictExp updates its inverse dictionary
+  enum class InverseMaintenance
+  {
+    /// Update the inverse on every insert or erase
+    eager,
+    /// Log changes and apply them on the next inverse query
+    lazy
+  };
+
+  /// Default number of pending key-value changes beyond which the inverse is
+  /// rebuilt from scratch rather than updated
+  inline constexpr std::size_t default_max_count_inverse_changes = 1 << 16;
+
+  /// @cond Suppress_Doxygen_Warning
+  namespace details
+  {
+    /**
+     * Pending changes to the Value -> Key inverse of a Key -> Value
+     * dictionary
+     */
+    template<typename Key, typename Value, typename Interval>
+    class InverseChangeLog
+    {
+      public:
+      using KeyValueIntervals = std::vector<std::tuple<Key, Value, Interval>>;
+
+      explicit InverseChangeLog (
+        std::size_t max_count_changes = default_max_count_inverse_changes)
+        : m_max_count_changes (max_count_changes)
+      {
+      }
+
+      /// @name Changes named after the IntervalDictExp member functions
+      /// they stand in for
+      /// @{
+      void inverse_insert (const KeyValueIntervals &key_value_intervals)
+      {
+        append<InsertChanges> (key_value_intervals);
+      }
+
+      void
+      inverse_insert (const std::vector<std::pair<Key, Value>> &key_value_pairs,
+                      Interval interval)
+      {
+        append<InsertChanges> (to_intervals (key_value_pairs, interval));
+      }
+
+      void insert (const std::vector<std::tuple<Value, Key, Interval>>
+                     &value_key_intervals)
+      {
+        append<InsertChanges> (swapped (value_key_intervals));
+      }
+
+      void insert (const std::vector<std::pair<Value, Key>> &value_key_pairs,
+                   Interval interval)
+      {
+        append<InsertChanges> (
+          swapped (to_intervals (value_key_pairs, interval)));
+      }
+
+      void inverse_erase (const KeyValueIntervals &key_value_intervals)
+      {
+        append<EraseChanges> (key_value_intervals);
+      }
+
+      void
+      inverse_erase (const std::vector<std::pair<Key, Value>> &key_value_pairs,
+                     Interval interval)
+      {
+        append<EraseChanges> (to_intervals (key_value_pairs, interval));
+      }
+
+      void erase (const std::vector<std::tuple<Value, Key, Interval>>
+                    &value_key_intervals)
+      {
+        append<EraseChanges> (swapped (value_key_intervals));
+      }
+
+      void erase (const std::vector<std::pair<Value, Key>> &value_key_pairs,
+                  Interval interval)
+      {
+        append<EraseChanges> (
+          swapped (to_intervals (value_key_pairs, interval)));
+      }
+
+      void erase (Interval interval)
+      {
+        if (count_change (1))
+        {
+          m_changes.emplace_back (EraseInterval {interval});
+        }
+      }
+      /// @}
+
+      /// Discard all changes: the inverse must be rebuilt
+      void rebuild ()
+      {
+        m_changes.clear ();
+        m_changes.shrink_to_fit ();
+        m_rebuild = true;
+      }
+
+      /// Forget all changes and any pending rebuild
+      void clear ()
+      {
+        m_changes.clear ();
+        m_count_changes = 0;
+        m_rebuild = false;
+      }
+
+      /// @return whether there is nothing to apply
+      [[nodiscard]] bool empty () const
+      {
+        return m_changes.empty () && !m_rebuild;
+      }
+
+      /// @return number of key-value changes logged since the last apply
+      [[nodiscard]] std::size_t count_changes () const
+      {
+        return m_count_changes;
+      }
+
+      /// @return whether the inverse will be rebuilt rather than updated
+      [[nodiscard]] bool needs_rebuild () const
+      {
+        return m_rebuild;
+      }
+
+      /// Bring @p inverse up to date with @p forward and clear the log
+      template<typename ForwardDict, typename InverseDict>
+      void apply (const ForwardDict &forward, InverseDict &inverse)
+      {
+        if (m_rebuild)
+        {
+          if constexpr (std::is_same_v<decltype (forward.invert ()),
+                                       InverseDict>)
+          {
+            inverse = forward.invert ();
+          }
+          else
+          {
+            KeyValueIntervals key_value_intervals;
+            for (const auto &key_value_interval : intervals (forward))
+            {
+              key_value_intervals.push_back (key_value_interval);
+            }
+            inverse.clear ();
+            inverse.inverse_insert (key_value_intervals);
+          }
+        }
+        else
+        {
+          for (const auto &change : m_changes)
+          {
+            std::visit (
+              [&] (const auto &entry)
+              {
+                entry.apply (inverse);
+              },
+              change);
+          }
+        }
+        clear ();
+      }
+
+      private:
+      struct InsertChanges
+      {
+        KeyValueIntervals key_value_intervals;
+
+        template<typename InverseDict> void apply (InverseDict &inverse) const
+        {
+          inverse.inverse_insert (key_value_intervals);
+        }
+      };
+
+      struct EraseChanges
+      {
+        KeyValueIntervals key_value_intervals;
+
+        template<typename InverseDict> void apply (InverseDict &inverse) const
+        {
+          inverse.inverse_erase (key_value_intervals);
+        }
+      };
+
+      struct EraseInterval
+      {
+        Interval interval;
+
+        template<typename InverseDict> void apply (InverseDict &inverse) const
+        {
+          inverse.erase (interval);
+        }
+      };
+
+      using Change = std::variant<InsertChanges, EraseChanges, EraseInterval>;
+
+      template<typename First, typename Second>
+      static std::vector<std::tuple<First, Second, Interval>>
+      to_intervals (const std::vector<std::pair<First, Second>> &pairs,
+                    Interval interval)
+      {
+        std::vector<std::tuple<First, Second, Interval>> results;
+        results.reserve (pairs.size ());
+        for (const auto &[first, second] : pairs)
+        {
+          results.emplace_back (first, second, interval);
+        }
+        return results;
+      }
+
+      static KeyValueIntervals
+      swapped (const std::vector<std::tuple<Value, Key, Interval>>
+                 &value_key_intervals)
+      {
+        KeyValueIntervals results;
+        results.reserve (value_key_intervals.size ());
+        for (const auto &[value, key, interval] : value_key_intervals)
+        {
+          results.emplace_back (key, value, interval);
+        }
+        return results;
+      }
+
+      /// Count @p count more changes, switching to a rebuild if there are
+      /// too many
+      /// \return whether the changes should still be logged
+      bool count_change (std::size_t count)
+      {
+        if (m_rebuild)
+        {
+          return false;
+        }
+        m_count_changes += count;
+        if (m_count_changes > m_max_count_changes)
+        {
+          rebuild ();
+          return false;
+        }
+        return true;
+      }
+
+      /// Log @p key_value_intervals, adding them to the last change if it
+      /// is of the same sort
+      template<typename Changes>
+      void append (KeyValueIntervals key_value_intervals)
+      {
+        if (!count_change (key_value_intervals.size ()))
+        {
+          return;
+        }
+        if (!m_changes.empty ())
+        {
+          if (auto *last = std::get_if<Changes> (&m_changes.back ()))
+          {
+            last->key_value_intervals.insert (
+              last->key_value_intervals.end (),
+              std::make_move_iterator (key_value_intervals.begin ()),
+              std::make_move_iterator (key_value_intervals.end ()));
+            return;
+          }
+        }
+        m_changes.emplace_back (Changes {std::move (key_value_intervals)});
+      }
+
+      std::vector<Change> m_changes;
+      std::size_t m_count_changes = 0;
+      std::size_t m_max_count_changes;
+      bool m_rebuild = false;
+    };
+  } // namespace details
+  /// @endcond
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_INVERSE_CHANGE_LOG_H
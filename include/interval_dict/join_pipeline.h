@@ -0,0 +1,330 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file join_pipeline.h
+/// \brief Joining a chain of dictionaries A -> B -> C -> ... in one pass
+///
+/// `a_to_b.joined_to (b_to_c).joined_to (c_to_d).subset (keys, interval)`
+/// builds a full dictionary at every hop, and only then discards the keys and
+/// intervals that are not wanted.
+///
+/// \code
+/// const auto a_to_d = chain (a_to_b)
+///                       .join (b_to_c)
+///                       .join (c_to_d)
+///                       .restrict_keys (keys)
+///                       .restrict_interval (interval)
+///                       .materialize ();
+/// \endcode
+///
+/// gives the same result, but only the restricted keys of A -> B are read,
+/// and only over the restricted interval. Each key is followed through every
+/// hop in turn by querying the intervals of the next dictionary that overlap
+/// the intervals so far, so that no intermediate dictionaries are built. Keys
+/// are split into contiguous partitions joined on separate threads.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_JOIN_PIPELINE_H
+#define INCLUDE_INTERVAL_DICT_JOIN_PIPELINE_H
+
+#include "intervaldict.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace interval_dict
+{
+  /// Minimum number of keys joined by each thread of
+  /// JoinPipeline::materialize()
+  inline constexpr std::size_t min_count_keys_per_join_thread = 64;
+
+  /**
+   * @brief Chain of dictionaries A -> B, B -> C, ... to be joined, with
+   * restrictions on the keys of A and the intervals
+   *
+   * Holds references to the dictionaries, which must outlive the pipeline.
+   * Start a pipeline with chain().
+   *
+   * @tparam Dicts IntervalDictExp types, where the keys of each are the
+   * values of the previous one
+   */
+  template<typename... Dicts> class JoinPipeline
+  {
+    static_assert (sizeof...(Dicts) >= 1);
+    using First = std::tuple_element_t<0, std::tuple<Dicts...>>;
+    using Last
+      = std::tuple_element_t<sizeof...(Dicts) - 1, std::tuple<Dicts...>>;
+
+    public:
+    /// @cond Suppress_Doxygen_Warning
+    using KeyType = typename First::KeyType;
+    using ValType = typename Last::ValType;
+    using IntervalType = typename First::IntervalType;
+    using ResultType
+      = IntervalDictExp<KeyType,
+                        ValType,
+                        IntervalType,
+                        typename First::template OtherImplType<ValType>>;
+    /// @endcond
+
+    /// Chain of @p dicts. See chain()
+    explicit JoinPipeline (std::tuple<const Dicts *...> dicts,
+                           std::optional<std::vector<KeyType>> keys = {},
+                           IntervalType query_interval
+                           = interval_extent<IntervalType>);
+
+    /// @return pipeline that also joins to @p next, whose keys are the values
+    /// of the last dictionary so far
+    template<typename Next>
+      requires std::same_as<typename Next::KeyType, ValType>
+               && std::same_as<typename Next::IntervalType, IntervalType>
+    [[nodiscard]] JoinPipeline<Dicts..., Next> join (const Next &next) const;
+
+    /// @return pipeline only joining the specified @p keys of the first
+    /// dictionary. Repeated restrictions keep the keys common to all
+    /// \param keys Any sequence of Key (suitable for range-based for loop)
+    template<typename KeyRange>
+    [[nodiscard]] JoinPipeline restrict_keys (const KeyRange &keys) const;
+
+    /// @return pipeline only joining over @p query_interval. Repeated
+    /// restrictions keep their intersection
+    [[nodiscard]] JoinPipeline
+    restrict_interval (const IntervalType &query_interval) const;
+
+    /// Joins all the dictionaries over the restricted keys and interval
+    ///
+    /// Gives the same results as successive joined_to() followed by subset()
+    /// \param count_threads Maximum number of threads. Each joins at least
+    /// min_count_keys_per_join_thread keys
+    [[nodiscard]] ResultType materialize (
+      std::size_t count_threads = std::thread::hardware_concurrency ()) const;
+
+    private:
+    template<typename... Others> friend class JoinPipeline;
+
+    using ResultImpl = typename ResultType::ImplType;
+    using ResultImplementation
+      = Implementation<ValType, IntervalType, ResultImpl>;
+    using KeyResults = std::vector<std::pair<KeyType, ResultImpl>>;
+
+    /// Add to @p results everything reached from @p value over @p interval,
+    /// through the dictionaries from @p Hop onwards
+    template<std::size_t Hop, typename Value>
+    void probe (const Value &value,
+                const IntervalType &interval,
+                ResultImpl &results) const;
+
+    /// @return the keys of the first dictionary to join, sorted
+    [[nodiscard]] std::vector<KeyType> keys_to_join () const;
+
+    /// @return join results for [@p begin, @p end) of @p keys
+    [[nodiscard]] KeyResults join_keys (const std::vector<KeyType> &keys,
+                                        std::size_t begin,
+                                        std::size_t end) const;
+
+    std::tuple<const Dicts *...> m_dicts;
+    std::optional<std::vector<KeyType>> m_keys;
+    IntervalType m_query_interval;
+  };
+
+  /// Starts a JoinPipeline from @p a_to_b
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  JoinPipeline<IntervalDictExp<Key, Value, Interval, Impl>>
+  chain (const IntervalDictExp<Key, Value, Interval, Impl> &a_to_b)
+  {
+    return JoinPipeline<IntervalDictExp<Key, Value, Interval, Impl>> (
+      std::tuple {&a_to_b});
+  }
+
+  /*
+   * _____________________________________________________________________________
+   *
+   * Implementation
+   *
+   */
+
+  template<typename... Dicts>
+  JoinPipeline<Dicts...>::JoinPipeline (
+    std::tuple<const Dicts *...> dicts,
+    std::optional<std::vector<KeyType>> keys,
+    IntervalType query_interval)
+    : m_dicts (std::move (dicts))
+    , m_keys (std::move (keys))
+    , m_query_interval (query_interval)
+  {
+  }
+
+  template<typename... Dicts>
+  template<typename Next>
+    requires std::same_as<typename Next::KeyType,
+                          typename JoinPipeline<Dicts...>::ValType>
+             && std::same_as<typename Next::IntervalType,
+                             typename JoinPipeline<Dicts...>::IntervalType>
+  JoinPipeline<Dicts..., Next>
+  JoinPipeline<Dicts...>::join (const Next &next) const
+  {
+    return JoinPipeline<Dicts..., Next> (
+      std::tuple_cat (m_dicts, std::tuple {&next}), m_keys, m_query_interval);
+  }
+
+  template<typename... Dicts>
+  template<typename KeyRange>
+  JoinPipeline<Dicts...>
+  JoinPipeline<Dicts...>::restrict_keys (const KeyRange &keys) const
+  {
+    std::vector<KeyType> sorted_keys (std::begin (keys), std::end (keys));
+    std::ranges::sort (sorted_keys);
+    const auto [first, last] = std::ranges::unique (sorted_keys);
+    sorted_keys.erase (first, last);
+    if (m_keys)
+    {
+      std::vector<KeyType> common_keys;
+      std::ranges::set_intersection (
+        *m_keys, sorted_keys, std::back_inserter (common_keys));
+      sorted_keys = std::move (common_keys);
+    }
+    return JoinPipeline (m_dicts, std::move (sorted_keys), m_query_interval);
+  }
+
+  template<typename... Dicts>
+  JoinPipeline<Dicts...> JoinPipeline<Dicts...>::restrict_interval (
+    const IntervalType &query_interval) const
+  {
+    return JoinPipeline (m_dicts, m_keys, m_query_interval & query_interval);
+  }
+
+  template<typename... Dicts>
+  template<std::size_t Hop, typename Value>
+  void JoinPipeline<Dicts...>::probe (const Value &value,
+                                      const IntervalType &interval,
+                                      ResultImpl &results) const
+  {
+    if constexpr (Hop == sizeof...(Dicts))
+    {
+      ResultImplementation::insert (results, interval, value);
+    }
+    else
+    {
+      // Intervals of the next hop overlapping the intervals so far
+      for (const auto &[_, next_value, next_interval] :
+           intervals (*std::get<Hop> (m_dicts), value, interval))
+      {
+        probe<Hop + 1> (next_value, interval & next_interval, results);
+      }
+    }
+  }
+
+  template<typename... Dicts>
+  std::vector<typename JoinPipeline<Dicts...>::KeyType>
+  JoinPipeline<Dicts...>::keys_to_join () const
+  {
+    const auto &first = *std::get<0> (m_dicts);
+    if (!m_keys)
+    {
+      return first.keys ();
+    }
+    std::vector<KeyType> keys;
+    std::ranges::copy_if (*m_keys,
+                          std::back_inserter (keys),
+                          [&first] (const KeyType &key)
+                          { return first.contains (key); });
+    return keys;
+  }
+
+  template<typename... Dicts>
+  typename JoinPipeline<Dicts...>::KeyResults
+  JoinPipeline<Dicts...>::join_keys (const std::vector<KeyType> &keys,
+                                     std::size_t begin,
+                                     std::size_t end) const
+  {
+    KeyResults results;
+    for (auto ii = begin; ii != end; ++ii)
+    {
+      ResultImpl interval_values;
+      probe<0> (keys[ii], m_query_interval, interval_values);
+      if (!ResultImplementation::empty (interval_values))
+      {
+        results.emplace_back (keys[ii], std::move (interval_values));
+      }
+    }
+    return results;
+  }
+
+  template<typename... Dicts>
+  typename JoinPipeline<Dicts...>::ResultType
+  JoinPipeline<Dicts...>::materialize (std::size_t count_threads) const
+  {
+    const auto keys = keys_to_join ();
+    const auto count_partitions = std::max<std::size_t> (
+      1,
+      std::min (count_threads, keys.size () / min_count_keys_per_join_thread));
+
+    // Contiguous partitions of keys, the first joined on this thread
+    std::vector<KeyResults> partition_results (count_partitions);
+    std::vector<std::exception_ptr> errors (count_partitions);
+    const auto join_partition = [&] (std::size_t partition)
+    {
+      try
+      {
+        partition_results[partition]
+          = join_keys (keys,
+                       keys.size () * partition / count_partitions,
+                       keys.size () * (partition + 1) / count_partitions);
+      }
+      catch (...)
+      {
+        errors[partition] = std::current_exception ();
+      }
+    };
+    {
+      std::vector<std::jthread> workers;
+      for (std::size_t partition = 1; partition < count_partitions;
+           ++partition)
+      {
+        workers.emplace_back (join_partition, partition);
+      }
+      join_partition (0);
+    }
+    for (const auto &error : errors)
+    {
+      if (error)
+      {
+        std::rethrow_exception (error);
+      }
+    }
+
+    const auto &first = *std::get<0> (m_dicts);
+    typename ResultType::DataType return_data (
+      typename ResultType::AllocatorType (first.get_allocator ()));
+    for (auto &results : partition_results)
+    {
+      for (auto &[key, interval_values] : results)
+      {
+        // Keys are already sorted
+        return_data.emplace_hint (
+          return_data.end (), key, std::move (interval_values));
+      }
+    }
+    return ResultType (std::move (return_data));
+  }
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_JOIN_PIPELINE_H
@@ -0,0 +1,417 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file joined_view.h
+/// \brief Lazy view of A -> C through dictionaries A -> B and B -> C
+///
+/// `a_to_b.joined_to (b_to_c)` builds the whole A -> C dictionary even if only
+/// a few keys are looked up afterwards. JoinedView instead answers find(),
+/// intervals() and disjoint_intervals() for each key on demand: it queries
+/// A -> B for the key, and probes B -> C for each overlapping value. The work
+/// done is proportional to the keys queried rather than to the dictionary.
+///
+/// The B -> C interval-values of recently probed values can be kept in a
+/// bounded least-recently-used cache. This pays off when many keys of A map to
+/// the same values of B.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_JOINED_VIEW_H
+#define INCLUDE_INTERVAL_DICT_JOINED_VIEW_H
+
+#include "adaptor_icl_interval_map.h"
+#include "interval_compare.h"
+#include "intervaldict.h"
+#include "value_interval.h"
+
+#include <cppcoro/generator.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace interval_dict
+{
+  /**
+   * @brief Read-only view of A -> C as if from `a_to_b.joined_to (b_to_c)`
+   *
+   * Holds references to both dictionaries, which must outlive the view. If
+   * @p b_to_c is modified while the cache is in use, call clear_cache().
+   *
+   * Queries update the cache, so a view with a cache must not be shared
+   * between threads without a lock.
+   *
+   * @tparam AToB IntervalDictExp type mapping A -> B
+   * @tparam BToC IntervalDictExp type mapping B -> C
+   */
+  template<typename AToB, typename BToC> class JoinedView
+  {
+    public:
+    /// @cond Suppress_Doxygen_Warning
+    using KeyType = typename AToB::KeyType;
+    using ValType = typename BToC::ValType;
+    using IntervalType = typename AToB::IntervalType;
+    using BaseType = typename AToB::BaseType;
+    using JoinType = typename BToC::KeyType;
+    /// @endcond
+
+    /// View of @p a_to_b joined to @p b_to_c
+    /// \param cache_capacity Number of values of B whose B -> C
+    /// interval-values are cached. Defaults to no cache
+    JoinedView (const AToB &a_to_b,
+                const BToC &b_to_c,
+                std::size_t cache_capacity = 0);
+
+    /// Returns all mapped values in a sorted list for the specified @p key on
+    /// the given query interval
+    [[nodiscard]] std::vector<ValType>
+    find (const KeyType &key,
+          IntervalType query_interval = interval_extent<IntervalType>) const;
+
+    /// Returns all mapped values in a sorted list for the specified @p key at
+    /// @p query
+    [[nodiscard]] std::vector<ValType> find (const KeyType &key,
+                                             BaseType query) const;
+
+    /// Returns all mapped values in a sorted list for the specified @p keys on
+    /// the given query interval
+    [[nodiscard]] std::vector<ValType>
+    find (const std::vector<KeyType> &keys,
+          IntervalType query_interval = interval_extent<IntervalType>) const;
+
+    /// Return all keys of A -> B in sorted order
+    [[nodiscard]] std::vector<KeyType> keys () const;
+
+    /// @return the number of values of B whose interval-values are cached
+    [[nodiscard]] std::size_t count_cached () const
+    {
+      return m_cache_index.size ();
+    }
+
+    /// @return number of probes of B -> C answered from the cache
+    [[nodiscard]] std::size_t count_cache_hits () const
+    {
+      return m_count_cache_hits;
+    }
+
+    /// @return number of probes of B -> C not answered from the cache
+    [[nodiscard]] std::size_t count_cache_misses () const
+    {
+      return m_count_cache_misses;
+    }
+
+    /// Discard cached interval-values, for example after @p b_to_c is modified
+    void clear_cache ();
+
+    /// @return coroutine enumerating the A -> C key-value-intervals for @p key
+    /// overlapping @p query_interval. Each is the intersection of an A -> B
+    /// interval with a B -> C interval, and they are not combined
+    cppcoro::generator<KeyValueInterval<KeyType, ValType, IntervalType>>
+    intervals (std::vector<KeyType> keys, IntervalType query_interval) const;
+
+    /// @return coroutine enumerating the disjoint A -> C intervals and their
+    /// values for @p keys, over @p query_interval
+    cppcoro::generator<
+      KeyValuesDisjointInterval<KeyType, ValType, IntervalType>>
+    disjoint_intervals (std::vector<KeyType> keys,
+                        IntervalType query_interval) const;
+
+    private:
+    using CValueIntervals = ValueIntervals<ValType, IntervalType>;
+    using CacheEntries = std::list<std::pair<JoinType, CValueIntervals>>;
+    using DisjointMap
+      = implementation::IntervalDictICLSubMap<ValType, IntervalType>;
+    using DisjointImplementation
+      = Implementation<ValType, IntervalType, DisjointMap>;
+
+    /// Call @p visit with each value of C and the intersection of the A -> B
+    /// and B -> C intervals, for @p key over @p query_interval
+    template<typename Visitor>
+    void for_each_joined (const KeyType &key,
+                          const IntervalType &query_interval,
+                          Visitor visit) const;
+
+    /// @return the B -> C interval-values for @p value_b, from the cache if
+    /// possible
+    const CValueIntervals &cached_slice (const JoinType &value_b) const;
+
+    const AToB &m_a_to_b;
+    const BToC &m_b_to_c;
+    std::size_t m_cache_capacity;
+
+    /// Most recently used first
+    mutable CacheEntries m_cache;
+    mutable std::map<JoinType, typename CacheEntries::iterator> m_cache_index;
+    mutable std::size_t m_count_cache_hits = 0;
+    mutable std::size_t m_count_cache_misses = 0;
+  };
+
+  /// Returns a lazy view of @p a_to_b joined to @p b_to_c, without
+  /// materialising the A -> C dictionary. See JoinedView
+  /// \param cache_capacity Number of values of B whose B -> C interval-values
+  /// are cached. Defaults to no cache
+  template<typename A,
+           typename B,
+           typename C,
+           typename Interval,
+           typename ImplAB,
+           typename ImplBC>
+  JoinedView<IntervalDictExp<A, B, Interval, ImplAB>,
+             IntervalDictExp<B, C, Interval, ImplBC>>
+  join_view (const IntervalDictExp<A, B, Interval, ImplAB> &a_to_b,
+             const IntervalDictExp<B, C, Interval, ImplBC> &b_to_c,
+             std::size_t cache_capacity = 0)
+  {
+    return {a_to_b, b_to_c, cache_capacity};
+  }
+
+  /// Joined intervals for the specified @p key. See JoinedView::intervals()
+  template<typename AToB, typename BToC>
+  cppcoro::generator<KeyValueInterval<typename AToB::KeyType,
+                                      typename BToC::ValType,
+                                      typename AToB::IntervalType>>
+  intervals (const JoinedView<AToB, BToC> &joined_view,
+             const typename AToB::KeyType &key,
+             typename AToB::IntervalType query_interval
+             = interval_extent<typename AToB::IntervalType>)
+  {
+    return joined_view.intervals (std::vector {key}, query_interval);
+  }
+
+  /// Joined intervals for the specified @p keys. See JoinedView::intervals()
+  template<typename AToB, typename BToC>
+  cppcoro::generator<KeyValueInterval<typename AToB::KeyType,
+                                      typename BToC::ValType,
+                                      typename AToB::IntervalType>>
+  intervals (const JoinedView<AToB, BToC> &joined_view,
+             std::vector<typename AToB::KeyType> keys,
+             typename AToB::IntervalType query_interval
+             = interval_extent<typename AToB::IntervalType>)
+  {
+    return joined_view.intervals (std::move (keys), query_interval);
+  }
+
+  /// Disjoint joined intervals for the specified @p key. See
+  /// JoinedView::disjoint_intervals()
+  template<typename AToB, typename BToC>
+  cppcoro::generator<KeyValuesDisjointInterval<typename AToB::KeyType,
+                                               typename BToC::ValType,
+                                               typename AToB::IntervalType>>
+  disjoint_intervals (const JoinedView<AToB, BToC> &joined_view,
+                      const typename AToB::KeyType &key,
+                      typename AToB::IntervalType query_interval
+                      = interval_extent<typename AToB::IntervalType>)
+  {
+    return joined_view.disjoint_intervals (std::vector {key}, query_interval);
+  }
+
+  /// Disjoint joined intervals for the specified @p keys. See
+  /// JoinedView::disjoint_intervals()
+  template<typename AToB, typename BToC>
+  cppcoro::generator<KeyValuesDisjointInterval<typename AToB::KeyType,
+                                               typename BToC::ValType,
+                                               typename AToB::IntervalType>>
+  disjoint_intervals (const JoinedView<AToB, BToC> &joined_view,
+                      std::vector<typename AToB::KeyType> keys,
+                      typename AToB::IntervalType query_interval
+                      = interval_extent<typename AToB::IntervalType>)
+  {
+    return joined_view.disjoint_intervals (std::move (keys), query_interval);
+  }
+
+  /*
+   * _____________________________________________________________________________
+   *
+   * Implementation
+   *
+   */
+
+  template<typename AToB, typename BToC>
+  JoinedView<AToB, BToC>::JoinedView (const AToB &a_to_b,
+                                      const BToC &b_to_c,
+                                      std::size_t cache_capacity)
+    : m_a_to_b (a_to_b)
+    , m_b_to_c (b_to_c)
+    , m_cache_capacity (cache_capacity)
+  {
+  }
+
+  template<typename AToB, typename BToC>
+  void JoinedView<AToB, BToC>::clear_cache ()
+  {
+    m_cache.clear ();
+    m_cache_index.clear ();
+  }
+
+  template<typename AToB, typename BToC>
+  const typename JoinedView<AToB, BToC>::CValueIntervals &
+  JoinedView<AToB, BToC>::cached_slice (const JoinType &value_b) const
+  {
+    if (const auto ff = m_cache_index.find (value_b);
+        ff != m_cache_index.end ())
+    {
+      ++m_count_cache_hits;
+      // Move to the front as most recently used
+      m_cache.splice (m_cache.begin (), m_cache, ff->second);
+      return ff->second->second;
+    }
+    ++m_count_cache_misses;
+    if (m_cache_index.size () == m_cache_capacity)
+    {
+      m_cache_index.erase (m_cache.back ().first);
+      m_cache.pop_back ();
+    }
+    CValueIntervals slice;
+    for (const auto &[_, value_c, interval_bc] : interval_dict::intervals (
+           m_b_to_c, value_b, interval_extent<IntervalType>))
+    {
+      slice.emplace_back (value_c, interval_bc);
+    }
+    m_cache.emplace_front (value_b, std::move (slice));
+    m_cache_index.emplace (value_b, m_cache.begin ());
+    return m_cache.front ().second;
+  }
+
+  template<typename AToB, typename BToC>
+  template<typename Visitor>
+  void JoinedView<AToB, BToC>::for_each_joined (
+    const KeyType &key, const IntervalType &query_interval, Visitor visit) const
+  {
+    if (boost::icl::is_empty (query_interval))
+    {
+      return;
+    }
+    for (const auto &[_, value_b, interval_ab] :
+         interval_dict::intervals (m_a_to_b, key, query_interval))
+    {
+      // B -> C intervals overlapping this part of the query
+      const auto probe = interval_ab & query_interval;
+      if (m_cache_capacity == 0)
+      {
+        for (const auto &[_, value_c, interval_bc] :
+             interval_dict::intervals (m_b_to_c, value_b, probe))
+        {
+          visit (value_c, interval_ab & interval_bc);
+        }
+        continue;
+      }
+      for (const auto &[value_c, interval_bc] : cached_slice (value_b))
+      {
+        if (comparisons::intersects (interval_bc, probe))
+        {
+          visit (value_c, interval_ab & interval_bc);
+        }
+      }
+    }
+  }
+
+  template<typename AToB, typename BToC>
+  std::vector<typename JoinedView<AToB, BToC>::ValType>
+  JoinedView<AToB, BToC>::find (const std::vector<KeyType> &keys,
+                                IntervalType query_interval) const
+  {
+    std::set<ValType> unique_results;
+    for (const auto &key : keys)
+    {
+      for_each_joined (key,
+                       query_interval,
+                       [&unique_results] (const ValType &value_c,
+                                          const IntervalType &)
+                       { unique_results.insert (value_c); });
+    }
+    return {unique_results.begin (), unique_results.end ()};
+  }
+
+  template<typename AToB, typename BToC>
+  std::vector<typename JoinedView<AToB, BToC>::ValType>
+  JoinedView<AToB, BToC>::find (const KeyType &key,
+                                IntervalType query_interval) const
+  {
+    return find (std::vector {key}, query_interval);
+  }
+
+  template<typename AToB, typename BToC>
+  std::vector<typename JoinedView<AToB, BToC>::ValType>
+  JoinedView<AToB, BToC>::find (const KeyType &key, BaseType query) const
+  {
+    return find (key, IntervalType {query, query});
+  }
+
+  template<typename AToB, typename BToC>
+  std::vector<typename JoinedView<AToB, BToC>::KeyType>
+  JoinedView<AToB, BToC>::keys () const
+  {
+    return m_a_to_b.keys ();
+  }
+
+  template<typename AToB, typename BToC>
+  cppcoro::generator<KeyValueInterval<typename AToB::KeyType,
+                                      typename BToC::ValType,
+                                      typename AToB::IntervalType>>
+  JoinedView<AToB, BToC>::intervals (std::vector<KeyType> keys,
+                                     IntervalType query_interval) const
+  {
+    // Return sorted by keys
+    std::ranges::sort (keys);
+    for (const auto &key : keys)
+    {
+      std::vector<KeyValueInterval<KeyType, ValType, IntervalType>> results;
+      for_each_joined (key,
+                       query_interval,
+                       [&results, &key] (const ValType &value_c,
+                                         const IntervalType &interval)
+                       { results.emplace_back (key, value_c, interval); });
+      for (auto &key_value_interval : results)
+      {
+        co_yield key_value_interval;
+      }
+    }
+  }
+
+  template<typename AToB, typename BToC>
+  cppcoro::generator<KeyValuesDisjointInterval<typename AToB::KeyType,
+                                               typename BToC::ValType,
+                                               typename AToB::IntervalType>>
+  JoinedView<AToB, BToC>::disjoint_intervals (std::vector<KeyType> keys,
+                                              IntervalType query_interval) const
+  {
+    // Return sorted by keys
+    std::ranges::sort (keys);
+    for (const auto &key : keys)
+    {
+      // Combine the joined intervals as if inserted into a dictionary
+      DisjointMap disjoint;
+      for_each_joined (key,
+                       query_interval,
+                       [&disjoint] (const ValType &value_c,
+                                    const IntervalType &interval)
+                       {
+                         DisjointImplementation::insert (
+                           disjoint, interval, value_c);
+                       });
+      for (const auto &[values, interval] :
+           DisjointImplementation::disjoint_intervals (disjoint,
+                                                       query_interval))
+      {
+        co_yield KeyValuesDisjointInterval<KeyType, ValType, IntervalType> {
+          key, values, interval};
+      }
+    }
+  }
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_JOINED_VIEW_H
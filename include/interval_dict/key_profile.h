@@ -0,0 +1,406 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file key_profile.h
+/// \brief Profile the shape of intervals per key and recommend an
+/// implementation
+///
+/// profile() summarises, for each key, the number of intervals, how many
+/// successive intervals each overlaps (see CountOverlap), how deeply they
+/// nest, the number of distinct values and how close to time order they
+/// were inserted.
+///
+/// It then builds ICL, ITree, AIL and hybrid dictionaries from a sample of
+/// keys and times inserts and find() queries to estimate the cost of each
+/// operation for each implementation.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_KEY_PROFILE_H
+#define INCLUDE_INTERVAL_DICT_KEY_PROFILE_H
+
+#include "intervaldictail.h"
+#include "intervaldicthybrid.h"
+#include "intervaldicticl.h"
+#include "intervaldictitree.h"
+#include "interval_compare.h"
+#include "interval_overlaps.h"
+#include "memory_usage.h"
+#include "value_interval.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace interval_dict
+{
+  /// Shape of the intervals for a single key
+  struct KeyProfile
+  {
+    std::size_t count_intervals = 0;
+
+    /// Distinct values
+    std::size_t count_values = 0;
+
+    /// Number of intervals binned by how many subsequent intervals each
+    /// overlaps, in powers of 2: log2_overlaps[i] counts [2^(i-1), 2^i)
+    std::array<std::size_t, 32> log2_overlaps {};
+    std::size_t max_overlaps = 0;
+    double mean_overlaps = 0.0;
+
+    /// Largest number of intervals enclosing any other interval
+    std::size_t max_nesting_depth = 0;
+
+    /// Fraction of intervals inserted after one with an earlier or equal
+    /// start. 1.0 for streams appended in time order
+    double fraction_in_order = 1.0;
+  };
+
+  /// Expected cost of each operation for one implementation
+  struct BackendCost
+  {
+    std::string backend;
+    double ns_per_insert = 0.0;
+    double ns_per_query = 0.0;
+    std::size_t bytes = 0;
+  };
+
+  /// Options for profile()
+  struct ProfileOptions
+  {
+    /// Keys used to time each implementation. The key with the most
+    /// intervals is always included
+    std::size_t count_sampled_keys = 32;
+
+    /// find() queries timed for each sampled key
+    std::size_t count_queries_per_key = 100;
+
+    /// Expected proportion of queries versus inserts in the workload
+    double query_fraction = 0.9;
+
+    /// Seed for sampling keys and queries
+    unsigned seed = 0;
+  };
+
+  /// Profile of a dictionary or batch of inserts
+  template<typename Key> struct DatasetProfile
+  {
+    /// Each key
+    std::map<Key, KeyProfile> keys;
+
+    std::size_t count_intervals = 0;
+
+    /// Number of keys binned by count of intervals, in powers of 2
+    std::array<std::size_t, 32> log2_intervals_per_key {};
+
+    /// Measured costs ordered from cheapest to most expensive for the
+    /// proportion of queries in ProfileOptions
+    std::vector<BackendCost> costs;
+
+    /// Name of the cheapest implementation
+    std::string recommended;
+  };
+
+  /// @return the shape of @p value_intervals, which are in insertion order
+  template<typename Value, typename Interval>
+  KeyProfile
+  profile_key (const ValueIntervals<Value, Interval> &value_intervals)
+  {
+    KeyProfile profile;
+    profile.count_intervals = value_intervals.size ();
+    if (value_intervals.empty ())
+    {
+      return profile;
+    }
+
+    std::set<Value> values;
+    std::size_t count_in_order = 0;
+    for (std::size_t i = 0; i < value_intervals.size (); ++i)
+    {
+      values.insert (value_intervals[i].value);
+      if (i > 0
+          && !(comparisons::lower_edge (value_intervals[i].interval)
+               < comparisons::lower_edge (value_intervals[i - 1].interval)))
+      {
+        ++count_in_order;
+      }
+    }
+    profile.count_values = values.size ();
+    if (value_intervals.size () > 1)
+    {
+      profile.fraction_in_order
+        = static_cast<double> (count_in_order) / (value_intervals.size () - 1);
+    }
+
+    // CountOverlap expects intervals sorted by start
+    auto sorted = value_intervals;
+    std::ranges::sort (sorted, comparisons::CompareInterval {});
+    CountOverlap<Interval> overlap_counter;
+    overlap_counter.update (sorted);
+    std::size_t total_overlaps = 0;
+    for (const auto count : overlap_counter.m_counts)
+    {
+      const auto overlaps
+        = static_cast<std::size_t> (std::max<int_fast32_t> (count, 0));
+      ++profile.log2_overlaps[details::log2_bin (
+        overlaps, profile.log2_overlaps.size ())];
+      profile.max_overlaps = std::max (profile.max_overlaps, overlaps);
+      total_overlaps += overlaps;
+    }
+    profile.mean_overlaps
+      = static_cast<double> (total_overlaps) / sorted.size ();
+
+    // Sorted by start, then longest first: the intervals still on the stack
+    // enclose the current one
+    using BaseType = typename ValueInterval<Value, Interval>::BaseType;
+    std::vector<std::tuple<BaseType, BaseType>> edges;
+    edges.reserve (sorted.size ());
+    for (const auto &[value, interval] : sorted)
+    {
+      edges.emplace_back (comparisons::lower_edge (interval),
+                          comparisons::upper_edge (interval));
+    }
+    std::ranges::sort (edges,
+                       [] (const auto &lhs, const auto &rhs)
+                       {
+                         return std::get<0> (lhs) < std::get<0> (rhs)
+                                || (std::get<0> (lhs) == std::get<0> (rhs)
+                                    && std::get<1> (rhs) < std::get<1> (lhs));
+                       });
+    std::vector<BaseType> enclosing_ends;
+    for (const auto &[begin, end] : edges)
+    {
+      while (!enclosing_ends.empty () && enclosing_ends.back () < end)
+      {
+        enclosing_ends.pop_back ();
+      }
+      profile.max_nesting_depth
+        = std::max (profile.max_nesting_depth, enclosing_ends.size ());
+      enclosing_ends.push_back (end);
+    }
+    return profile;
+  }
+
+  /// @cond Suppress_Doxygen_Warning
+  namespace details
+  {
+    /// Time building and querying a single key dictionary of type @p Dict
+    /// from each sample
+    template<typename Dict, typename Value, typename Interval>
+    BackendCost
+    probe_backend (std::string backend,
+                   const std::vector<ValueIntervals<Value, Interval>> &samples,
+                   const std::vector<std::vector<Interval>> &queries)
+    {
+      using Clock = std::chrono::steady_clock;
+      BackendCost cost {.backend = std::move (backend)};
+      std::int64_t insert_ns = 0;
+      std::int64_t query_ns = 0;
+      std::size_t count_inserts = 0;
+      std::size_t count_queries = 0;
+      std::size_t count_found = 0;
+      for (std::size_t i = 0; i < samples.size (); ++i)
+      {
+        std::vector<std::tuple<int, Value, Interval>> key_value_intervals;
+        key_value_intervals.reserve (samples[i].size ());
+        for (const auto &[value, interval] : samples[i])
+        {
+          key_value_intervals.emplace_back (0, value, interval);
+        }
+
+        Dict dict;
+        const auto insert_start = Clock::now ();
+        dict.insert (key_value_intervals);
+        insert_ns += std::chrono::duration_cast<std::chrono::nanoseconds> (
+                       Clock::now () - insert_start)
+                       .count ();
+        count_inserts += key_value_intervals.size ();
+
+        const auto query_start = Clock::now ();
+        for (const auto &query : queries[i])
+        {
+          count_found += dict.find (0, query).size ();
+        }
+        query_ns += std::chrono::duration_cast<std::chrono::nanoseconds> (
+                      Clock::now () - query_start)
+                      .count ();
+        count_queries += queries[i].size ();
+        cost.bytes += dict.memory_usage (0).total ();
+      }
+      // Keep the queries from being optimised away
+      [[maybe_unused]] static volatile std::size_t sink;
+      sink = count_found;
+
+      cost.ns_per_insert
+        = count_inserts ? static_cast<double> (insert_ns) / count_inserts : 0;
+      cost.ns_per_query
+        = count_queries ? static_cast<double> (query_ns) / count_queries : 0;
+      return cost;
+    }
+  } // namespace details
+  /// @endcond
+
+  /// Profile a batch of [key-value-interval]s in insertion order
+  /// \param key_value_intervals Intervals as they would be inserted
+  /// \param options Sampling and workload for timing implementations
+  template<typename Key, typename Value, typename Interval>
+  DatasetProfile<Key>
+  profile (const std::vector<std::tuple<Key, Value, Interval>>
+             &key_value_intervals,
+           const ProfileOptions &options = {})
+  {
+    DatasetProfile<Key> results;
+
+    // Group by key preserving insertion order
+    std::map<Key, ValueIntervals<Value, Interval>> intervals_per_key;
+    for (const auto &[key, value, interval] : key_value_intervals)
+    {
+      if (!boost::icl::is_empty (interval))
+      {
+        intervals_per_key[key].emplace_back (value, interval);
+      }
+    }
+    if (intervals_per_key.empty ())
+    {
+      return results;
+    }
+
+    const Key *heaviest_key = &intervals_per_key.begin ()->first;
+    std::size_t max_intervals = 0;
+    std::vector<const Key *> all_keys;
+    for (const auto &[key, value_intervals] : intervals_per_key)
+    {
+      results.keys.emplace (key, profile_key (value_intervals));
+      results.count_intervals += value_intervals.size ();
+      ++results.log2_intervals_per_key[details::log2_bin (
+        value_intervals.size (), results.log2_intervals_per_key.size ())];
+      if (value_intervals.size () > max_intervals)
+      {
+        max_intervals = value_intervals.size ();
+        heaviest_key = &key;
+      }
+      all_keys.push_back (&key);
+    }
+
+    // Sample keys and query intervals
+    std::mt19937 random_generator (options.seed);
+    std::vector<const Key *> sampled_keys {heaviest_key};
+    std::erase (all_keys, heaviest_key);
+    std::ranges::sample (all_keys,
+                         std::back_inserter (sampled_keys),
+                         options.count_sampled_keys
+                           ? options.count_sampled_keys - 1
+                           : 0,
+                         random_generator);
+    std::vector<ValueIntervals<Value, Interval>> samples;
+    std::vector<std::vector<Interval>> queries;
+    for (const auto *key : sampled_keys)
+    {
+      const auto &value_intervals = intervals_per_key.at (*key);
+      samples.push_back (value_intervals);
+      std::uniform_int_distribution<std::size_t> pick (
+        0, value_intervals.size () - 1);
+      auto &key_queries = queries.emplace_back ();
+      for (std::size_t i = 0; i < options.count_queries_per_key; ++i)
+      {
+        key_queries.push_back (
+          value_intervals[pick (random_generator)].interval);
+      }
+    }
+
+    results.costs = {
+      details::probe_backend<IntervalDictICLExp<int, Value, Interval>> (
+        "ICL", samples, queries),
+      details::probe_backend<IntervalDictITreeExp<int, Value, Interval>> (
+        "ITree", samples, queries),
+      details::probe_backend<IntervalDictAILExp<int, Value, Interval>> (
+        "AIL", samples, queries),
+      details::probe_backend<IntervalDictHybridExp<int, Value, Interval>> (
+        "Hybrid", samples, queries)};
+    const auto weighted_cost = [&options] (const BackendCost &cost)
+    {
+      return options.query_fraction * cost.ns_per_query
+             + (1.0 - options.query_fraction) * cost.ns_per_insert;
+    };
+    std::ranges::sort (results.costs,
+                       [&weighted_cost] (const auto &lhs, const auto &rhs)
+                       {
+                         return weighted_cost (lhs) < weighted_cost (rhs);
+                       });
+    results.recommended = results.costs.front ().backend;
+    return results;
+  }
+
+  /// Profile the intervals already in @p interval_dict
+  /// Insertion order is not known so intervals are taken in sorted order
+  template<typename Key, typename Value, typename Interval, typename Impl>
+  DatasetProfile<Key>
+  profile (const IntervalDictExp<Key, Value, Interval, Impl> &interval_dict,
+           const ProfileOptions &options = {})
+  {
+    std::vector<std::tuple<Key, Value, Interval>> key_value_intervals;
+    for (const auto &key_value_interval : intervals (interval_dict))
+    {
+      key_value_intervals.push_back (key_value_interval);
+    }
+    return profile (key_value_intervals, options);
+  }
+
+  /// Streaming operator for DatasetProfile
+  template<typename Key>
+  std::ostream &operator<< (std::ostream &os,
+                            const DatasetProfile<Key> &dataset_profile)
+  {
+    std::size_t max_overlaps = 0;
+    std::size_t max_nesting_depth = 0;
+    double fraction_in_order = 0.0;
+    for (const auto &[key, key_profile] : dataset_profile.keys)
+    {
+      max_overlaps = std::max (max_overlaps, key_profile.max_overlaps);
+      max_nesting_depth
+        = std::max (max_nesting_depth, key_profile.max_nesting_depth);
+      fraction_in_order += key_profile.fraction_in_order;
+    }
+    if (!dataset_profile.keys.empty ())
+    {
+      fraction_in_order /= dataset_profile.keys.size ();
+    }
+
+    os << "keys: " << dataset_profile.keys.size () << "\n"
+       << "intervals: " << dataset_profile.count_intervals << "\n"
+       << "log2 intervals per key:";
+    for (const auto count : dataset_profile.log2_intervals_per_key)
+    {
+      os << " " << count;
+    }
+    os << "\nmax overlaps: " << max_overlaps << "\n"
+       << "max nesting depth: " << max_nesting_depth << "\n"
+       << "mean fraction in order: " << fraction_in_order << "\n";
+    for (const auto &cost : dataset_profile.costs)
+    {
+      os << cost.backend << ": " << cost.ns_per_insert << " ns/insert "
+         << cost.ns_per_query << " ns/query " << cost.bytes << " bytes\n";
+    }
+    os << "recommended: " << dataset_profile.recommended << "\n";
+    return os;
+  }
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_KEY_PROFILE_H
@@ -0,0 +1,263 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file maintained_join.h
+/// \brief Keeping A -> C = A -> B joined to B -> C up to date as A -> B and
+/// B -> C change
+///
+/// Joins are pointwise in time: the values of A -> C for a key over an
+/// interval only depend on A -> B for that key over that interval, and on
+/// B -> C for the values it maps to. Small changes to either input therefore
+/// only need the join to be recomputed for a few keys over a few intervals:
+///
+/// - A change to A -> B for key `a` over interval `I` affects `a` over `I`.
+/// - A change to B -> C for value `b` over `I` affects every key that A -> B
+///   maps to `b` during `I`. These are found with the inverse of A -> B, which
+///   must therefore be a BiIntervalDictExp.
+///
+/// The affected intervals of each key are combined, erased from A -> C, and
+/// joined afresh. Changes are received by observing both inputs (see
+/// change_feed.h).
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_MAINTAINED_JOIN_H
+#define INCLUDE_INTERVAL_DICT_MAINTAINED_JOIN_H
+
+#include "bi_intervaldict.h"
+#include "intervaldict.h"
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace interval_dict
+{
+  /**
+   * @brief A -> C joined from A -> B and B -> C, updated incrementally
+   *
+   * Observes both inputs, which must outlive it, and updates A -> C after
+   * each change to either.
+   *
+   * @tparam AToB BiIntervalDictExp type mapping A -> B
+   * @tparam BToC IntervalDictExp or BiIntervalDictExp type mapping B -> C
+   */
+  template<typename AToB, typename BToC> class MaintainedJoin
+  {
+    public:
+    /// @cond Suppress_Doxygen_Warning
+    using KeyType = typename AToB::KeyType;
+    using JoinType = typename AToB::ValType;
+    using ValType = typename BToC::ValType;
+    using IntervalType = typename AToB::IntervalType;
+    using Intervals = interval_dict::Intervals<IntervalType>;
+    using ResultType
+      = IntervalDictExp<KeyType,
+                        ValType,
+                        IntervalType,
+                        typename AToB::template OtherImplType<ValType>>;
+    /// @endcond
+
+    /// Joins @p a_to_b to @p b_to_c and observes both for changes
+    MaintainedJoin (AToB &a_to_b, BToC &b_to_c);
+
+    MaintainedJoin (const MaintainedJoin &) = delete;
+    MaintainedJoin &operator= (const MaintainedJoin &) = delete;
+
+    /// Stops observing the inputs
+    ~MaintainedJoin ();
+
+    /// @return A -> C
+    [[nodiscard]] const ResultType &joined () const
+    {
+      return m_joined;
+    }
+
+    /// Update A -> C after the key-value-intervals of @p changes have been
+    /// inserted into or erased from A -> B. Changes made through A -> B
+    /// itself are already observed
+    void a_to_b_changed (
+      const std::vector<std::tuple<KeyType, JoinType, IntervalType>> &changes);
+
+    /// Update A -> C after any values of @p key_a have changed over
+    /// @p interval in A -> B
+    void a_to_b_changed (const KeyType &key_a,
+                         IntervalType interval
+                         = interval_extent<IntervalType>);
+
+    /// Update A -> C after the key-value-intervals of @p changes have been
+    /// inserted into or erased from B -> C. As for a_to_b_changed()
+    void b_to_c_changed (
+      const std::vector<std::tuple<JoinType, ValType, IntervalType>> &changes);
+
+    /// Update A -> C after any values of @p value_b have changed over
+    /// @p interval in B -> C
+    void b_to_c_changed (const JoinType &value_b,
+                         IntervalType interval
+                         = interval_extent<IntervalType>);
+
+    /// @return number of keys of A recomputed by the last update
+    [[nodiscard]] std::size_t count_keys_recomputed () const
+    {
+      return m_count_keys_recomputed;
+    }
+
+    private:
+    using AffectedIntervals = std::map<KeyType, Intervals>;
+
+    /// Add the keys of A mapping to @p value_b during @p interval to
+    /// @p affected
+    void add_affected_by_b (AffectedIntervals &affected,
+                            const JoinType &value_b,
+                            const IntervalType &interval) const;
+
+    /// Erase and rejoin each key of A over its intervals in @p affected
+    void recompute (const AffectedIntervals &affected);
+
+    AToB &m_a_to_b;
+    BToC &m_b_to_c;
+    ObserverId m_a_to_b_observer_id = 0;
+    ObserverId m_b_to_c_observer_id = 0;
+    ResultType m_joined;
+    std::size_t m_count_keys_recomputed = 0;
+  };
+
+  /*
+   * _____________________________________________________________________________
+   *
+   * Implementation
+   *
+   */
+
+  template<typename AToB, typename BToC>
+  MaintainedJoin<AToB, BToC>::MaintainedJoin (AToB &a_to_b, BToC &b_to_c)
+    : m_a_to_b (a_to_b)
+    , m_b_to_c (b_to_c)
+  {
+    AffectedIntervals affected;
+    for (const auto &key_a : m_a_to_b.keys ())
+    {
+      affected[key_a].add (interval_extent<IntervalType>);
+    }
+    recompute (affected);
+
+    m_a_to_b_observer_id = m_a_to_b.add_observer (
+      [this] (const typename AToB::ChangeBatchType &changes)
+      {
+        AffectedIntervals affected;
+        for (const auto &change : changes)
+        {
+          affected[change.key].add (change.interval);
+        }
+        recompute (affected);
+      });
+    m_b_to_c_observer_id = m_b_to_c.add_observer (
+      [this] (const typename BToC::ChangeBatchType &changes)
+      {
+        AffectedIntervals affected;
+        for (const auto &change : changes)
+        {
+          add_affected_by_b (affected, change.key, change.interval);
+        }
+        recompute (affected);
+      });
+  }
+
+  template<typename AToB, typename BToC>
+  MaintainedJoin<AToB, BToC>::~MaintainedJoin ()
+  {
+    m_a_to_b.remove_observer (m_a_to_b_observer_id);
+    m_b_to_c.remove_observer (m_b_to_c_observer_id);
+  }
+
+  template<typename AToB, typename BToC>
+  void MaintainedJoin<AToB, BToC>::add_affected_by_b (
+    AffectedIntervals &affected,
+    const JoinType &value_b,
+    const IntervalType &interval) const
+  {
+    for (const auto &key_a : m_a_to_b.inverse_find (value_b, interval))
+    {
+      affected[key_a].add (interval);
+    }
+  }
+
+  template<typename AToB, typename BToC>
+  void
+  MaintainedJoin<AToB, BToC>::recompute (const AffectedIntervals &affected)
+  {
+    std::vector<std::tuple<KeyType, ValType, IntervalType>> inserts;
+    for (const auto &[key_a, intervals_a] : affected)
+    {
+      for (const auto &interval : intervals_a)
+      {
+        m_joined.erase (key_a, interval);
+        for (const auto &[_, value_b, interval_ab] :
+             intervals (m_a_to_b, key_a, interval))
+        {
+          const auto probe = interval_ab & interval;
+          for (const auto &[_, value_c, interval_bc] :
+               intervals (m_b_to_c, value_b, probe))
+          {
+            inserts.emplace_back (key_a, value_c, probe & interval_bc);
+          }
+        }
+      }
+    }
+    m_joined.insert (inserts);
+    m_count_keys_recomputed = affected.size ();
+  }
+
+  template<typename AToB, typename BToC>
+  void MaintainedJoin<AToB, BToC>::a_to_b_changed (
+    const std::vector<std::tuple<KeyType, JoinType, IntervalType>> &changes)
+  {
+    AffectedIntervals affected;
+    for (const auto &[key_a, _, interval] : changes)
+    {
+      affected[key_a].add (interval);
+    }
+    recompute (affected);
+  }
+
+  template<typename AToB, typename BToC>
+  void MaintainedJoin<AToB, BToC>::a_to_b_changed (const KeyType &key_a,
+                                                   IntervalType interval)
+  {
+    AffectedIntervals affected;
+    affected[key_a].add (interval);
+    recompute (affected);
+  }
+
+  template<typename AToB, typename BToC>
+  void MaintainedJoin<AToB, BToC>::b_to_c_changed (
+    const std::vector<std::tuple<JoinType, ValType, IntervalType>> &changes)
+  {
+    AffectedIntervals affected;
+    for (const auto &[value_b, _, interval] : changes)
+    {
+      add_affected_by_b (affected, value_b, interval);
+    }
+    recompute (affected);
+  }
+
+  template<typename AToB, typename BToC>
+  void MaintainedJoin<AToB, BToC>::b_to_c_changed (const JoinType &value_b,
+                                                   IntervalType interval)
+  {
+    AffectedIntervals affected;
+    add_affected_by_b (affected, value_b, interval);
+    recompute (affected);
+  }
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_MAINTAINED_JOIN_H
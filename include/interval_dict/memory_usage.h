@@ -0,0 +1,153 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file memory_usage.h
+/// \brief Accounting of bytes used by IntervalDict implementations
+///
+/// Sizes are estimates: node-based containers are assumed to use the
+/// libstdc++ layout, and memory owned by the Key and Value types themselves
+/// (e.g. the heap buffer of a long std::string) is not included.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_MEMORY_USAGE_H
+#define INCLUDE_INTERVAL_DICT_MEMORY_USAGE_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace interval_dict
+{
+  /// Bytes used by the intervals for one or more keys
+  /// Categories that do not apply to an implementation remain zero.
+  struct MemoryUsage
+  {
+    /// Live values and intervals
+    std::size_t bytes_intervals = 0;
+
+    /// Augmented interval lists: erased intervals not yet removed
+    std::size_t bytes_tombstones = 0;
+
+    /// Augmented interval lists: cumulative maximum right edges
+    std::size_t bytes_scratch = 0;
+
+    /// Augmented interval lists: begin and end of each sorted run
+    std::size_t bytes_runs = 0;
+
+    /// Links and headers of node-based containers (std::map, std::set,
+    /// std::unordered_set)
+    std::size_t bytes_nodes = 0;
+
+    /// Interval trees: std::unordered_set bucket array
+    std::size_t bytes_hash_buckets = 0;
+
+    /// Interval trees: red-black and boost::intrusive hooks inside each node
+    std::size_t bytes_index = 0;
+
+    /// Allocated but unused std::vector capacity
+    std::size_t bytes_wasted_capacity = 0;
+
+    /// @return total of all categories
+    [[nodiscard]] std::size_t total () const
+    {
+      return bytes_intervals + bytes_tombstones + bytes_scratch + bytes_runs
+             + bytes_nodes + bytes_hash_buckets + bytes_index
+             + bytes_wasted_capacity;
+    }
+
+    MemoryUsage &operator+= (const MemoryUsage &other)
+    {
+      bytes_intervals += other.bytes_intervals;
+      bytes_tombstones += other.bytes_tombstones;
+      bytes_scratch += other.bytes_scratch;
+      bytes_runs += other.bytes_runs;
+      bytes_nodes += other.bytes_nodes;
+      bytes_hash_buckets += other.bytes_hash_buckets;
+      bytes_index += other.bytes_index;
+      bytes_wasted_capacity += other.bytes_wasted_capacity;
+      return *this;
+    }
+  };
+
+  /// Bytes used by an IntervalDict
+  template<typename Key> struct MemoryReport
+  {
+    /// All keys
+    MemoryUsage usage;
+
+    /// std::map from each key to its intervals
+    std::size_t bytes_keys = 0;
+
+    /// Number of keys binned by bytes used, in powers of 2:
+    /// log2_bytes_per_key[i] counts keys using [2^(i-1), 2^i) bytes
+    std::array<std::size_t, 64> log2_bytes_per_key {};
+
+    /// Keys using the most memory in descending order of bytes used
+    std::vector<std::pair<Key, std::size_t>> heaviest_keys;
+
+    /// @return total bytes
+    [[nodiscard]] std::size_t total () const
+    {
+      return usage.total () + bytes_keys;
+    }
+  };
+
+  /// @cond Suppress_Doxygen_Warning
+  namespace details
+  {
+    /// Colour, parent, left and right of a red-black tree node
+    inline constexpr std::size_t rb_tree_node_links = 4 * sizeof (void *);
+
+    /// Next pointer and cached hash of a std::unordered_set node
+    inline constexpr std::size_t hash_node_links = 2 * sizeof (void *);
+
+    /// Add the bytes used and unused by @p vec
+    template<typename T, typename Allocator>
+    void add_vector_usage (const std::vector<T, Allocator> &vec,
+                           std::size_t &bytes_used,
+                           MemoryUsage &usage)
+    {
+      bytes_used += vec.size () * sizeof (T);
+      usage.bytes_wasted_capacity
+        += (vec.capacity () - vec.size ()) * sizeof (T);
+    }
+
+    /// Bin @p bytes by powers of 2
+    inline std::size_t log2_bin (std::size_t bytes, std::size_t count_bins)
+    {
+      return std::min<std::size_t> (std::bit_width (bytes), count_bins - 1);
+    }
+  } // namespace details
+  /// @endcond
+
+  /// Streaming operator for MemoryUsage
+  inline std::ostream &operator<< (std::ostream &os, const MemoryUsage &usage)
+  {
+    os << "intervals: " << usage.bytes_intervals << "\n"
+       << "tombstones: " << usage.bytes_tombstones << "\n"
+       << "scratch: " << usage.bytes_scratch << "\n"
+       << "runs: " << usage.bytes_runs << "\n"
+       << "nodes: " << usage.bytes_nodes << "\n"
+       << "hash_buckets: " << usage.bytes_hash_buckets << "\n"
+       << "index: " << usage.bytes_index << "\n"
+       << "wasted_capacity: " << usage.bytes_wasted_capacity << "\n"
+       << "total: " << usage.total () << "\n";
+    return os;
+  }
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_MEMORY_USAGE_H
@@ -0,0 +1,717 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file partitioned_intervals.h
+/// \brief Intervals for a single key split into partitions of time, each
+/// held by a separate implementation
+///
+/// Long histories otherwise live in one augmented interval list or tree, so
+/// that correcting last week's data rebuilds or rebalances a structure holding
+/// years of intervals, and every query searches all of them.
+/// PartitionedIntervals instead keeps each interval that lies within a single
+/// month or year (see PartitionWidth) in the implementation for that
+/// partition, and the few intervals that cross partition boundaries in a
+/// separate spanning implementation. Writes only touch the partitions they
+/// overlap, queries only visit those partitions, and erasing whole
+/// partitions, for example to apply a retention period, drops them without
+/// examining their intervals.
+///
+/// Disjoint intervals and gaps are assembled from the intervals of the
+/// overlapping partitions in a boost::icl::interval_map, so that values split
+/// across partitions are combined as in the other implementations.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_PARTITIONED_INTERVALS_H
+#define INCLUDE_INTERVAL_DICT_PARTITIONED_INTERVALS_H
+
+#include "adaptor.h"
+#include "adaptor_icl_interval_map.h"
+#include "instrumentation.h"
+#include "interval_traits.h"
+#include "memory_usage.h"
+#include "query_explain.h"
+#include "value_interval.h"
+
+#include <boost/icl/concept/interval.hpp>
+
+#include <cppcoro/generator.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace interval_dict::partitioned
+{
+  /// Partition width, and tuning for the implementation of each partition
+  template<typename InnerTuning>
+  struct Tuning
+  {
+    PartitionWidth width;
+    InnerTuning inner {};
+
+    auto operator<=> (const Tuning &) const = default;
+  };
+
+  /**
+   * Interval-values for a single key split into partitions of time
+   *
+   * @tparam Inner Implementation for each partition, e.g.
+   * implementation::AugmentedIntervalList<Value, Interval>
+   */
+  template<typename Value, typename Interval, typename Inner>
+  class PartitionedIntervals
+  {
+    public:
+    using ValueIntervalType = ValueInterval<Value, Interval>;
+    using BaseType = typename IntervalTraits<Interval>::BaseType;
+    using InnerImplementation = Implementation<Value, Interval, Inner>;
+    using InnerType = Inner;
+    using TuningType = Tuning<typename InnerImplementation::Tuning>;
+
+    PartitionedIntervals () = default;
+
+    /// @return whether there are no values
+    [[nodiscard]] bool empty () const
+    {
+      return m_partitions.empty () && InnerImplementation::empty (m_spanning);
+    }
+
+    /// @return coroutine enumerating all interval-values overlapping
+    /// @p query_interval. Intervals in different partitions are not combined
+    cppcoro::generator<ValueIntervalType>
+    intervals (Interval query_interval) const;
+
+    /// @return coroutine enumerating all disjoint interval-values over
+    /// @p query_interval
+    cppcoro::generator<ValuesDisjointInterval<Value, Interval>>
+    disjoint_intervals (Interval query_interval) const;
+
+    /// @return coroutine enumerating gaps between intervals
+    cppcoro::generator<Interval> gaps () const;
+
+    /// @return gaps between intervals and the values on either side
+    SandwichedGaps<Value, Interval> sandwiched_gaps () const;
+
+    /// @return first disjoint interval (with one or more values)
+    ValuesDisjointInterval<Value, Interval> initial_values () const;
+
+    /// @return last disjoint interval (with one or more values)
+    ValuesDisjointInterval<Value, Interval> final_values () const;
+
+    /// insert @p value for @p interval
+    void insert (const Interval &interval, const Value &value);
+
+    /// erase @p value for @p query_interval
+    void erase (const Interval &query_interval, const Value &value);
+
+    /// erase all values for @p query_interval. Partitions lying entirely
+    /// within @p query_interval are dropped whole
+    void erase (const Interval &query_interval);
+
+    /// @return the union with another set of interval-values
+    PartitionedIntervals &merged_with (const PartitionedIntervals &other);
+
+    /// @return the asymmetrical difference with another set of
+    /// interval-values
+    PartitionedIntervals &subtract_by (const PartitionedIntervals &other);
+
+    /// record the work done by a query over @p query_interval in @p explain
+    void explain (const Interval &query_interval, QueryExplain &explain) const;
+
+    /// @return bytes used
+    [[nodiscard]] MemoryUsage memory_usage () const;
+
+    /// release unused capacity
+    void shrink_to_fit ();
+
+    /// Apply @p tuning, redistributing intervals if the partition width
+    /// changes
+    void tune (const TuningType &tuning);
+
+    /// @return whether any partition has pending changes
+    [[nodiscard]] bool needs_compaction () const;
+
+    /// integrate pending changes in all partitions
+    void compact ();
+
+    /// @return a value that changes whenever the interval-values are
+    /// modified
+    [[nodiscard]] std::uint64_t generation () const;
+
+    /// @return number of partitions holding intervals
+    [[nodiscard]] std::size_t count_partitions () const;
+
+    /// @return the implementation holding intervals that cross partitions
+    [[nodiscard]] const Inner &spanning () const;
+
+#ifdef INTERVAL_DICT_STATS
+    /// add internal statistics of all partitions to @p stats
+    void collect_stats (instrumentation::Stats &stats) const;
+
+    /// zero internal statistics of all partitions
+    void reset_stats ();
+#endif
+
+    /// Equal if the same disjoint interval-values, however partitioned
+    bool operator== (const PartitionedIntervals &rhs) const;
+
+    private:
+    using Partitioning = TimePartitioning<BaseType>;
+    using Partitions = std::map<std::int64_t, Inner>;
+    using DisjointMap = implementation::IntervalDictICLSubMap<Value, Interval>;
+    using DisjointImplementation = Implementation<Value, Interval, DisjointMap>;
+
+    /// @return the partition containing @p point
+    [[nodiscard]] std::int64_t partition (const BaseType &point) const;
+
+    /// @return the partition holding all of @p interval, or std::nullopt if
+    /// it crosses into the next partition
+    [[nodiscard]] std::optional<std::int64_t>
+    partition_of (const Interval &interval) const;
+
+    /// @return the range of partitions that may overlap @p query_interval
+    template<typename Self>
+    static auto overlapping (Self &self, const Interval &query_interval);
+
+    /// @return the implementation for @p partition, created if necessary
+    Inner &partition_data (std::int64_t partition);
+
+    /// @return whether all intervals of @p interval_values lie within
+    /// @p query_interval
+    static bool within (const Inner &interval_values,
+                        const Interval &query_interval);
+
+    /// @return the interval-values over @p query_interval combined into
+    /// disjoint intervals
+    DisjointMap disjoint_map (const Interval &query_interval) const;
+
+    /// @return the interval-values of the spanning implementation and
+    /// @p partitions combined into disjoint intervals
+    template<typename PartitionRange>
+    DisjointMap disjoint_map (const PartitionRange &partitions) const;
+
+    TuningType m_tuning;
+    Inner m_spanning;
+    Partitions m_partitions;
+    std::uint64_t m_generation = 0;
+  };
+
+  /// Type trait to identify PartitionedIntervals
+  template<typename T> struct IsPartitionedIntervals : std::false_type
+  {
+  };
+
+  /// Type trait to identify PartitionedIntervals
+  template<typename Value, typename Interval, typename Inner>
+  struct IsPartitionedIntervals<PartitionedIntervals<Value, Interval, Inner>>
+    : std::true_type
+  {
+  };
+
+  /*
+   * _____________________________________________________________________________
+   *
+   * Implementation
+   *
+   */
+
+  /*
+   * Private helpers
+   */
+  template<typename Value, typename Interval, typename Inner>
+  std::int64_t PartitionedIntervals<Value, Interval, Inner>::partition (
+    const BaseType &point) const
+  {
+    return Partitioning::partition (point, m_tuning.width);
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  std::optional<std::int64_t>
+  PartitionedIntervals<Value, Interval, Inner>::partition_of (
+    const Interval &interval) const
+  {
+    // Every point is after the lower bound, which is in this partition.
+    // The interval is convex, so it only reaches the next partition if it
+    // contains its first point
+    const auto lower_partition = [&interval, this]
+    {
+      if constexpr (boost::icl::is_discrete<BaseType>::value)
+      {
+        return partition (boost::icl::first (interval));
+      }
+      else
+      {
+        return partition (boost::icl::lower (interval));
+      }
+    }();
+    const auto partition_end
+      = Partitioning::partition_end (lower_partition, m_tuning.width);
+    if (partition_end && boost::icl::contains (interval, *partition_end))
+    {
+      return std::nullopt;
+    }
+    return lower_partition;
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  template<typename Self>
+  auto PartitionedIntervals<Value, Interval, Inner>::overlapping (
+    Self &self, const Interval &query_interval)
+  {
+    auto &partitions = self.m_partitions;
+    if (boost::icl::is_empty (query_interval))
+    {
+      return std::ranges::subrange (partitions.end (), partitions.end ());
+    }
+    // Open bounds of discrete intervals may lie in partitions the interval
+    // does not reach
+    if constexpr (boost::icl::is_discrete<BaseType>::value)
+    {
+      return std::ranges::subrange (
+        partitions.lower_bound (
+          self.partition (boost::icl::first (query_interval))),
+        partitions.upper_bound (
+          self.partition (boost::icl::last (query_interval))));
+    }
+    else
+    {
+      return std::ranges::subrange (
+        partitions.lower_bound (
+          self.partition (boost::icl::lower (query_interval))),
+        partitions.upper_bound (
+          self.partition (boost::icl::upper (query_interval))));
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  Inner &
+  PartitionedIntervals<Value, Interval, Inner>::partition_data (
+    std::int64_t partition)
+  {
+    auto [iter, inserted] = m_partitions.try_emplace (partition);
+    if (inserted)
+    {
+      InnerImplementation::tune (iter->second, m_tuning.inner);
+    }
+    return iter->second;
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  bool PartitionedIntervals<Value, Interval, Inner>::within (
+    const Inner &interval_values, const Interval &query_interval)
+  {
+    if (InnerImplementation::empty (interval_values))
+    {
+      return true;
+    }
+    const auto hull = boost::icl::hull (
+      std::get<1> (InnerImplementation::initial_values (interval_values)),
+      std::get<1> (InnerImplementation::final_values (interval_values)));
+    return boost::icl::contains (query_interval, hull);
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  typename PartitionedIntervals<Value, Interval, Inner>::DisjointMap
+  PartitionedIntervals<Value, Interval, Inner>::disjoint_map (
+    const Interval &query_interval) const
+  {
+    DisjointMap disjoint;
+    for (const auto &value_interval : intervals (query_interval))
+    {
+      DisjointImplementation::insert (
+        disjoint, value_interval.interval, value_interval.value);
+    }
+    return disjoint;
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  template<typename PartitionRange>
+  typename PartitionedIntervals<Value, Interval, Inner>::DisjointMap
+  PartitionedIntervals<Value, Interval, Inner>::disjoint_map (
+    const PartitionRange &partitions) const
+  {
+    DisjointMap disjoint;
+    const auto add = [&disjoint] (const Inner &interval_values)
+    {
+      for (const auto &value_interval : InnerImplementation::intervals (
+             interval_values, interval_extent<Interval>))
+      {
+        DisjointImplementation::insert (
+          disjoint, value_interval.interval, value_interval.value);
+      }
+    };
+    add (m_spanning);
+    for (const auto &[_, interval_values] : partitions)
+    {
+      add (interval_values);
+    }
+    return disjoint;
+  }
+
+  /*
+   * Queries
+   */
+  template<typename Value, typename Interval, typename Inner>
+  cppcoro::generator<ValueInterval<Value, Interval>>
+  PartitionedIntervals<Value, Interval, Inner>::intervals (
+    Interval query_interval) const
+  {
+    for (auto value_interval :
+         InnerImplementation::intervals (m_spanning, query_interval))
+    {
+      co_yield value_interval;
+    }
+    for (const auto &[_, interval_values] :
+         overlapping (*this, query_interval))
+    {
+      for (auto value_interval :
+           InnerImplementation::intervals (interval_values, query_interval))
+      {
+        co_yield value_interval;
+      }
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  cppcoro::generator<ValuesDisjointInterval<Value, Interval>>
+  PartitionedIntervals<Value, Interval, Inner>::disjoint_intervals (
+    Interval query_interval) const
+  {
+    const auto disjoint = disjoint_map (query_interval);
+    for (auto values_interval :
+         DisjointImplementation::disjoint_intervals (disjoint, query_interval))
+    {
+      co_yield values_interval;
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  cppcoro::generator<Interval>
+  PartitionedIntervals<Value, Interval, Inner>::gaps () const
+  {
+    const auto disjoint = disjoint_map (m_partitions);
+    for (auto gap : DisjointImplementation::gaps (disjoint))
+    {
+      co_yield gap;
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  SandwichedGaps<Value, Interval>
+  PartitionedIntervals<Value, Interval, Inner>::sandwiched_gaps () const
+  {
+    return DisjointImplementation::sandwiched_gaps (
+      disjoint_map (m_partitions));
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  ValuesDisjointInterval<Value, Interval>
+  PartitionedIntervals<Value, Interval, Inner>::initial_values () const
+  {
+    assert (!empty ());
+    // The first disjoint interval either starts in the first partition or in
+    // a spanning interval. Intervals in later partitions may still overlap
+    // or touch it, so add partitions up to one past its end until it no
+    // longer changes
+    auto end = std::next (m_partitions.begin (), m_partitions.empty () ? 0 : 1);
+    while (true)
+    {
+      auto values_interval = DisjointImplementation::initial_values (
+        disjoint_map (std::ranges::subrange (m_partitions.begin (), end)));
+      const auto new_end = m_partitions.upper_bound (
+        partition (boost::icl::upper (std::get<1> (values_interval))) + 1);
+      if (end == m_partitions.end ()
+          || (new_end != m_partitions.end () && new_end->first <= end->first))
+      {
+        return values_interval;
+      }
+      end = new_end;
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  ValuesDisjointInterval<Value, Interval>
+  PartitionedIntervals<Value, Interval, Inner>::final_values () const
+  {
+    assert (!empty ());
+    // As for initial_values(), adding earlier partitions while they may
+    // overlap or touch the last disjoint interval
+    auto begin = std::prev (m_partitions.end (), m_partitions.empty () ? 0 : 1);
+    while (true)
+    {
+      auto values_interval = DisjointImplementation::final_values (
+        disjoint_map (std::ranges::subrange (begin, m_partitions.end ())));
+      const auto new_begin = m_partitions.lower_bound (
+        partition (boost::icl::lower (std::get<1> (values_interval))) - 1);
+      if (begin == m_partitions.begin () || new_begin == m_partitions.end ()
+          || new_begin->first >= begin->first)
+      {
+        return values_interval;
+      }
+      begin = new_begin;
+    }
+  }
+
+  /*
+   * Insert and erase
+   */
+  template<typename Value, typename Interval, typename Inner>
+  void PartitionedIntervals<Value, Interval, Inner>::insert (
+    const Interval &interval, const Value &value)
+  {
+    if (boost::icl::is_empty (interval))
+    {
+      return;
+    }
+    ++m_generation;
+    if (const auto partition = partition_of (interval))
+    {
+      InnerImplementation::insert (
+        partition_data (*partition), interval, value);
+    }
+    else
+    {
+      InnerImplementation::insert (m_spanning, interval, value);
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  void PartitionedIntervals<Value, Interval, Inner>::erase (
+    const Interval &query_interval, const Value &value)
+  {
+    ++m_generation;
+    InnerImplementation::erase (m_spanning, query_interval, value);
+    const auto partitions = overlapping (*this, query_interval);
+    for (auto iter = partitions.begin (); iter != partitions.end ();)
+    {
+      InnerImplementation::erase (iter->second, query_interval, value);
+      iter = InnerImplementation::empty (iter->second)
+               ? m_partitions.erase (iter)
+               : std::next (iter);
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  void PartitionedIntervals<Value, Interval, Inner>::erase (
+    const Interval &query_interval)
+  {
+    ++m_generation;
+    InnerImplementation::erase (m_spanning, query_interval);
+    const auto partitions = overlapping (*this, query_interval);
+    for (auto iter = partitions.begin (); iter != partitions.end ();)
+    {
+      if (within (iter->second, query_interval))
+      {
+        iter = m_partitions.erase (iter);
+        continue;
+      }
+      InnerImplementation::erase (iter->second, query_interval);
+      iter = InnerImplementation::empty (iter->second)
+               ? m_partitions.erase (iter)
+               : std::next (iter);
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  PartitionedIntervals<Value, Interval, Inner> &
+  PartitionedIntervals<Value, Interval, Inner>::merged_with (
+    const PartitionedIntervals &other)
+  {
+    ++m_generation;
+    if (m_tuning.width != other.m_tuning.width)
+    {
+      for (const auto &value_interval :
+           other.intervals (interval_extent<Interval>))
+      {
+        insert (value_interval.interval, value_interval.value);
+      }
+      return *this;
+    }
+    // Same partitions: merge each with its counterpart
+    InnerImplementation::merged_with (m_spanning, other.m_spanning);
+    for (const auto &[partition, interval_values] : other.m_partitions)
+    {
+      InnerImplementation::merged_with (partition_data (partition),
+                                        interval_values);
+    }
+    return *this;
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  PartitionedIntervals<Value, Interval, Inner> &
+  PartitionedIntervals<Value, Interval, Inner>::subtract_by (
+    const PartitionedIntervals &other)
+  {
+    // Intervals of other may cross our partitions whatever its width
+    for (const auto &value_interval :
+         other.intervals (interval_extent<Interval>))
+    {
+      erase (value_interval.interval, value_interval.value);
+    }
+    return *this;
+  }
+
+  /*
+   * Explain, memory and tuning
+   */
+  template<typename Value, typename Interval, typename Inner>
+  void PartitionedIntervals<Value, Interval, Inner>::explain (
+    const Interval &query_interval, QueryExplain &explain) const
+  {
+    InnerImplementation::explain (m_spanning, query_interval, explain);
+    for (const auto &[_, interval_values] :
+         overlapping (*this, query_interval))
+    {
+      InnerImplementation::explain (interval_values, query_interval, explain);
+      ++explain.partitions_visited;
+    }
+    explain.backend = "partitioned " + explain.backend;
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  MemoryUsage
+  PartitionedIntervals<Value, Interval, Inner>::memory_usage () const
+  {
+    auto usage = InnerImplementation::memory_usage (m_spanning);
+    for (const auto &[_, interval_values] : m_partitions)
+    {
+      usage += InnerImplementation::memory_usage (interval_values);
+      usage.bytes_nodes += details::rb_tree_node_links
+                           + sizeof (typename Partitions::value_type);
+    }
+    return usage;
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  void PartitionedIntervals<Value, Interval, Inner>::shrink_to_fit ()
+  {
+    InnerImplementation::shrink_to_fit (m_spanning);
+    for (auto &[_, interval_values] : m_partitions)
+    {
+      InnerImplementation::shrink_to_fit (interval_values);
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  void PartitionedIntervals<Value, Interval, Inner>::tune (
+    const TuningType &tuning)
+  {
+    InnerImplementation::tune (m_spanning, tuning.inner);
+    for (auto &[_, interval_values] : m_partitions)
+    {
+      InnerImplementation::tune (interval_values, tuning.inner);
+    }
+    if (m_tuning.width == tuning.width || empty ())
+    {
+      m_tuning = tuning;
+      return;
+    }
+    // Gather intervals using the old partitions before switching widths
+    std::vector<ValueIntervalType> value_intervals;
+    for (const auto &value_interval : intervals (interval_extent<Interval>))
+    {
+      value_intervals.push_back (value_interval);
+    }
+    m_tuning = tuning;
+    m_partitions.clear ();
+    InnerImplementation::erase (m_spanning, interval_extent<Interval>);
+    for (const auto &value_interval : value_intervals)
+    {
+      insert (value_interval.interval, value_interval.value);
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  bool PartitionedIntervals<Value, Interval, Inner>::needs_compaction () const
+  {
+    if (InnerImplementation::needs_compaction (m_spanning))
+    {
+      return true;
+    }
+    for (const auto &[_, interval_values] : m_partitions)
+    {
+      if (InnerImplementation::needs_compaction (interval_values))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  void PartitionedIntervals<Value, Interval, Inner>::compact ()
+  {
+    InnerImplementation::compact (m_spanning);
+    for (auto &[_, interval_values] : m_partitions)
+    {
+      InnerImplementation::compact (interval_values);
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  std::uint64_t
+  PartitionedIntervals<Value, Interval, Inner>::generation () const
+  {
+    return m_generation;
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  std::size_t
+  PartitionedIntervals<Value, Interval, Inner>::count_partitions () const
+  {
+    return m_partitions.size ();
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  const Inner &PartitionedIntervals<Value, Interval, Inner>::spanning () const
+  {
+    return m_spanning;
+  }
+
+#ifdef INTERVAL_DICT_STATS
+  template<typename Value, typename Interval, typename Inner>
+  void PartitionedIntervals<Value, Interval, Inner>::collect_stats (
+    instrumentation::Stats &stats) const
+  {
+    InnerImplementation::collect_stats (m_spanning, stats);
+    for (const auto &[_, interval_values] : m_partitions)
+    {
+      InnerImplementation::collect_stats (interval_values, stats);
+    }
+  }
+
+  template<typename Value, typename Interval, typename Inner>
+  void PartitionedIntervals<Value, Interval, Inner>::reset_stats ()
+  {
+    InnerImplementation::reset_stats (m_spanning);
+    for (auto &[_, interval_values] : m_partitions)
+    {
+      InnerImplementation::reset_stats (interval_values);
+    }
+  }
+#endif
+
+  template<typename Value, typename Interval, typename Inner>
+  bool PartitionedIntervals<Value, Interval, Inner>::operator== (
+    const PartitionedIntervals &rhs) const
+  {
+    return disjoint_map (m_partitions) == rhs.disjoint_map (rhs.m_partitions);
+  }
+
+} // namespace interval_dict::partitioned
+
+#endif // INCLUDE_INTERVAL_DICT_PARTITIONED_INTERVALS_H
@@ -19,8 +19,13 @@
 // #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/icl/ptime.hpp>
 
+#include "gregorian.h"
 #include "interval_traits.h"
 
+#include <cstdint>
+#include <limits>
+#include <optional>
+
 namespace interval_dict::ptime_literals
 {
   /// Convenience function to make dates
@@ -66,6 +71,85 @@ namespace interval_dict
       return boost::posix_time::time_duration {boost::date_time::max_date_time};
     }
   };
+
+  /// Encodes times as ticks since the earliest time
+  ///
+  /// Special values are mapped to reserved tick counts, in the order
+  /// -infinity < all times < not_a_date_time < +infinity
+  template<> struct EdgeEncoding<boost::posix_time::ptime>
+  {
+    using EncodedType = std::int64_t;
+
+    static EncodedType encode (const boost::posix_time::ptime &edge) noexcept
+    {
+      if (edge.is_special ())
+      {
+        if (edge.is_neg_infinity ())
+        {
+          return std::numeric_limits<EncodedType>::min ();
+        }
+        if (edge.is_pos_infinity ())
+        {
+          return std::numeric_limits<EncodedType>::max ();
+        }
+        return std::numeric_limits<EncodedType>::max () - 1;
+      }
+      return (edge - origin ()).ticks ();
+    }
+
+    static boost::posix_time::ptime decode (EncodedType edge) noexcept
+    {
+      if (edge == std::numeric_limits<EncodedType>::min ())
+      {
+        return boost::posix_time::ptime {boost::date_time::neg_infin};
+      }
+      if (edge == std::numeric_limits<EncodedType>::max ())
+      {
+        return boost::posix_time::ptime {boost::date_time::pos_infin};
+      }
+      if (edge == std::numeric_limits<EncodedType>::max () - 1)
+      {
+        return boost::posix_time::ptime {boost::date_time::not_a_date_time};
+      }
+      return origin () + boost::posix_time::time_duration (0, 0, 0, edge);
+    }
+
+    private:
+    /// Tick zero
+    static boost::posix_time::ptime origin () noexcept
+    {
+      return boost::posix_time::ptime {boost::date_time::min_date_time};
+    }
+  };
+
+  /// Partitions times by the calendar months or years of their dates
+  template<> struct TimePartitioning<boost::posix_time::ptime>
+  {
+    static std::int64_t partition (const boost::posix_time::ptime &point,
+                                   const PartitionWidth &width)
+    {
+      using Limits = std::numeric_limits<std::int64_t>;
+      if (point.is_special ())
+      {
+        return point.is_neg_infinity () ? Limits::min () : Limits::max ();
+      }
+      return TimePartitioning<boost::gregorian::date>::partition (
+        point.date (), width);
+    }
+
+    static std::optional<boost::posix_time::ptime>
+    partition_end (std::int64_t partition, const PartitionWidth &width)
+    {
+      const auto date_end
+        = TimePartitioning<boost::gregorian::date>::partition_end (partition,
+                                                                   width);
+      if (!date_end)
+      {
+        return std::nullopt;
+      }
+      return boost::posix_time::ptime {*date_end};
+    }
+  };
 } // namespace interval_dict
 
 namespace interval_dict
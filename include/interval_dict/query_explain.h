@@ -0,0 +1,114 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file query_explain.h
+/// \brief Report of the work done by a single query
+///
+/// Returned by IntervalDictExp::explain() to show why a particular find() is
+/// slow. Counters that do not apply to an implementation remain zero.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_QUERY_EXPLAIN_H
+#define INCLUDE_INTERVAL_DICT_QUERY_EXPLAIN_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace interval_dict
+{
+  /// Work done by an augmented interval list query in a single sorted run
+  struct RunExplain
+  {
+    /// Indices of the run in the augmented interval list
+    int_fast32_t begin = 0;
+    int_fast32_t end = 0;
+
+    /// Short runs are scanned from beginning to end without binary search
+    bool brute_force = false;
+
+    /// Comparisons made by the binary search for the right edge of the query
+    std::size_t binary_search_steps = 0;
+
+    /// Intervals examined while scanning back from the right edge
+    std::size_t elements_scanned = 0;
+
+    /// Intervals overlapping the query
+    std::size_t elements_matched = 0;
+  };
+
+  /// Work done by a single query on the intervals for one key
+  struct QueryExplain
+  {
+    /// Which implementation answered the query
+    std::string backend;
+
+    /// Whether the key was present at all
+    bool key_found = false;
+
+    /// Interval-values returned by the implementation
+    std::size_t count_matched = 0;
+
+    /// Distinct values returned by find()
+    std::size_t count_values = 0;
+
+    /// Augmented interval lists: one entry for each run probed
+    std::vector<RunExplain> runs;
+
+    /// Interval trees: nodes visited and subtrees skipped using the
+    /// maximum right edge
+    std::size_t nodes_visited = 0;
+    std::size_t nodes_pruned = 0;
+
+    /// boost::icl::interval_map: disjoint segments overlapping the query
+    std::size_t segments_touched = 0;
+
+    /// Partitioned implementations: partitions of time overlapping the query
+    std::size_t partitions_visited = 0;
+  };
+
+  /// Streaming operator for QueryExplain
+  inline std::ostream &operator<< (std::ostream &os,
+                                   const QueryExplain &explain)
+  {
+    os << "backend: " << explain.backend << "\n"
+       << "key_found: " << (explain.key_found ? "true" : "false") << "\n"
+       << "count_matched: " << explain.count_matched << "\n"
+       << "count_values: " << explain.count_values << "\n";
+    for (const auto &run : explain.runs)
+    {
+      os << "  run [" << run.begin << " - " << run.end << "]"
+         << (run.brute_force ? " brute force" : "")
+         << " binary_search_steps: " << run.binary_search_steps
+         << " scanned: " << run.elements_scanned
+         << " matched: " << run.elements_matched << "\n";
+    }
+    if (explain.nodes_visited)
+    {
+      os << "nodes_visited: " << explain.nodes_visited << "\n"
+         << "nodes_pruned: " << explain.nodes_pruned << "\n";
+    }
+    if (explain.segments_touched)
+    {
+      os << "segments_touched: " << explain.segments_touched << "\n";
+    }
+    if (explain.partitions_visited)
+    {
+      os << "partitions_visited: " << explain.partitions_visited << "\n";
+    }
+    return os;
+  }
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_QUERY_EXPLAIN_H
@@ -0,0 +1,121 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file symbol_table.h
+/// \brief Dense 32-bit ids for keys or values
+///
+/// A SymbolTable assigns each distinct symbol (typically a std::string
+/// identifier) a SymbolId in order of first appearance. Each symbol is stored
+/// once, however many dictionaries refer to it. Ids are never reused, so that
+/// dictionaries sharing a table remain valid whatever the others erase.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_SYMBOL_TABLE_H
+#define INCLUDE_INTERVAL_DICT_SYMBOL_TABLE_H
+
+#include "memory_usage.h"
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace interval_dict
+{
+  /// Dense id standing in for a key or value
+  using SymbolId = std::uint32_t;
+
+  /**
+   * @brief Two-way mapping between symbols and dense SymbolIds
+   *
+   * Not thread-safe: dictionaries sharing a table must not be modified
+   * concurrently.
+   *
+   * @tparam T Type of symbols. Must be less-than comparable
+   */
+  template<typename T> class SymbolTable
+  {
+    public:
+    SymbolTable () = default;
+
+    /// Not copyable: ids refer to map nodes
+    SymbolTable (const SymbolTable &) = delete;
+    SymbolTable &operator= (const SymbolTable &) = delete;
+
+    /// std::map nodes do not move, so neither do the symbols
+    SymbolTable (SymbolTable &&) noexcept = default;
+    SymbolTable &operator= (SymbolTable &&) noexcept = default;
+
+    /// @return id of @p symbol, adding it if necessary
+    SymbolId intern (const T &symbol)
+    {
+      if (const auto ff = m_ids.find (symbol); ff != m_ids.end ())
+      {
+        return ff->second;
+      }
+      if (m_symbols.size () == std::numeric_limits<SymbolId>::max ())
+      {
+        throw std::length_error ("SymbolTable: too many symbols");
+      }
+      const auto id = static_cast<SymbolId> (m_symbols.size ());
+      const auto inserted = m_ids.emplace (symbol, id).first;
+      m_symbols.push_back (&inserted->first);
+      return id;
+    }
+
+    /// @return id of @p symbol if it has been interned
+    [[nodiscard]] std::optional<SymbolId> find (const T &symbol) const
+    {
+      const auto ff = m_ids.find (symbol);
+      if (ff == m_ids.end ())
+      {
+        return std::nullopt;
+      }
+      return ff->second;
+    }
+
+    /// @return symbol for @p id
+    [[nodiscard]] const T &symbol (SymbolId id) const
+    {
+      assert (id < m_symbols.size ());
+      return *m_symbols[id];
+    }
+
+    /// @return number of symbols interned
+    [[nodiscard]] std::size_t size () const
+    {
+      return m_symbols.size ();
+    }
+
+    /// Bytes used by the table, excluding any heap memory owned by the
+    /// symbols themselves
+    [[nodiscard]] MemoryUsage memory_usage () const
+    {
+      MemoryUsage usage;
+      usage.bytes_intervals += m_ids.size () * (sizeof (T) + sizeof (SymbolId));
+      usage.bytes_nodes += m_ids.size () * details::rb_tree_node_links;
+      details::add_vector_usage (m_symbols, usage.bytes_index, usage);
+      return usage;
+    }
+
+    private:
+    std::map<T, SymbolId> m_ids;
+    /// Symbol for each id, pointing into m_ids
+    std::vector<const T *> m_symbols;
+  };
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_SYMBOL_TABLE_H
@@ -0,0 +1,243 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file temporal_join.h
+/// \brief Pairs of values from two dictionaries that co-occur in time for the
+/// same key
+///
+/// temporal_join (dict_x, dict_y) returns (key, value_x, value_y, interval)
+/// for every key of both dictionaries, where value_x and value_y are both
+/// valid over interval.
+///
+/// The sorted keys of the two dictionaries are merge-joined. For each common
+/// key, the intervals of both are sorted by their lower bounds (as they
+/// usually already are) and swept through together. Intervals of the other
+/// dictionary that started earlier and are still open overlap each new
+/// interval, so each pair is found without searching. Keys are split into
+/// contiguous partitions joined on separate threads.
+///
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#ifndef INCLUDE_INTERVAL_DICT_TEMPORAL_JOIN_H
+#define INCLUDE_INTERVAL_DICT_TEMPORAL_JOIN_H
+
+#include "interval_compare.h"
+#include "intervaldict.h"
+#include "value_interval.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace interval_dict
+{
+  /// Minimum number of keys joined by each thread of temporal_join()
+  inline constexpr std::size_t min_count_keys_per_temporal_join_thread = 64;
+
+  /// \brief Key with values from two dictionaries and the interval over which
+  /// both are valid
+  template<typename Key, typename ValueX, typename ValueY, typename Interval>
+  using KeyValuePairInterval = std::tuple<Key, ValueX, ValueY, Interval>;
+
+  /// @cond Suppress_Doxygen_Warning
+  namespace details
+  {
+    /// @return the intervals of @p key in @p interval_dict, sorted by
+    /// interval then value
+    template<typename Key, typename Value, typename Interval, typename Impl>
+    ValueIntervals<Value, Interval> sorted_value_intervals (
+      const IntervalDictExp<Key, Value, Interval, Impl> &interval_dict,
+      const Key &key)
+    {
+      ValueIntervals<Value, Interval> value_intervals;
+      for (const auto &[_, value, interval] :
+           intervals (interval_dict, key, interval_extent<Interval>))
+      {
+        value_intervals.emplace_back (value, interval);
+      }
+      // Most implementations already return intervals in order
+      if (!std::ranges::is_sorted (value_intervals))
+      {
+        std::ranges::sort (value_intervals);
+      }
+      return value_intervals;
+    }
+
+    /// Calls @p emit with each interval in @p open_other overlapping
+    /// @p current and their intersection, then adds @p current to @p open
+    ///
+    /// Intervals are visited in sorted order, so intervals in @p open_other
+    /// which end before @p current cannot overlap later intervals either
+    template<typename Current, typename Other, typename Emit>
+    void sweep_interval (const Current &current,
+                         std::vector<const Other *> &open_other,
+                         std::vector<const Current *> &open,
+                         Emit emit)
+    {
+      std::erase_if (open_other,
+                     [&current] (const Other *earlier)
+                     {
+                       return comparisons::exclusive_less (earlier->interval,
+                                                           current.interval);
+                     });
+      for (const auto *earlier : open_other)
+      {
+        const auto intersection = earlier->interval & current.interval;
+        if (!boost::icl::is_empty (intersection))
+        {
+          emit (*earlier, intersection);
+        }
+      }
+      open.push_back (&current);
+    }
+
+    /// Appends to @p results the overlapping pairs of @p intervals_x and
+    /// @p intervals_y, both sorted by interval
+    template<typename Key, typename ValueX, typename ValueY, typename Interval>
+    void sweep_temporal_join (
+      const Key &key,
+      const ValueIntervals<ValueX, Interval> &intervals_x,
+      const ValueIntervals<ValueY, Interval> &intervals_y,
+      std::vector<KeyValuePairInterval<Key, ValueX, ValueY, Interval>> &results)
+    {
+      // Intervals which started earlier and may overlap later ones
+      std::vector<const ValueInterval<ValueX, Interval> *> open_x;
+      std::vector<const ValueInterval<ValueY, Interval> *> open_y;
+
+      auto ii_x = intervals_x.begin ();
+      auto ii_y = intervals_y.begin ();
+      while (ii_x != intervals_x.end () || ii_y != intervals_y.end ())
+      {
+        if (ii_y == intervals_y.end ()
+            || (ii_x != intervals_x.end ()
+                && !(ii_y->interval < ii_x->interval)))
+        {
+          const auto &current = *ii_x++;
+          sweep_interval (
+            current,
+            open_y,
+            open_x,
+            [&] (const auto &earlier, const Interval &intersection)
+            {
+              results.emplace_back (
+                key, current.value, earlier.value, intersection);
+            });
+        }
+        else
+        {
+          const auto &current = *ii_y++;
+          sweep_interval (
+            current,
+            open_x,
+            open_y,
+            [&] (const auto &earlier, const Interval &intersection)
+            {
+              results.emplace_back (
+                key, earlier.value, current.value, intersection);
+            });
+        }
+      }
+    }
+  } // namespace details
+  /// @endcond
+
+  /**
+   * @brief Values of @p dict_x and @p dict_y valid at the same time for the
+   * same key
+   *
+   * \param count_threads Maximum number of threads. Each joins at least
+   * min_count_keys_per_temporal_join_thread keys
+   * \return (key, value_x, value_y, interval) for every pair of values of each
+   * key in both dictionaries, where interval is the overlap of the interval of
+   * value_x with that of value_y. Sorted by key, then in order of the later
+   * starting interval
+   */
+  template<typename Key,
+           typename ValueX,
+           typename ValueY,
+           typename Interval,
+           typename ImplX,
+           typename ImplY>
+  std::vector<KeyValuePairInterval<Key, ValueX, ValueY, Interval>>
+  temporal_join (const IntervalDictExp<Key, ValueX, Interval, ImplX> &dict_x,
+                 const IntervalDictExp<Key, ValueY, Interval, ImplY> &dict_y,
+                 std::size_t count_threads
+                 = std::thread::hardware_concurrency ())
+  {
+    using Results
+      = std::vector<KeyValuePairInterval<Key, ValueX, ValueY, Interval>>;
+
+    // Merge join of the sorted keys
+    std::vector<Key> keys;
+    std::ranges::set_intersection (
+      dict_x.keys (), dict_y.keys (), std::back_inserter (keys));
+
+    const auto count_partitions = std::max<std::size_t> (
+      1,
+      std::min (count_threads,
+                keys.size () / min_count_keys_per_temporal_join_thread));
+
+    // Contiguous partitions of keys, the first joined on this thread
+    std::vector<Results> partition_results (count_partitions);
+    std::vector<std::exception_ptr> errors (count_partitions);
+    const auto join_partition = [&] (std::size_t partition)
+    {
+      try
+      {
+        const auto begin = keys.size () * partition / count_partitions;
+        const auto end = keys.size () * (partition + 1) / count_partitions;
+        for (auto ii = begin; ii != end; ++ii)
+        {
+          details::sweep_temporal_join (
+            keys[ii],
+            details::sorted_value_intervals (dict_x, keys[ii]),
+            details::sorted_value_intervals (dict_y, keys[ii]),
+            partition_results[partition]);
+        }
+      }
+      catch (...)
+      {
+        errors[partition] = std::current_exception ();
+      }
+    };
+    {
+      std::vector<std::jthread> workers;
+      for (std::size_t partition = 1; partition < count_partitions;
+           ++partition)
+      {
+        workers.emplace_back (join_partition, partition);
+      }
+      join_partition (0);
+    }
+    for (const auto &error : errors)
+    {
+      if (error)
+      {
+        std::rethrow_exception (error);
+      }
+    }
+
+    Results results = std::move (partition_results[0]);
+    for (std::size_t partition = 1; partition < count_partitions; ++partition)
+    {
+      std::ranges::move (partition_results[partition],
+                         std::back_inserter (results));
+    }
+    return results;
+  }
+
+} // namespace interval_dict
+
+#endif // INCLUDE_INTERVAL_DICT_TEMPORAL_JOIN_H
@@ -16,8 +16,11 @@
 #ifndef TESTS_PRINT_VECTOR_H
 #define TESTS_PRINT_VECTOR_H
 
+#include <boost/container/small_vector.hpp>
+
 #include <iostream>
 #include <set>
+#include <vector>
 
 /*
  * To dump errors for debugging
@@ -42,4 +45,25 @@ namespace std
   }
 } // namespace std
 
+namespace boost::container
+{
+  template<typename T, std::size_t N>
+  std::ostream &operator<< (std::ostream &os,
+                            const small_vector<T, N> &values)
+  {
+    if (!values.empty ())
+    {
+      os << "[ ";
+      auto ii = values.begin ();
+      os << *ii;
+      while (++ii != values.end ())
+      {
+        os << ", " << *ii;
+      }
+      os << " ]";
+    }
+    return os;
+  }
+} // namespace boost::container
+
 #endif // TESTS_PRINT_VECTOR_H
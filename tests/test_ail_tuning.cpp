@@ -0,0 +1,103 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_ail_tuning.cpp
+/// \brief Test tune() and augmented_interval_list::Tuning
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/intervaldictail.h>
+
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+TEST_CASE ("Test tune() for IntervalDictAIL", "[tuning]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using Tuning = interval_dict::augmented_interval_list::Tuning;
+  using Dict = interval_dict::IntervalDictAILExp<int, int, Interval>;
+
+  // Nested intervals which overlap many neighbours so that runs are promoted
+  std::vector<std::tuple<int, int, Interval>> key_value_intervals;
+  for (int i = 0; i < 2000; ++i)
+  {
+    key_value_intervals.emplace_back (i % 2, i, Interval {i, i + 1 + i % 97});
+  }
+  const Dict original (key_value_intervals);
+  const Tuning tuning {.max_overlapping_neighbours = 5,
+                       .min_run_length = 16,
+                       .max_fraction_promoted_per_run = 0.5,
+                       .max_brute_force_run_length = 8,
+                       .max_fraction_pending = 0.1};
+
+  GIVEN ("A tuned copy of a dictionary")
+  {
+    auto tuned = original;
+    tuned.tune (tuning);
+    THEN ("Queries return the same values")
+    {
+      REQUIRE (tuned.tuning () == tuning);
+      for (int key = 0; key < 2; ++key)
+      {
+        for (int query = 0; query < 2100; query += 37)
+        {
+          REQUIRE (tuned.find (key, Interval {query, query + 5})
+                   == original.find (key, Interval {query, query + 5}));
+        }
+      }
+    }
+    WHEN ("Keys are added afterwards")
+    {
+      std::vector<std::tuple<int, int, Interval>> new_key_intervals;
+      for (int i = 0; i < 32; ++i)
+      {
+        new_key_intervals.emplace_back (2, i, Interval {i * 10, i * 10 + 5});
+      }
+      tuned.insert (new_key_intervals);
+      THEN ("They use the same tuning")
+      {
+        // A single run of 32 intervals is only scanned without binary search
+        // with the default max_brute_force_run_length
+        const auto explained = tuned.explain (2);
+        REQUIRE (explained.runs.size () == 1);
+        REQUIRE (!explained.runs.front ().brute_force);
+
+        auto untuned = original;
+        untuned.insert (new_key_intervals);
+        REQUIRE (untuned.explain (2).runs.front ().brute_force);
+      }
+    }
+  }
+
+  GIVEN ("Tuning written to a stream")
+  {
+    std::stringstream stream;
+    stream << tuning;
+    THEN ("It is read back unchanged")
+    {
+      Tuning read_back;
+      REQUIRE (stream >> read_back);
+      REQUIRE (read_back == tuning);
+    }
+  }
+
+  GIVEN ("Unrecognised tuning parameters")
+  {
+    std::stringstream stream ("max_overlapping_neighbours=5 colour=blue");
+    THEN ("Reading fails without changing the tuning")
+    {
+      Tuning read_back;
+      REQUIRE (!(stream >> read_back));
+      REQUIRE (read_back == Tuning {});
+    }
+  }
+}
@@ -0,0 +1,189 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_bi_interval_dict_shared.cpp
+/// \brief Test BiIntervalDictSharedExp against IntervalDictAILExp in each
+/// direction
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/bi_intervaldictshared.h>
+#include <interval_dict/intervaldictail.h>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+TEST_CASE ("Test BiIntervalDictSharedExp", "[shared]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using Dict = interval_dict::IntervalDictAILExp<int, int, Interval>;
+  using SharedDict = interval_dict::BiIntervalDictSharedExp<int, int, Interval>;
+  using KeyValueIntervals = std::vector<std::tuple<int, int, Interval>>;
+
+  // Enough intervals per key and value to span several blocks of the index
+  KeyValueIntervals key_value_intervals;
+  for (int i = 0; i < 1000; ++i)
+  {
+    key_value_intervals.emplace_back (
+      i % 7, i % 13, Interval {(i * 37) % 500, (i * 37) % 500 + 1 + i % 29});
+  }
+
+  const auto require_same = [] (const SharedDict &shared, const Dict &forward)
+  {
+    const auto inverse = forward.invert ();
+    REQUIRE (shared.keys () == forward.keys ());
+    REQUIRE (shared.values () == inverse.keys ());
+    for (int query = 0; query < 560; query += 7)
+    {
+      const Interval query_interval {query, query + 1 + query % 11};
+      for (int key = 0; key < 8; ++key)
+      {
+        REQUIRE (shared.find (key, query_interval)
+                 == forward.find (key, query_interval));
+      }
+      for (int value = 0; value < 14; ++value)
+      {
+        REQUIRE (shared.inverse_find (value, query_interval)
+                 == inverse.find (value, query_interval));
+      }
+    }
+  };
+
+  GIVEN ("A shared dictionary and an AIL dictionary with the same data")
+  {
+    SharedDict shared (key_value_intervals);
+    Dict forward (key_value_intervals);
+    require_same (shared, forward);
+
+    WHEN ("Intervals are erased for key-values, keys and all keys")
+    {
+      KeyValueIntervals erased;
+      for (int i = 0; i < 300; i += 3)
+      {
+        erased.emplace_back (i % 7, i % 13, Interval {i, i + 40});
+      }
+      shared.erase (erased);
+      forward.erase (erased);
+      shared.erase (3, Interval {100, 200});
+      forward.erase (3, Interval {100, 200});
+      shared.erase (Interval {250, 260});
+      forward.erase (Interval {250, 260});
+      THEN ("Both still agree")
+      {
+        require_same (shared, forward);
+      }
+    }
+
+    WHEN ("All intervals for a value are erased")
+    {
+      shared.inverse_erase (5);
+      THEN ("The value disappears and its id can be reused")
+      {
+        REQUIRE (!shared.contains_value (5));
+        REQUIRE (shared.inverse_find (5).empty ());
+        shared.inverse_insert (5, 100, Interval {0, 10});
+        REQUIRE (shared.inverse_find (5) == std::vector {100});
+        REQUIRE (shared.find (100) == std::vector {5});
+      }
+    }
+
+    WHEN ("Everything is cleared")
+    {
+      shared.clear ();
+      THEN ("The dictionary is empty")
+      {
+        REQUIRE (shared.empty ());
+        REQUIRE (shared.inverse_size () == 0);
+        REQUIRE (shared.intervals ().empty ());
+      }
+    }
+
+    WHEN ("The dictionary is copied and the original cleared")
+    {
+      const auto copy = shared;
+      SharedDict assigned;
+      assigned = shared;
+      shared.clear ();
+      THEN ("The copies are unchanged")
+      {
+        require_same (copy, forward);
+        require_same (assigned, forward);
+      }
+    }
+
+    THEN ("Inverting twice gives back the same dictionary")
+    {
+      REQUIRE (shared.invert ().invert () == shared);
+    }
+  }
+
+  GIVEN ("Random inserts and erases")
+  {
+    // Enough erases for tombstones to be compacted and rows reused
+    SharedDict shared;
+    Dict forward;
+    std::mt19937 generator (11);
+    std::uniform_int_distribution<int> key (0, 7);
+    std::uniform_int_distribution<int> value (0, 13);
+    std::uniform_int_distribution<int> lower (0, 500);
+    std::uniform_int_distribution<int> length (1, 40);
+    for (int i = 0; i < 5000; ++i)
+    {
+      const auto begin = lower (generator);
+      const KeyValueIntervals changes {
+        {key (generator),
+         value (generator),
+         Interval {begin, begin + length (generator)}}};
+      if (i % 3 == 0)
+      {
+        shared.erase (changes);
+        forward.erase (changes);
+      }
+      else
+      {
+        shared.insert (changes);
+        forward.insert (changes);
+      }
+    }
+    THEN ("Both agree")
+    {
+      require_same (shared, forward);
+    }
+  }
+
+  GIVEN ("Touching and overlapping intervals for the same key and value")
+  {
+    SharedDict shared;
+    shared.insert (1, 2, Interval {0, 5});
+    shared.insert (1, 2, Interval {5, 10});
+    shared.insert (1, 2, Interval {8, 12});
+    shared.insert (1, 3, Interval {4, 6});
+    THEN ("They are merged")
+    {
+      REQUIRE (shared.intervals ()
+               == KeyValueIntervals {{1, 2, Interval {0, 12}},
+                                     {1, 3, Interval {4, 6}}});
+    }
+    WHEN ("The middle of an interval is erased")
+    {
+      shared.erase (1, 2, Interval {3, 7});
+      THEN ("Both ends remain")
+      {
+        REQUIRE (shared.intervals ()
+                 == KeyValueIntervals {{1, 2, Interval {0, 3}},
+                                       {1, 3, Interval {4, 6}},
+                                       {1, 2, Interval {7, 12}}});
+        REQUIRE (shared.inverse_find (2, Interval {3, 7}).empty ());
+      }
+    }
+  }
+}
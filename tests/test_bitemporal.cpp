@@ -0,0 +1,168 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_bitemporal.cpp
+/// \brief Test BitemporalIntervalDictExp against a snapshot of
+/// IntervalDictICLExp for each transaction time
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicticl.h>
+
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+TEST_CASE ("Test BitemporalIntervalDictExp", "[bitemporal]")
+{
+  // Point queries only make sense for closed intervals
+  using Interval = boost::icl::closed_interval<int>;
+  using Dict = interval_dict::BitemporalIntervalDictAILExp<int, int, Interval>;
+  using Snapshot = interval_dict::IntervalDictICLExp<int, int, Interval>;
+  using KeyValueIntervals = std::vector<std::tuple<int, int, Interval>>;
+
+  GIVEN ("A value corrected by a later load")
+  {
+    Dict dict;
+    dict.insert ({{1, 10, Interval {0, 99}}}, 1);
+    dict.assign (1, {20}, Interval {50, 99}, 2);
+
+    THEN ("Current and past beliefs are both found")
+    {
+      REQUIRE (dict.find (1, 75) == std::vector<int> {20});
+      REQUIRE (dict.find (1, 25) == std::vector<int> {10});
+      REQUIRE (dict.find_as_of (1, 75, 1) == std::vector<int> {10});
+      REQUIRE (dict.find_as_of (1, 75, 2) == std::vector<int> {20});
+      REQUIRE (dict.find_as_of (1, 75, 0).empty ());
+      REQUIRE (dict.find_as_of (1, Interval {0, 99}, 2)
+               == std::vector<int> {10, 20});
+    }
+
+    THEN ("The superseded record is closed, not erased")
+    {
+      using Record = Dict::Record;
+      REQUIRE (dict.history (1)
+               == std::vector<Record> {{1, 10, Interval {0, 99}, 1, 2},
+                                       {1, 10, Interval {0, 49}, 2, {}},
+                                       {1, 20, Interval {50, 99}, 2, {}}});
+    }
+
+    THEN ("Reloading the same values adds no records")
+    {
+      for (int txn = 3; txn < 100; ++txn)
+      {
+        dict.assign (1, {10}, Interval {0, 49}, txn);
+        dict.insert ({{1, 20, Interval {50, 99}}}, txn);
+      }
+      REQUIRE (dict.records ().size () == 3);
+    }
+
+    THEN ("Writes earlier than the latest transaction are rejected")
+    {
+      REQUIRE_THROWS_AS (dict.insert ({{1, 30, Interval {0, 9}}}, 1),
+                         std::invalid_argument);
+    }
+  }
+
+  GIVEN ("Random loads, each at a new transaction time")
+  {
+    // Small epochs so that queries span many of them
+    Dict dict (8);
+    Snapshot snapshot;
+    std::map<int, Snapshot> snapshots;
+    std::mt19937 generator (7);
+    std::uniform_int_distribution<int> key (0, 3);
+    std::uniform_int_distribution<int> value (0, 5);
+    std::uniform_int_distribution<int> edge (0, 80);
+    std::uniform_int_distribution<int> length (1, 20);
+    std::uniform_int_distribution<int> operation (0, 3);
+    for (int txn = 0; txn < 200; ++txn)
+    {
+      const auto lower = edge (generator);
+      const Interval interval {lower, lower + length (generator)};
+      const KeyValueIntervals changes {
+        {key (generator), value (generator), interval}};
+      switch (operation (generator))
+      {
+        case 0:
+          dict.erase (changes, txn);
+          snapshot.erase (changes);
+          break;
+        case 1:
+        {
+          const auto [changed_key, changed_value, _] = changes.front ();
+          dict.assign (changed_key, {changed_value}, interval, txn);
+          snapshot.erase (changed_key, interval);
+          snapshot.insert (changes);
+          break;
+        }
+        case 2:
+          dict.erase (std::get<0> (changes.front ()), interval, txn);
+          snapshot.erase (std::get<0> (changes.front ()), interval);
+          break;
+        default:
+          dict.insert (changes, txn);
+          snapshot.insert (changes);
+      }
+      snapshots[txn] = snapshot;
+    }
+    REQUIRE (dict.count_epochs () > 1);
+
+    THEN ("Each transaction time sees the snapshot written then")
+    {
+      REQUIRE (dict.as_of (snapshots.begin ()->first - 1).empty ());
+      for (const auto &[txn, expected] : snapshots)
+      {
+        const auto as_of = dict.as_of (txn);
+        for (int key_query = 0; key_query < 4; ++key_query)
+        {
+          for (int query = -1; query < 105; query += 3)
+          {
+            REQUIRE (dict.find_as_of (key_query, query, txn)
+                     == expected.find (key_query, query));
+            REQUIRE (as_of.find (key_query, query)
+                     == expected.find (key_query, query));
+          }
+          const Interval query_interval {txn % 90, txn % 90 + 10};
+          REQUIRE (dict.find_as_of (key_query, query_interval, txn)
+                   == expected.find (key_query, query_interval));
+        }
+      }
+    }
+
+    THEN ("Current beliefs are the latest snapshot")
+    {
+      const auto current = dict.current ();
+      for (int key_query = 0; key_query < 4; ++key_query)
+      {
+        for (int query = -1; query < 105; query += 3)
+        {
+          REQUIRE (dict.find (key_query, query)
+                   == snapshot.find (key_query, query));
+          REQUIRE (current.find (key_query, query)
+                   == snapshot.find (key_query, query));
+        }
+      }
+    }
+
+    THEN ("Records are only kept for changes")
+    {
+      REQUIRE (dict.memory_usage ().total () > 0);
+      for (const auto &record : dict.records ())
+      {
+        REQUIRE (!boost::icl::is_empty (record.interval));
+      }
+    }
+  }
+}
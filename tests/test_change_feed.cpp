@@ -0,0 +1,412 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_change_feed.cpp
+/// \brief Test change observers and ChangeFeed by replaying changes onto a
+/// replica
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/bi_intervaldicticl.h>
+#include <interval_dict/change_feed.h>
+#include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicticl.h>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+  template<typename Dict>
+  void replay (Dict &replica, const typename Dict::ChangeBatchType &changes)
+  {
+    for (const auto &[key, value, interval, kind] : changes)
+    {
+      if (kind == interval_dict::ChangeKind::insert)
+      {
+        replica.insert ({{key, value, interval}});
+      }
+      else
+      {
+        replica.erase ({{key, value, interval}});
+      }
+    }
+  }
+
+  /// @return whether each insert in @p changes is absent from @p replica and
+  /// each erase present throughout its interval
+  template<typename Dict>
+  bool only_net_changes (const Dict &replica,
+                         const typename Dict::ChangeBatchType &changes)
+  {
+    for (const auto &[key, value, interval, kind] : changes)
+    {
+      typename Dict::Intervals present;
+      for (const auto &[_, other_value, other_interval] :
+           intervals (replica, key, interval))
+      {
+        if (other_value == value)
+        {
+          present += other_interval & interval;
+        }
+      }
+      if (kind == interval_dict::ChangeKind::insert
+            ? !boost::icl::is_empty (present)
+            : !boost::icl::within (interval, present))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+} // namespace
+
+TEST_CASE ("Test change observers", "[change_feed]")
+{
+  using Interval = boost::icl::interval<int>::type;
+  using Dict = interval_dict::IntervalDictICLExp<int, int, Interval>;
+  using Change = interval_dict::Change<int, int, Interval>;
+  using interval_dict::ChangeKind;
+
+  Dict dict;
+  std::vector<Dict::ChangeBatchType> batches;
+  const auto id = dict.add_observer ([&batches] (const auto &changes)
+                                     { batches.push_back (changes); });
+
+  GIVEN ("Overlapping inserts in one call")
+  {
+    dict.insert ({{1, 10, Interval {0, 10}},
+                  {1, 10, Interval {5, 20}},
+                  {2, 20, Interval {0, 5}}});
+    THEN ("They are coalesced into one batch")
+    {
+      REQUIRE (batches.size () == 1);
+      REQUIRE (batches[0]
+               == Dict::ChangeBatchType {
+                 Change {1, 10, Interval {0, 20}, ChangeKind::insert},
+                 Change {2, 20, Interval {0, 5}, ChangeKind::insert}});
+    }
+
+    WHEN ("Erasing a key over an interval")
+    {
+      dict.erase (1, Interval {15, 30});
+      THEN ("Only the values present are reported")
+      {
+        REQUIRE (batches.size () == 2);
+        REQUIRE (batches[1]
+                 == Dict::ChangeBatchType {
+                   Change {1, 10, Interval {15, 20}, ChangeKind::erase}});
+      }
+    }
+
+    WHEN ("Filling gaps")
+    {
+      dict.insert ({{3, 30, Interval {0, 5}}, {3, 30, Interval {10, 15}}});
+      dict.fill_gaps ();
+      THEN ("Internal inserts are published once")
+      {
+        REQUIRE (batches.size () == 3);
+        REQUIRE (batches[2]
+                 == Dict::ChangeBatchType {
+                   Change {3, 30, Interval {5, 10}, ChangeKind::insert}});
+      }
+    }
+
+    WHEN ("Inserts and erases are batched explicitly")
+    {
+      {
+        const auto batch = dict.batch_changes ();
+        dict.erase ({{2, 20, Interval {0, 5}}});
+        dict.insert ({{2, 20, Interval {0, 5}}});
+        dict.insert ({{2, 20, Interval {5, 8}}});
+      }
+      THEN ("Only the net changes are published")
+      {
+        REQUIRE (batches.size () == 2);
+        REQUIRE (batches[1]
+                 == Dict::ChangeBatchType {
+                   Change {2, 20, Interval {5, 8}, ChangeKind::insert}});
+      }
+    }
+
+    WHEN ("Associations already present are inserted")
+    {
+      dict.insert ({{1, 10, Interval {2, 8}}, {2, 20, Interval {0, 5}}});
+      dict += Dict ({{1, 10, Interval {0, 25}}});
+      THEN ("Only the new intervals are published")
+      {
+        REQUIRE (batches.size () == 2);
+        REQUIRE (batches[1]
+                 == Dict::ChangeBatchType {
+                   Change {1, 10, Interval {20, 25}, ChangeKind::insert}});
+      }
+    }
+
+    WHEN ("The observer is removed or the dictionary copied")
+    {
+      dict.remove_observer (id);
+      auto copy = dict;
+      dict.clear ();
+      copy.clear ();
+      THEN ("No changes are published")
+      {
+        REQUIRE (batches.size () == 1);
+      }
+    }
+  }
+
+  GIVEN ("Observers which add and remove observers")
+  {
+    std::vector<int> calls;
+    interval_dict::ObserverId self_id = 0;
+    interval_dict::ObserverId later_id = 0;
+    interval_dict::ObserverId added_id = 0;
+    self_id = dict.add_observer (
+      [&] (const auto &)
+      {
+        calls.push_back (1);
+        dict.remove_observer (self_id);
+        dict.remove_observer (later_id);
+        added_id = dict.add_observer ([&] (const auto &)
+                                      { calls.push_back (3); });
+      });
+    later_id = dict.add_observer ([&] (const auto &)
+                                  { calls.push_back (2); });
+    dict.insert ({{1, 10, Interval {0, 10}}});
+    THEN ("Only observers registered before and not yet removed are called")
+    {
+      REQUIRE (calls == std::vector<int> {1});
+      REQUIRE (batches.size () == 1);
+      dict.insert ({{1, 10, Interval {10, 20}}});
+      REQUIRE (calls == std::vector<int> {1, 3});
+      REQUIRE (batches.size () == 2);
+      dict.remove_observer (added_id);
+    }
+  }
+
+  GIVEN ("Assignment to an observed dictionary")
+  {
+    dict.insert ({{1, 10, Interval {0, 10}},
+                  {1, 11, Interval {5, 15}},
+                  {2, 20, Interval {0, 5}}});
+    Dict replica;
+    replay (replica, batches.back ());
+    batches.clear ();
+
+    WHEN ("Assigning the flattened dictionary")
+    {
+      dict = flattened (dict);
+      THEN ("Only the values removed by flattening are published")
+      {
+        REQUIRE (batches.size () == 1);
+        REQUIRE (std::ranges::all_of (
+          batches[0],
+          [] (const auto &change)
+          { return change.kind == interval_dict::ChangeKind::erase; }));
+        replay (replica, batches[0]);
+        REQUIRE (replica == dict);
+      }
+    }
+
+    WHEN ("Copy and move assigning other dictionaries")
+    {
+      Dict other ({{1, 10, Interval {20, 30}}, {3, 30, Interval {0, 5}}});
+      std::vector<Dict::ChangeBatchType> other_batches;
+      other.add_observer ([&other_batches] (const auto &changes)
+                          { other_batches.push_back (changes); });
+      dict = other;
+      replay (replica, batches.back ());
+      REQUIRE (replica == dict);
+      REQUIRE (batches.size () == 1);
+
+      // The same contents again
+      dict = std::move (other);
+      REQUIRE (batches.size () == 1);
+      THEN ("The observers of both dictionaries are kept")
+      {
+        dict.insert ({{4, 40, Interval {0, 5}}});
+        replay (replica, batches.back ());
+        REQUIRE (replica == dict);
+        REQUIRE (batches.size () == 2);
+        REQUIRE (other_batches.size () == 1);
+        dict.remove_observer (id);
+        dict.clear ();
+        REQUIRE (batches.size () == 2);
+        REQUIRE (other_batches.size () == 2);
+      }
+    }
+  }
+
+  GIVEN ("Random changes")
+  {
+    Dict replica;
+    std::mt19937 generator (7);
+    std::uniform_int_distribution<int> key (0, 20);
+    std::uniform_int_distribution<int> value (0, 5);
+    std::uniform_int_distribution<int> edge (0, 200);
+    std::uniform_int_distribution<int> length (1, 40);
+    const auto random_changes = [&] ()
+    {
+      Dict::KeyValueIntervals changes;
+      for (int i = 0; i < 20; ++i)
+      {
+        const auto lower = edge (generator);
+        changes.emplace_back (key (generator),
+                              value (generator),
+                              Interval {lower, lower + length (generator)});
+      }
+      return changes;
+    };
+
+    THEN ("Replaying the changes of every mutation gives the same dictionary")
+    {
+      for (int i = 0; i < 60; ++i)
+      {
+        switch (i % 6)
+        {
+        case 0:
+        case 1:
+          dict.insert (random_changes ());
+          break;
+        case 2:
+          dict.erase (random_changes ());
+          break;
+        case 3:
+          dict.erase (key (generator), Interval {50, 100});
+          break;
+        case 4:
+          dict += Dict (random_changes ());
+          break;
+        default:
+          dict = i % 12 == 5 ? flattened (dict)
+                             : flattened (std::move (dict));
+          break;
+        }
+        for (const auto &changes : batches)
+        {
+          REQUIRE (!changes.empty ());
+          REQUIRE (only_net_changes (replica, changes));
+          replay (replica, changes);
+        }
+        batches.clear ();
+        REQUIRE (replica == dict);
+      }
+      dict -= replica;
+      replay (replica, batches.back ());
+      REQUIRE (replica.empty ());
+    }
+  }
+}
+
+TEST_CASE ("Test change observers of bidirectional dictionaries",
+           "[change_feed]")
+{
+  using Interval = boost::icl::interval<int>::type;
+  using BiDict = interval_dict::BiIntervalDictICLExp<int, int, Interval>;
+  using Dict = interval_dict::IntervalDictICLExp<int, int, Interval>;
+
+  BiDict dict;
+  Dict replica;
+  dict.add_observer ([&replica] (const auto &changes)
+                     { replay (replica, changes); });
+  const auto forward = [&dict] ()
+  {
+    Dict::KeyValueIntervals key_value_intervals;
+    for (const auto &key_value_interval : intervals (dict))
+    {
+      key_value_intervals.push_back (key_value_interval);
+    }
+    return Dict (key_value_intervals);
+  };
+
+  GIVEN ("Changes with eager and lazy inverses")
+  {
+    dict.insert ({{1, 10, Interval {0, 10}},
+                  {1, 11, Interval {5, 20}},
+                  {2, 20, Interval {30, 40}}});
+    REQUIRE (replica == forward ());
+    dict.set_inverse_maintenance (interval_dict::InverseMaintenance::lazy);
+    dict.erase (1, Interval {8, 12});
+    dict.fill_gaps ();
+    REQUIRE (replica == forward ());
+    dict = flattened (dict);
+    REQUIRE (replica == forward ());
+  }
+}
+
+TEST_CASE ("Test change feeds", "[change_feed]")
+{
+  using Interval = boost::icl::interval<int>::type;
+  using Dict = interval_dict::IntervalDictAILExp<int, int, Interval>;
+
+  GIVEN ("A feed read on another thread")
+  {
+    Dict dict;
+    Dict replica;
+    const int count_changes = 2000;
+    {
+      interval_dict::ChangeFeed feed (dict, 16);
+      std::jthread reader (
+        [&]
+        {
+          int count_batches = 0;
+          while (count_batches + static_cast<int> (feed.count_dropped ())
+                 < count_changes)
+          {
+            if (const auto changes = feed.try_pop ())
+            {
+              replay (replica, *changes);
+              ++count_batches;
+            }
+          }
+        });
+      for (int i = 0; i < count_changes; ++i)
+      {
+        dict.insert ({{i % 50, i % 7, Interval {i, i + 10}}});
+      }
+      reader.join ();
+
+      THEN ("Every batch is either replayed or counted as dropped")
+      {
+        if (feed.count_dropped () == 0)
+        {
+          REQUIRE (replica == dict);
+        }
+        REQUIRE (feed.try_pop () == std::nullopt);
+      }
+    }
+
+    THEN ("Destroying the feed stops observing the dictionary")
+    {
+      dict.insert ({{1, 1, Interval {0, 1}}});
+    }
+  }
+
+  GIVEN ("A full ring buffer")
+  {
+    interval_dict::SpscRingBuffer<int> buffer (2);
+    REQUIRE (buffer.try_push (1));
+    REQUIRE (buffer.try_push (2));
+    REQUIRE (!buffer.try_push (3));
+    THEN ("Items are popped in order")
+    {
+      REQUIRE (buffer.try_pop () == 1);
+      REQUIRE (buffer.try_push (4));
+      REQUIRE (buffer.try_pop () == 2);
+      REQUIRE (buffer.try_pop () == 4);
+      REQUIRE (buffer.try_pop () == std::nullopt);
+      REQUIRE (buffer.empty ());
+    }
+  }
+}
@@ -0,0 +1,296 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_compaction.cpp
+/// \brief Test compaction policies and BackgroundCompactor
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/compaction.h>
+#include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicticl.h>
+
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+TEST_CASE ("Test compaction of IntervalDictAIL", "[compaction]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using Tuning = interval_dict::augmented_interval_list::Tuning;
+  using Dict = interval_dict::IntervalDictAILExp<int, int, Interval>;
+  using namespace std::chrono_literals;
+
+  std::vector<std::tuple<int, int, Interval>> key_value_intervals;
+  for (int i = 0; i < 1000; ++i)
+  {
+    key_value_intervals.emplace_back (i % 2, i, Interval {i, i + 1 + i % 13});
+  }
+  std::vector<std::tuple<int, int, Interval>> erased;
+  for (int i = 0; i < 1000; i += 3)
+  {
+    erased.push_back (key_value_intervals[i]);
+  }
+
+  Dict expected (key_value_intervals);
+  expected.erase (erased);
+
+  const auto same_values = [&] (const Dict &dict)
+  {
+    for (int key = 0; key < 2; ++key)
+    {
+      for (int query = 0; query < 1020; query += 7)
+      {
+        if (dict.find (key, Interval {query, query + 3})
+            != expected.find (key, Interval {query, query + 3}))
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  GIVEN ("Compaction left to the background")
+  {
+    Dict dict (key_value_intervals);
+    dict.tune (Tuning {.compact_in_foreground = false});
+    dict.erase (erased);
+    REQUIRE (same_values (dict));
+
+    THEN ("compact() integrates erases without changing values")
+    {
+      REQUIRE (dict.compact () == 2);
+      REQUIRE (dict.compact () == 0);
+      REQUIRE (same_values (dict));
+    }
+
+    THEN ("BackgroundCompactor swaps in compacted keys")
+    {
+      std::mutex mutex;
+      interval_dict::BackgroundCompactor compactor (dict, mutex, 1h);
+      // The worker thread may already have compacted both keys
+      compactor.stop ();
+      compactor.compact_once ();
+      REQUIRE (compactor.count_compacted () == 2);
+      REQUIRE (compactor.count_discarded () == 0);
+      const std::lock_guard lock (mutex);
+      REQUIRE (dict.compact () == 0);
+      REQUIRE (same_values (dict));
+    }
+
+    THEN ("The worker thread compacts when woken")
+    {
+      std::mutex mutex;
+      interval_dict::BackgroundCompactor compactor (dict, mutex, 1h);
+      compactor.wake ();
+      for (int i = 0; i < 1000 && compactor.count_compacted () < 2; ++i)
+      {
+        std::this_thread::sleep_for (1ms);
+      }
+      compactor.stop ();
+      REQUIRE (compactor.count_compacted () == 2);
+      REQUIRE (same_values (dict));
+    }
+  }
+
+  GIVEN ("A dictionary modified while keys are being compacted")
+  {
+    Dict dict (key_value_intervals);
+    dict.tune (Tuning {.max_fraction_pending = 0.01,
+                       .compact_in_foreground = false});
+    std::mutex mutex;
+    interval_dict::BackgroundCompactor compactor (dict, mutex, 1h);
+    for (const auto &key_value_interval : erased)
+    {
+      const std::lock_guard lock (mutex);
+      dict.erase ({key_value_interval});
+      compactor.wake ();
+    }
+    compactor.stop ();
+
+    THEN ("No changes are lost")
+    {
+      compactor.compact_once ();
+      REQUIRE (dict.compact () == 0);
+      REQUIRE (same_values (dict));
+    }
+  }
+
+  GIVEN ("A list modified after it was copied for compaction")
+  {
+    using List = interval_dict::augmented_interval_list::
+      AugmentedIntervalList<int, Interval>;
+    List list;
+    for (int i = 0; i < 100; ++i)
+    {
+      list.insert (Interval {i, i + 5}, i);
+    }
+    auto compacted = list;
+    REQUIRE (compacted.generation () == list.generation ());
+    compacted.compact ();
+    list.erase (Interval {0, 5}, 0);
+
+    THEN ("Its generation no longer matches the copy")
+    {
+      REQUIRE (compacted.generation () != list.generation ());
+      auto copy = list;
+      REQUIRE (copy.generation () == list.generation ());
+    }
+  }
+
+  GIVEN ("A limit on the count of pending changes")
+  {
+    Dict dict (key_value_intervals);
+    dict.tune (Tuning {.max_fraction_pending = 1.0,
+                       .max_count_pending = 10,
+                       .compact_in_foreground = false});
+    std::vector<std::tuple<int, int, Interval>> few (erased.begin (),
+                                                     erased.begin () + 10);
+    dict.erase (few);
+    REQUIRE (dict.compact () == 0);
+    dict.erase (erased);
+    REQUIRE (dict.compact () == 2);
+    REQUIRE (same_values (dict));
+  }
+
+  GIVEN ("A limit on the age of pending changes")
+  {
+    Dict dict (key_value_intervals);
+    dict.tune (Tuning {.max_fraction_pending = 1.0,
+                       .max_age_pending = 5ms,
+                       .compact_in_foreground = false});
+    dict.erase (erased);
+    REQUIRE (dict.compact () == 0);
+    std::this_thread::sleep_for (20ms);
+    REQUIRE (dict.compact () == 2);
+    REQUIRE (same_values (dict));
+  }
+
+  GIVEN ("Compaction policy written to a stream")
+  {
+    const Tuning tuning {.max_count_pending = 100,
+                         .max_age_pending = 250ms,
+                         .compact_in_foreground = false};
+    std::stringstream stream;
+    stream << tuning;
+    THEN ("It is read back unchanged")
+    {
+      Tuning read_back;
+      REQUIRE (stream >> read_back);
+      REQUIRE (read_back == tuning);
+    }
+  }
+}
+
+TEST_CASE ("Test merging and subtracting IntervalDictAIL", "[compaction]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using Tuning = interval_dict::augmented_interval_list::Tuning;
+  using Dict = interval_dict::IntervalDictAILExp<int, int, Interval>;
+  using Reference = interval_dict::IntervalDictICLExp<int, int, Interval>;
+  using KeyValueIntervals = std::vector<std::tuple<int, int, Interval>>;
+
+  std::mt19937 generator (17);
+  std::uniform_int_distribution<int> key (0, 1);
+  std::uniform_int_distribution<int> value (0, 20);
+  std::uniform_int_distribution<int> edge (0, 1000);
+  std::uniform_int_distribution<int> length (1, 10);
+  const auto random_intervals = [&] (int count)
+  {
+    KeyValueIntervals key_value_intervals;
+    for (int i = 0; i < count; ++i)
+    {
+      const auto lower = edge (generator);
+      key_value_intervals.emplace_back (
+        key (generator),
+        value (generator),
+        Interval {lower, lower + length (generator)});
+    }
+    return key_value_intervals;
+  };
+  const auto disjoint = [] (const auto &dict)
+  {
+    std::vector<std::tuple<int, std::vector<int>, Interval>> results;
+    for (const auto &[key, values, interval] : disjoint_intervals (dict))
+    {
+      results.emplace_back (
+        key, std::vector<int> (values.begin (), values.end ()), interval);
+    }
+    return results;
+  };
+  const auto same_values = [&] (const Dict &dict, const Reference &reference)
+  {
+    for (int key = 0; key < 2; ++key)
+    {
+      for (int query = 0; query < 1100; ++query)
+      {
+        if (dict.find (key, Interval {query, query + 2})
+            != reference.find (key, Interval {query, query + 2}))
+        {
+          return false;
+        }
+      }
+    }
+    return disjoint (dict) == disjoint (reference);
+  };
+
+  // Many intervals per key, so that runs are kept between updates
+  GIVEN ("Dictionaries with pending inserts and erases")
+  {
+    auto initial = random_intervals (2000);
+    Dict dict (initial);
+    Reference reference (initial);
+    THEN ("Merging and subtracting large dictionaries matches ICL")
+    {
+      for (int round = 0; round < 6; ++round)
+      {
+        // Few enough to be left pending
+        const auto inserts = random_intervals (20);
+        const auto erases = random_intervals (20);
+        dict.insert (inserts);
+        reference.insert (inserts);
+        dict.erase (erases);
+        reference.erase (erases);
+
+        const auto others = random_intervals (2000);
+        if (round % 2 == 0)
+        {
+          dict += Dict (others);
+          reference += Reference (others);
+        }
+        else
+        {
+          dict -= Dict (others);
+          reference -= Reference (others);
+        }
+        REQUIRE (same_values (dict, reference));
+      }
+    }
+
+    THEN ("With compaction left to the background, nothing is rebuilt")
+    {
+      dict.tune (Tuning {.compact_in_foreground = false});
+      const auto others = random_intervals (2000);
+      dict += Dict (others);
+      reference += Reference (others);
+      dict -= Dict (initial);
+      reference -= Reference (initial);
+      REQUIRE (same_values (dict, reference));
+      REQUIRE (dict.compact () == 2);
+      REQUIRE (same_values (dict, reference));
+    }
+  }
+}
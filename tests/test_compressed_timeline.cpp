@@ -0,0 +1,238 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_compressed_timeline.cpp
+/// \brief Test IntervalDictTimelineExp against IntervalDictICLExp and
+/// IntervalDictAILExp
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/gregorian.h>
+#include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicticl.h>
+#include <interval_dict/intervaldicttimeline.h>
+
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+  /// Point @p offset days or units from an arbitrary origin
+  template<typename BaseType> BaseType point (int offset)
+  {
+    if constexpr (std::is_same_v<BaseType, boost::gregorian::date>)
+    {
+      return boost::gregorian::date {2020, 1, 1}
+             + boost::gregorian::days {offset};
+    }
+    else
+    {
+      return offset;
+    }
+  }
+
+  /// Difference of @p count days or units
+  template<typename BaseType> auto duration (int count)
+  {
+    if constexpr (std::is_same_v<BaseType, boost::gregorian::date>)
+    {
+      return boost::gregorian::days {count};
+    }
+    else
+    {
+      return count;
+    }
+  }
+
+  template<typename Dict> auto snapshot (const Dict &dict)
+  {
+    std::vector<std::tuple<int, std::vector<int>, typename Dict::IntervalType>>
+      results;
+    for (const auto &[key, values, interval] : disjoint_intervals (dict))
+    {
+      results.emplace_back (
+        key, std::vector<int> (values.begin (), values.end ()), interval);
+    }
+    return results;
+  }
+} // namespace
+
+TEMPLATE_TEST_CASE ("Test compressed timelines for different interval types",
+                    "[compressed_timeline]",
+                    boost::icl::interval<int>::type,
+                    boost::icl::right_open_interval<int>,
+                    boost::icl::left_open_interval<int>,
+                    boost::icl::open_interval<int>,
+                    boost::icl::closed_interval<int>,
+                    boost::icl::interval<boost::gregorian::date>::type,
+                    boost::icl::right_open_interval<boost::gregorian::date>,
+                    boost::icl::closed_interval<boost::gregorian::date>)
+{
+  using Interval = TestType;
+  using BaseType = typename boost::icl::interval_traits<Interval>::domain_type;
+  using Timeline = interval_dict::IntervalDictTimelineExp<int, int, Interval>;
+  using Expected = interval_dict::IntervalDictICLExp<int, int, Interval>;
+  const auto make_interval = [] (int lower, int upper)
+  {
+    return boost::icl::construct<Interval> (point<BaseType> (lower),
+                                            point<BaseType> (upper));
+  };
+
+  GIVEN ("The same random inserts and erases")
+  {
+    Timeline timeline;
+    Expected expected;
+    std::mt19937 generator (42);
+    std::uniform_int_distribution<int> key (0, 2);
+    std::uniform_int_distribution<int> value (0, 4);
+    std::uniform_int_distribution<int> edge (-30, 60);
+    std::uniform_int_distribution<int> length (2, 12);
+    for (int i = 0; i < 400; ++i)
+    {
+      const auto lower = edge (generator);
+      const auto interval = make_interval (lower, lower + length (generator));
+      const std::vector<std::tuple<int, int, Interval>> changes {
+        {key (generator), value (generator), interval}};
+      if (i % 3 == 2)
+      {
+        timeline.erase (changes);
+        expected.erase (changes);
+      }
+      else
+      {
+        timeline.insert (changes);
+        expected.insert (changes);
+      }
+      if (i % 50 == 49)
+      {
+        timeline.erase (make_interval (lower, lower + 3));
+        expected.erase (make_interval (lower, lower + 3));
+      }
+    }
+
+    THEN ("Disjoint intervals match")
+    {
+      REQUIRE (snapshot (timeline) == snapshot (expected));
+    }
+
+    THEN ("Point and range queries match")
+    {
+      for (int key_query = 0; key_query < 3; ++key_query)
+      {
+        for (int lower = -40; lower < 80; lower += 7)
+        {
+          const auto query = make_interval (lower, lower + 5);
+          REQUIRE (timeline.find (key_query, query)
+                   == expected.find (key_query, query));
+          REQUIRE (timeline.find (key_query, point<BaseType> (lower))
+                   == expected.find (key_query, point<BaseType> (lower)));
+        }
+      }
+    }
+
+    THEN ("Filling and extending into gaps match")
+    {
+      auto filled_timeline = timeline;
+      auto filled_expected = expected;
+      filled_timeline.fill_gaps (duration<BaseType> (5));
+      filled_expected.fill_gaps (duration<BaseType> (5));
+      REQUIRE (snapshot (filled_timeline) == snapshot (filled_expected));
+
+      filled_timeline.extend_into_gaps (
+        interval_dict::GapExtensionDirection::Both);
+      filled_expected.extend_into_gaps (
+        interval_dict::GapExtensionDirection::Both);
+      REQUIRE (snapshot (filled_timeline) == snapshot (filled_expected));
+    }
+
+    THEN ("Inverses and merges match")
+    {
+      REQUIRE (snapshot (timeline.invert ()) == snapshot (expected.invert ()));
+
+      auto merged_timeline = timeline;
+      auto merged_expected = expected;
+      merged_timeline += timeline.invert ();
+      merged_expected += expected.invert ();
+      REQUIRE (snapshot (merged_timeline) == snapshot (merged_expected));
+
+      merged_timeline -= timeline;
+      merged_expected -= expected;
+      REQUIRE (snapshot (merged_timeline) == snapshot (merged_expected));
+    }
+  }
+}
+
+TEST_CASE ("Test compressed timeline of daily snapshots",
+           "[compressed_timeline]")
+{
+  using Interval = boost::icl::right_open_interval<boost::gregorian::date>;
+  using Timeline = interval_dict::IntervalDictTimelineExp<int, int, Interval>;
+  using Expected = interval_dict::IntervalDictAILExp<int, int, Interval>;
+
+  GIVEN ("Ten years of daily snapshots, with a gap every hundred days")
+  {
+    std::vector<std::tuple<int, int, Interval>> snapshots;
+    for (int day = 0; day < 3650; ++day)
+    {
+      if (day % 100 == 99)
+      {
+        continue;
+      }
+      const Interval today {point<boost::gregorian::date> (day),
+                            point<boost::gregorian::date> (day + 1)};
+      snapshots.emplace_back (1, day / 1000, today);
+      snapshots.emplace_back (2, 7, today);
+    }
+    const Timeline timeline (snapshots);
+    const Expected expected (snapshots);
+
+    THEN ("Each unbroken stretch is a single run")
+    {
+      REQUIRE (snapshot (timeline) == snapshot (expected));
+      // 36 gaps split each key into 37 runs. Key 1 changes value on days
+      // that are already gaps
+      REQUIRE (timeline.memory_usage ().usage.bytes_runs
+               == (37 + 37) * 2 * sizeof (std::uint32_t));
+      REQUIRE (timeline.memory_usage ().total ()
+               < expected.memory_usage ().total ());
+    }
+
+    THEN ("Gaps are filled")
+    {
+      auto filled_timeline = timeline;
+      auto filled_expected = expected;
+      filled_timeline.fill_gaps ();
+      filled_expected.fill_gaps ();
+      REQUIRE (snapshot (filled_timeline) == snapshot (filled_expected));
+    }
+  }
+
+  GIVEN ("An earlier insert than any so far")
+  {
+    Timeline timeline;
+    timeline.insert (
+      {{1, 1, Interval {point<boost::gregorian::date> (10),
+                        point<boost::gregorian::date> (20)}},
+       {1, 1, Interval {point<boost::gregorian::date> (-5),
+                        point<boost::gregorian::date> (10)}}});
+    THEN ("Runs are moved to the new epoch and merged")
+    {
+      REQUIRE (snapshot (timeline)
+               == std::vector<std::tuple<int, std::vector<int>, Interval>> {
+                 {1,
+                  {1},
+                  Interval {point<boost::gregorian::date> (-5),
+                            point<boost::gregorian::date> (20)}}});
+    }
+  }
+}
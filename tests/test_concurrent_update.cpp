@@ -0,0 +1,250 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_concurrent_update.cpp
+/// \brief Test BiIntervalDictExp updating its forward and inverse
+/// dictionaries on separate threads
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/bi_intervaldictail.h>
+
+#include <atomic>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+  /// Value whose copies throw once a countdown reaches zero
+  struct Fragile
+  {
+    /// Number of copies before one throws, or negative never to throw
+    static inline std::atomic<int> copies_before_throw = -1;
+
+    int value = 0;
+
+    Fragile (int value)
+      : value (value)
+    {
+    }
+
+    Fragile (const Fragile &other)
+      : value (other.value)
+    {
+      if (copies_before_throw.fetch_sub (1) == 0)
+      {
+        throw std::runtime_error ("Fragile copy");
+      }
+    }
+
+    Fragile &operator= (const Fragile &other) = default;
+
+    auto operator<=> (const Fragile &) const = default;
+  };
+} // namespace
+
+TEST_CASE ("Test concurrent forward and inverse updates", "[concurrent]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using BiDict = interval_dict::BiIntervalDictAILExp<int, int, Interval>;
+  using KeyValueIntervals = std::vector<std::tuple<int, int, Interval>>;
+
+  KeyValueIntervals key_value_intervals;
+  KeyValueIntervals erased;
+  for (int i = 0; i < 2000; ++i)
+  {
+    key_value_intervals.emplace_back (
+      i % 31, i % 17, Interval {(i * 37) % 500, (i * 37) % 500 + 1 + i % 43});
+  }
+  for (int i = 0; i < 600; i += 2)
+  {
+    erased.emplace_back (i % 31, i % 17, Interval {i % 500, i % 500 + 60});
+  }
+
+  const auto to_string = [] (const BiDict &dict)
+  {
+    std::stringstream stream;
+    stream << dict << dict.invert ();
+    return stream.str ();
+  };
+
+  BiDict concurrent;
+  BiDict serial;
+  concurrent.set_min_count_concurrent (0);
+  serial.set_min_count_concurrent (std::numeric_limits<std::size_t>::max ());
+  const auto both = [&] (auto change)
+  {
+    change (concurrent);
+    change (serial);
+  };
+
+  GIVEN ("The same inserts and erases")
+  {
+    both (
+      [&] (BiDict &dict)
+      {
+        dict.insert (key_value_intervals);
+        dict.erase (erased);
+        dict.erase (3, Interval {100, 200});
+        dict.erase (Interval {250, 260});
+        dict.inverse_insert (std::vector<std::pair<int, int>> {{20, 1}},
+                             Interval {0, 400});
+      });
+    THEN ("Both directions agree with updates on a single thread")
+    {
+      REQUIRE (to_string (concurrent) == to_string (serial));
+      for (int value = 0; value < 21; ++value)
+      {
+        REQUIRE (concurrent.inverse_find (value, Interval {0, 600})
+                 == serial.inverse_find (value, Interval {0, 600}));
+      }
+    }
+
+    WHEN ("Whole dictionaries are added and subtracted")
+    {
+      const BiDict other (erased);
+      both (
+        [&] (BiDict &dict)
+        {
+          dict += other;
+          dict -= BiDict (key_value_intervals);
+        });
+      THEN ("Both still agree")
+      {
+        REQUIRE (to_string (concurrent) == to_string (serial));
+      }
+    }
+
+    WHEN ("Joined to another dictionary")
+    {
+      const BiDict other (erased);
+      THEN ("The results agree")
+      {
+        REQUIRE (to_string (concurrent.joined_to (other))
+                 == to_string (serial.joined_to (other)));
+      }
+    }
+  }
+}
+
+TEST_CASE ("Test concurrent joins", "[concurrent]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using AToB = interval_dict::BiIntervalDictAILExp<int, std::string, Interval>;
+  using BToC
+    = interval_dict::BiIntervalDictAILExp<std::string, double, Interval>;
+
+  // The inverse C -> A can only be joined concurrently from C -> B and B -> A
+  // if it has the same type as the inverse of the results
+  using Results = decltype (std::declval<AToB> ().joined_to (
+    std::declval<BToC> ()));
+  static_assert (
+    std::is_same_v<decltype (std::declval<BToC::InverseDict> ().joined_to (
+                     std::declval<AToB::InverseDict> ())),
+                   Results::InverseDict>);
+
+  AToB a_to_b;
+  BToC b_to_c;
+  for (int i = 0; i < 500; ++i)
+  {
+    a_to_b.insert ({{i % 23, std::to_string (i % 13), Interval {i, i + 30}}});
+    b_to_c.insert (
+      {{std::to_string (i % 13), i % 7 + 0.5, Interval {i, i + 9}}});
+  }
+
+  GIVEN ("Joins with and without concurrent threads")
+  {
+    a_to_b.set_min_count_concurrent (0);
+    const auto concurrent = a_to_b.joined_to (b_to_c);
+    a_to_b.set_min_count_concurrent (std::numeric_limits<std::size_t>::max ());
+    const auto serial = a_to_b.joined_to (b_to_c);
+    THEN ("The results and their inverses agree")
+    {
+      REQUIRE (concurrent == serial);
+      REQUIRE (concurrent.values () == serial.values ());
+      for (double value = 0.5; value < 7; value += 1)
+      {
+        REQUIRE (concurrent.inverse_find (value, Interval {0, 600})
+                 == serial.inverse_find (value, Interval {0, 600}));
+      }
+    }
+  }
+}
+
+TEST_CASE ("Test exceptions during concurrent updates", "[concurrent]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using BiDict = interval_dict::BiIntervalDictAILExp<int, Fragile, Interval>;
+  using KeyValueIntervals = std::vector<std::tuple<int, Fragile, Interval>>;
+
+  KeyValueIntervals key_value_intervals;
+  for (int i = 0; i < 300; ++i)
+  {
+    key_value_intervals.emplace_back (
+      i % 13, Fragile {i % 11}, Interval {(i * 37) % 200, (i * 37) % 200 + 20});
+  }
+
+  // The inverse must match the forward dictionary, whatever state it was
+  // left in
+  const auto require_consistent = [] (const BiDict &dict)
+  {
+    KeyValueIntervals forward;
+    for (const auto &[key, value, interval] :
+         intervals (dict, interval_dict::interval_extent<Interval>))
+    {
+      forward.emplace_back (key, value, interval);
+    }
+    const BiDict rebuilt (forward);
+    REQUIRE (dict.values () == rebuilt.values ());
+    for (int value = 0; value < 11; ++value)
+    {
+      for (int query = 0; query < 220; query += 7)
+      {
+        const Interval query_interval {query, query + 5};
+        REQUIRE (dict.inverse_find (Fragile {value}, query_interval)
+                 == rebuilt.inverse_find (Fragile {value}, query_interval));
+      }
+    }
+  };
+
+  GIVEN ("Copies of values that throw part way through each update")
+  {
+    for (int copies_before_throw = 0; copies_before_throw < 400;
+         copies_before_throw += 13)
+    {
+      BiDict dict (key_value_intervals);
+      dict.set_min_count_concurrent (0);
+      Fragile::copies_before_throw = copies_before_throw;
+      bool thrown = false;
+      try
+      {
+        dict.erase (key_value_intervals);
+        dict.insert (key_value_intervals);
+        dict += BiDict (key_value_intervals);
+      }
+      catch (const std::runtime_error &)
+      {
+        thrown = true;
+      }
+      Fragile::copies_before_throw = -1;
+      THEN ("The exception is rethrown and the inverse is consistent")
+      {
+        REQUIRE (thrown);
+        require_consistent (dict);
+      }
+    }
+  }
+}
@@ -21,9 +21,11 @@
 
 #include "test_utils.h"
 #include <interval_dict/bi_intervaldictail.h>
+#include <interval_dict/bi_intervaldicthybrid.h>
 #include <interval_dict/bi_intervaldicticl.h>
 #include <interval_dict/bi_intervaldictitree.h>
 #include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicthybrid.h>
 #include <interval_dict/intervaldicticl.h>
 #include <interval_dict/intervaldictitree.h>
 
@@ -148,7 +150,8 @@ namespace test_detail
 
   // Expected results from calling disjoint_intervals()
   template<typename Interval>
-  std::vector<std::tuple<std::string, std::vector<int>, Interval>>
+  std::vector<
+    interval_dict::KeyValuesDisjointInterval<std::string, int, Interval>>
   disjoint_intervals (const std::vector<typename Interval::domain_type> &values)
   {
     using namespace std::string_literals;
@@ -394,7 +397,8 @@ struct TestData
     return test_detail::to_str<Interval> (values);
   }
 
-  std::vector<std::tuple<std::string, std::vector<int>, Interval>>
+  std::vector<
+    interval_dict::KeyValuesDisjointInterval<std::string, int, Interval>>
   disjoint_intervals () const
   {
     return test_detail::disjoint_intervals<Interval> (values);
@@ -57,7 +57,8 @@ TEMPLATE_TEST_CASE ("Test disjoint intervals for different interval types",
   using Value = int;
   using IDict = interval_dict::INTERVALDICTTESTTYPE<Key, Value, Interval>;
   static_assert(std::same_as<Interval, typename IDict::IntervalType>);
-  using ImportData = std::vector<std::tuple<Key, std::vector<Value>, Interval>>;
+  using ImportData = std::vector<
+    interval_dict::KeyValuesDisjointInterval<Key, Value, Interval>>;
 
   /*
    * TestData
@@ -0,0 +1,106 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_edge_encoding.cpp
+/// \brief Test that EdgeEncoding of dates and times round trips and
+/// preserves order
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/gregorian.h>
+#include <interval_dict/intervaldictail.h>
+#include <interval_dict/ptime.h>
+
+#include <vector>
+
+TEST_CASE ("Test EdgeEncoding", "[edge_encoding]")
+{
+  using namespace interval_dict::date_literals;
+  using namespace interval_dict::ptime_literals;
+
+  const auto require_encoding = [] (const auto &sorted_edges)
+  {
+    using Encoding = interval_dict::EdgeEncoding<
+      std::decay_t<decltype (sorted_edges.front ())>>;
+    for (std::size_t i = 0; i < sorted_edges.size (); ++i)
+    {
+      const auto encoded = Encoding::encode (sorted_edges[i]);
+      REQUIRE (Encoding::encode (Encoding::decode (encoded)) == encoded);
+      if (i > 0)
+      {
+        REQUIRE (Encoding::encode (sorted_edges[i - 1]) < encoded);
+      }
+    }
+  };
+
+  GIVEN ("Dates including special values")
+  {
+    using boost::gregorian::date;
+    const std::vector<date> dates {date {boost::date_time::neg_infin},
+                                   date {boost::date_time::min_date_time},
+                                   20100101_dt,
+                                   20100102_dt,
+                                   20240229_dt,
+                                   date {boost::date_time::max_date_time},
+                                   date {boost::date_time::not_a_date_time},
+                                   date {boost::date_time::pos_infin}};
+    THEN ("Encoding round trips and preserves order")
+    {
+      require_encoding (dates);
+      REQUIRE (interval_dict::EdgeEncoding<date>::decode (
+                 interval_dict::EdgeEncoding<date>::encode (20240229_dt))
+               == 20240229_dt);
+    }
+  }
+
+  GIVEN ("Times including special values")
+  {
+    using boost::posix_time::ptime;
+    const std::vector<ptime> times {
+      ptime {boost::date_time::neg_infin},
+      ptime {boost::date_time::min_date_time},
+      "20100101T000000"_pt,
+      "20100101T000000.000001"_pt,
+      "20100101T120000"_pt,
+      ptime {boost::date_time::max_date_time},
+      ptime {boost::date_time::not_a_date_time},
+      ptime {boost::date_time::pos_infin}};
+    THEN ("Encoding round trips and preserves order")
+    {
+      require_encoding (times);
+      REQUIRE (interval_dict::EdgeEncoding<ptime>::decode (
+                 interval_dict::EdgeEncoding<ptime>::encode (
+                   "20100101T120000"_pt))
+               == "20100101T120000"_pt);
+    }
+  }
+
+  GIVEN ("An AIL dictionary over dates")
+  {
+    using Interval = boost::icl::right_open_interval<boost::gregorian::date>;
+    interval_dict::IntervalDictAILExp<int, int, Interval> dict;
+    auto tuning = dict.tuning ();
+    tuning.max_brute_force_run_length = 0;
+    dict.tune (tuning);
+    dict.insert ({{1, 1, Interval {20100101_dt, 20100301_dt}},
+                  {1, 2, Interval {20100115_dt, 20100120_dt}},
+                  {1, 3, Interval {20100201_dt, 20100401_dt}}});
+    THEN ("Queries compare encoded right edges")
+    {
+      REQUIRE (dict.find (1, Interval {20100118_dt, 20100119_dt})
+               == std::vector {1, 2});
+      REQUIRE (dict.find (1, Interval {20100301_dt, 20100302_dt})
+               == std::vector {3});
+      REQUIRE (dict.find (1, Interval {20100120_dt, 20100201_dt})
+               == std::vector {1});
+    }
+  }
+}
@@ -172,3 +172,44 @@ TEMPLATE_TEST_CASE ("Test find() for different interval types",
     }
   }
 }
+
+TEST_CASE ("Test explain() reports the work done by find()", "[find][explain]")
+{
+  using namespace std::string_literals;
+  using Interval = boost::icl::right_open_interval<int>;
+  using IDict = interval_dict::INTERVALDICTTESTTYPE<std::string, int, Interval>;
+  IDict test_dict;
+  for (int i = 0; i < 200; ++i)
+  {
+    test_dict.insert ({{"aa"s, i}}, Interval {i * 10, i * 10 + 15});
+  }
+
+  GIVEN ("A query over a present key")
+  {
+    const auto explain = test_dict.explain ("aa"s, Interval {500, 520});
+    THEN ("The values counted match find()")
+    {
+      REQUIRE (explain.key_found);
+      REQUIRE (!explain.backend.empty ());
+      REQUIRE (explain.count_values
+               == test_dict.find ("aa"s, Interval {500, 520}).size ());
+      REQUIRE (explain.count_matched > 0);
+      std::size_t count_work = explain.nodes_visited + explain.segments_touched;
+      for (const auto &run : explain.runs)
+      {
+        REQUIRE (run.elements_matched <= run.elements_scanned);
+        count_work += run.elements_scanned;
+      }
+      REQUIRE (count_work > 0);
+    }
+  }
+  GIVEN ("A query over a missing key")
+  {
+    const auto explain = test_dict.explain ("zz"s);
+    THEN ("Nothing is done")
+    {
+      REQUIRE (!explain.key_found);
+      REQUIRE (explain.count_values == 0);
+    }
+  }
+}
@@ -0,0 +1,84 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_hybrid.cpp
+/// \brief Test promotion and demotion between the representations of
+/// HybridIntervalList
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/intervaldicthybrid.h>
+
+#include <algorithm>
+
+TEST_CASE ("Test promotion and demotion of HybridIntervalList", "[hybrid]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using Large
+    = interval_dict::augmented_interval_list::AugmentedIntervalList<int,
+                                                                    Interval>;
+  using Hybrid
+    = interval_dict::hybrid::HybridIntervalList<int, Interval, Large, 8>;
+  static_assert (Hybrid::max_demote == 4);
+
+  Hybrid hybrid;
+  for (int i = 0; i < 8; ++i)
+  {
+    hybrid.insert (Interval {i * 10, i * 10 + 5}, i);
+  }
+  REQUIRE (!hybrid.is_large ());
+
+  GIVEN ("More interval-values than fit in the small vector")
+  {
+    hybrid.insert (Interval {80, 85}, 8);
+    REQUIRE (hybrid.is_large ());
+
+    WHEN ("Erasing down to the promotion threshold")
+    {
+      hybrid.erase (Interval {80, 85}, 8);
+      THEN ("Large is kept")
+      {
+        REQUIRE (hybrid.is_large ());
+      }
+    }
+
+    WHEN ("Erasing values one by one")
+    {
+      for (int i = 8; i >= 5; --i)
+      {
+        hybrid.erase (Interval {i * 10, i * 10 + 5}, i);
+        REQUIRE (hybrid.is_large ());
+      }
+      hybrid.erase (Interval {40, 45}, 4);
+      THEN ("The small vector is used again once no more than half remain")
+      {
+        REQUIRE (!hybrid.is_large ());
+        Hybrid expected;
+        for (int i = 0; i < 4; ++i)
+        {
+          expected.insert (Interval {i * 10, i * 10 + 5}, i);
+        }
+        REQUIRE (hybrid == expected);
+      }
+    }
+
+    WHEN ("Erasing all values over an interval")
+    {
+      hybrid.erase (Interval {25, 100});
+      THEN ("The small vector is used again")
+      {
+        REQUIRE (!hybrid.is_large ());
+        REQUIRE (std::ranges::distance (hybrid.intervals (Interval {0, 100}))
+                 == 3);
+      }
+    }
+  }
+}
@@ -0,0 +1,214 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_interned.cpp
+/// \brief Test InternedIntervalDictExp against IntervalDictAILExp
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/interned_intervaldictail.h>
+#include <interval_dict/intervaldictail.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+TEST_CASE ("Test InternedIntervalDictExp", "[interned]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using Dict
+    = interval_dict::IntervalDictAILExp<std::string, std::string, Interval>;
+  using InternedDict = interval_dict::
+    InternedIntervalDictAILExp<std::string, std::string, Interval>;
+  using KeyValueIntervals
+    = std::vector<std::tuple<std::string, std::string, Interval>>;
+
+  // Insert in an order where ids do not sort like their symbols
+  KeyValueIntervals key_value_intervals;
+  for (int i = 0; i < 500; ++i)
+  {
+    key_value_intervals.emplace_back ("key" + std::to_string ((i * 7) % 23),
+                                      "value" + std::to_string ((i * 5) % 19),
+                                      Interval {i % 97, i % 97 + 1 + i % 13});
+  }
+
+  const auto require_same = [] (const InternedDict &interned, const Dict &dict)
+  {
+    REQUIRE (interned.keys () == dict.keys ());
+    REQUIRE (interned.size () == dict.size ());
+    for (const auto &key : dict.keys ())
+    {
+      for (int query = 0; query < 120; query += 11)
+      {
+        const Interval query_interval {query, query + 5};
+        REQUIRE (interned.find (key, query_interval)
+                 == dict.find (key, query_interval));
+      }
+      REQUIRE (interned.find (key, 40) == dict.find (key, 40));
+    }
+    const std::vector<std::string> some_keys {"key1", "key2", "unknown"};
+    REQUIRE (interned.find (some_keys, Interval {0, 50})
+             == dict.find (std::vector<std::string> {"key1", "key2"},
+                           Interval {0, 50}));
+  };
+
+  const auto interned_from = [] (const Dict &dict)
+  {
+    KeyValueIntervals key_value_intervals;
+    for (const auto &key_value_interval : intervals (dict))
+    {
+      key_value_intervals.push_back (key_value_interval);
+    }
+    return InternedDict (key_value_intervals);
+  };
+
+  GIVEN ("An interned and a plain dictionary with the same data")
+  {
+    InternedDict interned (key_value_intervals);
+    Dict dict (key_value_intervals);
+    require_same (interned, dict);
+    REQUIRE (interned.key_symbols ()->size () == 23);
+    REQUIRE (interned.value_symbols ()->size () == 19);
+
+    WHEN ("Intervals are erased for key-values, keys and all keys")
+    {
+      KeyValueIntervals erased {{"key3", "value4", Interval {0, 60}},
+                                {"unknown", "value4", Interval {0, 60}}};
+      interned.erase (erased);
+      dict.erase (erased);
+      interned.erase ("key5", Interval {10, 30});
+      dict.erase ("key5", Interval {10, 30});
+      interned.erase ("unknown");
+      interned.erase (Interval {70, 80});
+      dict.erase (Interval {70, 80});
+      THEN ("Both still agree")
+      {
+        require_same (interned, dict);
+        REQUIRE (!interned.contains ("unknown"));
+      }
+    }
+
+    THEN ("Inverting shares symbol tables and matches the plain inverse")
+    {
+      const auto inverse = interned.invert ();
+      REQUIRE (inverse.key_symbols () == interned.value_symbols ());
+      REQUIRE (inverse.keys () == dict.invert ().keys ());
+      REQUIRE (inverse.find ("value3", Interval {0, 100})
+               == dict.invert ().find ("value3", Interval {0, 100}));
+      REQUIRE (inverse.invert () == interned);
+    }
+
+    THEN ("Joins through shared and separate symbol tables agree")
+    {
+      const auto inverse = interned.invert ();
+      const auto plain_inverse = dict.invert ();
+      KeyValueIntervals inverse_intervals;
+      for (const auto &key_value_interval : intervals (plain_inverse))
+      {
+        inverse_intervals.push_back (key_value_interval);
+      }
+      const InternedDict separate (inverse_intervals);
+      REQUIRE (separate.key_symbols () != interned.value_symbols ());
+      const auto joined = interned.joined_to (inverse);
+      REQUIRE (joined == interned.joined_to (separate));
+      REQUIRE (joined.find ("key1", Interval {0, 100})
+               == dict.joined_to (plain_inverse).find ("key1",
+                                                       Interval {0, 100}));
+    }
+
+    THEN ("Disjoint intervals are the same")
+    {
+      InternedDict::KeyValuesDisjointIntervals expected;
+      for (const auto &key_values_interval : disjoint_intervals (dict))
+      {
+        expected.push_back (key_values_interval);
+      }
+      REQUIRE (interned.disjoint_intervals () == expected);
+    }
+
+    THEN ("Subsets share symbol tables and match plain subsets")
+    {
+      const std::vector<std::string> keys {"key1", "key4", "unknown"};
+      const std::vector<std::string> values {"value2", "value7", "unknown"};
+      const auto subset = interned.subset (keys, Interval {10, 60});
+      REQUIRE (subset.key_symbols () == interned.key_symbols ());
+      REQUIRE (subset == interned_from (dict.subset (keys, Interval {10, 60})));
+      REQUIRE (interned.subset (keys, values)
+               == interned_from (dict.subset (keys, values)));
+    }
+
+    WHEN ("Gaps are filled")
+    {
+      interned.erase ("key2", Interval {20, 40});
+      dict.erase ("key2", Interval {20, 40});
+      const InternedDict other ({{"key2", "other", Interval {0, 200}},
+                                 {"new", "value1", Interval {0, 10}}});
+      interned.fill_gaps_with (other)
+        .fill_to_start (20, 5)
+        .fill_to_end (90, 5)
+        .extend_into_gaps (interval_dict::GapExtensionDirection::Backwards, 2)
+        .fill_gaps ();
+      dict.fill_gaps_with (Dict ({{"key2", "other", Interval {0, 200}},
+                                  {"new", "value1", Interval {0, 10}}}))
+        .fill_to_start (20, 5)
+        .fill_to_end (90, 5)
+        .extend_into_gaps (interval_dict::GapExtensionDirection::Backwards, 2)
+        .fill_gaps ();
+      THEN ("Both still agree")
+      {
+        REQUIRE (interned == interned_from (dict));
+      }
+    }
+
+    THEN ("Flattening matches the plain dictionary")
+    {
+      REQUIRE (flattened (interned) == interned_from (flattened (dict)));
+      REQUIRE (flattened (interned, interval_dict::flatten_policy_discard ())
+               == interned_from (
+                 flattened (dict, interval_dict::flatten_policy_discard ())));
+    }
+
+    THEN ("Values chosen when flattening are interned")
+    {
+      const auto flat = flattened (
+        interned,
+        [] (const std::optional<std::string> &,
+            Interval,
+            const std::string &,
+            const std::vector<std::string> &) -> std::optional<std::string>
+        { return "chosen"; });
+      REQUIRE (flat.value_symbols () == interned.value_symbols ());
+      for (const auto &[key, values, interval] : interned.disjoint_intervals ())
+      {
+        if (values.size () > 1)
+        {
+          REQUIRE (flat.find (key, interval)
+                   == std::vector<std::string> {"chosen"});
+        }
+      }
+    }
+
+    WHEN ("Dictionaries with other symbol tables are added and subtracted")
+    {
+      const InternedDict other ({{"key1", "value1", Interval {200, 300}},
+                                 {"new", "value2", Interval {0, 10}}});
+      interned += other;
+      THEN ("Symbols are translated")
+      {
+        REQUIRE (interned.find ("new") == std::vector<std::string> {"value2"});
+        interned -= other;
+        require_same (interned, dict);
+      }
+    }
+  }
+}
@@ -602,4 +602,46 @@ TEMPLATE_TEST_CASE ("Test count_overlaps",
 //     }
 // }
 
-// Mix of intervals
\ No newline at end of file
+// Mix of intervals
+TEST_CASE ("Test static right-open comparisons", "[comparisons]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  namespace cmp = interval_dict::comparisons;
+
+#ifndef INTERVAL_DICT_GENERIC_COMPARISONS
+  using DateInterval = boost::icl::right_open_interval<boost::gregorian::date>;
+  static_assert (cmp::StaticRightOpen<Interval>);
+  static_assert (cmp::StaticRightOpen<DateInterval>);
+#endif
+  static_assert (!cmp::StaticRightOpen<boost::icl::left_open_interval<int>>);
+  static_assert (!cmp::StaticRightOpen<boost::icl::closed_interval<int>>);
+  static_assert (!cmp::StaticRightOpen<boost::icl::discrete_interval<int>>);
+
+  // Agree with boost::icl for all non-empty intervals in a small range
+  for (int lower1 = 0; lower1 < 6; ++lower1)
+  {
+    for (int upper1 = lower1 + 1; upper1 < 7; ++upper1)
+    {
+      const Interval left {lower1, upper1};
+      REQUIRE (cmp::lower_edge (left) == boost::icl::lower (left));
+      REQUIRE (cmp::upper_edge (left) == boost::icl::upper (left));
+      for (int lower2 = 0; lower2 < 6; ++lower2)
+      {
+        REQUIRE (cmp::exclusive_less (upper1, Interval {lower2, lower2 + 1})
+                 == (upper1 <= lower2));
+        for (int upper2 = lower2 + 1; upper2 < 7; ++upper2)
+        {
+          const Interval right {lower2, upper2};
+          REQUIRE (cmp::exclusive_less (left, right)
+                   == boost::icl::exclusive_less (left, right));
+          REQUIRE (cmp::intersects (left, right)
+                   == boost::icl::intersects (left, right));
+          REQUIRE (cmp::more_or_touches (left, right)
+                   == (boost::icl::intersects (left, right)
+                       || boost::icl::touches (left, right)
+                       || boost::icl::exclusive_less (right, left)));
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,101 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_join_pipeline.cpp
+/// \brief Test chain().join()...materialize() against joined_to()
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicticl.h>
+#include <interval_dict/join_pipeline.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+TEST_CASE ("Test multi-hop join pipelines", "[join_pipeline]")
+{
+  using Interval = boost::icl::interval<int>::type;
+  using AToB = interval_dict::IntervalDictICLExp<int, int, Interval>;
+  using BToC = interval_dict::IntervalDictAILExp<int, std::string, Interval>;
+  using CToD = interval_dict::IntervalDictICLExp<std::string, int, Interval>;
+
+  GIVEN ("Random A -> B, B -> C and C -> D dictionaries")
+  {
+    AToB a_to_b;
+    BToC b_to_c;
+    CToD c_to_d;
+    std::mt19937 generator (5);
+    std::uniform_int_distribution<int> key (0, 400);
+    std::uniform_int_distribution<int> value (0, 9);
+    std::uniform_int_distribution<int> edge (0, 200);
+    std::uniform_int_distribution<int> length (1, 40);
+    const auto random_interval = [&] ()
+    {
+      const auto lower = edge (generator);
+      return Interval {lower, lower + length (generator)};
+    };
+    for (int i = 0; i < 2000; ++i)
+    {
+      a_to_b.insert (
+        {{key (generator), value (generator), random_interval ()}});
+    }
+    for (int i = 0; i < 60; ++i)
+    {
+      b_to_c.insert ({{value (generator),
+                       std::to_string (value (generator)),
+                       random_interval ()}});
+      c_to_d.insert ({{std::to_string (value (generator)),
+                       value (generator),
+                       random_interval ()}});
+    }
+    const auto expected = a_to_b.joined_to (b_to_c).joined_to (c_to_d);
+
+    THEN ("Joining all hops at once matches successive joins")
+    {
+      for (const std::size_t count_threads : {1, 4})
+      {
+        const auto a_to_d = interval_dict::chain (a_to_b)
+                              .join (b_to_c)
+                              .join (c_to_d)
+                              .materialize (count_threads);
+        REQUIRE (a_to_d == expected);
+      }
+    }
+
+    THEN ("Restrictions match subsets of successive joins")
+    {
+      const std::vector<int> keys {500, 3, 17, 3, 250, 64, 399, 128};
+      const Interval query_interval {40, 120};
+      for (const std::size_t count_threads : {1, 4})
+      {
+        const auto a_to_d = interval_dict::chain (a_to_b)
+                              .join (b_to_c)
+                              .restrict_keys (keys)
+                              .join (c_to_d)
+                              .restrict_interval (query_interval)
+                              .materialize (count_threads);
+        REQUIRE (a_to_d == expected.subset (keys, query_interval));
+      }
+      const auto narrower = interval_dict::chain (a_to_b)
+                              .join (b_to_c)
+                              .join (c_to_d)
+                              .restrict_keys (keys)
+                              .restrict_keys (std::vector {3, 64, 65})
+                              .restrict_interval (query_interval)
+                              .restrict_interval (Interval {100, 150})
+                              .materialize ();
+      REQUIRE (narrower
+               == expected.subset (std::vector {3, 64}, Interval {100, 120}));
+    }
+  }
+}
@@ -0,0 +1,113 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_joined_view.cpp
+/// \brief Test join_view() against joined_to()
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/gregorian.h>
+#include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicticl.h>
+#include <interval_dict/joined_view.h>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+  template<typename Generator>
+  auto snapshot (Generator &&generator)
+  {
+    using Interval = boost::icl::interval<int>::type;
+    std::vector<std::tuple<int, std::vector<int>, Interval>> results;
+    for (const auto &[key, values, interval] : generator)
+    {
+      results.emplace_back (
+        key, std::vector<int> (values.begin (), values.end ()), interval);
+    }
+    return results;
+  }
+} // namespace
+
+TEST_CASE ("Test lazy join views", "[join_view]")
+{
+  using Interval = boost::icl::interval<int>::type;
+  using AToB = interval_dict::IntervalDictICLExp<int, int, Interval>;
+  using BToC = interval_dict::IntervalDictAILExp<int, int, Interval>;
+
+  GIVEN ("Random A -> B and B -> C dictionaries")
+  {
+    AToB a_to_b;
+    BToC b_to_c;
+    std::mt19937 generator (7);
+    std::uniform_int_distribution<int> key (0, 20);
+    std::uniform_int_distribution<int> value (0, 5);
+    std::uniform_int_distribution<int> edge (0, 200);
+    std::uniform_int_distribution<int> length (1, 40);
+    for (int i = 0; i < 300; ++i)
+    {
+      const auto lower = edge (generator);
+      a_to_b.insert ({{key (generator),
+                       value (generator),
+                       Interval {lower, lower + length (generator)}}});
+    }
+    for (int i = 0; i < 60; ++i)
+    {
+      const auto lower = edge (generator);
+      b_to_c.insert ({{value (generator),
+                       key (generator),
+                       Interval {lower, lower + length (generator)}}});
+    }
+    const auto joined = a_to_b.joined_to (b_to_c);
+
+    THEN ("Lookups match the materialised join with or without a cache")
+    {
+      for (const std::size_t cache_capacity : {0, 2, 100})
+      {
+        const auto view
+          = interval_dict::join_view (a_to_b, b_to_c, cache_capacity);
+        for (int key_query = 0; key_query <= 21; ++key_query)
+        {
+          REQUIRE (view.find (key_query) == joined.find (key_query));
+          for (int lower = -10; lower < 230; lower += 9)
+          {
+            const Interval query {lower, lower + 15};
+            REQUIRE (view.find (key_query, query)
+                     == joined.find (key_query, query));
+            REQUIRE (
+              snapshot (disjoint_intervals (view, key_query, query))
+              == snapshot (disjoint_intervals (joined, key_query, query)));
+          }
+        }
+        REQUIRE (snapshot (disjoint_intervals (view, view.keys ()))
+                 == snapshot (disjoint_intervals (joined)));
+        REQUIRE (view.count_cached () <= cache_capacity);
+        if (cache_capacity)
+        {
+          REQUIRE (view.count_cache_hits () > 0);
+        }
+      }
+    }
+
+    THEN ("Joined intervals cover the same values and intervals")
+    {
+      const auto view = interval_dict::join_view (a_to_b, b_to_c);
+      interval_dict::IntervalDictICLExp<int, int, Interval> from_view;
+      for (const auto &key_value_interval : intervals (view, view.keys ()))
+      {
+        from_view.insert ({key_value_interval});
+      }
+      REQUIRE (from_view == joined);
+    }
+  }
+}
@@ -0,0 +1,71 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_key_profile.cpp
+/// \brief Test profile_key() and profile()
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/key_profile.h>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+TEST_CASE ("Test profile_key() and profile()", "[profile]")
+{
+  using namespace std::string_literals;
+  using Interval = boost::icl::right_open_interval<int>;
+  using Value = int;
+
+  GIVEN ("Nested intervals inserted out of order")
+  {
+    const interval_dict::ValueIntervals<Value, Interval> value_intervals {
+      {1, Interval {10, 20}},
+      {2, Interval {0, 100}},
+      {3, Interval {5, 50}},
+      {3, Interval {60, 70}}};
+    const auto key_profile = interval_dict::profile_key (value_intervals);
+    THEN ("Counts, nesting and order are reported")
+    {
+      REQUIRE (key_profile.count_intervals == 4);
+      REQUIRE (key_profile.count_values == 3);
+      REQUIRE (key_profile.max_nesting_depth == 2);
+      REQUIRE (key_profile.max_overlaps > 0);
+      REQUIRE (key_profile.fraction_in_order == Approx (2.0 / 3));
+    }
+  }
+
+  GIVEN ("One large append-ordered key and many tiny keys")
+  {
+    std::vector<std::tuple<std::string, Value, Interval>> key_value_intervals;
+    for (int i = 0; i < 1000; ++i)
+    {
+      key_value_intervals.emplace_back ("big"s, i, Interval {i, i + 10});
+    }
+    for (int i = 0; i < 20; ++i)
+    {
+      key_value_intervals.emplace_back (
+        "small"s + std::to_string (i), i, Interval {i, i + 1});
+    }
+    const auto dataset_profile = interval_dict::profile (
+      key_value_intervals, {.count_sampled_keys = 4});
+    THEN ("Every key is profiled and each implementation is timed")
+    {
+      REQUIRE (dataset_profile.keys.size () == 21);
+      REQUIRE (dataset_profile.count_intervals == 1020);
+      REQUIRE (dataset_profile.keys.at ("big"s).fraction_in_order == 1.0);
+      REQUIRE (dataset_profile.costs.size () == 4);
+      REQUIRE (dataset_profile.recommended
+               == dataset_profile.costs.front ().backend);
+    }
+  }
+}
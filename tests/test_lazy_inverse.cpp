@@ -0,0 +1,226 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_lazy_inverse.cpp
+/// \brief Test BiIntervalDictExp with InverseMaintenance::lazy
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/bi_intervaldictail.h>
+
+#include <tuple>
+#include <utility>
+#include <vector>
+
+TEST_CASE ("Test lazy inverse maintenance", "[inverse_maintenance]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using BiDict = interval_dict::BiIntervalDictAILExp<int, int, Interval>;
+  using interval_dict::InverseMaintenance;
+
+  std::vector<std::tuple<int, int, Interval>> key_value_intervals;
+  for (int i = 0; i < 300; ++i)
+  {
+    key_value_intervals.emplace_back (i % 7, i % 11, Interval {i, i + 25});
+  }
+
+  const auto require_same_inverse
+    = [] (const BiDict &lazy, const BiDict &eager)
+  {
+    REQUIRE (lazy.values () == eager.values ());
+    for (int value = 0; value < 12; ++value)
+    {
+      for (int query = 0; query < 340; query += 17)
+      {
+        REQUIRE (lazy.inverse_find (value, Interval {query, query + 9})
+                 == eager.inverse_find (value, Interval {query, query + 9}));
+      }
+    }
+  };
+
+  GIVEN ("Lazy and eager dictionaries with the same changes")
+  {
+    BiDict eager;
+    BiDict lazy;
+    lazy.set_inverse_maintenance (InverseMaintenance::lazy);
+    const auto both = [&] (auto change)
+    {
+      change (eager);
+      change (lazy);
+    };
+    both (
+      [&] (BiDict &dict)
+      {
+        dict.insert (key_value_intervals);
+        dict.erase (3, Interval {50, 150});
+        dict.erase (Interval {200, 210});
+        dict.inverse_insert (std::vector<std::pair<int, int>> {{20, 1}},
+                             Interval {0, 400});
+      });
+
+    THEN ("Changes are pending until the inverse is queried")
+    {
+      REQUIRE (lazy.count_pending_inverse_changes () > 0);
+      REQUIRE (lazy.find (1, Interval {0, 400})
+               == eager.find (1, Interval {0, 400}));
+      REQUIRE (lazy.count_pending_inverse_changes () > 0);
+      require_same_inverse (lazy, eager);
+      REQUIRE (lazy.count_pending_inverse_changes () == 0);
+    }
+
+    WHEN ("There are more changes than the log holds")
+    {
+      lazy.set_inverse_maintenance (InverseMaintenance::lazy, 10);
+      both (
+        [&] (BiDict &dict)
+        {
+          dict.erase (key_value_intervals);
+          dict.insert (key_value_intervals);
+        });
+      THEN ("The inverse is rebuilt instead")
+      {
+        require_same_inverse (lazy, eager);
+      }
+    }
+
+    WHEN ("Switching back to eager maintenance")
+    {
+      lazy.set_inverse_maintenance (InverseMaintenance::eager);
+      THEN ("Pending changes are applied")
+      {
+        REQUIRE (lazy.count_pending_inverse_changes () == 0);
+        lazy.insert (std::vector<std::pair<int, int>> {{30, 2}},
+                     Interval {0, 5});
+        eager.insert (std::vector<std::pair<int, int>> {{30, 2}},
+                      Interval {0, 5});
+        REQUIRE (lazy.count_pending_inverse_changes () == 0);
+        require_same_inverse (lazy, eager);
+      }
+    }
+  }
+
+  GIVEN ("Lazy and eager dictionaries with gaps")
+  {
+    BiDict eager (key_value_intervals);
+    BiDict lazy (key_value_intervals);
+    lazy.set_inverse_maintenance (InverseMaintenance::lazy);
+    for (auto *dict : {&eager, &lazy})
+    {
+      dict->erase (3, Interval {50, 150});
+      dict->erase (Interval {200, 210});
+      dict->erase (5, Interval {0, 40});
+      dict->erase (6, Interval {280, 400});
+    }
+    std::vector<std::tuple<int, int, Interval>> other_key_value_intervals;
+    for (int i = 0; i < 100; ++i)
+    {
+      other_key_value_intervals.emplace_back (
+        i % 9, i % 5, Interval {i * 3, i * 3 + 40});
+    }
+    const BiDict other (other_key_value_intervals);
+
+    const auto require_same = [&] (const BiDict &lazy, const BiDict &eager)
+    {
+      REQUIRE (lazy == eager);
+      require_same_inverse (lazy, eager);
+      REQUIRE (lazy.count_pending_inverse_changes () == 0);
+    };
+
+    WHEN ("Joining to another dictionary")
+    {
+      THEN ("The inverses are the same")
+      {
+        require_same (lazy.joined_to (other), eager.joined_to (other));
+      }
+    }
+
+    WHEN ("Merging with another dictionary")
+    {
+      lazy += other;
+      eager += other;
+      THEN ("The inverses are the same")
+      {
+        require_same (lazy, eager);
+      }
+    }
+
+    WHEN ("Subtracting another dictionary")
+    {
+      lazy -= other;
+      eager -= other;
+      THEN ("The inverses are the same")
+      {
+        require_same (lazy, eager);
+      }
+    }
+
+    WHEN ("Filling gaps with another dictionary")
+    {
+      lazy.fill_gaps_with (other);
+      eager.fill_gaps_with (other);
+      THEN ("The logged changes give the same inverse")
+      {
+        REQUIRE (lazy.count_pending_inverse_changes () > 0);
+        require_same (lazy, eager);
+      }
+    }
+
+    WHEN ("Filling to the start and end")
+    {
+      lazy.fill_to_start (100, 30).fill_to_end (200, 30);
+      eager.fill_to_start (100, 30).fill_to_end (200, 30);
+      THEN ("The logged changes give the same inverse")
+      {
+        REQUIRE (lazy.count_pending_inverse_changes () > 0);
+        require_same (lazy, eager);
+      }
+    }
+
+    WHEN ("Extending into gaps")
+    {
+      lazy.extend_into_gaps (interval_dict::GapExtensionDirection::Forwards,
+                             20);
+      eager.extend_into_gaps (interval_dict::GapExtensionDirection::Forwards,
+                              20);
+      THEN ("The logged changes give the same inverse")
+      {
+        REQUIRE (lazy.count_pending_inverse_changes () > 0);
+        require_same (lazy, eager);
+      }
+    }
+
+    WHEN ("Filling gaps")
+    {
+      lazy.fill_gaps ();
+      eager.fill_gaps ();
+      THEN ("The logged changes give the same inverse")
+      {
+        REQUIRE (lazy.count_pending_inverse_changes () > 0);
+        require_same (lazy, eager);
+      }
+    }
+  }
+
+  GIVEN ("Two associations for the same value")
+  {
+    BiDict dict;
+    dict.set_inverse_maintenance (InverseMaintenance::lazy);
+    dict.insert ({{1, 2, Interval {0, 10}}, {3, 2, Interval {5, 20}}});
+    WHEN ("One key is erased")
+    {
+      dict.erase (1, Interval {0, 10});
+      THEN ("The other key remains in the inverse")
+      {
+        REQUIRE (dict.inverse_find (2, Interval {0, 30}) == std::vector {3});
+      }
+    }
+  }
+}
@@ -0,0 +1,189 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_maintained_join.cpp
+/// \brief Test MaintainedJoin against joined_to() after each change
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/bi_intervaldicticl.h>
+#include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicticl.h>
+#include <interval_dict/maintained_join.h>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+TEST_CASE ("Test incrementally maintained joins", "[maintained_join]")
+{
+  using Interval = boost::icl::interval<int>::type;
+  using AToB = interval_dict::BiIntervalDictICLExp<int, int, Interval>;
+  using BToC = interval_dict::IntervalDictAILExp<int, int, Interval>;
+  using Forward = interval_dict::IntervalDictICLExp<int, int, Interval>;
+  using Changes = std::vector<std::tuple<int, int, Interval>>;
+
+  std::mt19937 generator (3);
+  std::uniform_int_distribution<int> key (0, 30);
+  std::uniform_int_distribution<int> value (0, 6);
+  std::uniform_int_distribution<int> edge (0, 200);
+  std::uniform_int_distribution<int> length (1, 40);
+  const auto random_changes = [&] (std::size_t count)
+  {
+    Changes changes;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const auto lower = edge (generator);
+      changes.emplace_back (key (generator) % 7 == 0 ? value (generator)
+                                                     : key (generator),
+                            value (generator),
+                            Interval {lower, lower + length (generator)});
+    }
+    return changes;
+  };
+  // A -> B as an IntervalDictExp to join from scratch
+  const auto expected_join = [] (const AToB &a_to_b, const BToC &b_to_c)
+  {
+    Changes forward;
+    for (const auto &key_value_interval : intervals (a_to_b))
+    {
+      forward.push_back (key_value_interval);
+    }
+    return Forward (forward).joined_to (b_to_c);
+  };
+
+  GIVEN ("A join of random dictionaries")
+  {
+    AToB a_to_b (random_changes (300));
+    BToC b_to_c (random_changes (40));
+    interval_dict::MaintainedJoin maintained (a_to_b, b_to_c);
+    REQUIRE (maintained.joined () == expected_join (a_to_b, b_to_c));
+
+    THEN ("Small changes to either side keep the join up to date")
+    {
+      for (int i = 0; i < 40; ++i)
+      {
+        const auto changes = random_changes (3);
+        switch (i % 4)
+        {
+        case 0:
+          a_to_b.insert (changes);
+          break;
+        case 1:
+          a_to_b.erase (changes);
+          break;
+        case 2:
+          b_to_c.insert (changes);
+          break;
+        default:
+          b_to_c.erase (changes);
+          break;
+        }
+        REQUIRE (maintained.joined () == expected_join (a_to_b, b_to_c));
+        REQUIRE (maintained.count_keys_recomputed () <= 31);
+      }
+    }
+
+    THEN ("Erasing whole keys or values keeps the join up to date")
+    {
+      const auto all_time = interval_dict::interval_extent<Interval>;
+      a_to_b.erase (3, all_time);
+      REQUIRE (maintained.joined () == expected_join (a_to_b, b_to_c));
+
+      b_to_c.erase (2, Interval {50, 100});
+      REQUIRE (maintained.joined () == expected_join (a_to_b, b_to_c));
+    }
+
+    THEN ("Gap filling, flattening and assignment keep the join up to date")
+    {
+      a_to_b.fill_gaps ();
+      REQUIRE (maintained.joined () == expected_join (a_to_b, b_to_c));
+
+      a_to_b = flattened (a_to_b);
+      REQUIRE (maintained.joined () == expected_join (a_to_b, b_to_c));
+
+      b_to_c = BToC (random_changes (40));
+      REQUIRE (maintained.joined () == expected_join (a_to_b, b_to_c));
+    }
+
+    THEN ("Changes applied concurrently to a lazy or eager inverse keep the "
+          "join up to date")
+    {
+      a_to_b.set_min_count_concurrent (1);
+      for (const auto maintenance : {interval_dict::InverseMaintenance::lazy,
+                                     interval_dict::InverseMaintenance::eager})
+      {
+        a_to_b.set_inverse_maintenance (maintenance);
+        a_to_b.insert (random_changes (20));
+        b_to_c.insert (random_changes (5));
+        REQUIRE (maintained.joined () == expected_join (a_to_b, b_to_c));
+      }
+    }
+  }
+
+  GIVEN ("A join of a dictionary to itself")
+  {
+    AToB a_to_b (random_changes (100));
+    const auto expected_self_join = [&a_to_b] ()
+    {
+      Changes forward;
+      for (const auto &key_value_interval : intervals (a_to_b))
+      {
+        forward.push_back (key_value_interval);
+      }
+      return Forward (forward).joined_to (Forward (forward));
+    };
+    interval_dict::MaintainedJoin maintained (a_to_b, a_to_b);
+    REQUIRE (maintained.joined () == expected_self_join ());
+
+    THEN ("The inverse is up to date when changes are published")
+    {
+      for (const std::size_t min_count_concurrent : {1000, 1})
+      {
+        a_to_b.set_min_count_concurrent (min_count_concurrent);
+        for (int i = 0; i < 10; ++i)
+        {
+          const auto changes = random_changes (5);
+          if (i % 2)
+          {
+            a_to_b.erase (changes);
+          }
+          else
+          {
+            a_to_b.insert (changes);
+          }
+          REQUIRE (maintained.joined () == expected_self_join ());
+        }
+        a_to_b.erase (3, interval_dict::interval_extent<Interval>);
+        REQUIRE (maintained.joined () == expected_self_join ());
+        a_to_b = AToB (random_changes (100));
+        REQUIRE (maintained.joined () == expected_self_join ());
+      }
+    }
+  }
+
+  GIVEN ("A join which is no longer maintained")
+  {
+    AToB a_to_b (random_changes (30));
+    BToC b_to_c (random_changes (10));
+    const auto joined = [&] ()
+    {
+      const interval_dict::MaintainedJoin maintained (a_to_b, b_to_c);
+      return maintained.joined ();
+    }();
+    THEN ("Later changes are not observed")
+    {
+      a_to_b.insert (random_changes (10));
+      b_to_c.insert (random_changes (10));
+      REQUIRE (joined != expected_join (a_to_b, b_to_c));
+    }
+  }
+}
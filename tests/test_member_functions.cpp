@@ -25,6 +25,9 @@
 #include <interval_dict/intervaldictitree.h>
 #include <interval_dict/ptime.h>
 #include <concepts>
+#include <cstdint>
+#include <limits>
+#include <sstream>
 #include <vector>
 
 TEMPLATE_TEST_CASE (
@@ -138,4 +141,100 @@ TEMPLATE_TEST_CASE (
       }
     }
   }
-}
\ No newline at end of file
+}
+TEST_CASE ("Test memory_usage() and shrink_to_fit()", "[memory_usage]")
+{
+  using namespace std::string_literals;
+  using Interval = boost::icl::right_open_interval<int>;
+  using IDict = interval_dict::INTERVALDICTTESTTYPE<std::string, int, Interval>;
+  IDict test_dict;
+  for (int i = 0; i < 500; ++i)
+  {
+    test_dict.insert ({{"aa"s, i}}, Interval {i, i + 20});
+  }
+  test_dict.insert ({{"bb"s, 1}}, Interval {0, 10});
+
+  GIVEN ("A dictionary with one heavy and one light key")
+  {
+    const auto report = test_dict.memory_usage (1);
+    THEN ("The heavy key is reported and all keys are binned")
+    {
+      REQUIRE (report.usage.bytes_intervals > 0);
+      REQUIRE (report.total () > report.usage.total ());
+      REQUIRE (report.heaviest_keys.size () == 1);
+      REQUIRE (report.heaviest_keys[0].first == "aa"s);
+      std::size_t count_keys = 0;
+      for (const auto count : report.log2_bytes_per_key)
+      {
+        count_keys += count;
+      }
+      REQUIRE (count_keys == test_dict.size ());
+    }
+  }
+  GIVEN ("A large erase")
+  {
+    const auto before = test_dict.memory_usage ().usage;
+    test_dict.erase ("aa"s, Interval {0, 480});
+    const auto after_erase = test_dict.find ("aa"s);
+    test_dict.shrink_to_fit ();
+    const auto after = test_dict.memory_usage ().usage;
+    THEN ("Memory is reclaimed without changing the contents")
+    {
+      REQUIRE (test_dict.find ("aa"s) == after_erase);
+      REQUIRE (after.bytes_tombstones == 0);
+      REQUIRE (after.bytes_wasted_capacity == 0);
+      REQUIRE (after.total () < before.total ());
+    }
+  }
+}
+
+#ifdef INTERVAL_DICT_STATS
+TEST_CASE ("Test instrumentation counters", "[stats]")
+{
+  using namespace std::string_literals;
+  using Interval = boost::icl::right_open_interval<int>;
+  using IDict = interval_dict::INTERVALDICTTESTTYPE<std::string, int, Interval>;
+  TestData<Interval> test_data;
+  IDict test_dict (test_data.initial ());
+  test_dict.reset_stats ();
+
+  GIVEN ("Calls to member functions")
+  {
+    test_dict.insert ({{"aa"s, 1}}, Interval {0, 10});
+    test_dict.insert ({{"aa"s, 2}}, Interval {5, 20});
+    (void)test_dict.find ("aa"s, Interval {0, 100});
+    test_dict.erase ("aa"s, Interval {0, 3});
+    THEN ("Each call is counted by name")
+    {
+      const auto stats = test_dict.stats ();
+      REQUIRE (stats.operations.at ("insert").calls == 2);
+      REQUIRE (stats.operations.at ("find").calls == 1);
+      REQUIRE (stats.operations.at ("erase").calls == 1);
+      REQUIRE (stats.count_keys == test_dict.size ());
+      REQUIRE (stats.count_intervals > 0);
+
+      std::ostringstream json;
+      interval_dict::instrumentation::write_json (json, stats);
+      REQUIRE (json.str ().find ("\"insert\": {\"calls\": 2") != std::string::npos);
+    }
+    THEN ("Statistics can be reset")
+    {
+      test_dict.reset_stats ();
+      REQUIRE (test_dict.stats ().operations.empty ());
+    }
+  }
+
+  GIVEN ("Latencies too long for the histogram")
+  {
+    interval_dict::instrumentation::Histogram histogram;
+    histogram.add (std::numeric_limits<std::uint64_t>::max ());
+    histogram.add (1);
+    THEN ("They are counted in the last bucket")
+    {
+      REQUIRE (histogram.buckets.back () == 1);
+      REQUIRE (histogram.buckets[1] == 1);
+      REQUIRE (histogram.buckets[0] == 0);
+    }
+  }
+}
+#endif
@@ -0,0 +1,283 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_partitioned.cpp
+/// \brief Test IntervalDictPartitionedAILExp against IntervalDictICLExp
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/gregorian.h>
+#include <interval_dict/intervaldicticl.h>
+#include <interval_dict/intervaldictpartitioned.h>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+  /// Point @p offset days or units from an arbitrary origin
+  template<typename BaseType> BaseType point (int offset)
+  {
+    if constexpr (std::is_same_v<BaseType, boost::gregorian::date>)
+    {
+      return boost::gregorian::date {2020, 1, 1}
+             + boost::gregorian::days {offset};
+    }
+    else
+    {
+      return offset;
+    }
+  }
+
+  /// Narrow partitions so that random intervals often cross them
+  template<typename BaseType> interval_dict::PartitionWidth narrow_width ()
+  {
+    if constexpr (std::is_same_v<BaseType, boost::gregorian::date>)
+    {
+      return {.period = interval_dict::PartitionPeriod::Month};
+    }
+    else
+    {
+      return {.units = 16};
+    }
+  }
+
+  template<typename Dict> auto snapshot (const Dict &dict)
+  {
+    std::vector<std::tuple<int, std::vector<int>, typename Dict::IntervalType>>
+      results;
+    for (const auto &[key, values, interval] : disjoint_intervals (dict))
+    {
+      results.emplace_back (
+        key, std::vector<int> (values.begin (), values.end ()), interval);
+    }
+    return results;
+  }
+} // namespace
+
+TEMPLATE_TEST_CASE ("Test partitioned dictionaries for different interval "
+                    "types",
+                    "[partitioned]",
+                    boost::icl::interval<int>::type,
+                    boost::icl::right_open_interval<int>,
+                    boost::icl::closed_interval<int>,
+                    boost::icl::interval<boost::gregorian::date>::type,
+                    boost::icl::right_open_interval<boost::gregorian::date>)
+{
+  using Interval = TestType;
+  using BaseType = typename boost::icl::interval_traits<Interval>::domain_type;
+  using Partitioned
+    = interval_dict::IntervalDictPartitionedAILExp<int, int, Interval>;
+  using Expected = interval_dict::IntervalDictICLExp<int, int, Interval>;
+  const auto make_interval = [] (int lower, int upper)
+  {
+    return boost::icl::construct<Interval> (point<BaseType> (lower),
+                                            point<BaseType> (upper));
+  };
+
+  GIVEN ("The same random inserts and erases")
+  {
+    Partitioned partitioned;
+    partitioned.tune ({.width = narrow_width<BaseType> ()});
+    Expected expected;
+    std::mt19937 generator (11);
+    std::uniform_int_distribution<int> key (0, 2);
+    std::uniform_int_distribution<int> value (0, 4);
+    std::uniform_int_distribution<int> edge (-40, 200);
+    std::uniform_int_distribution<int> length (2, 40);
+    for (int i = 0; i < 400; ++i)
+    {
+      const auto lower = edge (generator);
+      const auto interval = make_interval (lower, lower + length (generator));
+      const std::vector<std::tuple<int, int, Interval>> changes {
+        {key (generator), value (generator), interval}};
+      if (i % 3 == 2)
+      {
+        partitioned.erase (changes);
+        expected.erase (changes);
+      }
+      else
+      {
+        partitioned.insert (changes);
+        expected.insert (changes);
+      }
+      if (i % 50 == 49)
+      {
+        partitioned.erase (make_interval (lower, lower + 20));
+        expected.erase (make_interval (lower, lower + 20));
+      }
+    }
+
+    THEN ("Disjoint intervals and queries match")
+    {
+      REQUIRE (snapshot (partitioned) == snapshot (expected));
+      for (int key_query = 0; key_query < 3; ++key_query)
+      {
+        for (int lower = -50; lower < 260; lower += 7)
+        {
+          const auto query = make_interval (lower, lower + 10);
+          REQUIRE (partitioned.find (key_query, query)
+                   == expected.find (key_query, query));
+        }
+      }
+    }
+
+    THEN ("Filling gaps, inverses and merges match")
+    {
+      auto filled_partitioned = partitioned;
+      auto filled_expected = expected;
+      filled_partitioned.fill_gaps ();
+      filled_expected.fill_gaps ();
+      REQUIRE (snapshot (filled_partitioned) == snapshot (filled_expected));
+
+      REQUIRE (snapshot (partitioned.invert ())
+               == snapshot (expected.invert ()));
+
+      auto merged_partitioned = partitioned;
+      auto merged_expected = expected;
+      merged_partitioned += partitioned.invert ();
+      merged_expected += expected.invert ();
+      REQUIRE (snapshot (merged_partitioned) == snapshot (merged_expected));
+      merged_partitioned -= partitioned;
+      merged_expected -= expected;
+      REQUIRE (snapshot (merged_partitioned) == snapshot (merged_expected));
+    }
+
+    THEN ("Initial and final values match")
+    {
+      using PartitionedImpl = typename Partitioned::ImplType;
+      using ExpectedImpl = typename Expected::ImplType;
+      for (int key_query = 0; key_query < 3; ++key_query)
+      {
+        PartitionedImpl partitioned_values;
+        partitioned_values.tune ({.width = narrow_width<BaseType> ()});
+        ExpectedImpl expected_values;
+        for (const auto &[_, value, interval] :
+             intervals (expected, key_query))
+        {
+          partitioned_values.insert (interval, value);
+          interval_dict::Implementation<int, Interval, ExpectedImpl>::insert (
+            expected_values, interval, value);
+        }
+        if (partitioned_values.empty ())
+        {
+          continue;
+        }
+        REQUIRE (partitioned_values.initial_values ()
+                 == interval_dict::Implementation<int, Interval, ExpectedImpl>::
+                   initial_values (expected_values));
+        REQUIRE (partitioned_values.final_values ()
+                 == interval_dict::Implementation<int, Interval, ExpectedImpl>::
+                   final_values (expected_values));
+      }
+    }
+
+    THEN ("Changing the partition width keeps the same intervals")
+    {
+      auto retuned = partitioned;
+      retuned.tune ({});
+      REQUIRE (snapshot (retuned) == snapshot (expected));
+      REQUIRE (retuned == partitioned);
+    }
+  }
+}
+
+TEST_CASE ("Test initial and final values of partitioned intervals",
+           "[partitioned]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using Partitioned
+    = interval_dict::IntervalDictPartitionedAILExp<int, int, Interval>;
+  using Expected = interval_dict::IntervalDictICLExp<int, int, Interval>;
+  using PartitionedImpl = Partitioned::ImplType;
+  using ExpectedImplementation
+    = interval_dict::Implementation<int, Interval, Expected::ImplType>;
+
+  GIVEN ("Spanning intervals which overlap intervals in later partitions")
+  {
+    PartitionedImpl partitioned;
+    partitioned.tune ({.width = {.units = 16}});
+    Expected::ImplType expected;
+    for (const auto &[value, interval] :
+         std::vector<std::tuple<int, Interval>> {{1, Interval {0, 40}},
+                                                 {1, Interval {2, 3}},
+                                                 {2, Interval {20, 25}},
+                                                 {1, Interval {70, 100}},
+                                                 {2, Interval {70, 76}}})
+    {
+      partitioned.insert (interval, value);
+      ExpectedImplementation::insert (expected, interval, value);
+    }
+    THEN ("Initial and final values only span the first and last values")
+    {
+      REQUIRE (std::get<1> (partitioned.initial_values ()) == Interval {0, 20});
+      REQUIRE (partitioned.initial_values ()
+               == ExpectedImplementation::initial_values (expected));
+      REQUIRE (std::get<1> (partitioned.final_values ()) == Interval {76, 100});
+      REQUIRE (partitioned.final_values ()
+               == ExpectedImplementation::final_values (expected));
+    }
+  }
+}
+
+TEST_CASE ("Test retention of monthly partitions", "[partitioned]")
+{
+  using Interval = boost::icl::right_open_interval<boost::gregorian::date>;
+  using Partitioned
+    = interval_dict::IntervalDictPartitionedAILExp<int, int, Interval>;
+  using boost::gregorian::date;
+
+  GIVEN ("Three years of daily values and one value for all three years")
+  {
+    Partitioned partitioned;
+    partitioned.tune (
+      {.width = {.period = interval_dict::PartitionPeriod::Month}});
+    std::vector<std::tuple<int, int, Interval>> daily;
+    for (int day = 0; day < 3 * 365; ++day)
+    {
+      daily.emplace_back (1,
+                          day % 7,
+                          Interval {point<date> (day), point<date> (day + 1)});
+    }
+    partitioned.insert (daily);
+    partitioned.insert (
+      {{1, 100, Interval {point<date> (0), point<date> (3 * 365)}}});
+    const auto all_time = interval_dict::interval_extent<Interval>;
+    REQUIRE (partitioned.explain (1, all_time).partitions_visited == 36);
+
+    THEN ("Queries only visit overlapping partitions")
+    {
+      const Interval february {date {2021, 2, 1}, date {2021, 3, 1}};
+      const auto explain = partitioned.explain (1, february);
+      REQUIRE (explain.partitions_visited == 1);
+      REQUIRE (partitioned.find (1, february)
+               == std::vector<int> {0, 1, 2, 3, 4, 5, 6, 100});
+    }
+
+    WHEN ("Everything before 2022 is dropped")
+    {
+      partitioned.erase (
+        Interval {interval_dict::IntervalTraits<Interval>::minimum (),
+                  date {2022, 1, 1}});
+      THEN ("Only the later partitions remain")
+      {
+        REQUIRE (partitioned.explain (1, all_time).partitions_visited == 12);
+        REQUIRE (partitioned.find (1, Interval {point<date> (0),
+                                                date {2022, 1, 1}})
+                   .empty ());
+        REQUIRE (partitioned.find (1, Interval {date {2022, 1, 1},
+                                                date {2022, 1, 2}})
+                 == std::vector<int> {(365 + 366) % 7, 100});
+      }
+    }
+  }
+}
@@ -0,0 +1,128 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_pmr.cpp
+/// \brief Test dictionaries allocating from a std::pmr::memory_resource
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/intervaldictail.h>
+
+#include <cstddef>
+#include <memory_resource>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+  /// Counts bytes allocated through it
+  class CountingResource : public std::pmr::memory_resource
+  {
+    public:
+    std::size_t bytes_allocated = 0;
+
+    private:
+    void *do_allocate (std::size_t bytes, std::size_t alignment) override
+    {
+      bytes_allocated += bytes;
+      return std::pmr::new_delete_resource ()->allocate (bytes, alignment);
+    }
+
+    void
+    do_deallocate (void *ptr, std::size_t bytes, std::size_t alignment) override
+    {
+      std::pmr::new_delete_resource ()->deallocate (ptr, bytes, alignment);
+    }
+
+    [[nodiscard]] bool
+    do_is_equal (const std::pmr::memory_resource &other) const noexcept override
+    {
+      return this == &other;
+    }
+  };
+} // namespace
+
+TEST_CASE ("Test IntervalDictAIL with a memory resource", "[pmr]")
+{
+  using Interval = boost::icl::right_open_interval<int>;
+  using Dict = interval_dict::IntervalDictAILExp<int, int, Interval>;
+  using PmrDict = interval_dict::IntervalDictAILPmrExp<int, int, Interval>;
+
+  std::vector<std::tuple<int, int, Interval>> key_value_intervals;
+  for (int i = 0; i < 500; ++i)
+  {
+    key_value_intervals.emplace_back (i % 7, i % 11, Interval {i, i + 20});
+  }
+  const Dict expected (key_value_intervals);
+
+  GIVEN ("A dictionary constructed with a memory resource")
+  {
+    CountingResource resource;
+    PmrDict dict (&resource);
+    dict.insert (key_value_intervals);
+    REQUIRE (dict.get_allocator ().resource () == &resource);
+
+    THEN ("Keys and interval-values are allocated from it")
+    {
+      // More than the map nodes alone: at least one copy of each interval
+      REQUIRE (resource.bytes_allocated
+               > key_value_intervals.size ()
+                   * sizeof (interval_dict::ValueInterval<int, Interval>));
+      REQUIRE (dict.find (3, Interval {0, 600})
+               == expected.find (3, Interval {0, 600}));
+    }
+
+    THEN ("invert(), joined_to() and subset() use the same resource")
+    {
+      const auto bytes_before = resource.bytes_allocated;
+      const auto inverse = dict.invert ();
+      REQUIRE (inverse.get_allocator ().resource () == &resource);
+      REQUIRE (resource.bytes_allocated > bytes_before);
+      REQUIRE (inverse.find (5, Interval {0, 600})
+               == expected.invert ().find (5, Interval {0, 600}));
+
+      const auto joined = dict.joined_to (inverse);
+      REQUIRE (joined.get_allocator ().resource () == &resource);
+      REQUIRE (joined.find (2, Interval {0, 600})
+               == expected.joined_to (expected.invert ())
+                    .find (2, Interval {0, 600}));
+
+      const auto subset = dict.subset (std::vector {1, 2});
+      REQUIRE (subset.get_allocator ().resource () == &resource);
+      REQUIRE (subset.keys () == std::vector {1, 2});
+    }
+
+    THEN ("Erasing and compacting keep the same results")
+    {
+      dict.erase ({{3, 5}}, Interval {0, 300});
+      dict.compact ();
+      auto copy = expected;
+      copy.erase ({{3, 5}}, Interval {0, 300});
+      REQUIRE (dict.find (3, Interval {0, 600})
+               == copy.find (3, Interval {0, 600}));
+    }
+  }
+
+  GIVEN ("A dictionary in a monotonic arena")
+  {
+    std::pmr::monotonic_buffer_resource arena;
+    PmrDict dict (&arena);
+    dict.insert (key_value_intervals);
+    THEN ("Queries match the dictionary on the global heap")
+    {
+      for (int key = 0; key < 7; ++key)
+      {
+        REQUIRE (dict.find (key, Interval {100, 200})
+                 == expected.find (key, Interval {100, 200}));
+      }
+    }
+  }
+}
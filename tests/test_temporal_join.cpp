@@ -0,0 +1,96 @@
+//  IntervalDict library
+//
+//  Copyright Leo Goodstadt 2020-present
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0.
+//  (See http://www.boost.org/LICENSE_1_0.txt)
+//
+//  Project home: https://github.com/goodstadt/intervaldict
+//
+/// \file test_temporal_join.cpp
+/// \brief Test temporal_join() against comparing every pair of intervals
+/// \author Leo Goodstadt
+/// Contact intervaldict@llew.org.uk
+
+#include "catch.hpp"
+#include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicticl.h>
+#include <interval_dict/temporal_join.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+TEST_CASE ("Test temporal joins", "[temporal_join]")
+{
+  using Interval = boost::icl::interval<int>::type;
+  using DictX = interval_dict::IntervalDictICLExp<int, int, Interval>;
+  using DictY = interval_dict::IntervalDictAILExp<int, std::string, Interval>;
+  using Results = std::vector<
+    interval_dict::KeyValuePairInterval<int, int, std::string, Interval>>;
+
+  GIVEN ("Random dictionaries with some keys in common")
+  {
+    DictX dict_x;
+    DictY dict_y;
+    std::mt19937 generator (11);
+    std::uniform_int_distribution<int> key (0, 300);
+    std::uniform_int_distribution<int> value (0, 5);
+    std::uniform_int_distribution<int> edge (0, 200);
+    std::uniform_int_distribution<int> length (1, 40);
+    const auto random_interval = [&] ()
+    {
+      const auto lower = edge (generator);
+      return Interval {lower, lower + length (generator)};
+    };
+    for (int i = 0; i < 2000; ++i)
+    {
+      dict_x.insert (
+        {{key (generator), value (generator), random_interval ()}});
+      dict_y.insert ({{key (generator) + 100,
+                       std::to_string (value (generator)),
+                       random_interval ()}});
+    }
+
+    // Every pair of intervals for each key
+    Results expected;
+    for (const auto &[key_x, value_x, interval_x] : intervals (dict_x))
+    {
+      if (!dict_y.contains (key_x))
+      {
+        continue;
+      }
+      for (const auto &[_, value_y, interval_y] :
+           intervals (dict_y, key_x, interval_x))
+      {
+        expected.emplace_back (
+          key_x, value_x, value_y, interval_x & interval_y);
+      }
+    }
+    std::ranges::sort (expected);
+    REQUIRE (!expected.empty ());
+
+    THEN ("The sweep finds the same pairs")
+    {
+      for (const std::size_t count_threads : {1, 4})
+      {
+        auto results
+          = interval_dict::temporal_join (dict_x, dict_y, count_threads);
+        REQUIRE (std::ranges::is_sorted (
+          results,
+          {},
+          [] (const auto &result) { return std::get<0> (result); }));
+        std::ranges::sort (results);
+        REQUIRE (results == expected);
+      }
+    }
+
+    THEN ("Dictionaries without common keys do not join")
+    {
+      REQUIRE (interval_dict::temporal_join (dict_x, DictY ()).empty ());
+    }
+  }
+}
@@ -18,9 +18,11 @@
 
 #include <interval_dict/gregorian.h>
 #include <interval_dict/intervaldictail.h>
+#include <interval_dict/intervaldicthybrid.h>
 #include <interval_dict/intervaldicticl.h>
 #include <interval_dict/intervaldictitree.h>
 #include <interval_dict/bi_intervaldictail.h>
+#include <interval_dict/bi_intervaldicthybrid.h>
 #include <interval_dict/bi_intervaldicticl.h>
 #include <interval_dict/bi_intervaldictitree.h>
 #include <interval_dict/ptime.h>